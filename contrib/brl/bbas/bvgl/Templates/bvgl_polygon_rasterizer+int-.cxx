@@ -0,0 +1,3 @@
+// Instantiation of bvgl_polygon_rasterizer<int>
+#include <bvgl/bvgl_polygon_rasterizer.hxx>
+BVGL_POLYGON_RASTERIZER_INSTANTIATE(int);
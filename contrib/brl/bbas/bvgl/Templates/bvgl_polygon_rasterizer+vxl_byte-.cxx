@@ -0,0 +1,4 @@
+// Instantiation of bvgl_polygon_rasterizer<vxl_byte>
+#include <vxl_config.h>
+#include <bvgl/bvgl_polygon_rasterizer.hxx>
+BVGL_POLYGON_RASTERIZER_INSTANTIATE(vxl_byte);
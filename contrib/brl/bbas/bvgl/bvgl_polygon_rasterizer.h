@@ -0,0 +1,101 @@
+// This is brl/bbas/bvgl/bvgl_polygon_rasterizer.h
+#ifndef bvgl_polygon_rasterizer_h_
+#define bvgl_polygon_rasterizer_h_
+//:
+// \file
+// \brief Rasterize many polygons into an image, in parallel row bands
+//
+// vgl_polygon_scan_iterator scan converts one polygon at a time, one span
+// per call to next(), and re-sorts its crossing edges on every scan line.
+// To burn thousands of polygons (e.g. OSM footprints) into a label image
+// that is wasteful. bvgl_polygon_rasterizer instead builds an edge table
+// for each polygon once, sorted by lower y. The image is then cut into
+// bands of rows which are processed concurrently on the vpl thread pool;
+// each band binary-searches the edge tables for the first edge that can
+// reach it, walks them with its own active edge list, and fills spans for every
+// polygon in the order the polygons were added, so later polygons
+// overwrite earlier ones exactly as in a sequential fill.
+//
+// Pixel (i,j) is identified with the point (i,j), as in
+// vgl_polygon_scan_iterator, and the inside test uses the even-odd rule
+// over all sheets of a polygon. With include_boundary set, spans are
+// widened outwards to the enclosing pixels (floor/ceil of the edge
+// crossings), again as vgl_polygon_scan_iterator does.
+//
+// With anti-aliasing enabled each pixel is sampled on an n x n grid, and
+// the fraction of covered samples is used to blend the polygon's value
+// into the image:  p = p + coverage * (value - p).
+
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vgl/vgl_polygon.h>
+#include <vil/vil_image_view.h>
+
+template <class T>
+class bvgl_polygon_rasterizer
+{
+ public:
+  bvgl_polygon_rasterizer() = default;
+
+  //: Add a polygon, to be drawn with the given value.
+  void add(vgl_polygon<double> const& poly, T value);
+
+  //: Remove all polygons.
+  void clear();
+
+  //: Number of polygons added.
+  unsigned size() const { return static_cast<unsigned>(polys_.size()); }
+
+  //: Include pixels on the polygon boundary (only used without anti-aliasing). Default true.
+  void set_include_boundary(bool b) { include_boundary_ = b; }
+
+  //: Anti-alias using n x n samples per pixel. n<=1 disables anti-aliasing (default).
+  void set_anti_alias(unsigned n) { aa_samples_ = n < 1 ? 1 : n; }
+
+  //: Number of image rows per band; 0 (default) chooses automatically.
+  void set_band_rows(unsigned n) { band_rows_ = n; }
+
+  //: Draw all the polygons into plane p of img.
+  void fill(vil_image_view<T>& img, unsigned p = 0) const;
+
+  //: Fraction of each pixel covered by the union of the polygons.
+  //  cov is resized to ni x nj. Uses the anti-alias sample count (1 gives a 0/1 mask).
+  void coverage(vil_image_view<float>& cov, unsigned ni, unsigned nj) const;
+
+ private:
+  //: A non-horizontal polygon edge, oriented so that y0 < y1.
+  struct edge
+  {
+    double y0, y1; //!< y extent; the edge crosses scan lines y0 <= y < y1
+    double x0;     //!< x at y0
+    double dxdy;   //!< change in x per unit y
+  };
+
+  //: Edge table of one polygon.
+  struct poly_edges
+  {
+    std::vector<edge> edges; //!< sorted by y0
+    std::vector<double> reach; //!< reach[k] is the largest y1 of edges[0..k]
+    double min_y, max_y;
+    T value;
+  };
+
+  //: Call span(j, k, s0, s1) for every span of samples covered by the polygon in rows [row0,row1).
+  //  Samples are n per pixel in each direction; k is the sample row within image row j,
+  //  and s0 <= s1 are sample columns in [0,max_sample].
+  template <class F>
+  void scan_band(poly_edges const& pe, int row0, int row1, unsigned n, bool widen, int max_sample, F span) const;
+
+  //: Run f(row0, row1) over the row bands of an image with nj rows.
+  template <class F>
+  void for_each_band(unsigned nj, F f) const;
+
+  std::vector<poly_edges> polys_;
+  bool include_boundary_{true};
+  unsigned aa_samples_{1};
+  unsigned band_rows_{0};
+};
+
+#endif // bvgl_polygon_rasterizer_h_
@@ -0,0 +1,242 @@
+// This is brl/bbas/bvgl/bvgl_polygon_rasterizer.hxx
+#ifndef bvgl_polygon_rasterizer_hxx_
+#define bvgl_polygon_rasterizer_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "bvgl_polygon_rasterizer.h"
+#include <vpl/vpl_thread_pool.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+template <class T>
+void bvgl_polygon_rasterizer<T>::add(vgl_polygon<double> const& poly, T value)
+{
+  poly_edges pe;
+  pe.value = value;
+  pe.min_y = 0.0;
+  pe.max_y = -1.0;
+  bool first = true;
+  for (unsigned s = 0; s < poly.num_sheets(); ++s)
+  {
+    std::vector<vgl_point_2d<double> > const& sheet = poly[s];
+    const std::size_t nv = sheet.size();
+    for (std::size_t v = 0; v < nv; ++v)
+    {
+      vgl_point_2d<double> p = sheet[v], q = sheet[(v + 1) % nv];
+      if (first || p.y() < pe.min_y) pe.min_y = p.y();
+      if (first || p.y() > pe.max_y) pe.max_y = p.y();
+      first = false;
+      if (p.y() == q.y()) // horizontal edges never cross a scan line
+        continue;
+      if (p.y() > q.y())
+        std::swap(p, q);
+      edge e;
+      e.y0 = p.y();
+      e.y1 = q.y();
+      e.x0 = p.x();
+      e.dxdy = (q.x() - p.x()) / (q.y() - p.y());
+      pe.edges.push_back(e);
+    }
+  }
+  std::sort(pe.edges.begin(), pe.edges.end(), [](edge const& a, edge const& b) { return a.y0 < b.y0; });
+  for (edge const& e : pe.edges)
+    pe.reach.push_back(pe.reach.empty() ? e.y1 : std::max(pe.reach.back(), e.y1));
+  polys_.push_back(pe);
+}
+
+template <class T>
+void bvgl_polygon_rasterizer<T>::clear()
+{
+  polys_.clear();
+}
+
+template <class T>
+template <class F>
+void bvgl_polygon_rasterizer<T>::scan_band(poly_edges const& pe, int row0, int row1, unsigned n, bool widen,
+                                           int max_sample, F span) const
+{
+  if (pe.edges.empty())
+    return;
+  // Rows whose samples can lie inside the polygon.
+  row0 = std::max(row0, static_cast<int>(std::ceil(pe.min_y - 0.5)));
+  row1 = std::min(row1, static_cast<int>(std::floor(pe.max_y + 0.5)) + 1);
+  if (row0 >= row1)
+    return;
+
+  // Edges before the first one reaching past the band's first sample row
+  // all end above the band, so the walk starts there.
+  const double y_first = row0 + 0.5 / n - 0.5;
+  std::size_t next = std::upper_bound(pe.reach.begin(), pe.reach.end(), y_first) - pe.reach.begin();
+  std::vector<edge const*> active;
+  std::vector<double> xs;
+  for (int j = row0; j < row1; ++j)
+    for (unsigned k = 0; k < n; ++k)
+    {
+      const double y = j + (k + 0.5) / n - 0.5;
+      // Update the active edge table: an edge crosses sample row y if y0 <= y < y1.
+      while (next < pe.edges.size() && pe.edges[next].y0 <= y)
+        active.push_back(&pe.edges[next++]);
+      active.erase(std::remove_if(active.begin(), active.end(), [y](edge const* e) { return e->y1 <= y; }),
+                   active.end());
+      if (active.size() < 2)
+        continue;
+
+      xs.clear();
+      for (edge const* e : active)
+        xs.push_back(e->x0 + (y - e->y0) * e->dxdy);
+      std::sort(xs.begin(), xs.end());
+
+      // Even-odd rule: the inside is between alternate crossings.
+      for (std::size_t c = 0; c + 1 < xs.size(); c += 2)
+      {
+        int s0, s1;
+        if (widen)
+        {
+          s0 = static_cast<int>(std::floor(xs[c]));
+          s1 = static_cast<int>(std::ceil(xs[c + 1]));
+        }
+        else
+        {
+          s0 = static_cast<int>(std::ceil((xs[c] + 0.5) * n - 0.5));
+          s1 = static_cast<int>(std::floor((xs[c + 1] + 0.5) * n - 0.5));
+        }
+        s0 = std::max(s0, 0);
+        s1 = std::min(s1, max_sample);
+        if (s0 <= s1)
+          span(j, k, s0, s1);
+      }
+    }
+}
+
+template <class T>
+template <class F>
+void bvgl_polygon_rasterizer<T>::for_each_band(unsigned nj, F f) const
+{
+  unsigned band = band_rows_;
+  if (band == 0) // a few bands per thread, to balance uneven polygon density
+    band = std::max(8u, (nj + 4 * vpl_concurrency() - 1) / (4 * vpl_concurrency()));
+  const unsigned n_bands = (nj + band - 1) / band;
+  vpl_parallel_for(0u, n_bands, [&](unsigned b) {
+    f(static_cast<int>(b * band), static_cast<int>(std::min(nj, (b + 1) * band)));
+  }, 1u);
+}
+
+template <class T>
+void bvgl_polygon_rasterizer<T>::fill(vil_image_view<T>& img, unsigned p) const
+{
+  const unsigned ni = img.ni(), nj = img.nj();
+  if (ni == 0 || nj == 0 || p >= img.nplanes())
+    return;
+  const std::ptrdiff_t istep = img.istep(), jstep = img.jstep();
+  T* plane = img.top_left_ptr() + p * img.planestep();
+
+  if (aa_samples_ <= 1)
+  {
+    for_each_band(nj, [&](int row0, int row1) {
+      for (poly_edges const& pe : polys_)
+      {
+        const T v = pe.value;
+        scan_band(pe, row0, row1, 1, include_boundary_, static_cast<int>(ni) - 1, [&](int j, unsigned, int s0, int s1) {
+          T* pix = plane + j * jstep + s0 * istep;
+          for (int i = s0; i <= s1; ++i, pix += istep)
+            *pix = v;
+        });
+      }
+    });
+    return;
+  }
+
+  // Anti-aliased: count the covered samples of each pixel, one polygon at a
+  // time, then blend the polygon into the pixels it touched.
+  const unsigned n = aa_samples_;
+  const double inv_area = 1.0 / (n * n);
+  for_each_band(nj, [&](int row0, int row1) {
+    std::vector<unsigned> counts(std::size_t(row1 - row0) * ni, 0u);
+    for (poly_edges const& pe : polys_)
+    {
+      int i_min = static_cast<int>(ni), i_max = -1, j_min = row1, j_max = row0 - 1;
+      scan_band(pe, row0, row1, n, false, static_cast<int>(ni * n) - 1, [&](int j, unsigned, int s0, int s1) {
+        unsigned* row = &counts[std::size_t(j - row0) * ni];
+        const int i0 = s0 / static_cast<int>(n), i1 = s1 / static_cast<int>(n);
+        if (i0 == i1)
+          row[i0] += s1 - s0 + 1;
+        else
+        {
+          row[i0] += n - s0 % n;
+          for (int i = i0 + 1; i < i1; ++i)
+            row[i] += n;
+          row[i1] += s1 % n + 1;
+        }
+        i_min = std::min(i_min, i0);
+        i_max = std::max(i_max, i1);
+        j_min = std::min(j_min, j);
+        j_max = std::max(j_max, j);
+      });
+      const double v = static_cast<double>(pe.value);
+      for (int j = j_min; j <= j_max; ++j)
+      {
+        unsigned* row = &counts[std::size_t(j - row0) * ni];
+        T* pix = plane + j * jstep + i_min * istep;
+        for (int i = i_min; i <= i_max; ++i, pix += istep)
+        {
+          if (row[i] == 0)
+            continue;
+          const double old = static_cast<double>(*pix);
+          double blended = old + row[i] * inv_area * (v - old);
+          if (std::is_integral<T>::value)
+            blended = std::floor(blended + 0.5);
+          *pix = static_cast<T>(blended);
+          row[i] = 0;
+        }
+      }
+    }
+  });
+}
+
+template <class T>
+void bvgl_polygon_rasterizer<T>::coverage(vil_image_view<float>& cov, unsigned ni, unsigned nj) const
+{
+  cov.set_size(ni, nj, 1);
+  cov.fill(0.0f);
+  if (ni == 0 || nj == 0)
+    return;
+  const unsigned n = aa_samples_;
+  const std::size_t row_samples = std::size_t(ni) * n;
+  const float inv_area = 1.0f / (n * n);
+
+  for_each_band(nj, [&](int row0, int row1) {
+    // One flag per sample of the band, so that overlapping polygons are
+    // only counted once.
+    std::vector<unsigned char> mask(std::size_t(row1 - row0) * n * row_samples, 0);
+    for (poly_edges const& pe : polys_)
+      scan_band(pe, row0, row1, n, n == 1 && include_boundary_, static_cast<int>(row_samples) - 1,
+                [&](int j, unsigned k, int s0, int s1) {
+                  unsigned char* m = &mask[(std::size_t(j - row0) * n + k) * row_samples];
+                  std::fill(m + s0, m + s1 + 1, static_cast<unsigned char>(1));
+                });
+    for (int j = row0; j < row1; ++j)
+    {
+      const unsigned char* m = &mask[std::size_t(j - row0) * n * row_samples];
+      for (unsigned i = 0; i < ni; ++i)
+      {
+        unsigned c = 0;
+        for (unsigned k = 0; k < n; ++k)
+          for (unsigned s = 0; s < n; ++s)
+            c += m[k * row_samples + i * n + s];
+        cov(i, j) = c * inv_area;
+      }
+    }
+  });
+}
+
+#undef BVGL_POLYGON_RASTERIZER_INSTANTIATE
+#define BVGL_POLYGON_RASTERIZER_INSTANTIATE(T) \
+  template class bvgl_polygon_rasterizer<T >
+
+#endif // bvgl_polygon_rasterizer_hxx_
@@ -11,6 +11,7 @@ DECLARE(test_poly_region);
 DECLARE(test_scaled_shape);
 DECLARE(test_k_nearest_neighbors);
 DECLARE(test_knn_index_3d);
+DECLARE(test_polygon_rasterizer);
 #ifdef EXPAT_FOUND
 DECLARE(test_bvgl_labelme_parser);
 #endif
@@ -29,6 +30,7 @@ register_tests()
   REGISTER(test_scaled_shape);
   REGISTER(test_k_nearest_neighbors);
   REGISTER(test_knn_index_3d);
+  REGISTER(test_polygon_rasterizer);
 #ifdef EXPAT_FOUND
   REGISTER(test_bvgl_labelme_parser);
 #endif
@@ -7,6 +7,7 @@
 #include <bvgl/bvgl_intersection.h>
 #include <bvgl/bvgl_labelme_parser.h>
 #include <bvgl/bvgl_point_3d_cmp.h>
+#include <bvgl/bvgl_polygon_rasterizer.h>
 #include <bvgl/bvgl_ray_pyramid.h>
 #include <bvgl/bvgl_triangle_3d.h>
 #include <bvgl/bvgl_triangle_interpolation_iterator.h>
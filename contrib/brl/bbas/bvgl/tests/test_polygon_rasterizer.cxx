@@ -0,0 +1,163 @@
+//:
+// \file
+#include <iostream>
+#include <cmath>
+#include "testlib/testlib_test.h"
+#include <bvgl/bvgl_polygon_rasterizer.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vgl/vgl_polygon.h"
+#include "vgl/vgl_polygon_scan_iterator.h"
+#include "vil/vil_image_view.h"
+#include "vnl/vnl_random.h"
+#include <vpl/vpl_thread_pool.h>
+
+//: A random star-shaped polygon around (cx, cy), possibly self-intersecting.
+static vgl_polygon<double> random_polygon(vnl_random& rng, double cx, double cy, double r)
+{
+  const unsigned n = 3 + rng.lrand32(0, 8);
+  vgl_polygon<double> poly(1);
+  for (unsigned k = 0; k < n; ++k)
+  {
+    const double a = rng.drand64(0.0, 6.2831853);
+    const double d = rng.drand64(0.2 * r, r);
+    poly.push_back(cx + d * std::cos(a), cy + d * std::sin(a));
+  }
+  return poly;
+}
+
+//: Reference fill using vgl_polygon_scan_iterator.
+static void scan_fill(vgl_polygon<double> const& poly, bool boundary, vxl_byte value, vil_image_view<vxl_byte>& img)
+{
+  vgl_polygon_scan_iterator<double> it(poly, boundary);
+  for (it.reset(); it.next();)
+  {
+    const int j = it.scany();
+    if (j < 0 || j >= int(img.nj()))
+      continue;
+    for (int i = std::max(0, it.startx()); i <= std::min(int(img.ni()) - 1, it.endx()); ++i)
+      img(i, j) = value;
+  }
+}
+
+static bool same(vil_image_view<vxl_byte> const& a, vil_image_view<vxl_byte> const& b)
+{
+  for (unsigned j = 0; j < a.nj(); ++j)
+    for (unsigned i = 0; i < a.ni(); ++i)
+      if (a(i, j) != b(i, j))
+        return false;
+  return true;
+}
+
+static void test_polygon_rasterizer()
+{
+  vnl_random rng(1234);
+  const unsigned ni = 97, nj = 83;
+
+  // Many overlapping polygons, partly outside the image: later ones overwrite earlier ones.
+  bvgl_polygon_rasterizer<vxl_byte> rast;
+  rast.set_include_boundary(false);
+  vil_image_view<vxl_byte> ref(ni, nj);
+  ref.fill(0);
+  for (unsigned p = 0; p < 200; ++p)
+  {
+    vgl_polygon<double> poly = random_polygon(rng, rng.drand64(-10.0, ni + 10.0), rng.drand64(-10.0, nj + 10.0),
+                                              rng.drand64(2.0, 25.0));
+    const vxl_byte value = static_cast<vxl_byte>(1 + p % 255);
+    rast.add(poly, value);
+    scan_fill(poly, false, value, ref);
+  }
+  TEST("number of polygons", rast.size(), 200);
+
+  vil_image_view<vxl_byte> single(ni, nj), multi(ni, nj);
+  single.fill(0);
+  multi.fill(0);
+  vpl_set_concurrency(1);
+  rast.fill(single);
+  TEST("single thread agrees with vgl_polygon_scan_iterator", same(single, ref), true);
+
+  vpl_set_concurrency(4);
+  rast.set_band_rows(5);
+  rast.fill(multi);
+  TEST("multi-threaded fill agrees with single thread", same(multi, single), true);
+
+  // A comb: the long back edge is first in the edge table and must stay
+  // active in every band, while the teeth are found by the binary search.
+  vgl_polygon<double> comb(1);
+  comb.push_back(2.3, 1.2);
+  for (unsigned t = 0; t < 20; ++t)
+  {
+    comb.push_back(30.7, 1.2 + 4.0 * t);
+    comb.push_back(30.7, 3.2 + 4.0 * t);
+    comb.push_back(10.1, 3.2 + 4.0 * t);
+    comb.push_back(10.1, 5.2 + 4.0 * t);
+  }
+  comb.push_back(2.3, 81.2);
+  bvgl_polygon_rasterizer<vxl_byte> comb_rast;
+  comb_rast.add(comb, 7);
+  comb_rast.set_include_boundary(false);
+  comb_rast.set_band_rows(3);
+  vil_image_view<vxl_byte> comb_img(40, 90), comb_ref(40, 90);
+  comb_img.fill(0);
+  comb_ref.fill(0);
+  comb_rast.fill(comb_img);
+  scan_fill(comb, false, 7, comb_ref);
+  TEST("comb in narrow bands agrees with vgl_polygon_scan_iterator", same(comb_img, comb_ref), true);
+  vpl_set_concurrency(0);
+
+  // Boundary pixels are included by widening each span to the enclosing pixels.
+  vgl_polygon<double> square(1);
+  square.push_back(10.5, 10.5);
+  square.push_back(20.5, 10.5);
+  square.push_back(20.5, 20.5);
+  square.push_back(10.5, 20.5);
+  bvgl_polygon_rasterizer<vxl_byte> sq;
+  sq.add(square, 255);
+  vil_image_view<vxl_byte> inner(40, 40), outer(40, 40);
+  inner.fill(0);
+  outer.fill(0);
+  sq.fill(outer);
+  sq.set_include_boundary(false);
+  sq.fill(inner);
+  unsigned n_inner = 0, n_outer = 0;
+  for (unsigned j = 0; j < 40; ++j)
+    for (unsigned i = 0; i < 40; ++i)
+    {
+      n_inner += inner(i, j) ? 1 : 0;
+      n_outer += outer(i, j) ? 1 : 0;
+    }
+  TEST("interior of square", n_inner, 100);
+  TEST("square with boundary", n_outer, 120);
+
+  // Anti-aliased coverage of a square sums to its area.
+  vgl_polygon<double> tilted(1);
+  tilted.push_back(20.0, 5.3);
+  tilted.push_back(34.7, 20.0);
+  tilted.push_back(20.0, 34.7);
+  tilted.push_back(5.3, 20.0);
+  bvgl_polygon_rasterizer<float> aa;
+  aa.add(tilted, 1.0f);
+  aa.set_anti_alias(8);
+  vil_image_view<float> cov;
+  aa.coverage(cov, 40, 40);
+  double area = 0.0;
+  for (unsigned j = 0; j < 40; ++j)
+    for (unsigned i = 0; i < 40; ++i)
+      area += cov(i, j);
+  TEST_NEAR("anti-aliased coverage area", area, 2 * 14.7 * 14.7, 1.0);
+  TEST("centre fully covered", cov(20, 20), 1.0f);
+  TEST("outside not covered", cov(2, 2), 0.0f);
+
+  // Blending into a float image gives the same coverage.
+  vil_image_view<float> blend(40, 40);
+  blend.fill(0.0f);
+  aa.fill(blend);
+  double max_diff = 0.0;
+  for (unsigned j = 0; j < 40; ++j)
+    for (unsigned i = 0; i < 40; ++i)
+      max_diff = std::max(max_diff, double(std::fabs(blend(i, j) - cov(i, j))));
+  TEST_NEAR("blended fill equals coverage", max_diff, 0.0, 1e-6);
+}
+
+TESTMAIN(test_polygon_rasterizer);
@@ -1,4 +1,5 @@
 #include <bvgl/bvgl_intersection.hxx>
+#include <bvgl/bvgl_polygon_rasterizer.hxx>
 #include <bvgl/bvgl_triangle_3d.hxx>
 #include <bvgl/bvgl_triangle_interpolation_iterator.hxx>
 #include <bvgl/bvgl_volume_of_intersection.hxx>
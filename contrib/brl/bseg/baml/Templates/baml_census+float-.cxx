@@ -0,0 +1,2 @@
+#include "baml_census.hxx"
+BAML_COMPUTE_CENSUS_IMG_INSTANTIATE(float);
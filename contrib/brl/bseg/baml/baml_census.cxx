@@ -0,0 +1,104 @@
+// This is brl/bseg/baml/baml_census.cxx
+
+#include "baml_census.h"
+#include <vil/vil_config.h>
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+#  include <emmintrin.h>
+#endif
+
+
+//---------------------------------------------------------
+void
+baml_census_accumulate(
+  const vxl_byte* nbr,
+  const vxl_byte* center,
+  const vxl_byte* center_min,
+  const vxl_byte* center_max,
+  int n,
+  unsigned char* cen_bits,
+  unsigned char* sal_bits )
+{
+  int x = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  // 16 pixels at a time.  SSE2 only compares signed bytes, so flip the sign
+  // bits for the "less than" test, and use min/max for the others.
+  const __m128i sign = _mm_set1_epi8( static_cast<char>(0x80) );
+  for( ; x + 16 <= n; x += 16 ){
+    __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( nbr + x ) );
+    __m128i c = _mm_loadu_si128( reinterpret_cast<const __m128i*>( center + x ) );
+    __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>( center_min + x ) );
+    __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>( center_max + x ) );
+    __m128i cb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( cen_bits + x ) );
+    __m128i sb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( sal_bits + x ) );
+
+    // All ones where the bit is set
+    __m128i lt = _mm_cmplt_epi8( _mm_xor_si128( v, sign ), _mm_xor_si128( c, sign ) );
+    __m128i sal = _mm_or_si128( _mm_cmpeq_epi8( _mm_min_epu8( v, lo ), v ),
+                                _mm_cmpeq_epi8( _mm_max_epu8( v, hi ), v ) );
+
+    // bits = 2*bits - (-1 or 0)
+    cb = _mm_sub_epi8( _mm_add_epi8( cb, cb ), lt );
+    sb = _mm_sub_epi8( _mm_add_epi8( sb, sb ), sal );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( cen_bits + x ), cb );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( sal_bits + x ), sb );
+  }
+#endif
+  for( ; x < n; x++ ){
+    cen_bits[x] = (unsigned char)( ( cen_bits[x] << 1 ) | ( nbr[x] < center[x] ) );
+    sal_bits[x] = (unsigned char)( ( sal_bits[x] << 1 ) |
+      ( nbr[x] <= center_min[x] || nbr[x] >= center_max[x] ) );
+  }
+}
+
+
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+//: Number of set bits in each 64 bit half, in the low 16 bits of the half
+static inline __m128i
+baml_popcount_epi64( __m128i v )
+{
+  const __m128i m1 = _mm_set1_epi8( 0x55 );
+  const __m128i m2 = _mm_set1_epi8( 0x33 );
+  const __m128i m4 = _mm_set1_epi8( 0x0f );
+  v = _mm_sub_epi64( v, _mm_and_si128( _mm_srli_epi64( v, 1 ), m1 ) );
+  v = _mm_add_epi64( _mm_and_si128( v, m2 ), _mm_and_si128( _mm_srli_epi64( v, 2 ), m2 ) );
+  v = _mm_and_si128( _mm_add_epi64( v, _mm_srli_epi64( v, 4 ) ), m4 );
+  return _mm_sad_epu8( v, _mm_setzero_si128() );
+}
+#endif
+
+
+//---------------------------------------------------------
+void
+baml_census_hamming(
+  vxl_uint_64 cen,
+  vxl_uint_64 sal,
+  const vxl_uint_64* cen2,
+  const vxl_uint_64* sal2,
+  int n,
+  unsigned char* ham )
+{
+  int i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  // 8 strings at a time, 2 per register
+  const __m128i c = _mm_set1_epi64x( static_cast<long long>( cen ) );
+  const __m128i s = _mm_set1_epi64x( static_cast<long long>( sal ) );
+  for( ; i + 8 <= n; i += 8 ){
+    __m128i h[4];
+    for( int k = 0; k < 4; k++ ){
+      __m128i c2 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( cen2 + i + 2*k ) );
+      __m128i s2 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( sal2 + i + 2*k ) );
+      h[k] = baml_popcount_epi64(
+        _mm_and_si128( _mm_xor_si128( c, c2 ), _mm_or_si128( s, s2 ) ) );
+    }
+    // Each count is in the low 16 bits of its 64 bit half, so packing the
+    // 32 bit values twice lines them up as 16 bit values
+    __m128i h01 = _mm_packs_epi32( h[0], h[1] );
+    __m128i h23 = _mm_packs_epi32( h[2], h[3] );
+    __m128i h16 = _mm_packs_epi32( h01, h23 );
+    _mm_storel_epi64( reinterpret_cast<__m128i*>( ham + i ),
+                      _mm_packus_epi16( h16, h16 ) );
+  }
+#endif
+  for( ; i < n; i++ )
+    ham[i] = baml_compute_hamming( ( cen ^ cen2[i] ) & ( sal | sal2[i] ) );
+}
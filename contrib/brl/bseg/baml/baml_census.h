@@ -3,6 +3,7 @@
 #define baml_census_h
 
 #include <vector>
+#include <vxl_config.h>
 #include <vil/vil_image_view.h>
 
 //:
@@ -21,6 +22,74 @@ bool baml_compute_census_img(
   vil_image_view<vxl_uint_64>& census_sal,
   int tol = 2 );
 
+//: Compute a census image and census salience image over a rectangular
+// neighborhood of nbhd_ni x nbhd_nj pixels, e.g. 9x7.  Returns false if
+// the neighborhood has more than 64 pixels.
+template <class T>
+bool baml_compute_census_img(
+  const vil_image_view<T>& img,
+  int nbhd_ni,
+  int nbhd_nj,
+  vil_image_view<vxl_uint_64>& census,
+  vil_image_view<vxl_uint_64>& census_sal,
+  int tol = 2 );
+
+//: Compute census and salience bit strings of the pixels in
+// [start_x, stop_x) x [start_y, stop_y), which must be far enough from the
+// image border for their whole neighborhood to be inside img.
+// The bits are in raster order of the neighborhood, the first pixel in the
+// most significant bit.  census and census_sal must already be allocated.
+// This is the kernel used by baml_compute_census_img and
+// bsgm_compute_census_img; it builds 8 bits of every pixel in a row at a
+// time, which is vectorised for vxl_byte images.
+template <class T>
+void baml_compute_census_rows(
+  const vil_image_view<T>& img,
+  int nbhd_ni,
+  int nbhd_nj,
+  int tol,
+  int start_x,
+  int stop_x,
+  int start_y,
+  int stop_y,
+  vil_image_view<vxl_uint_64>& census,
+  vil_image_view<vxl_uint_64>& census_sal );
+
+//: Shift the comparison of n neighbor pixels with their centers into the
+// low bits of cen_bits and sal_bits.
+template <class T>
+void baml_census_accumulate(
+  const T* nbr,
+  const T* center,
+  const T* center_min,
+  const T* center_max,
+  int n,
+  unsigned char* cen_bits,
+  unsigned char* sal_bits );
+
+//: Vectorised version of the above for bytes.
+void baml_census_accumulate(
+  const vxl_byte* nbr,
+  const vxl_byte* center,
+  const vxl_byte* center_min,
+  const vxl_byte* center_max,
+  int n,
+  unsigned char* cen_bits,
+  unsigned char* sal_bits );
+
+//: Compute the hamming distances between the census string (cen, sal) and
+// each of the n strings (cen2[i], sal2[i]), counting only bits where one of
+// the two is salient.  Computes two distances at a time where SSE2 is
+// available, so is the kernel to use when matching a pixel against a range
+// of disparities.
+void baml_census_hamming(
+  vxl_uint_64 cen,
+  vxl_uint_64 sal,
+  const vxl_uint_64* cen2,
+  const vxl_uint_64* sal2,
+  int n,
+  unsigned char* ham );
+
 //: Find the difference between two census bit-strings with saliences
 inline unsigned long long baml_compute_diff_string(
   unsigned long long int cen1,
@@ -43,6 +112,18 @@ inline unsigned long long baml_compute_diff_string(
 // http://graphics.stanford.edu/~seander/bithacks.html
 
 
+//: Compute the hamming distance of a difference bit-string by counting bits
+// in parallel.  Unlike the functions below it takes constant time, and
+// covers all 64 bits.
+inline unsigned char baml_compute_hamming(
+  unsigned long long int diff )
+{
+  diff = diff - ((diff >> 1) & 0x5555555555555555ULL);
+  diff = (diff & 0x3333333333333333ULL) + ((diff >> 2) & 0x3333333333333333ULL);
+  diff = (diff + (diff >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (unsigned char)( (diff*0x0101010101010101ULL) >> 56 );
+}
+
 //: Compute the hamming distance of a difference bit-string using Brian
 // Kernighan's algorithm.
 inline unsigned char baml_compute_hamming_bk(
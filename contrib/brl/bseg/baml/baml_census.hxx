@@ -1,66 +1,173 @@
 // This is brl/bseg/baml/baml_census.hxx
 
 #include <algorithm>
+#include <limits>
 #include "baml_census.h"
 
 
+//---------------------------------------------------------
+template <class T>
+void
+baml_census_accumulate(
+  const T* nbr,
+  const T* center,
+  const T* center_min,
+  const T* center_max,
+  int n,
+  unsigned char* cen_bits,
+  unsigned char* sal_bits )
+{
+  for( int x = 0; x < n; x++ ){
+
+    // Record the sign of the sample-to-center difference
+    cen_bits[x] = (unsigned char)( ( cen_bits[x] << 1 ) | ( nbr[x] < center[x] ) );
+
+    // Also record whether the pixel differs significantly from the center
+    sal_bits[x] = (unsigned char)( ( sal_bits[x] << 1 ) |
+      ( nbr[x] <= center_min[x] || nbr[x] >= center_max[x] ) );
+  }
+}
+
+
+//---------------------------------------------------------
+template <class T>
+void
+baml_compute_census_rows(
+  const vil_image_view<T>& img,
+  int nbhd_ni,
+  int nbhd_nj,
+  int tol,
+  int start_x,
+  int stop_x,
+  int start_y,
+  int stop_y,
+  vil_image_view<vxl_uint_64>& census,
+  vil_image_view<vxl_uint_64>& census_sal )
+{
+  int n = stop_x - start_x;
+  if( n <= 0 || start_y >= stop_y ) return;
+
+  // The kernels need contiguous rows
+  if( img.istep() != 1 ){
+    vil_image_view<T> img_copy;
+    img_copy.deep_copy( img );
+    baml_compute_census_rows( img_copy, nbhd_ni, nbhd_nj, tol,
+      start_x, stop_x, start_y, stop_y, census, census_sal );
+    return;
+  }
+
+  int rad_i = (nbhd_ni-1)/2, rad_j = (nbhd_nj-1)/2;
+  int num_bits = nbhd_ni*nbhd_nj;
+  T max_val = std::numeric_limits<T>::max();
+
+  std::vector<T> center_min( n ), center_max( n );
+  std::vector<unsigned char> cen_bits( n ), sal_bits( n );
+  std::ptrdiff_t cen_step = census.istep(), sal_step = census_sal.istep();
+
+  for( int y = start_y; y < stop_y; y++ ){
+
+    // Intensity range around each center within which neighbors are not
+    // salient
+    const T* center = &img( start_x, y );
+    for( int x = 0; x < n; x++ ){
+      T c = center[x];
+      center_max[x] = c > max_val - tol ? max_val : T( c + tol );
+      center_min[x] = c > tol ? T( c - tol ) : T( 0 );
+    }
+
+    vxl_uint_64* cen_row = &census( start_x, y );
+    vxl_uint_64* sal_row = &census_sal( start_x, y );
+    for( int x = 0; x < n; x++ ){
+      cen_row[x*cen_step] = 0;
+      sal_row[x*sal_step] = 0;
+    }
+
+    // Build the bit strings 8 neighbors at a time, then move each byte into
+    // place
+    for( int b0 = 0; b0 < num_bits; b0 += 8 ){
+      int nb = std::min( 8, num_bits - b0 );
+      std::fill( cen_bits.begin(), cen_bits.end(), 0 );
+      std::fill( sal_bits.begin(), sal_bits.end(), 0 );
+      for( int b = b0; b < b0 + nb; b++ ){
+        const T* nbr = &img( start_x + b%nbhd_ni - rad_i, y + b/nbhd_ni - rad_j );
+        baml_census_accumulate( nbr, center, &center_min[0], &center_max[0], n,
+          &cen_bits[0], &sal_bits[0] );
+      }
+      int shift = num_bits - b0 - nb;
+      for( int x = 0; x < n; x++ ){
+        cen_row[x*cen_step] |= vxl_uint_64( cen_bits[x] ) << shift;
+        sal_row[x*sal_step] |= vxl_uint_64( sal_bits[x] ) << shift;
+      }
+    }
+  }
+}
+
+
 //---------------------------------------------------------
 template <class T>
 bool
 baml_compute_census_img(
   const vil_image_view<T>& img,
-  int nbhd_diam,
+  int nbhd_ni,
+  int nbhd_nj,
   vil_image_view<vxl_uint_64>& census,
   vil_image_view<vxl_uint_64>& census_sal,
   int tol )
 {
   int height = img.nj(), width = img.ni();
 
-  // Can't handle bigger patch sizes with current implementation.
-  if( nbhd_diam > 7 ) return false;
+  // The bit strings hold at most 64 pixels
+  if( nbhd_ni < 1 || nbhd_nj < 1 || nbhd_ni*nbhd_nj > 64 ) return false;
 
   census.set_size( width, height );
   census_sal.set_size( width, height );
+  census.fill( 0 );
+  census_sal.fill( 0 );
 
-  int nbhd_rad = (nbhd_diam-1)/2;
-  int max_intensity = pow( 256, sizeof(T) )-1;
-
-  // Iterate over each pixel
-  for( int y = nbhd_rad; y < height-nbhd_rad; y++ ){
-    for( int x = nbhd_rad; x < width-nbhd_rad; x++ ){
-
-      T center_max = (T)( std::min( max_intensity, img(x,y) + tol ) );
-      T center_min = (T)( std::max( 0, img(x,y) - tol ) );
-
-      unsigned long long cen = 0;
-      unsigned long long sal = 0;
+  int rad_i = (nbhd_ni-1)/2, rad_j = (nbhd_nj-1)/2;
+  baml_compute_census_rows( img, nbhd_ni, nbhd_nj, tol,
+    rad_i, width - (nbhd_ni-1-rad_i), rad_j, height - (nbhd_nj-1-rad_j),
+    census, census_sal );
+  return true;
+}
 
-      int x_min = x-nbhd_rad, y_min = y-nbhd_rad;
-      T img_xy = img(x,y);
-      for( int dy = 0; dy < nbhd_diam; dy++ ){
-        const T* img_x2y2 = &img( x_min, y_min + dy );
-        for( int dx = 0; dx < nbhd_diam; dx++, img_x2y2++ ){
 
-          // Record the sign of the sample-to-center difference in a bit at
-          // each pixel in a patch.
-          cen <<= 1;
-          if( *img_x2y2 < img_xy ) cen++;
+//---------------------------------------------------------
+template <class T>
+bool
+baml_compute_census_img(
+  const vil_image_view<T>& img,
+  int nbhd_diam,
+  vil_image_view<vxl_uint_64>& census,
+  vil_image_view<vxl_uint_64>& census_sal,
+  int tol )
+{
+  // Can't handle bigger patch sizes with current implementation.
+  if( nbhd_diam > 7 ) return false;
 
-          // Also record whether the pixel differs significantly from the
-          // center in a separate "salience" bit
-          sal <<= 1;
-          if( *img_x2y2 <= center_min || *img_x2y2 >= center_max ) sal++;
-        }
-      }
-      census(x,y) = cen;
-      census_sal(x,y) = sal;
-    }
-  }
-  return true;
-};
+  return baml_compute_census_img( img, nbhd_diam, nbhd_diam, census, census_sal, tol );
+}
 
 #undef BAML_COMPUTE_CENSUS_IMG_INSTANTIATE
 #define BAML_COMPUTE_CENSUS_IMG_INSTANTIATE(T) \
+template void baml_compute_census_rows( \
+  const vil_image_view<T>& img, \
+  int nbhd_ni, \
+  int nbhd_nj, \
+  int tol, \
+  int start_x, \
+  int stop_x, \
+  int start_y, \
+  int stop_y, \
+  vil_image_view<vxl_uint_64>& census, \
+  vil_image_view<vxl_uint_64>& census_sal ); \
+template bool baml_compute_census_img( \
+  const vil_image_view<T>& img, \
+  int nbhd_ni, \
+  int nbhd_nj, \
+  vil_image_view<vxl_uint_64>& census, \
+  vil_image_view<vxl_uint_64>& census_sal, \
+  int tol ); \
 template bool baml_compute_census_img( \
   const vil_image_view<T>& img, \
   int nbhd_diam, \
@@ -529,11 +529,6 @@ baml_change_detection::detect_census(
   if (params_.census_rad > 3) params_.census_rad = 3;
   int census_diam = params_.census_rad * 2 + 1;
 
-  // Pre-build a census lookup table
-  unsigned char lut[256];
-  baml_generate_bit_set_lut(lut);
-  bool only_32_bits = (census_diam <= 5);
-
   // Compute foreground likelihood assuming uniform distribution
   fg_prob = 1.0 / (census_diam*census_diam);
 
@@ -560,7 +555,7 @@ baml_change_detection::detect_census(
         census_tar(x, y), census_ref(x, y),
         salience_tar(x, y), salience_ref(x, y));
 
-      score(x,y) = (float)baml_compute_hamming_lut(cen_diff, lut, only_32_bits);
+      score(x,y) = (float)baml_compute_hamming(cen_diff);
     }
   }
 
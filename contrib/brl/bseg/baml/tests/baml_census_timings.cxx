@@ -0,0 +1,132 @@
+//:
+// \file
+// \brief Tool to time the census transform and census matching cost
+//   Times baml_compute_census_img against the pixel by pixel transform it
+//   replaces, and filling a cost volume of hamming distances over a range
+//   of disparities with baml_census_hamming against the look-up table
+//   version.  Run with optional image width, height and number of
+//   disparities (default 2000 1000 64).
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include "vxl_config.h" // for vxl_byte
+#include "vul/vul_timer.h"
+#include "vil/vil_image_view.h"
+#include "vnl/vnl_random.h"
+#include <baml/baml_census.h>
+
+//: The census transform before baml_compute_census_rows
+static void
+census_by_pixel(const vil_image_view<vxl_byte> & img,
+                int nbhd_diam,
+                vil_image_view<vxl_uint_64> & census,
+                vil_image_view<vxl_uint_64> & census_sal,
+                int tol)
+{
+  int width = img.ni(), height = img.nj();
+  census.set_size(width, height);
+  census_sal.set_size(width, height);
+  int nbhd_rad = (nbhd_diam - 1) / 2;
+  for (int y = nbhd_rad; y < height - nbhd_rad; y++)
+  {
+    for (int x = nbhd_rad; x < width - nbhd_rad; x++)
+    {
+      vxl_byte img_xy = img(x, y);
+      vxl_byte center_max = vxl_byte(std::min(255, img_xy + tol));
+      vxl_byte center_min = vxl_byte(std::max(0, img_xy - tol));
+      unsigned long long cen = 0, sal = 0;
+      for (int dy = 0; dy < nbhd_diam; dy++)
+      {
+        const vxl_byte * p = &img(x - nbhd_rad, y - nbhd_rad + dy);
+        for (int dx = 0; dx < nbhd_diam; dx++, p++)
+        {
+          cen <<= 1;
+          if (*p < img_xy)
+            cen++;
+          sal <<= 1;
+          if (*p <= center_min || *p >= center_max)
+            sal++;
+        }
+      }
+      census(x, y) = cen;
+      census_sal(x, y) = sal;
+    }
+  }
+}
+
+int
+main(int argc, char * argv[])
+{
+  int ni = argc > 1 ? std::atoi(argv[1]) : 2000;
+  int nj = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int nd = argc > 3 ? std::atoi(argv[3]) : 64;
+  if (ni <= nd || nj < 8 || nd < 1)
+  {
+    std::cerr << "Usage: " << argv[0] << " [width height num_disparities]\n";
+    return 1;
+  }
+
+  vnl_random rng(1234);
+  vil_image_view<vxl_byte> img_tar(ni, nj), img_ref(ni, nj);
+  for (int y = 0; y < nj; y++)
+    for (int x = 0; x < ni; x++)
+    {
+      img_ref(x, y) = vxl_byte(rng.lrand32(0, 255));
+      img_tar(x, y) = x + 5 < ni ? img_ref(x + 5, y) : 0;
+    }
+
+  vul_timer t;
+  for (int diam = 3; diam <= 7; diam += 2)
+  {
+    vil_image_view<vxl_uint_64> cen_old, sal_old, cen_new, sal_new;
+    t.mark();
+    census_by_pixel(img_tar, diam, cen_old, sal_old, 2);
+    double t_old = t.real();
+    t.mark();
+    baml_compute_census_img(img_tar, diam, cen_new, sal_new, 2);
+    double t_new = t.real();
+    std::cout << "Census " << diam << 'x' << diam << ": pixel by pixel " << t_old << " ms, rows " << t_new
+              << " ms\n";
+  }
+
+  // Hamming distances of each target pixel to nd reference pixels
+  vil_image_view<vxl_uint_64> cen_tar, sal_tar, cen_ref, sal_ref;
+  baml_compute_census_img(img_tar, 7, cen_tar, sal_tar, 2);
+  baml_compute_census_img(img_ref, 7, cen_ref, sal_ref, 2);
+  std::vector<unsigned char> cost_old(std::size_t(ni - nd) * nd), cost_new(cost_old.size());
+  unsigned char lut[256];
+  baml_generate_bit_set_lut(lut);
+  auto by_lut = [&](int y) {
+    for (int x = 0; x < ni - nd; x++)
+      for (int d = 0; d < nd; d++)
+        cost_old[x * nd + d] = baml_compute_hamming_lut(
+          baml_compute_diff_string(cen_tar(x, y), cen_ref(x + d, y), sal_tar(x, y), sal_ref(x + d, y)), lut);
+  };
+  auto vectorised = [&](int y) {
+    for (int x = 0; x < ni - nd; x++)
+      baml_census_hamming(cen_tar(x, y), sal_tar(x, y), &cen_ref(x, y), &sal_ref(x, y), nd, &cost_new[x * nd]);
+  };
+  t.mark();
+  for (int y = 0; y < nj; y++)
+    by_lut(y);
+  double t_old = t.real();
+  t.mark();
+  for (int y = 0; y < nj; y++)
+    vectorised(y);
+  double t_new = t.real();
+  for (int y = 0; y < nj; y++)
+  {
+    by_lut(y);
+    vectorised(y);
+    if (cost_old != cost_new)
+    {
+      std::cerr << "Hamming distances differ in row " << y << '\n';
+      return 1;
+    }
+  }
+  std::cout << "Hamming cost volume, " << nd << " disparities: look-up table " << t_old << " ms, vectorised "
+            << t_new << " ms\n";
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vil/vil_image_view.h"
+#include "vil/vil_plane.h"
+#include "vnl/vnl_random.h"
+#include <baml/baml_census.h>
+
+//: Census of one pixel, bit by bit
+template <class T>
+static void census_of_pixel(
+  const vil_image_view<T>& img, int x, int y, int nbhd_ni, int nbhd_nj, int tol,
+  vxl_uint_64& cen, vxl_uint_64& sal)
+{
+  T max_val = std::numeric_limits<T>::max();
+  T c = img(x, y);
+  T c_max = double(c) + tol > double(max_val) ? max_val : T(c + tol);
+  T c_min = double(c) > tol ? T(c - tol) : T(0);
+  cen = 0; sal = 0;
+  for (int dy = 0; dy < nbhd_nj; dy++) {
+    for (int dx = 0; dx < nbhd_ni; dx++) {
+      T v = img(x - (nbhd_ni - 1) / 2 + dx, y - (nbhd_nj - 1) / 2 + dy);
+      cen = (cen << 1) | (v < c ? 1 : 0);
+      sal = (sal << 1) | (v <= c_min || v >= c_max ? 1 : 0);
+    }
+  }
+}
+
+//: Check baml_compute_census_img against census_of_pixel for each size
+template <class T>
+static bool check_census(const vil_image_view<T>& img, int tol)
+{
+  const int sizes[][2] = { {3, 3}, {5, 5}, {7, 7}, {4, 4}, {9, 7}, {8, 8} };
+  bool good = true;
+  for (const auto& size : sizes) {
+    int ni = size[0], nj = size[1];
+    vil_image_view<vxl_uint_64> census, census_sal;
+    good = good && baml_compute_census_img(img, ni, nj, census, census_sal, tol);
+    for (int y = (nj - 1) / 2; y < int(img.nj()) - nj / 2; y++) {
+      for (int x = (ni - 1) / 2; x < int(img.ni()) - ni / 2; x++) {
+        vxl_uint_64 cen, sal;
+        census_of_pixel(img, x, y, ni, nj, tol, cen, sal);
+        good = good && census(x, y) == cen && census_sal(x, y) == sal;
+      }
+    }
+    // Pixels without a full neighborhood are zero
+    good = good && census(0, 0) == 0 && census_sal(img.ni() - 1, img.nj() - 1) == 0;
+  }
+  return good;
+}
+
+static void test_census()
+{
+  vnl_random rng(7321);
+
+  // Odd width to exercise the tails of the vectorised loops; bytes near
+  // both ends of the range to exercise the tolerance clamping
+  int width = 83, height = 21;
+  vil_image_view<vxl_byte> img_byte(width, height);
+  vil_image_view<vxl_uint_16> img_16(width, height);
+  vil_image_view<float> img_float(width, height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int r = rng.lrand32(0, 24);
+      img_byte(x, y) = vxl_byte(r < 8 ? r : r > 16 ? 231 + r : rng.lrand32(0, 255));
+      img_16(x, y) = vxl_uint_16(rng.lrand32(0, 65535));
+      img_float(x, y) = float(rng.drand32(0.0, 10.0));
+    }
+  }
+  TEST("byte census", check_census(img_byte, 2), true);
+  TEST("byte census, tol 0", check_census(img_byte, 0), true);
+  TEST("uint16 census", check_census(img_16, 300), true);
+  TEST("float census", check_census(img_float, 1), true);
+
+  // A plane of an interleaved image has istep != 1
+  vil_image_view<vxl_byte> img_rgb(width, height, 1, 3);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      for (int p = 0; p < 3; p++)
+        img_rgb(x, y, p) = img_byte(x, (y + p) % height);
+  TEST("byte census of interleaved plane", check_census(vil_plane(img_rgb, 1), 2), true);
+
+  vil_image_view<vxl_uint_64> census, census_sal;
+  TEST("more than 64 bits fails", baml_compute_census_img(img_byte, 9, 8, census, census_sal), false);
+  TEST("square more than 7 fails", baml_compute_census_img(img_byte, 9, census, census_sal), false);
+
+  // Hamming distances of one string against many
+  int n = 45;
+  std::vector<vxl_uint_64> cen2(n), sal2(n);
+  for (int i = 0; i < n; i++) {
+    cen2[i] = (vxl_uint_64(rng.lrand32()) << 32) | rng.lrand32();
+    sal2[i] = (vxl_uint_64(rng.lrand32()) << 32) | rng.lrand32();
+  }
+  cen2[3] = ~vxl_uint_64(0);
+  sal2[3] = ~vxl_uint_64(0);
+  vxl_uint_64 cen = 0x0123456789abcdefULL, sal = 0x00ff00ff00ff00ffULL;
+  cen2[4] = cen;
+  std::vector<unsigned char> ham(n);
+  baml_census_hamming(cen, sal, &cen2[0], &sal2[0], n, &ham[0]);
+  bool good = true;
+  for (int i = 0; i < n; i++) {
+    vxl_uint_64 diff = baml_compute_diff_string(cen, cen2[i], sal, sal2[i]);
+    good = good && ham[i] == baml_compute_hamming_bk(diff) &&
+           baml_compute_hamming(diff) == baml_compute_hamming_bk(diff);
+  }
+  TEST("hamming distances", good, true);
+  TEST("hamming distance of all bits", ham[3], 32);
+  TEST("hamming distance of equal strings", ham[4], 0);
+}
+
+TESTMAIN(test_census);
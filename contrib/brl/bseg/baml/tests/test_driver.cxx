@@ -1,11 +1,13 @@
 #include "testlib/testlib_register.h"
 
 DECLARE( test_appearance );
+DECLARE( test_census );
 DECLARE( test_dem_appear );
 void
 register_tests()
 {
   REGISTER( test_appearance );
+  REGISTER( test_census );
   REGISTER( test_dem_appear );
 }
 
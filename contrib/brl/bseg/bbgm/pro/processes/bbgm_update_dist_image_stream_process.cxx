@@ -16,6 +16,7 @@
 #include "vil/vil_math.h"
 #include "vil/vil_convert.h"
 #include "vidl/vidl_istream_sptr.h"
+#include "vidl/vidl_pipelined_istream.h"
 #include "vidl/vidl_frame.h"
 #include "vidl/vidl_convert.h"
 #ifdef _MSC_VER
@@ -139,11 +140,13 @@ bool bbgm_update_dist_image_stream_process(bprb_func_process& pro)
                                                           window_size);
 
 
-  while (istr->advance() && (end_frame<0||(int)(istr->frame_number()) <= end_frame)) {
+  // Decode the next frames on another thread while this one is used.
+  // Closing the pipeline returns istr to the last frame used.
+  vidl_pipelined_istream pipe(istr);
+  while (pipe.advance() && (end_frame<0||(int)(pipe.frame_number()) <= end_frame)) {
     // get frame from stream
-    if ((int)(istr->frame_number()) >= start_frame) {
-      vidl_frame_sptr f = istr->current_frame();
-      vil_image_view_base_sptr fb = vidl_convert_wrap_in_view(*f);
+    if ((int)(pipe.frame_number()) >= start_frame) {
+      vil_image_view_base_sptr fb = pipe.current_view();
       if (!fb)
         return false;
       vil_image_view<float> frame = *vil_convert_cast(float(), fb);
@@ -151,7 +154,7 @@ bool bbgm_update_dist_image_stream_process(bprb_func_process& pro)
         vil_math_scale_values(frame,1.0/255.0);
 
       update(*model,frame,updater);
-      std::cout << "updated frame # "<< istr->frame_number()
+      std::cout << "updated frame # "<< pipe.frame_number()
                << " format " << fb->pixel_format() << " nplanes "
                << fb->nplanes()<< '\n';
       std::cout.flush();
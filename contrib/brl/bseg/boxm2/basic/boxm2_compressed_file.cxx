@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "boxm2_compressed_file.h"
+//:
+// \file
+#include <vpl/vpl_thread_pool.h>
+#if defined(HAS_ZLIB) && HAS_ZLIB
+#  include <zlib.h>
+#endif
+
+namespace
+{
+const char magic[4] = { 'B', 'X', 'Z', '1' };
+const std::size_t header_size = 32;
+const std::size_t max_chunk_size = std::size_t(1)<<30;
+
+//: the most zlib can take to compress len bytes (its compressBound)
+std::size_t packed_bound(std::size_t len)
+{
+  return len + (len >> 12) + (len >> 14) + (len >> 25) + 13;
+}
+
+struct chunk_layout
+{
+  std::uint32_t width;
+  std::uint64_t chunk_size;
+  std::uint64_t raw_length;
+  //: offset in the file of each chunk, and of the end
+  std::vector<std::size_t> offsets;
+};
+
+//: reads and checks the header and chunk table
+bool parse(const char* bytes, std::size_t len, chunk_layout& layout)
+{
+  if (!bytes || len < header_size || std::memcmp(bytes, magic, 4) != 0)
+    return false;
+  std::uint32_t chunk_size, reserved;
+  std::uint64_t n;
+  std::memcpy(&layout.width, bytes + 4, 4);
+  std::memcpy(&chunk_size, bytes + 8, 4);
+  std::memcpy(&reserved, bytes + 12, 4);
+  std::memcpy(&layout.raw_length, bytes + 16, 8);
+  std::memcpy(&n, bytes + 24, 8);
+  layout.chunk_size = chunk_size;
+  if (layout.width == 0 || chunk_size == 0 || chunk_size > max_chunk_size ||
+      chunk_size % layout.width != 0 || reserved != 0 ||
+      n > (len - header_size) / 8 ||
+      n != (layout.raw_length + chunk_size - 1) / chunk_size)
+    return false;
+  layout.offsets.resize(std::size_t(n) + 1);
+  std::size_t offset = header_size + std::size_t(n)*8;
+  for (std::size_t c = 0; c < n; ++c) {
+    layout.offsets[c] = offset;
+    std::uint64_t packed;
+    std::memcpy(&packed, bytes + header_size + 8*c, 8);
+    if (packed > len - offset)
+      return false;
+    // deflate neither grows a chunk past its bound nor shrinks it more than 1032 times
+    std::size_t clen = std::size_t(std::min<std::uint64_t>(chunk_size, layout.raw_length - c*chunk_size));
+    if (packed > packed_bound(clen) || clen > 1032*packed)
+      return false;
+    offset += std::size_t(packed);
+  }
+  layout.offsets[std::size_t(n)] = offset;
+  return offset == len;
+}
+
+//: gathers byte b of each element of a chunk together; a partial element at the end is copied as it is
+void shuffle(const char* in, std::size_t len, unsigned width, char* out)
+{
+  std::size_t n = len / width;
+  for (std::size_t e = 0; e < n; ++e)
+    for (unsigned b = 0; b < width; ++b)
+      out[b*n + e] = in[e*width + b];
+  std::memcpy(out + n*width, in + n*width, len - n*width);
+}
+
+void unshuffle(const char* in, std::size_t len, unsigned width, char* out)
+{
+  std::size_t n = len / width;
+  for (unsigned b = 0; b < width; ++b)
+    for (std::size_t e = 0; e < n; ++e)
+      out[e*width + b] = in[b*n + e];
+  std::memcpy(out + n*width, in + n*width, len - n*width);
+}
+}
+
+bool boxm2_compressed_file::is_compressed(const char* bytes, std::size_t len)
+{
+  chunk_layout layout;
+  return parse(bytes, len, layout);
+}
+
+std::size_t boxm2_compressed_file::raw_length(const char* bytes, std::size_t len)
+{
+  chunk_layout layout;
+  return parse(bytes, len, layout) ? std::size_t(layout.raw_length) : 0;
+}
+
+std::vector<char> boxm2_compressed_file::compress(const char* bytes, std::size_t len, unsigned elem_size,
+                                                  std::size_t chunk_size, int level)
+{
+#if defined(HAS_ZLIB) && HAS_ZLIB
+  unsigned width = std::max(elem_size, 1u);
+  chunk_size = std::min(chunk_size, max_chunk_size);
+  chunk_size = std::max<std::size_t>(width, chunk_size - chunk_size % width);
+  std::size_t n = (len + chunk_size - 1) / chunk_size;
+
+  std::vector<std::vector<char> > packed(n);
+  std::atomic<bool> ok(true);
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t c) {
+    std::size_t begin = c*chunk_size;
+    std::size_t clen = std::min(chunk_size, len - begin);
+    const char* src = bytes + begin;
+    std::vector<char> shuffled;
+    if (width > 1) {
+      shuffled.resize(clen);
+      shuffle(src, clen, width, shuffled.data());
+      src = shuffled.data();
+    }
+    uLongf dest_len = compressBound(uLong(clen));
+    packed[c].resize(dest_len);
+    if (compress2(reinterpret_cast<Bytef*>(packed[c].data()), &dest_len,
+                  reinterpret_cast<const Bytef*>(src), uLong(clen), level) != Z_OK)
+      ok = false;
+    packed[c].resize(dest_len);
+  }, std::size_t(1));
+  if (!ok)
+    return std::vector<char>();
+
+  std::size_t total = header_size + n*8;
+  for (auto const& p : packed)
+    total += p.size();
+  std::vector<char> file(total, 0);
+  std::uint32_t chunk32 = std::uint32_t(chunk_size);
+  std::uint64_t raw64 = len, n64 = n;
+  std::memcpy(&file[0], magic, 4);
+  std::memcpy(&file[4], &width, 4);
+  std::memcpy(&file[8], &chunk32, 4);
+  std::memcpy(&file[16], &raw64, 8);
+  std::memcpy(&file[24], &n64, 8);
+  std::size_t offset = header_size + n*8;
+  for (std::size_t c = 0; c < n; ++c) {
+    std::uint64_t size = packed[c].size();
+    std::memcpy(&file[header_size + 8*c], &size, 8);
+    std::copy(packed[c].begin(), packed[c].end(), file.begin() + offset);
+    offset += packed[c].size();
+  }
+  return file;
+#else
+  (void)bytes; (void)len; (void)elem_size; (void)chunk_size; (void)level;
+  std::cerr << "boxm2_compressed_file: compression needs zlib\n";
+  return std::vector<char>();
+#endif
+}
+
+bool boxm2_compressed_file::decompress(const char* bytes, std::size_t len, char* raw)
+{
+  chunk_layout layout;
+  if (!parse(bytes, len, layout))
+    return false;
+#if defined(HAS_ZLIB) && HAS_ZLIB
+  std::size_t n = layout.offsets.size() - 1;
+  std::atomic<bool> ok(true);
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t c) {
+    std::size_t begin = c*std::size_t(layout.chunk_size);
+    std::size_t clen = std::min(std::size_t(layout.chunk_size), std::size_t(layout.raw_length) - begin);
+    std::vector<char> shuffled;
+    char* dest = raw + begin;
+    if (layout.width > 1) {
+      shuffled.resize(clen);
+      dest = shuffled.data();
+    }
+    uLongf dest_len = uLongf(clen);
+    if (uncompress(reinterpret_cast<Bytef*>(dest), &dest_len,
+                   reinterpret_cast<const Bytef*>(bytes + layout.offsets[c]),
+                   uLong(layout.offsets[c+1] - layout.offsets[c])) != Z_OK || dest_len != clen) {
+      ok = false;
+      return;
+    }
+    if (layout.width > 1)
+      unshuffle(dest, clen, layout.width, raw + begin);
+  }, std::size_t(1));
+  return ok;
+#else
+  (void)raw;
+  std::cerr << "boxm2_compressed_file: decompression needs zlib\n";
+  return false;
+#endif
+}
+
+bool boxm2_compressed_file::expand(char*& bytes, std::size_t& len)
+{
+  if (!is_compressed(bytes, len))
+    return true;
+  std::size_t raw_len = raw_length(bytes, len);
+  char* raw = new char[raw_len];
+  if (!decompress(bytes, len, raw)) {
+    std::cerr << "boxm2_compressed_file: cannot decompress a file of " << len << " bytes\n";
+    delete [] raw;
+    return false;
+  }
+  delete [] bytes;
+  bytes = raw;
+  len = raw_len;
+  return true;
+}
+
+bool boxm2_compressed_file::write(std::string const& path, const char* bytes, std::size_t len, unsigned elem_size,
+                                  std::size_t chunk_size, int level)
+{
+  std::vector<char> file = compress(bytes, len, elem_size, chunk_size, level);
+  if (file.empty())
+    return false;
+  std::ofstream os(path.c_str(), std::ios::out | std::ios::binary);
+  os.write(file.data(), std::streamsize(file.size()));
+  return bool(os);
+}
@@ -0,0 +1,68 @@
+#ifndef boxm2_compressed_file_h_
+#define boxm2_compressed_file_h_
+//:
+// \file
+// \brief Chunked zlib compression of block and data files (boxm2 and bstm)
+//
+//  A compressed file keeps the name of the file it replaces, and starts
+//  with a header the readers (boxm2_sio_mgr, boxm2_asio_mgr,
+//  boxm2_mmap_cache, bstm_sio_mgr) recognise, so they expand it as it
+//  is read; other files are read as they are.  A file is only taken as
+//  compressed if its whole header and chunk table are consistent with its
+//  size, so a raw file which happens to start with the magic is still read
+//  raw.
+//
+//  The data is split in chunks which are compressed independently, so
+//  they are compressed and decompressed in parallel.  Before compressing,
+//  the bytes of each chunk are shuffled so that byte b of all its elements
+//  come together; for float data the exponent bytes, which hardly change
+//  from cell to cell, then make long runs zlib compresses well.
+//
+//  Layout, in native byte order:
+//  \verbatim
+//    char[4]   magic "BXZ1"
+//    uint32    shuffle width (element size in bytes, 1 for no shuffle)
+//    uint32    chunk size (bytes of data per chunk, a multiple of the width)
+//    uint32    reserved (0)
+//    uint64    data length
+//    uint64    number of chunks n
+//    uint64[n] compressed length of each chunk
+//    the compressed chunks, one after the other
+//  \endverbatim
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class boxm2_compressed_file
+{
+ public:
+  enum { default_chunk_size = 1<<20 };
+
+  //: true if the bytes are a compressed file
+  //  The header fields and the chunk table must be valid, and account for
+  //  all len bytes; the chunks themselves are not decompressed.
+  static bool is_compressed(const char* bytes, std::size_t len);
+
+  //: length of the data a compressed file holds, 0 if the header is not valid
+  static std::size_t raw_length(const char* bytes, std::size_t len);
+
+  //: compresses len bytes of elements elem_size bytes long; returns the file contents
+  //  Returns an empty vector if zlib is not available.
+  static std::vector<char> compress(const char* bytes, std::size_t len, unsigned elem_size = 1,
+                                    std::size_t chunk_size = default_chunk_size, int level = 6);
+
+  //: decompresses a compressed file into raw, which holds raw_length() bytes
+  static bool decompress(const char* bytes, std::size_t len, char* raw);
+
+  //: replaces a buffer (new[]) read from a compressed file by the data it holds
+  //  Buffers for which is_compressed() is false are left as they are.
+  //  Returns false, leaving the buffer as it is, if a compressed file cannot be decompressed.
+  static bool expand(char*& bytes, std::size_t& len);
+
+  //: writes a compressed file
+  static bool write(std::string const& path, const char* bytes, std::size_t len, unsigned elem_size = 1,
+                    std::size_t chunk_size = default_chunk_size, int level = 6);
+};
+
+#endif // boxm2_compressed_file_h_
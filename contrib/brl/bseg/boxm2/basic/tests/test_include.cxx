@@ -2,5 +2,6 @@
 #include <boxm2/basic/boxm2_array_2d.h>
 #include <boxm2/basic/boxm2_array_3d.h>
 #include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
 
 int main() { return 0; }
@@ -70,6 +70,8 @@ class boxm2_block : public vbl_ref_count
   //: accessors
   boxm2_block_id&           block_id()          { return block_id_; }         //somehow make this a const return..
   char*                     buffer()            { return buffer_; }
+  //: gives up ownership of the byte buffer (e.g. when it is a mapped file); the trees stay in it
+  char*                     release_buffer()    { char* b = buffer_; buffer_ = nullptr; return b; }
 // User has only write access to a copy of the current trees  via trees_copy(); Use the set_trees method to put them back in the block
 // this way, n_cells_ will always remain up to date.
   const boxm2_array_3d<uchar16>&  trees()       { return trees_; }
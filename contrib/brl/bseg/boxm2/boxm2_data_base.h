@@ -47,6 +47,9 @@ class boxm2_data_base : public vbl_ref_count
     //: accessor to a portion of the byte buffer
     char *            cell_buffer(int i, std::size_t cell_size);
 
+    //: gives up ownership of the byte buffer (e.g. when it is a mapped file)
+    char *            release_buffer() { char* b = data_buffer_; data_buffer_ = nullptr; return b; }
+
     //: setter for swapping out data buffer
 
     //: by default data is read-only, i.e. cache doesn't save it before destroying it
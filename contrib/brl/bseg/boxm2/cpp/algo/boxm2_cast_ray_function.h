@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstddef>
+#include <vector>
 #include <vgl/vgl_ray_3d.h>
 
 #include <cassert>
@@ -20,6 +22,8 @@
 #  include <vcl_msvc_warnings.h>
 #endif
 #include <vpgl/vpgl_generic_camera.h>
+#include <vpgl/vpgl_perspective_camera.h>
+#include <vpl/vpl_thread_pool.h>
 
 #define BLOCK_EPSILON .006125f
 #define TREE_EPSILON  .005f
@@ -207,5 +211,108 @@ bool cast_ray_per_block(functor_type functor,
   return false;
 }
 
+//: Cast the rays of the pixels in [i0,i1) x [j0,j1), columns outermost
+//  One of gcam and pcam is the camera, the other is null.
+template <class functor_type>
+void boxm2_cast_rays_in_box(functor_type const& functor,
+                            boxm2_scene_info * linfo,
+                            boxm2_block * blk_sptr,
+                            vpgl_generic_camera<double> const* gcam,
+                            vpgl_perspective_camera<double> const* pcam,
+                            unsigned i0, unsigned i1,
+                            unsigned j0, unsigned j1)
+{
+  for (unsigned i=i0;i<i1;++i)
+  {
+    for (unsigned j=j0;j<j1;++j)
+    {
+      vgl_ray_3d<double> ray_ij = gcam ? gcam->ray(i,j) : vgl_ray_3d<double>(pcam->backproject(i,j));
+      boxm2_cast_ray_function<functor_type>(ray_ij,linfo,blk_sptr,i,j,functor);
+    }
+  }
+}
+
+//: Get the camera as one of the types the rays can be cast from
+//  The perspective camera caches its svd on first use, so it is computed
+//  here, before the camera is shared between threads.
+inline bool boxm2_cast_ray_camera(vpgl_camera_double_sptr const& cam,
+                                  vpgl_generic_camera<double> const*& gcam,
+                                  vpgl_perspective_camera<double> const*& pcam)
+{
+  gcam = dynamic_cast<vpgl_generic_camera<double>*>(cam.ptr());
+  pcam = nullptr;
+  if (gcam)
+    return true;
+  if (cam->type_name()== "vpgl_perspective_camera") {
+    pcam = (vpgl_perspective_camera<double>*) cam.ptr();
+    pcam->svd();
+    return true;
+  }
+  std::cout<<"boxm2_cast_ray_function cannot dynamic cast camera"<<std::endl;
+  return false;
+}
+
+//: Cast rays with a functor which adds up values in the cells, in parallel.
+//  The columns of the image are split into bands of 64, which are cast a
+//  few at a time, as many as there are threads.  The first band adds to
+//  \p cells, as cast_ray_per_block would; each of the others adds to a
+//  zeroed copy of the n_cells values (which is given to a copy of the
+//  functor with set_accumulator).  The copies are added to \p cells in band
+//  order, so the result does not depend on the number of threads, nor on
+//  their scheduling.
+//  Each thread but one needs n_cells values of memory.
+template <class functor_type, class T>
+bool cast_ray_per_block_accumulate(functor_type functor,
+                                   T * cells,
+                                   std::size_t n_cells,
+                                   boxm2_scene_info * linfo,
+                                   boxm2_block * blk_sptr,
+                                   vpgl_camera_double_sptr cam ,
+                                   unsigned int roi_ni,
+                                   unsigned int roi_nj,
+                                   unsigned int roi_ni0=0,
+                                   unsigned int roi_nj0=0)
+{
+  vpgl_generic_camera<double> const* gcam;
+  vpgl_perspective_camera<double> const* pcam;
+  if (!boxm2_cast_ray_camera(cam, gcam, pcam))
+    return false;
+  if (roi_ni <= roi_ni0 || roi_nj <= roi_nj0)
+    return true;
+
+  const unsigned band_width = 64;
+  unsigned n_bands = (roi_ni-roi_ni0+band_width-1)/band_width;
+  unsigned n_at_once = std::max(1u, std::min(vpl_concurrency(), n_bands));
+  std::vector<std::vector<T> > partial(n_at_once);
+  for (unsigned b0=0; b0<n_bands; b0+=n_at_once)
+  {
+    unsigned b1 = std::min(n_bands, b0+n_at_once);
+    vpl_parallel_for(b0, b1, [&](unsigned b)
+    {
+      functor_type band_functor = functor;
+      if (b > 0) {
+        partial[b-b0].assign(n_cells, T(0.0f));
+        band_functor.set_accumulator(&partial[b-b0][0]);
+      }
+      else
+        band_functor.set_accumulator(cells);
+      unsigned i0 = roi_ni0 + b*band_width;
+      unsigned i1 = std::min(roi_ni, i0+band_width);
+      boxm2_cast_rays_in_box(band_functor,linfo,blk_sptr,gcam,pcam,i0,i1,roi_nj0,roi_nj);
+    }, 1u);
+
+    unsigned first = std::max(b0, 1u);
+    if (first >= b1)
+      continue;
+    vpl_parallel_for_range(std::size_t(0), n_cells, [&](std::size_t c0, std::size_t c1)
+    {
+      for (unsigned b=first; b<b1; ++b)
+        for (std::size_t c=c0;c<c1;++c)
+          cells[c] += partial[b-b0][c];
+    });
+  }
+  return true;
+}
+
 
 #endif // boxm2_cast_ray_function_h_
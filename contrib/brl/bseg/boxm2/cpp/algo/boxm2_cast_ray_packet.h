@@ -0,0 +1,284 @@
+#ifndef boxm2_cast_ray_packet_h_
+#define boxm2_cast_ray_packet_h_
+//:
+// \file
+// \brief Cast bundles of neighbouring camera rays through a block together
+//
+//  The rays of a packet of up to 8x8 pixels are set up together: their
+//  entry and exit of the block are found four at a time with SSE2 where it
+//  is available, and rays which miss the block are dropped before the walk.
+//  The rays then walk the block one after another, so each functor sees the
+//  same step_cell calls, with the same values, as with boxm2_cast_ray_function.
+//  What the rays of a packet share is the decoding of the trees they pass
+//  through: the data index of a cell is found from the tree bits once per
+//  packet rather than once per ray.  Packets whose rays do not all point
+//  into the same octant are cast one ray at a time.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <vil/vil_config.h>
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+#  include <emmintrin.h>
+#endif
+#include <boxm2/cpp/algo/boxm2_cast_ray_function.h>
+
+//: Data indices of the cells of the trees visited by a packet of rays
+class boxm2_packet_tree_cache
+{
+ public:
+  typedef vnl_vector_fixed<unsigned char, 16> uchar16;
+
+  boxm2_packet_tree_cache(int num_levels)
+  : num_levels_(num_levels), num_cells_(((1<<(3*num_levels))-1)/7),
+    trees_(num_entries, nullptr), data_index_(num_entries*num_cells_)
+  {
+    for (int d=0; d<4; ++d)
+      cell_len_[d] = std::pow((float)2,(float)-d);
+  }
+
+  //: The data index of cell bit_index of tree
+  int data_index(const uchar16* tree, int bit_index)
+  {
+    std::size_t key = reinterpret_cast<std::size_t>(tree) / sizeof(uchar16);
+    std::size_t e = (key * 2654435761u) % num_entries;
+    int* indices = &data_index_[e*num_cells_];
+    if (trees_[e] != tree) {
+      trees_[e] = tree;
+      std::fill(indices, indices+num_cells_, -1);
+    }
+    int& index = indices[bit_index];
+    if (index < 0)
+      index = boct_bit_tree(const_cast<unsigned char*>(tree->data_block()),num_levels_).get_data_index(bit_index);
+    return index;
+  }
+
+  //: Side of a cell at depth in a tree of side 1
+  float cell_len(int depth) const { return cell_len_[depth]; }
+
+ private:
+  enum { num_entries = 61 };
+  int num_levels_;
+  int num_cells_;
+  std::vector<const uchar16*> trees_;
+  std::vector<int> data_index_;
+  float cell_len_[4];
+};
+
+//: Walk one ray, set up by boxm2_cast_ray_packet, through the block
+//  The same steps as boxm2_cast_ray_function, with the data indices from
+//  the cache.
+template <class F>
+void boxm2_walk_packet_ray(float ray_ox, float ray_oy, float ray_oz,
+                           float ray_dx, float ray_dy, float ray_dz,
+                           float tblock, float tfar,
+                           boxm2_scene_info * linfo,
+                           boxm2_block * blk_sptr,
+                           boxm2_packet_tree_cache& cache,
+                           unsigned i, unsigned j,
+                           F& functor)
+{
+  typedef vnl_vector_fixed<unsigned char, 16> uchar16;
+  while (tblock < tfar)
+  {
+    float posx = (ray_ox + (tblock + TREE_EPSILON)*ray_dx);
+    float posy = (ray_oy + (tblock + TREE_EPSILON)*ray_dy);
+    float posz = (ray_oz + (tblock + TREE_EPSILON)*ray_dz);
+
+    float cell_minx = boxm2_util::clamp(std::floor(posx), 0.0f, linfo->scene_dims[0]-1.0f);
+    float cell_miny = boxm2_util::clamp(std::floor(posy), 0.0f, linfo->scene_dims[1]-1.0f);
+    float cell_minz = boxm2_util::clamp(std::floor(posz), 0.0f, linfo->scene_dims[2]-1.0f);
+
+    const uchar16* tree = &blk_sptr->trees()((unsigned short)cell_minx,(unsigned short)cell_miny,(unsigned short)cell_minz);
+    boct_bit_tree bit_tree(const_cast<unsigned char*>(tree->data_block()),linfo->root_level+1);
+
+    float lrayx = (posx - cell_minx);
+    float lrayy = (posy - cell_miny);
+    float lrayz = (posz - cell_minz);
+
+    cell_minx = (ray_dx > 0) ? cell_minx+1.0f : cell_minx;
+    cell_miny = (ray_dy > 0) ? cell_miny+1.0f : cell_miny;
+    cell_minz = (ray_dz > 0) ? cell_minz+1.0f : cell_minz;
+    float texit = std::min(std::min( (cell_minx-ray_ox)*(1.0f/ray_dx), (cell_miny-ray_oy)*(1.0f/ray_dy)), (cell_minz-ray_oz)*(1.0f/ray_dz));
+    if (texit <= tblock) break;
+
+    texit = (texit - tblock - BLOCK_EPSILON);
+    float ttree = 0.0f;
+    while (ttree < texit)
+    {
+      posx = (lrayx + (ttree + TREE_EPSILON)*ray_dx);
+      posy = (lrayy + (ttree + TREE_EPSILON)*ray_dy);
+      posz = (lrayz + (ttree + TREE_EPSILON)*ray_dz);
+
+      int bit_index=bit_tree.traverse(vgl_point_3d<double>(posx,posy,posz));
+      float cell_len=cache.cell_len(bit_tree.depth_at(bit_index));
+
+      cell_minx=std::floor(posx/cell_len)* cell_len;
+      cell_miny=std::floor(posy/cell_len)* cell_len;
+      cell_minz=std::floor(posz/cell_len)* cell_len;
+
+      cell_minx = (ray_dx > 0.0f) ? cell_minx+cell_len : cell_minx;
+      cell_miny = (ray_dy > 0.0f) ? cell_miny+cell_len : cell_miny;
+      cell_minz = (ray_dz > 0.0f) ? cell_minz+cell_len : cell_minz;
+      float t1 = std::min(std::min( (cell_minx-lrayx)*(1.0f/ray_dx), (cell_miny-lrayy)*(1.0f/ray_dy)), (cell_minz-lrayz)*(1.0f/ray_dz));
+
+      if (t1 <= ttree) break;
+
+      float d = (t1-ttree) * linfo->block_len;
+      ttree = t1;
+
+      functor.step_cell(d,cache.data_index(tree,bit_index),i,j, (ttree + tblock ) * linfo->block_len);
+    }
+
+    texit = texit + tblock + BLOCK_EPSILON;
+    tblock = texit;
+  }
+}
+
+//: Cast the rays of the pixels in [i0,i1) x [j0,j1), at most 8x8, through the block
+//  One of gcam and pcam is the camera, the other is null.
+template <class F>
+void boxm2_cast_ray_packet(F const& functor,
+                           boxm2_scene_info * linfo,
+                           boxm2_block * blk_sptr,
+                           vpgl_generic_camera<double> const* gcam,
+                           vpgl_perspective_camera<double> const* pcam,
+                           boxm2_packet_tree_cache& cache,
+                           unsigned i0, unsigned i1,
+                           unsigned j0, unsigned j1)
+{
+  // the rays in block coordinates, as in boxm2_cast_ray_function
+  const unsigned max_rays = 64;
+  float ox[max_rays], oy[max_rays], oz[max_rays], dx[max_rays], dy[max_rays], dz[max_rays];
+  unsigned n = 0;
+  const float thresh = std::exp(-12.0f);
+  int sign[3] = {0, 0, 0};
+  bool coherent = true;
+  for (unsigned i=i0;i<i1;++i)
+  {
+    for (unsigned j=j0;j<j1;++j, ++n)
+    {
+      vgl_ray_3d<double> ray_ij = gcam ? gcam->ray(i,j) : vgl_ray_3d<double>(pcam->backproject(i,j));
+      vgl_point_3d<float> block_origin(float(ray_ij.origin().x()-linfo->scene_origin[0])/linfo->block_len,
+                                       float(ray_ij.origin().y()-linfo->scene_origin[1])/linfo->block_len,
+                                       float(ray_ij.origin().z()-linfo->scene_origin[2])/linfo->block_len);
+      float d[3] = { float(ray_ij.direction().x()), float(ray_ij.direction().y()), float(ray_ij.direction().z()) };
+      for (float& dk : d)
+        if (std::fabs(dk) < thresh) dk = (dk>0)?thresh:-thresh;
+      vgl_ray_3d<float> ray(block_origin,vgl_vector_3d<float>(d[0],d[1],d[2]));
+      ox[n] = ray.origin().x(); oy[n] = ray.origin().y(); oz[n] = ray.origin().z();
+      dx[n] = ray.direction().x(); dy[n] = ray.direction().y(); dz[n] = ray.direction().z();
+      const float dn[3] = { dx[n], dy[n], dz[n] };
+      for (int k=0; k<3; ++k) {
+        int s = dn[k] > 0.0f ? 1 : -1;
+        if (n == 0) sign[k] = s;
+        coherent = coherent && s == sign[k];
+      }
+    }
+  }
+  if (!coherent) {
+    boxm2_cast_rays_in_box(functor,linfo,blk_sptr,gcam,pcam,i0,i1,j0,j1);
+    return;
+  }
+
+  // entry and exit of the scene.  All rays point into the same octant, so
+  // they leave through the same faces.
+  float max_facex = (sign[0] > 0) ? (linfo->scene_dims[0]) : 0.0f;
+  float max_facey = (sign[1] > 0) ? (linfo->scene_dims[1]) : 0.0f;
+  float max_facez = (sign[2] > 0) ? (linfo->scene_dims[2]) : 0.0f;
+  float min_facex = (sign[0] < 0) ? (linfo->scene_dims[0]) : 0.0f;
+  float min_facey = (sign[1] < 0) ? (linfo->scene_dims[1]) : 0.0f;
+  float min_facez = (sign[2] < 0) ? (linfo->scene_dims[2]) : 0.0f;
+  float tfar[max_rays], tblock[max_rays];
+  unsigned k = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  // std::min(a,b) is _mm_min_ps(b,a) and std::max(a,b) is _mm_max_ps(b,a),
+  // which keeps the results the same as the scalar code
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; k + 4 <= n; k += 4) {
+    __m128 rox = _mm_loadu_ps(ox+k), roy = _mm_loadu_ps(oy+k), roz = _mm_loadu_ps(oz+k);
+    __m128 idx = _mm_div_ps(one, _mm_loadu_ps(dx+k));
+    __m128 idy = _mm_div_ps(one, _mm_loadu_ps(dy+k));
+    __m128 idz = _mm_div_ps(one, _mm_loadu_ps(dz+k));
+    __m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_facex), rox), idx);
+    __m128 fy = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_facey), roy), idy);
+    __m128 fz = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_facez), roz), idz);
+    _mm_storeu_ps(tfar+k, _mm_min_ps(fz, _mm_min_ps(fy, fx)));
+    __m128 nx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min_facex), rox), idx);
+    __m128 ny = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min_facey), roy), idy);
+    __m128 nz = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min_facez), roz), idz);
+    _mm_storeu_ps(tblock+k, _mm_max_ps(nz, _mm_max_ps(ny, nx)));
+  }
+#endif
+  for (; k < n; ++k) {
+    tfar[k] = std::min(std::min( (max_facex-ox[k])*(1.0f/dx[k]), (max_facey-oy[k])*(1.0f/dy[k])), (max_facez-oz[k])*(1.0f/dz[k]));
+    tblock[k] = std::max(std::max( (min_facex-ox[k])*(1.0f/dx[k]), (min_facey-oy[k])*(1.0f/dy[k])), (min_facez-oz[k])*(1.0f/dz[k]));
+  }
+
+  n = 0;
+  for (unsigned i=i0;i<i1;++i)
+  {
+    for (unsigned j=j0;j<j1;++j, ++n)
+    {
+      if (tfar[n] <= tblock[n] || tfar[n] < 0)
+        continue;
+      float tnear = (tblock[n] > 0.0f) ? tblock[n] : 0.0f;
+      F ray_functor = functor;
+      boxm2_walk_packet_ray(ox[n],oy[n],oz[n],dx[n],dy[n],dz[n],
+                            tnear,tfar[n]-BLOCK_EPSILON,
+                            linfo,blk_sptr,cache,i,j,ray_functor);
+    }
+  }
+}
+
+//: Cast the rays of the pixels in [i0,i1) x [j0,j1) in packets of 8x8
+//  Packets are taken column by column, and the rays within a packet too.
+template <class F>
+void boxm2_cast_ray_packets_in_box(F const& functor,
+                                   boxm2_scene_info * linfo,
+                                   boxm2_block * blk_sptr,
+                                   vpgl_generic_camera<double> const* gcam,
+                                   vpgl_perspective_camera<double> const* pcam,
+                                   unsigned i0, unsigned i1,
+                                   unsigned j0, unsigned j1)
+{
+  boxm2_packet_tree_cache cache(linfo->root_level+1);
+  for (unsigned pi=i0; pi<i1; pi+=8)
+    for (unsigned pj=j0; pj<j1; pj+=8)
+      boxm2_cast_ray_packet(functor,linfo,blk_sptr,gcam,pcam,cache,
+                            pi,std::min(pi+8,i1),pj,std::min(pj+8,j1));
+}
+
+//: Same as cast_ray_per_block, but the image is cut into tiles which are cast in parallel.
+//  The tiles are cast in packets.  The functor must only write to state
+//  belonging to pixel (i,j), e.g. the vis and expected images of the render
+//  functors, and not to the cells, as the rays are not cast in the order of
+//  cast_ray_per_block.
+template <class functor_type>
+bool cast_ray_per_block_parallel(functor_type functor,
+                                 boxm2_scene_info * linfo,
+                                 boxm2_block * blk_sptr,
+                                 vpgl_camera_double_sptr cam ,
+                                 unsigned int roi_ni,
+                                 unsigned int roi_nj,
+                                 unsigned int roi_ni0=0,
+                                 unsigned int roi_nj0=0)
+{
+  vpgl_generic_camera<double> const* gcam;
+  vpgl_perspective_camera<double> const* pcam;
+  if (!boxm2_cast_ray_camera(cam, gcam, pcam))
+    return false;
+  if (roi_ni <= roi_ni0 || roi_nj <= roi_nj0)
+    return true;
+
+  vpl_parallel_for_2d(roi_ni-roi_ni0, roi_nj-roi_nj0,
+                      [&](unsigned i0, unsigned i1, unsigned j0, unsigned j1)
+  {
+    boxm2_cast_ray_packets_in_box(functor,linfo,blk_sptr,gcam,pcam,
+                                  roi_ni0+i0,roi_ni0+i1,roi_nj0+j0,roi_nj0+j1);
+  }, 32, 32);
+  return true;
+}
+
+#endif // boxm2_cast_ray_packet_h_
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <list>
+#include <vector>
 #include "boxm2_merge_block_function.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
@@ -7,6 +8,7 @@
 
 //:
 // \file
+#include <vpl/vpl_thread_pool.h>
 
 //: initialize generic data base pointers as their data type
 bool boxm2_merge_block_function::init_data(boxm2_block* blk, std::vector<boxm2_data_base*>& datas, float prob_thresh)
@@ -172,10 +174,66 @@ bool boxm2_merge_block_function::merge(std::vector<boxm2_data_base*>& datas)
   cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_MOG3_GREY>::prefix(), newM);
   cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_NUM_OBS>::prefix(), newN);
 
+  delete [] trees_copy;
   delete [] dataIndex;
   return true;
 }
 
+bool boxm2_merge_block_function::merge_parallel(std::vector<boxm2_data_base*>& datas)
+{
+  boxm2_array_3d<uchar16> trees = blk_->trees_copy();
+  uchar16* tree_bits = trees.data_block();
+  const std::size_t n = trees.size();
+  const std::size_t grain = 256;
+
+  //1. merge each tree, and count its cells
+  std::vector<uchar16> merged(n);
+  std::vector<int> dataIndex(n+1, 0);
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t t) {
+    uchar16 tree = tree_bits[t];
+    boct_bit_tree curr_tree( (unsigned char*) tree.data_block(), max_level_);
+    boct_bit_tree merged_tree = this->merge_bit_tree(curr_tree, alpha_, prob_thresh_);
+    std::memcpy(merged[t].data_block(), merged_tree.get_bits(), 16);
+    dataIndex[t+1] = merged_tree.num_cells();
+  }, grain);
+
+  //2. the data of each tree starts after that of the trees before it
+  for (std::size_t t = 0; t < n; ++t)
+    dataIndex[t+1] += dataIndex[t];
+  int dataSize = dataIndex[n];
+
+  boxm2_block_id id = datas[0]->block_id();
+  boxm2_data_base* newA = new boxm2_data_base(new char[dataSize * sizeof(float) ], dataSize * sizeof(float), id);
+  boxm2_data_base* newM = new boxm2_data_base(new char[dataSize * sizeof(uchar8)], dataSize * sizeof(uchar8), id);
+  boxm2_data_base* newN = new boxm2_data_base(new char[dataSize * sizeof(ushort4)], dataSize * sizeof(ushort4), id);
+  auto*   alpha_cpy = (float*) newA->data_buffer();
+  auto*  mog_cpy   = (uchar8*) newM->data_buffer();
+  auto* num_obs_cpy = (ushort4*) newN->data_buffer();
+
+  //3. move the data of each tree to its new place, and put the merged tree in the block
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t t) {
+    boct_bit_tree old_tree( (unsigned char*) tree_bits[t].data_block(), max_level_);
+    boct_bit_tree merged_tree( (unsigned char*) merged[t].data_block(), max_level_);
+    int root_index = dataIndex[t];
+    merged_tree.set_data_ptr(root_index, false); //is not random
+    int old_root_index = old_tree.get_data_ptr();
+    this->move_data(old_tree, merged_tree,
+                    alpha_ + old_root_index, mog_ + old_root_index, num_obs_ + old_root_index,
+                    alpha_cpy + root_index, mog_cpy + root_index, num_obs_cpy + root_index);
+    tree_bits[t] = merged[t];
+  }, grain);
+  blk_->set_trees(trees);
+  std::cout<<"Parallel merge of "<<n<<" trees on "<<vpl_concurrency()<<" threads: "
+           <<merge_count_<<" merged cells, "<<dataSize<<" cells"<<std::endl;
+
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_ALPHA>::prefix(), newA);
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_MOG3_GREY>::prefix(), newM);
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_NUM_OBS>::prefix(), newN);
+
+  return true;
+}
+
 /////////////////////////////////////////////////////////////////
 ////Refine Tree (refines local tree)
 ////Depth first search iteration of the tree (keeping track of node level)
@@ -186,8 +244,8 @@ bool boxm2_merge_block_function::merge(std::vector<boxm2_data_base*>& datas)
 /////////////////////////////////////////////////////////////////
 boct_bit_tree boxm2_merge_block_function::merge_bit_tree(boct_bit_tree& unrefined_tree, const float* alphas, float prob_thresh)
 {
-  //initialize tree to return
-  boct_bit_tree merged_tree(unrefined_tree.get_bits(), max_level_);
+  //initialize tree to return (a copy: the tree looked at must not change as it is merged)
+  boct_bit_tree merged_tree(const_cast<const unsigned char*>(unrefined_tree.get_bits()), max_level_);
 
   //it can't be merged if it's a root
   if (merged_tree.bit_at(0) == 0)
@@ -336,3 +394,13 @@ void boxm2_merge_block( const boxm2_scene_sptr& scene,
   merge_block.init_data(blk, datas, prob_thresh);
   merge_block.merge(datas);
 }
+
+void boxm2_merge_block_parallel( const boxm2_scene_sptr& scene,
+                                 boxm2_block* blk,
+                                 std::vector<boxm2_data_base*> & datas,
+                                 float prob_thresh)
+{
+  boxm2_merge_block_function merge_block(scene);
+  merge_block.init_data(blk, datas, prob_thresh);
+  merge_block.merge_parallel(datas);
+}
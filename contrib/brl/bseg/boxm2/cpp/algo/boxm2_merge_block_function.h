@@ -3,6 +3,7 @@
 //:
 // \file
 
+#include <atomic>
 #include <iostream>
 #include <boxm2/boxm2_data_traits.h>
 #include <boct/boct_bit_tree.h>
@@ -34,6 +35,12 @@ class boxm2_merge_block_function
   //: refine function;
   bool merge(std::vector<boxm2_data_base*>& datas);
 
+  //: merge the trees on several threads, with the same result as merge
+  //  As boxm2_refine_block_function::refine_parallel, the trees are merged
+  //  and counted in parallel, then their data is moved in parallel to the
+  //  offsets given by a prefix sum of the counts.
+  bool merge_parallel(std::vector<boxm2_data_base*>& datas);
+
   //: refine bit tree
   boct_bit_tree merge_bit_tree(boct_bit_tree& curr_tree, const float* alphas, float prob_thresh);
 
@@ -49,7 +56,7 @@ class boxm2_merge_block_function
 
  private:
   boxm2_scene_sptr scene_;
-  int          merge_count_;
+  std::atomic<int> merge_count_;
   boxm2_block* blk_;
   const uchar16*     trees_;
 
@@ -82,4 +89,10 @@ void boxm2_merge_block( const boxm2_scene_sptr& scene,
                         float prob_thresh,
                         bool is_random = true);
 
+//: merges a block with boxm2_merge_block_function::merge_parallel
+void boxm2_merge_block_parallel( const boxm2_scene_sptr& scene,
+                                 boxm2_block* blk,
+                                 std::vector<boxm2_data_base*> & datas,
+                                 float prob_thresh);
+
 #endif // boxm2_merge_block_function_h
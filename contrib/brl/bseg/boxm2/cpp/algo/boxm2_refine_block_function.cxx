@@ -1,6 +1,8 @@
+#include <vector>
 #include "boxm2_refine_block_function.h"
 //:
 // \file
+#include <vpl/vpl_thread_pool.h>
 
 #define copy_parent_data_ 1
 
@@ -137,6 +139,8 @@ bool boxm2_refine_block_function::refine_deterministic(std::vector<boxm2_data_ba
   }
   blk_->set_trees(trees);
   std::cout<<"Number of new cells: "<<newInitCount<<std::endl;
+  delete [] trees_copy;
+  delete [] dataIndex;
 
   //3. Replace data in the cache
   boxm2_cache_sptr cache = boxm2_cache::instance();
@@ -147,6 +151,58 @@ bool boxm2_refine_block_function::refine_deterministic(std::vector<boxm2_data_ba
   return true;
 }
 
+bool boxm2_refine_block_function::refine_parallel(std::vector<boxm2_data_base*>& datas)
+{
+  boxm2_array_3d<uchar16> trees = blk_->trees_copy();
+  uchar16* tree_bits = trees.data_block();
+  const std::size_t n = trees.size();
+  const std::size_t grain = 256;
+
+  //1. refine each tree, and count its cells
+  std::vector<uchar16> refined(n);
+  std::vector<int> dataIndex(n+1, 0);
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t t) {
+    uchar16 tree = tree_bits[t];
+    boct_bit_tree curr_tree( (unsigned char*) tree.data_block(), max_level_);
+    boct_bit_tree refined_tree = this->refine_bit_tree(curr_tree, 0, false);
+    std::memcpy(refined[t].data_block(), refined_tree.get_bits(), 16);
+    dataIndex[t+1] = refined_tree.num_cells();
+  }, grain);
+
+  //2. the data of each tree starts after that of the trees before it
+  for (std::size_t t = 0; t < n; ++t)
+    dataIndex[t+1] += dataIndex[t];
+  int dataSize = dataIndex[n];
+
+  boxm2_block_id id = datas[0]->block_id();
+  boxm2_data_base* newA = new boxm2_data_base(new char[dataSize * sizeof(float) ], dataSize * sizeof(float), id);
+  boxm2_data_base* newM = new boxm2_data_base(new char[dataSize * sizeof(uchar8)], dataSize * sizeof(uchar8), id);
+  boxm2_data_base* newN = new boxm2_data_base(new char[dataSize * sizeof(ushort4)], dataSize * sizeof(ushort4), id);
+  auto*   alpha_cpy = (float*) newA->data_buffer();
+  auto*  mog_cpy   = (uchar8*) newM->data_buffer();
+  auto* num_obs_cpy = (ushort4*) newN->data_buffer();
+
+  //3. move the data of each tree to its new place, and put the refined tree in the block
+  std::atomic<int> newInitCount(0);
+  vpl_parallel_for(std::size_t(0), n, [&](std::size_t t) {
+    boct_bit_tree old_tree( (unsigned char*) tree_bits[t].data_block(), max_level_);
+    boct_bit_tree refined_tree( (unsigned char*) refined[t].data_block(), max_level_);
+    refined_tree.set_data_ptr(dataIndex[t], false); //is not random
+    newInitCount += this->move_data(old_tree, refined_tree, alpha_cpy, mog_cpy, num_obs_cpy);
+    tree_bits[t] = refined[t];
+  }, grain);
+  blk_->set_trees(trees);
+  std::cout<<"Parallel refine of "<<n<<" trees on "<<vpl_concurrency()<<" threads: "
+           <<newInitCount<<" new cells"<<std::endl;
+
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_ALPHA>::prefix(), newA);
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_MOG3_GREY>::prefix(), newM);
+  cache->replace_data_base(scene_, id, boxm2_data_traits<BOXM2_NUM_OBS>::prefix(), newN);
+
+  return true;
+}
+
 /////////////////////////////////////////////////////////////////
 ////Refine Tree (refines local tree)
 ////Depth first search iteration of the tree (keeping track of node level)
@@ -159,8 +215,8 @@ boct_bit_tree boxm2_refine_block_function::refine_bit_tree(boct_bit_tree& unrefi
                                                            int buff_offset,
                                                            bool is_random)
 {
-  //initialize tree to return
-  boct_bit_tree refined_tree(unrefined_tree.get_bits(), max_level_);
+  //initialize tree to return (a copy: the tree looked at must not change as it is refined)
+  boct_bit_tree refined_tree(const_cast<const unsigned char*>(unrefined_tree.get_bits()), max_level_);
 
   //no need to do depth first search, just iterate and check each node along the way
   //(iterate through the max number of inner cells)
@@ -292,3 +348,13 @@ void boxm2_refine_block( const boxm2_scene_sptr& scene,
 
   refine_block.refine_deterministic(datas);
 }
+
+void boxm2_refine_block_parallel( const boxm2_scene_sptr& scene,
+                                  boxm2_block* blk,
+                                  std::vector<boxm2_data_base*> & datas,
+                                  float prob_thresh)
+{
+  boxm2_refine_block_function refine_block;
+  refine_block.init_data(scene, blk, datas, prob_thresh);
+  refine_block.refine_parallel(datas);
+}
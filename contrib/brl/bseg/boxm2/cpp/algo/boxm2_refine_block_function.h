@@ -3,6 +3,7 @@
 //:
 // \file
 
+#include <atomic>
 #include <iostream>
 #include <boxm2/boxm2_data_traits.h>
 #include <boxm2/cpp/algo/boxm2_cast_ray_function.h>
@@ -33,6 +34,12 @@ class boxm2_refine_block_function
   bool refine();
   bool refine_deterministic(std::vector<boxm2_data_base*>& datas);
 
+  //: refine the trees on several threads, with the same result as refine_deterministic
+  //  The trees are refined, and their cells counted, in parallel; a prefix
+  //  sum of the counts gives the data offset of each tree, and the data of
+  //  each tree is then moved, in parallel, into the new buffers.
+  bool refine_parallel(std::vector<boxm2_data_base*>& datas);
+
   //: refine bit tree
   boct_bit_tree refine_bit_tree(boct_bit_tree& curr_tree,
                                  int buff_offset,
@@ -70,7 +77,7 @@ class boxm2_refine_block_function
   //length of one side of a sub block
   double block_len_;
 
-  int num_split_;
+  std::atomic<int> num_split_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -82,4 +89,10 @@ void boxm2_refine_block( const boxm2_scene_sptr& scene,
                          float prob_thresh,
                          bool is_random = true);
 
+//: refines a block with boxm2_refine_block_function::refine_parallel
+void boxm2_refine_block_parallel( const boxm2_scene_sptr& scene,
+                                  boxm2_block* blk,
+                                  std::vector<boxm2_data_base*> & datas,
+                                  float prob_thresh);
+
 #endif
@@ -4,6 +4,7 @@
 #include "boxm2_cast_cone_ray_function.h"
 #include "boxm2_render_silhouette_functor.h"
 #include "vul/vul_timer.h"
+#include "vpgl/algo/vpgl_camera_convert.h"
 
 void boxm2_render_expected_image( boxm2_scene_info * linfo,
                                   boxm2_block * blk_sptr,
@@ -20,14 +21,14 @@ void boxm2_render_expected_image( boxm2_scene_info * linfo,
   {
     boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render_functor;
     render_functor.init_data(datas,expected,vis);
-    cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> >
+    cast_ray_per_block_parallel<boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
   else if (data_type.find(boxm2_data_traits<BOXM2_GAUSS_GREY>::prefix()) != std::string::npos )
   {
     boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> render_functor;
     render_functor.init_data(datas,expected,vis);
-    cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> >
+    cast_ray_per_block_parallel<boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
 }
@@ -65,7 +66,7 @@ void boxm2_render_expected_depth( boxm2_scene_info * linfo,
 {
   boxm2_render_exp_depth_functor render_functor;
   render_functor.init_data(data,expected,vis,len_img);
-  cast_ray_per_block<boxm2_render_exp_depth_functor>
+  cast_ray_per_block_parallel<boxm2_render_exp_depth_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
 void boxm2_render_silhouette( boxm2_scene_info * linfo,
@@ -81,7 +82,7 @@ void boxm2_render_silhouette( boxm2_scene_info * linfo,
 {
   boxm2_render_silhouette_functor render_functor;
   render_functor.init_data(alpha,silhouette,vis);
-  cast_ray_per_block<boxm2_render_silhouette_functor>
+  cast_ray_per_block_parallel<boxm2_render_silhouette_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
 
@@ -99,6 +100,24 @@ void boxm2_render_depth_of_max_prob( boxm2_scene_info * linfo,
 {
   boxm2_render_depth_of_max_prob_functor render_functor;
   render_functor.init_data(data,expected,vis,prob_img);
-  cast_ray_per_block<boxm2_render_depth_of_max_prob_functor>
+  cast_ray_per_block_parallel<boxm2_render_depth_of_max_prob_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
+
+std::vector<boxm2_block_id> boxm2_vis_graph_order(boxm2_scene_sptr & scene,
+                                                  const vpgl_camera_double_sptr& cam,
+                                                  unsigned int ni,
+                                                  unsigned int nj)
+{
+  if (auto* gcam = dynamic_cast<vpgl_generic_camera<double>*>(cam.ptr()))
+    return scene->get_vis_blocks(gcam);
+
+  vpgl_generic_camera<double> gcam;
+  if (vpgl_generic_camera_convert::convert(cam, int(ni), int(nj), gcam))
+    return scene->get_vis_blocks(&gcam);
+
+  std::cout<<"boxm2_vis_graph_order: cannot convert "<<cam->type_name()<<" to a generic camera"<<std::endl;
+  if (auto* pcam = dynamic_cast<vpgl_perspective_camera<double>*>(cam.ptr()))
+    return scene->get_vis_blocks(pcam);
+  return std::vector<boxm2_block_id>();
+}
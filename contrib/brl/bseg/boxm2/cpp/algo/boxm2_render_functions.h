@@ -5,6 +5,7 @@
 //
 #include "boxm2_render_exp_image_functor.h"
 #include "boxm2_render_exp_depth_functor.h"
+#include "boxm2_cast_ray_packet.h"
 #include <boxm2/io/boxm2_cache.h>
 #include <boxm2/boxm2_scene.h>
 
@@ -65,5 +66,14 @@ void boxm2_render_depth_of_max_prob( boxm2_scene_info * linfo,
                                      unsigned int roi_ni0=0,
                                      unsigned int roi_nj0=0);
 
+//: The blocks seen by an ni x nj image of cam, in the order of the boxm2_block_vis_graph
+//  Cameras other than generic ones are converted to generic cameras to
+//  build the graph.  A perspective camera that can not be converted falls
+//  back to scene->get_vis_blocks.
+std::vector<boxm2_block_id> boxm2_vis_graph_order(boxm2_scene_sptr & scene,
+                                                  const vpgl_camera_double_sptr& cam,
+                                                  unsigned int ni,
+                                                  unsigned int nj);
+
 
 #endif  //boxm2_render_functions_h_
@@ -5,6 +5,8 @@
 #include <boxm2/cpp/algo/boxm2_update_image_functor.h>
 #include <boxm2/cpp/algo/boxm2_update_with_shadow_functor.h>
 #include <boxm2/cpp/algo/boxm2_update_using_quality_functor.h>
+#include <boxm2/cpp/algo/boxm2_render_functions.h>
+#include <boxm2/io/boxm2_block_prefetcher.h>
 #include "vil/vil_math.h"
 #include "vil/vil_save.h"
 #include "vpgl/vpgl_perspective_camera.h"
@@ -158,16 +160,7 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
                         unsigned int  /*roi_nj0*/)
 {
     boxm2_cache_sptr cache=boxm2_cache::instance();
-    std::vector<boxm2_block_id> vis_order;
-    if (auto* pcam = // assignment, not comparison
-        dynamic_cast<vpgl_perspective_camera<double>* >(cam.ptr()))
-    {
-        vis_order=scene->get_vis_blocks(pcam);
-    }
-    else
-    {
-        vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
-    }
+    std::vector<boxm2_block_id> vis_order=boxm2_vis_graph_order(scene,cam,input_image->ni(),input_image->nj());
     if (vis_order.empty())
     {
         std::cout<<" None of the blocks are visible from this viewpoint"<<std::endl;
@@ -183,6 +176,13 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
     int alphaTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_ALPHA>::prefix());
     int nobsTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_NUM_OBS>::prefix());
 
+    // the first pass reads the blocks ahead while it works; the later passes find them in the cache
+    std::vector<std::string> prefetch_types;
+    prefetch_types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+    prefetch_types.push_back(data_type);
+    prefetch_types.push_back(num_obs_type);
+    boxm2_block_prefetcher prefetch(scene,cache,vis_order,prefetch_types);
+
     bool success = true;
     for (unsigned int pass_no=0;pass_no<num_passes;++pass_no)
     {
@@ -194,6 +194,8 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
         for (id = vis_order.begin(); id != vis_order.end(); ++id)
         {
             std::cout<<"Block id "<<(*id)<<' ';
+            if (pass_no==0)
+                prefetch.fetch(unsigned(id-vis_order.begin()));
             boxm2_block *     blk   = cache->get_block(scene,*id);
             boxm2_data_base *  alph = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_ALPHA>::prefix(),0,false);
             boxm2_data_base *  mog  = cache->get_data_base(scene,*id,data_type,alph->buffer_length()/alphaTypeSize*appTypeSize,false);
@@ -208,13 +210,18 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
             datas.push_back(nobs);
             auto *scene_info_wrapper=new boxm2_scene_info_wrapper();
             scene_info_wrapper->info=scene->get_blk_metadata(*id);
+            // the rays of passes 0 and 2 add to the aux data of the cells
+            auto* aux_cells = reinterpret_cast<boxm2_data_traits<BOXM2_AUX>::datatype*>(aux->data_buffer());
+            std::size_t n_cells = alph->buffer_length()/alphaTypeSize;
             // pass 0
             if (pass_no==0)
             {
                 boxm2_update_pass0_functor pass0;
                 pass0.init_data(datas,input_image);
-                success=success && cast_ray_per_block<boxm2_update_pass0_functor>
+                success=success && cast_ray_per_block_accumulate<boxm2_update_pass0_functor>
                                        (pass0,
+                                        aux_cells,
+                                        n_cells,
                                         scene_info_wrapper->info,
                                         blk,
                                         cam,
@@ -228,14 +235,14 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
               {
                 boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> pass1;
                 pass1.init_data(datas,&pre_img,&vis_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> >
                   (pass1,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
               else if (data_type.find(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()) != std::string::npos)
               {
                 boxm2_update_pass1_functor<BOXM2_MOG3_GREY> pass1;
                 pass1.init_data(datas,&pre_img,&vis_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass1_functor<BOXM2_MOG3_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass1_functor<BOXM2_MOG3_GREY> >
                   (pass1,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
             }
@@ -246,15 +253,15 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
               {
                 boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> pass2;
                 pass2.init_data(datas,&pre_img,&vis_img, & proc_norm_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> >
-                  (pass2,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
+                success=success&&cast_ray_per_block_accumulate<boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> >
+                  (pass2,aux_cells,n_cells,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
               else if (data_type.find(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()) != std::string::npos)
               {
                 boxm2_update_pass2_functor<BOXM2_MOG3_GREY> pass2;
                 pass2.init_data(datas,&pre_img,&vis_img, & proc_norm_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass2_functor<BOXM2_MOG3_GREY> >
-                  (pass2,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
+                success=success&&cast_ray_per_block_accumulate<boxm2_update_pass2_functor<BOXM2_MOG3_GREY> >
+                  (pass2,aux_cells,n_cells,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
             }
         }
@@ -349,6 +356,13 @@ bool boxm2_update_with_shadow(boxm2_scene_sptr & scene,
     int alphaTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_ALPHA>::prefix());
     int nobsTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_NUM_OBS>::prefix());
 
+    // the first pass reads the blocks ahead while it works; the later passes find them in the cache
+    std::vector<std::string> prefetch_types;
+    prefetch_types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+    prefetch_types.push_back(data_type);
+    prefetch_types.push_back(num_obs_type);
+    boxm2_block_prefetcher prefetch(scene,cache,vis_order,prefetch_types);
+
     bool success = true;
     for (unsigned int pass_no=0;pass_no<num_passes;++pass_no)
     {
@@ -360,6 +374,8 @@ bool boxm2_update_with_shadow(boxm2_scene_sptr & scene,
         for (id = vis_order.begin(); id != vis_order.end(); ++id)
         {
             std::cout<<"Block id "<<(*id)<<' ';
+            if (pass_no==0)
+                prefetch.fetch(unsigned(id-vis_order.begin()));
             boxm2_block *     blk   = cache->get_block(scene,*id);
             boxm2_data_base *  alph = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_ALPHA>::prefix(),0,false);
             boxm2_data_base *  mog  = cache->get_data_base(scene,*id,data_type,alph->buffer_length()/alphaTypeSize*appTypeSize,false);
@@ -498,6 +514,13 @@ bool boxm2_update_using_quality(boxm2_scene_sptr & scene,
     int alphaTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_ALPHA>::prefix());
     int nobsTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_NUM_OBS>::prefix());
 
+    // the first pass reads the blocks ahead while it works; the later passes find them in the cache
+    std::vector<std::string> prefetch_types;
+    prefetch_types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+    prefetch_types.push_back(data_type);
+    prefetch_types.push_back(num_obs_type);
+    boxm2_block_prefetcher prefetch(scene,cache,vis_order,prefetch_types);
+
     bool success = true;
     for (unsigned int pass_no=0;pass_no<num_passes;++pass_no)
     {
@@ -509,6 +532,8 @@ bool boxm2_update_using_quality(boxm2_scene_sptr & scene,
         for (id = vis_order.begin(); id != vis_order.end(); ++id)
         {
             std::cout<<"Block id "<<(*id)<<' ';
+            if (pass_no==0)
+                prefetch.fetch(unsigned(id-vis_order.begin()));
             boxm2_block *     blk   = cache->get_block(scene,*id);
             boxm2_data_base *  alph = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_ALPHA>::prefix(),0,false);
             boxm2_data_base *  mog  = cache->get_data_base(scene,*id,data_type,alph->buffer_length()/alphaTypeSize*appTypeSize,false);
@@ -23,13 +23,17 @@ class boxm2_update_pass0_functor
   bool init_data(std::vector<boxm2_data_base*> & datas, vil_image_view<float> * input_img)
   {
     aux_data_=new boxm2_data<BOXM2_AUX>(datas[0]->data_buffer(),datas[0]->buffer_length(),datas[0]->block_id());
+    acc_=aux_data_->data().begin();
     input_img_=input_img;
     return true;
   }
 
+  //: Add the segment lengths and observations to \p acc instead of the aux data
+  void set_accumulator(boxm2_data<BOXM2_AUX>::datatype * acc) { acc_=acc; }
+
   inline bool step_cell(float seg_len,int index,unsigned i,unsigned j, float abs_depth=0.0f)
   {
-    boxm2_data<BOXM2_AUX>::datatype & aux=aux_data_->data()[index];
+    boxm2_data<BOXM2_AUX>::datatype & aux=acc_[index];
     aux[0]+=seg_len;
     aux[1]+=seg_len*(*input_img_)(i,j);
 
@@ -37,6 +41,7 @@ class boxm2_update_pass0_functor
   }
  private:
   boxm2_data<BOXM2_AUX> * aux_data_;
+  boxm2_data<BOXM2_AUX>::datatype * acc_;
   vil_image_view<float> * input_img_;
 };
 
@@ -97,15 +102,20 @@ class boxm2_update_pass2_functor
     aux_data_=new boxm2_data<BOXM2_AUX>(datas[0]->data_buffer(),datas[0]->buffer_length(),datas[0]->block_id());
     alpha_data_=new boxm2_data<BOXM2_ALPHA>(datas[1]->data_buffer(),datas[1]->buffer_length(),datas[1]->block_id());
     mog3_data_=new boxm2_data<APM_TYPE>(datas[2]->data_buffer(),datas[2]->buffer_length(),datas[2]->block_id());
+    acc_=aux_data_->data().begin();
     pre_img_=pre_img;
     vis_img_=vis_img;
     norm_img_=norm_img;
     return true;
   }
 
+  //: Add beta and vis to \p acc instead of the aux data
+  //  The mean observation is still read from the aux data.
+  void set_accumulator(typename boxm2_data<BOXM2_AUX>::datatype * acc) { acc_=acc; }
+
   inline bool step_cell(float seg_len,int index,unsigned i,unsigned j, float abs_depth=0.0f)
   {
-    typename boxm2_data<BOXM2_AUX>::datatype & aux=aux_data_->data()[index];
+    typename boxm2_data<BOXM2_AUX>::datatype const& aux=aux_data_->data()[index];
     if (aux[0]<1e-10f)return true;
     float mean_obs=aux[1]/aux[0];
     float PI=boxm2_processor_type<APM_TYPE>::type::prob_density(mog3_data_->data()[index], mean_obs);
@@ -117,8 +127,9 @@ class boxm2_update_pass2_functor
     float omega=(1-std::exp(-seg_len*alpha));
     if ((*norm_img_)(i,j)>1e-10f)
     {
-        aux[2]+=((pre+vis*PI)/((*norm_img_)(i,j))*seg_len);
-        aux[3]+=vis*seg_len;
+        typename boxm2_data<BOXM2_AUX>::datatype & acc=acc_[index];
+        acc[2]+=((pre+vis*PI)/((*norm_img_)(i,j))*seg_len);
+        acc[3]+=vis*seg_len;
     }
     pre+=vis*omega*PI;
     vis=vis*(1-omega);
@@ -130,6 +141,7 @@ class boxm2_update_pass2_functor
   boxm2_data<BOXM2_AUX> * aux_data_;
   boxm2_data<BOXM2_ALPHA> * alpha_data_;
   boxm2_data<APM_TYPE> * mog3_data_;
+  typename boxm2_data<BOXM2_AUX>::datatype * acc_;
   vil_image_view<float> * pre_img_;
   vil_image_view<float> * vis_img_;
   vil_image_view<float> * norm_img_;
@@ -0,0 +1,126 @@
+//:
+// \file
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vgl/vgl_point_3d.h"
+#include "vpgl/vpgl_perspective_camera.h"
+#include "vpgl/algo/vpgl_camera_convert.h"
+#include "vil/vil_image_view.h"
+#include "vnl/vnl_random.h"
+#include <vpl/vpl_thread_pool.h>
+
+#include <boct/boct_bit_tree.h>
+
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/cpp/algo/boxm2_cast_ray_packet.h>
+#include <boxm2/cpp/algo/boxm2_render_exp_image_functor.h>
+#include <boxm2/tests/test_utils.h>
+
+//: Render with cast_ray_per_block, or with packets on n_threads threads
+static void render(std::vector<boxm2_data_base*>& datas, boxm2_scene_info* info, boxm2_block* blk,
+                   const vpgl_camera_double_sptr& cam, unsigned ni, unsigned nj, unsigned n_threads,
+                   vil_image_view<float>& exp_img, vil_image_view<float>& vis_img)
+{
+  exp_img.set_size(ni,nj);
+  vis_img.set_size(ni,nj);
+  exp_img.fill(0.0f);
+  vis_img.fill(1.0f);
+  boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> functor;
+  functor.init_data(datas,&exp_img,&vis_img);
+  if (n_threads == 0) {
+    cast_ray_per_block(functor,info,blk,cam,ni,nj);
+    return;
+  }
+  vpl_set_concurrency(n_threads);
+  cast_ray_per_block_parallel(functor,info,blk,cam,ni,nj);
+  vpl_set_concurrency(0);
+}
+
+static bool same_image(const vil_image_view<float>& a, const vil_image_view<float>& b)
+{
+  for (unsigned j=0; j<a.nj(); ++j)
+    for (unsigned i=0; i<a.ni(); ++i)
+      if (a(i,j) != b(i,j))
+        return false;
+  return true;
+}
+
+static void test_cast_ray_packet()
+{
+  // a block of 4x4x4 randomly refined trees
+  boxm2_scene_sptr scene = boxm2_test_utils::create_test_row_scene(1, vgl_vector_3d<unsigned>(4,4,4), 0.25, 4);
+  boxm2_block_id id(0,0,0);
+  boxm2_scene_info* info = scene->get_blk_metadata(id);
+
+  boxm2_lru_cache::create(scene);
+  boxm2_block* blk = boxm2_cache::instance()->get_block(scene,id);
+  boxm2_array_3d<vnl_vector_fixed<unsigned char,16> > trees = blk->trees_copy();
+  vnl_random rng(9876);
+  int n_cells = 0;
+  for (auto& tree : trees) {
+    boct_bit_tree bit_tree(tree.data_block(), 4);
+    for (int b=0; b<73; ++b)
+      bit_tree.set_bit_at(b, false);
+    if (rng.drand32() < 0.8) {
+      bit_tree.set_bit_at(0, true);
+      for (int b=1; b<9; ++b) {
+        if (rng.drand32() < 0.5) {
+          bit_tree.set_bit_at(b, true);
+          for (int c=8*b+1; c<8*b+9; ++c)
+            bit_tree.set_bit_at(c, rng.drand32() < 0.3);
+        }
+      }
+    }
+    bit_tree.set_data_ptr(n_cells);
+    n_cells += bit_tree.num_cells();
+  }
+  blk->set_trees(trees);
+
+  auto* alpha = new boxm2_data<BOXM2_ALPHA>(new char[n_cells*sizeof(float)], n_cells*sizeof(float), id);
+  std::size_t mog_size = n_cells*sizeof(boxm2_data_traits<BOXM2_MOG3_GREY>::datatype);
+  auto* mog = new boxm2_data<BOXM2_MOG3_GREY>(new char[mog_size], mog_size, id);
+  for (int c=0; c<n_cells; ++c) {
+    alpha->data()[c] = rng.drand32() < 0.7 ? 0.0f : float(rng.drand32(0.0, 30.0));
+    boxm2_data_traits<BOXM2_MOG3_GREY>::datatype app((unsigned char)0);
+    app[0] = (unsigned char)rng.lrand32(0, 255); app[1] = 25; app[2] = 255;
+    mog->data()[c] = app;
+  }
+  std::vector<boxm2_data_base*> datas;
+  datas.push_back(alpha);
+  datas.push_back(mog);
+
+  // an oblique camera, whose rays point into different octants in
+  // different parts of the image; the image size is not a multiple of 8
+  unsigned ni = 61, nj = 43;
+  vpgl_calibration_matrix<double> K(60.0, vgl_point_2d<double>(30.0, 21.0));
+  auto* pcam = new vpgl_perspective_camera<double>(K, vgl_point_3d<double>(-0.6,-0.4,1.7), vgl_rotation_3d<double>());
+  pcam->look_at(vgl_homg_point_3d<double>(0.5,0.5,0.5));
+  vpgl_camera_double_sptr cam = pcam;
+
+  vil_image_view<float> exp_ray, vis_ray, exp_packet, vis_packet;
+  render(datas, info, blk, cam, ni, nj, 0, exp_ray, vis_ray);
+  bool seen = false;
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i)
+      seen = seen || vis_ray(i,j) < 0.5f;
+  TEST("Scene is seen", seen, true);
+  render(datas, info, blk, cam, ni, nj, 1, exp_packet, vis_packet);
+  TEST("Packets match single rays, perspective camera",
+       same_image(exp_ray, exp_packet) && same_image(vis_ray, vis_packet), true);
+  render(datas, info, blk, cam, ni, nj, 3, exp_packet, vis_packet);
+  TEST("Packets on three threads match single rays",
+       same_image(exp_ray, exp_packet) && same_image(vis_ray, vis_packet), true);
+
+  auto* gcam = new vpgl_generic_camera<double>();
+  vpgl_generic_camera_convert::convert(*pcam, int(ni), int(nj), *gcam);
+  vpgl_camera_double_sptr generic = gcam;
+  render(datas, info, blk, generic, ni, nj, 0, exp_ray, vis_ray);
+  render(datas, info, blk, generic, ni, nj, 2, exp_packet, vis_packet);
+  TEST("Packets match single rays, generic camera",
+       same_image(exp_ray, exp_packet) && same_image(vis_ray, vis_packet), true);
+}
+
+TESTMAIN(test_cast_ray_packet);
@@ -4,6 +4,9 @@ DECLARE( test_merge_mixtures );
 DECLARE( test_cone_ray_trace );
 DECLARE( test_cone_update );
 DECLARE( test_merge_function );
+DECLARE( test_parallel_cast_ray );
+DECLARE( test_cast_ray_packet );
+DECLARE( test_refine_block_parallel );
 
 void register_tests()
 {
@@ -11,6 +14,9 @@ void register_tests()
   REGISTER( test_cone_ray_trace );
   REGISTER( test_cone_update );
   REGISTER( test_merge_function );
+  REGISTER( test_parallel_cast_ray );
+  REGISTER( test_cast_ray_packet );
+  REGISTER( test_refine_block_parallel );
 }
 
 
@@ -5,6 +5,7 @@
 #include <boxm2/cpp/algo/boxm2_cast_cone_ray_function.h>
 #include <boxm2/cpp/algo/boxm2_cast_intensities_functor.h>
 #include <boxm2/cpp/algo/boxm2_cast_ray_function.h>
+#include <boxm2/cpp/algo/boxm2_cast_ray_packet.h>
 #include <boxm2/cpp/algo/boxm2_change_detection_functor.h>
 #include <boxm2/cpp/algo/boxm2_compute_derivative_function.h>
 #include <boxm2/cpp/algo/boxm2_compute_nonsurface_histogram_functor.h>
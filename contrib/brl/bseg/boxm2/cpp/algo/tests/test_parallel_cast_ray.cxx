@@ -0,0 +1,127 @@
+//:
+// \file
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vil/vil_image_view.h"
+#include "vnl/vnl_random.h"
+#include <vpl/vpl_thread_pool.h>
+
+#include <boct/boct_bit_tree.h>
+
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/cpp/algo/boxm2_render_functions.h>
+#include <boxm2/cpp/algo/boxm2_update_image_functor.h>
+#include <boxm2/tests/test_utils.h>
+
+typedef boxm2_data_traits<BOXM2_AUX>::datatype aux_t;
+
+//: Cast pass 0 of the update with the cells added up by n_threads threads
+static std::vector<aux_t> pass0_aux(std::vector<boxm2_data_base*>& datas, boxm2_scene_info* info,
+                                    boxm2_block* blk, const vpgl_camera_double_sptr& cam,
+                                    vil_image_view<float>& img, unsigned n_threads)
+{
+  std::size_t n_cells = datas[0]->buffer_length()/sizeof(aux_t);
+  auto* cells = reinterpret_cast<aux_t*>(datas[0]->data_buffer());
+  std::fill(cells, cells+n_cells, aux_t(0.0f));
+  vpl_set_concurrency(n_threads);
+  boxm2_update_pass0_functor pass0;
+  pass0.init_data(datas, &img);
+  cast_ray_per_block_accumulate(pass0, cells, n_cells, info, blk, cam, img.ni(), img.nj());
+  vpl_set_concurrency(0);
+  return std::vector<aux_t>(cells, cells+n_cells);
+}
+
+static void test_parallel_cast_ray()
+{
+  // a single block of 8x8x1 unrefined trees
+  boxm2_scene_sptr scene = boxm2_test_utils::create_test_row_scene(1, vgl_vector_3d<unsigned>(8,8,1), 1.0/8.0, 1);
+  boxm2_block_id id(0,0,0);
+  boxm2_scene_info* info = scene->get_blk_metadata(id);
+
+  boxm2_lru_cache::create(scene);
+  boxm2_block* blk = boxm2_cache::instance()->get_block(scene,id);
+  boxm2_data_base* alph = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_ALPHA>::prefix());
+  boxm2_data_base* mog  = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_MOG3_GREY>::prefix());
+  std::size_t n_cells = alph->buffer_length()/sizeof(float);
+  boxm2_data_base* aux  = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_AUX>::prefix(),n_cells*sizeof(aux_t));
+  // the data views own their buffers, so they are not deleted (as in the functors)
+  auto* alpha_data = new boxm2_data<BOXM2_ALPHA>(alph->data_buffer(),alph->buffer_length(),id);
+  auto* mog_data = new boxm2_data<BOXM2_MOG3_GREY>(mog->data_buffer(),mog->buffer_length(),id);
+
+  // random occupancy and appearance in each tree
+  vnl_random rng(4321);
+  for (int x=0; x<8; ++x) {
+    for (int y=0; y<8; ++y) {
+      vnl_vector_fixed<unsigned char,16> tree = blk->trees()(x,y,0);
+      boct_bit_tree bit_tree((unsigned char*)tree.data_block(), info->root_level+1);
+      int data_ptr = bit_tree.get_data_ptr();
+      alpha_data->data()[data_ptr] = float(rng.drand32(0.0, 40.0));
+      boxm2_data_traits<BOXM2_MOG3_GREY>::datatype app((unsigned char)0);
+      app[0] = (unsigned char)rng.lrand32(0, 255); app[1] = 25; app[2] = 255;
+      mog_data->data()[data_ptr] = app;
+    }
+  }
+
+  unsigned ni = 256, nj = 256;
+  vpgl_camera_double_sptr cam = boxm2_test_utils::test_camera_above(ni);
+  std::vector<boxm2_block_id> order = boxm2_vis_graph_order(scene, cam, ni, nj);
+  TEST("Vis graph order of the perspective camera", order.size() == 1 && order[0] == id, true);
+
+  // rendering in tiles on several threads gives the same image
+  std::vector<boxm2_data_base*> datas;
+  datas.push_back(alph);
+  datas.push_back(mog);
+  vil_image_view<float> exp_serial(ni,nj), vis_serial(ni,nj), exp_parallel(ni,nj), vis_parallel(ni,nj);
+  exp_serial.fill(0.0f); vis_serial.fill(1.0f);
+  exp_parallel.fill(0.0f); vis_parallel.fill(1.0f);
+  boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render_functor;
+  render_functor.init_data(datas,&exp_serial,&vis_serial);
+  cast_ray_per_block(render_functor,info,blk,cam,ni,nj);
+  vpl_set_concurrency(4);
+  boxm2_render_expected_image(info,blk,datas,cam,&exp_parallel,&vis_parallel,ni,nj);
+  vpl_set_concurrency(0);
+  bool same = true, seen = false;
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i) {
+      same = same && exp_serial(i,j) == exp_parallel(i,j) && vis_serial(i,j) == vis_parallel(i,j);
+      seen = seen || vis_serial(i,j) < 1.0f;
+    }
+  TEST("Scene is seen", seen, true);
+  TEST("Parallel render matches serial render", same, true);
+
+  // pass 0 of the update adds up the rays of each cell
+  vil_image_view<float> img(ni,nj);
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i)
+      img(i,j) = float(rng.drand32());
+  std::vector<boxm2_data_base*> update_datas;
+  update_datas.push_back(aux);
+  std::vector<aux_t> serial(n_cells), one, four;
+  {
+    auto* cells = reinterpret_cast<aux_t*>(aux->data_buffer());
+    std::fill(cells, cells+n_cells, aux_t(0.0f));
+    boxm2_update_pass0_functor pass0;
+    pass0.init_data(update_datas, &img);
+    cast_ray_per_block(pass0,info,blk,cam,ni,nj);
+    serial.assign(cells, cells+n_cells);
+  }
+  // the columns are added up in bands of 64, whatever the number of threads
+  one = pass0_aux(update_datas, info, blk, cam, img, 1);
+  bool same_sums = true;
+  for (unsigned n_threads : {2u, 3u, 4u, 8u})
+    same_sums = same_sums && pass0_aux(update_datas, info, blk, cam, img, n_threads) == one;
+  TEST("Any number of threads adds up as one thread, bit for bit", same_sums, true);
+  four = pass0_aux(update_datas, info, blk, cam, img, 4);
+  double max_diff = 0.0;
+  for (std::size_t c=0; c<n_cells; ++c)
+    for (unsigned k=0; k<2; ++k)
+      max_diff = std::max(max_diff, (double)std::fabs(four[c][k]-serial[c][k])/(1.0+std::fabs(serial[c][k])));
+  TEST_NEAR("Four threads add up to the serial sums", max_diff, 0.0, 1e-5);
+}
+
+TESTMAIN(test_parallel_cast_ray);
@@ -0,0 +1,96 @@
+//:
+// \file
+#include <cstring>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vnl/vnl_random.h"
+#include <vpl/vpl_thread_pool.h>
+
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/cpp/algo/boxm2_refine_block_function.h>
+#include <boxm2/cpp/algo/boxm2_merge_block_function.h>
+#include <boxm2/tests/test_utils.h>
+
+static std::vector<boxm2_data_base*> block_datas(boxm2_scene_sptr scene, boxm2_block_id const& id)
+{
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  std::vector<boxm2_data_base*> datas;
+  datas.push_back(cache->get_data_base(scene, id, boxm2_data_traits<BOXM2_ALPHA>::prefix()));
+  datas.push_back(cache->get_data_base(scene, id, boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()));
+  datas.push_back(cache->get_data_base(scene, id, boxm2_data_traits<BOXM2_NUM_OBS>::prefix()));
+  return datas;
+}
+
+//: the same random occupancy and appearance for the cells of each block
+static void randomize(std::vector<boxm2_data_base*> const& datas, float max_alpha)
+{
+  vnl_random rng(1234);
+  auto* alpha = reinterpret_cast<float*>(datas[0]->data_buffer());
+  auto* mog = reinterpret_cast<unsigned char*>(datas[1]->data_buffer());
+  std::size_t n = datas[0]->buffer_length()/sizeof(float);
+  for (std::size_t c=0; c<n; ++c) {
+    alpha[c] = float(rng.drand32(0.0, max_alpha));
+    for (unsigned b=0; b<8; ++b)
+      mog[8*c+b] = (unsigned char)rng.lrand32(0, 255);
+  }
+  std::memset(datas[2]->data_buffer(), 0, datas[2]->buffer_length());
+}
+
+static bool same_blocks(boxm2_scene_sptr scene, boxm2_block_id const& a, boxm2_block_id const& b)
+{
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  boxm2_block* blk_a = cache->get_block(scene, a);
+  boxm2_block* blk_b = cache->get_block(scene, b);
+  if (blk_a->num_cells() != blk_b->num_cells() ||
+      std::memcmp(blk_a->trees().data_block(), blk_b->trees().data_block(), 16*blk_a->trees().size()) != 0)
+    return false;
+  std::vector<boxm2_data_base*> datas_a = block_datas(scene, a), datas_b = block_datas(scene, b);
+  for (unsigned i=0; i<datas_a.size(); ++i)
+    if (datas_a[i]->buffer_length() != datas_b[i]->buffer_length() ||
+        std::memcmp(datas_a[i]->data_buffer(), datas_b[i]->data_buffer(), datas_a[i]->buffer_length()) != 0)
+      return false;
+  return true;
+}
+
+static void test_refine_block_parallel()
+{
+  // two identical blocks of 8x8x8 unrefined trees; the serial functions
+  // work on the first, the parallel ones on the second
+  boxm2_scene_sptr scene = boxm2_test_utils::create_test_row_scene(2, vgl_vector_3d<unsigned>(8,8,8), 0.125, 4);
+  boxm2_block_id serial_id(0,0,0), parallel_id(1,0,0);
+
+  boxm2_lru_cache::create(scene);
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  unsigned n_cells = cache->get_block(scene, serial_id)->num_cells();
+
+  // refine twice, with new occupancies each time, so trees get to several depths
+  vpl_set_concurrency(4);
+  for (int pass=0; pass<2; ++pass) {
+    std::vector<boxm2_data_base*> serial_datas = block_datas(scene, serial_id);
+    std::vector<boxm2_data_base*> parallel_datas = block_datas(scene, parallel_id);
+    randomize(serial_datas, 40.0f);
+    randomize(parallel_datas, 40.0f);
+    boxm2_refine_block(scene, cache->get_block(scene, serial_id), serial_datas, 0.3f, false);
+    boxm2_refine_block_parallel(scene, cache->get_block(scene, parallel_id), parallel_datas, 0.3f);
+  }
+  unsigned n_refined = cache->get_block(scene, parallel_id)->num_cells();
+  TEST("Block is refined", n_refined > n_cells, true);
+  TEST("Parallel refine matches serial refine", same_blocks(scene, serial_id, parallel_id), true);
+
+  // merge with low occupancies
+  std::vector<boxm2_data_base*> serial_datas = block_datas(scene, serial_id);
+  std::vector<boxm2_data_base*> parallel_datas = block_datas(scene, parallel_id);
+  randomize(serial_datas, 8.0f);
+  randomize(parallel_datas, 8.0f);
+  boxm2_merge_block(scene, cache->get_block(scene, serial_id), serial_datas, 0.1f, false);
+  boxm2_merge_block_parallel(scene, cache->get_block(scene, parallel_id), parallel_datas, 0.1f);
+  vpl_set_concurrency(0);
+  unsigned n_merged = cache->get_block(scene, parallel_id)->num_cells();
+  TEST("Block is merged", n_merged < n_refined, true);
+  TEST("Parallel merge matches serial merge", same_blocks(scene, serial_id, parallel_id), true);
+}
+
+TESTMAIN(test_refine_block_parallel);
@@ -52,6 +52,7 @@ DECLARE_FUNC_CONS(boxm2_cpp_batch_update_app_process);
 DECLARE_FUNC_CONS(boxm2_cpp_batch_update_alpha_process);
 
 DECLARE_FUNC_CONS(boxm2_cpp_merge_process);
+DECLARE_FUNC_CONS(boxm2_cpp_refine_parallel_process);
 
 DECLARE_FUNC_CONS(boxm2_cpp_update_with_shadow_process);
 DECLARE_FUNC_CONS(boxm2_cpp_image_density_masked_process);
@@ -0,0 +1,100 @@
+// This is brl/bseg/boxm2/cpp/pro/processes/boxm2_cpp_refine_parallel_process.cxx
+#include <algorithm>
+#include <iostream>
+#include <bprb/bprb_func_process.h>
+//:
+// \file
+// \brief  A process for refining, or merging, the scene on several threads.
+//
+//  The trees of each block are refined (or merged) in parallel, and their
+//  data moved in parallel into the new buffers; the scene is the same as
+//  that of boxm2CppRefineProcess (boxm2CppMergeProcess).  The number of
+//  threads is that of vpl_concurrency().
+
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <boxm2/io/boxm2_cache.h>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+//brdb stuff
+#include <brdb/brdb_value.h>
+#include <boxm2/cpp/algo/boxm2_refine_block_function.h>
+#include <boxm2/cpp/algo/boxm2_merge_block_function.h>
+#include "vul/vul_timer.h"
+
+namespace boxm2_cpp_refine_parallel_process_globals
+{
+  constexpr unsigned n_inputs_ = 4;
+  constexpr unsigned n_outputs_ = 0;
+}
+
+bool boxm2_cpp_refine_parallel_process_cons(bprb_func_process& pro)
+{
+  using namespace boxm2_cpp_refine_parallel_process_globals;
+
+  std::vector<std::string> input_types_(n_inputs_);
+  input_types_[0] = "boxm2_scene_sptr";
+  input_types_[1] = "boxm2_cache_sptr";
+  input_types_[2] = "float";  // occupancy probability threshold
+  input_types_[3] = "bool";   // merge instead of refine
+
+  std::vector<std::string>  output_types_(n_outputs_);
+
+  bool good = pro.set_input_types(input_types_) && pro.set_output_types(output_types_);
+  // refine unless told otherwise
+  brdb_value_sptr merge = new brdb_value_t<bool>(false);
+  pro.set_input(3, merge);
+  return good;
+}
+
+bool boxm2_cpp_refine_parallel_process(bprb_func_process& pro)
+{
+  using namespace boxm2_cpp_refine_parallel_process_globals;
+
+  if ( pro.n_inputs() < n_inputs_ ) {
+    std::cout << pro.name() << ": The input number should be " << n_inputs_<< std::endl;
+    return false;
+  }
+  //get the inputs
+  unsigned i = 0;
+  boxm2_scene_sptr scene = pro.get_input<boxm2_scene_sptr>(i++);
+  boxm2_cache_sptr cache = pro.get_input<boxm2_cache_sptr>(i++);
+  auto thresh = pro.get_input<float>(i++);
+  bool merge = pro.get_input<bool>(i++);
+
+  // the refine and merge functions only handle this appearance model
+  std::string data_type = boxm2_data_traits<BOXM2_MOG3_GREY>::prefix();
+  std::vector<std::string> apps = scene->appearances();
+  if (std::find(apps.begin(), apps.end(), data_type) == apps.end()) {
+    std::cout<<"BOXM2_CPP_REFINE_PARALLEL_PROCESS ERROR: scene doesn't have BOXM2_MOG3_GREY data type"<<std::endl;
+    return false;
+  }
+
+  vul_timer t;
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks = scene->blocks();
+  std::map<boxm2_block_id, boxm2_block_metadata>::iterator blk_iter;
+  for (blk_iter = blocks.begin(); blk_iter != blocks.end(); ++blk_iter)
+  {
+    boxm2_block_id id = blk_iter->first;
+    boxm2_block *     blk = cache->get_block(scene,id);
+    boxm2_data_base * alph = cache->get_data_base(scene,id,boxm2_data_traits<BOXM2_ALPHA>::prefix(), 0, false);
+    boxm2_data_base * mog = cache->get_data_base(scene,id,data_type, 0, false);
+    boxm2_data_base * num_obs = cache->get_data_base(scene,id,boxm2_data_traits<BOXM2_NUM_OBS>::prefix(), 0, false);
+
+    std::vector<boxm2_data_base*> datas;
+    datas.push_back(alph);
+    datas.push_back(mog);
+    datas.push_back(num_obs);
+
+    if (merge)
+      boxm2_merge_block_parallel(scene, blk, datas, thresh);
+    else
+      boxm2_refine_block_parallel(scene, blk, datas, thresh);
+    blk->enable_write(); // now cache will make sure that it is written to disc
+  }
+
+  std::cout<<"  "<<(merge ? "merge" : "refine")<<" time: "<<t.all()/1000.0f<<" sec"<<std::endl;
+  return true;
+}
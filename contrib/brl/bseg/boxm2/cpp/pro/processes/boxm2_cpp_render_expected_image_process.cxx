@@ -13,6 +13,7 @@
 #  include "vcl_msvc_warnings.h"
 #endif
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/io/boxm2_block_prefetcher.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -109,20 +110,16 @@ bool boxm2_cpp_render_expected_image_process(bprb_func_process& pro)
   auto * vis_img=new vil_image_view<float>(ni,nj);
   exp_img->fill(0.0f);
   vis_img->fill(1.0f);
-  std::vector<boxm2_block_id> vis_order;
-  if (auto* pcam = // assignment, not comparison
-      dynamic_cast<vpgl_perspective_camera<double>* >(cam.ptr()))
-  {
-    vis_order=scene->get_vis_blocks(pcam);
-  }
-  else
-  {
-    vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
-  }
+  std::vector<boxm2_block_id> vis_order=boxm2_vis_graph_order(scene,cam,ni,nj);
+  std::vector<std::string> prefetch_types;
+  prefetch_types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+  prefetch_types.push_back(data_type);
+  boxm2_block_prefetcher prefetch(scene,cache,vis_order,prefetch_types);
   std::vector<boxm2_block_id>::iterator id;
   for (id = vis_order.begin(); id != vis_order.end(); ++id)
   {
     std::cout<<"Block Id "<<(*id)<<std::endl;
+    prefetch.fetch(unsigned(id-vis_order.begin()));
     boxm2_block *     blk = cache->get_block(scene,*id);
     boxm2_data_base *  alph = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_ALPHA>::prefix());
     boxm2_data_base *  mog = cache->get_data_base(scene,*id,data_type);
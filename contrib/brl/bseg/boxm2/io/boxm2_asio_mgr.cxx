@@ -112,15 +112,32 @@ std::map<boxm2_block_id, boxm2_block*> boxm2_asio_mgr::get_loaded_blocks()
       // close baio file
       aio->close_file();
 
-      // instantiate new block
-      auto*  blk = new boxm2_block(id, load_metadata_list_[id],aio->buffer());
-      toReturn[id] = blk;
+      // instantiate new block, expanding a compressed file
+      char* bytes = aio->buffer();
+      std::size_t len = aio->buffer_size();
+      if (boxm2_compressed_file::expand(bytes, len)) {
+        auto*  blk = new boxm2_block(id, load_metadata_list_[id],bytes);
+        toReturn[id] = blk;
+      }
+      else {
+        delete [] bytes;
+        failed_list_.push_back(id);
+      }
 
       // remove iter from the load list/delete aio
       //load_list_.erase(iter);
       to_delete.push_back(iter);
       delete aio;
     }
+    else if ( aio->status() == BAIO_ERROR )
+    {
+      // the read will never finish, so drop it
+      aio->close_file();
+      delete [] aio->buffer();
+      failed_list_.push_back(id);
+      to_delete.push_back(iter);
+      delete aio;
+    }
   }
 
   for (auto i : to_delete)
@@ -152,14 +169,30 @@ std::map<boxm2_block_id, boxm2_data_base*> boxm2_asio_mgr::get_loaded_data_gener
         // close baio file
         aio->close_file();
 
-        // instantiate new block
-        boxm2_data_base* dat = new boxm2_data_base(aio->buffer(), aio->buffer_size(), id);
-        toReturn[id] = dat;
+        // instantiate new block, expanding a compressed file
+        char* bytes = aio->buffer();
+        std::size_t len = aio->buffer_size();
+        if (boxm2_compressed_file::expand(bytes, len)) {
+          boxm2_data_base* dat = new boxm2_data_base(bytes, len, id);
+          toReturn[id] = dat;
+        }
+        else {
+          delete [] bytes;
+          failed_data_list_[prefix].push_back(id);
+        }
 
         // remove iter from the load list/delete aio
         to_delete.push_back(iter);
         delete aio;
       }
+      else if ( aio->status() == BAIO_ERROR )
+      {
+        aio->close_file();
+        delete [] aio->buffer();
+        failed_data_list_[prefix].push_back(id);
+        to_delete.push_back(iter);
+        delete aio;
+      }
     }
 
     //delete loaded entries from data list
@@ -169,6 +202,24 @@ std::map<boxm2_block_id, boxm2_data_base*> boxm2_asio_mgr::get_loaded_data_gener
   return toReturn;
 }
 
+//: the block loads which failed since the last call
+std::vector<boxm2_block_id> boxm2_asio_mgr::get_failed_blocks()
+{
+  std::vector<boxm2_block_id> failed;
+  failed.swap(failed_list_);
+  return failed;
+}
+
+//: the data loads which failed since the last call
+std::vector<boxm2_block_id> boxm2_asio_mgr::get_failed_data_generic(const std::string& prefix)
+{
+  std::vector<boxm2_block_id> failed;
+  auto iter = failed_data_list_.find(prefix);
+  if (iter != failed_data_list_.end())
+    failed.swap(iter->second);
+  return failed;
+}
+
 
 
 //: load_block_data creates and stores async request for data of data_type with block_id
@@ -10,6 +10,7 @@
 #include <boxm2/boxm2_data_traits.h>
 #include <boxm2/boxm2_data.h>
 #include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -66,6 +67,13 @@ class boxm2_asio_mgr
     // \returns a map of data pointers (generic pointers)
     std::map<boxm2_block_id, boxm2_data_base*> get_loaded_data_generic(const std::string& prefix);
 
+    //: the block loads which failed since the last call
+    //  get_loaded_blocks() drops the failed loads; they are never returned
+    std::vector<boxm2_block_id> get_failed_blocks();
+
+    //: the data loads which failed since the last call
+    std::vector<boxm2_block_id> get_failed_data_generic(const std::string& prefix);
+
   private:
 
     //: list of asynchronous io loads
@@ -77,6 +85,10 @@ class boxm2_asio_mgr
     data_list_t load_data_list_;
     metadata_list_t load_metadata_list_;
 
+    //: loads dropped because they failed
+    std::vector<boxm2_block_id> failed_list_;
+    std::map<std::string, std::vector<boxm2_block_id> > failed_data_list_;
+
     //: list of asynchronous io saves
     block_list_t save_list_;
     data_list_t save_data_list_;
@@ -159,9 +171,17 @@ std::map<boxm2_block_id, boxm2_data<data_type>* > boxm2_asio_mgr::get_loaded_dat
         // close baio file
         aio->close_file();
 
-        // instantiate new block
-        boxm2_data<data_type>* dat = new boxm2_data<data_type>(aio->buffer(), aio->buffer_size(), id);
-        toReturn[id] = dat;
+        // instantiate new block, expanding a compressed file
+        char* bytes = aio->buffer();
+        std::size_t len = aio->buffer_size();
+        if (boxm2_compressed_file::expand(bytes, len)) {
+          boxm2_data<data_type>* dat = new boxm2_data<data_type>(bytes, len, id);
+          toReturn[id] = dat;
+        }
+        else {
+          delete [] bytes;
+          failed_data_list_[boxm2_data_traits<data_type>::prefix()].push_back(id);
+        }
 
         // remove iter from the load list/delete aio
         to_delete.push_back(iter);
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "boxm2_block_prefetcher.h"
+//:
+// \file
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_traits.h>
+
+boxm2_block_prefetcher::boxm2_block_prefetcher(boxm2_scene_sptr const& scene, boxm2_cache_sptr const& cache,
+                                               std::vector<boxm2_block_id> const& order,
+                                               std::vector<std::string> const& data_types,
+                                               unsigned depth)
+: scene_(scene), cache_(cache), order_(order), data_types_(data_types), depth_(depth),
+  next_(0), start_(std::chrono::steady_clock::now()),
+  num_loads_(0), load_time_(0.0), hidden_time_(0.0), stall_time_(0.0)
+{
+}
+
+boxm2_block_prefetcher::boxm2_block_prefetcher(boxm2_scene_sptr const& scene, boxm2_cache_sptr const& cache,
+                                               vpgl_camera_double_sptr cam,
+                                               std::vector<std::string> const& data_types,
+                                               unsigned depth)
+: scene_(scene), cache_(cache), order_(scene->get_vis_blocks(cam)), data_types_(data_types), depth_(depth),
+  next_(0), start_(std::chrono::steady_clock::now()),
+  num_loads_(0), load_time_(0.0), hidden_time_(0.0), stall_time_(0.0)
+{
+}
+
+boxm2_block_prefetcher::~boxm2_block_prefetcher()
+{
+  // the buffers of the reads going on belong to the io manager until they finish
+  bool pending = true;
+  while (pending) {
+    this->harvest();
+    pending = false;
+    for (auto const& l : loads_)
+      pending = pending || l.second.pending > 0;
+    if (pending)
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+double boxm2_block_prefetcher::now() const
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void boxm2_block_prefetcher::request(unsigned n)
+{
+  boxm2_block_id id = order_[n];
+  if (loads_.find(id) != loads_.end())
+    return;
+  load& l = loads_[id];
+  l.requested = this->now();
+  std::string dir = scene_->data_path();
+  if (scene_->block_on_disk(id)) {
+    io_mgr_.load_block(dir, id, scene_->get_block_metadata(id));
+    l.block_pending = true;
+    ++l.pending;
+  }
+  for (auto const& type : data_types_) {
+    if (scene_->data_on_disk(id, type)) {
+      io_mgr_.load_block_data_generic(dir, id, type);
+      ++l.pending;
+    }
+  }
+  num_loads_ += l.pending;
+  l.finished = l.requested;
+}
+
+void boxm2_block_prefetcher::finished(load& l, double t)
+{
+  if (--l.pending == 0)
+    l.finished = t;
+}
+
+void boxm2_block_prefetcher::add_data(boxm2_block_id const& id, std::string const& type, boxm2_data_base* data)
+{
+  // data of the wrong size is left to the cache to initialize
+  boxm2_block* blk = cache_->get_block(scene_, id);
+  if (!blk || data->buffer_length() != blk->num_cells()*boxm2_data_info::datasize(type) ||
+      !cache_->add_data_base(scene_, id, type, data))
+    delete data;
+}
+
+void boxm2_block_prefetcher::harvest()
+{
+  double t = this->now();
+  for (auto const& b : io_mgr_.get_loaded_blocks()) {
+    load& l = loads_[b.first];
+    if (!cache_->add_block(scene_, b.second))
+      delete b.second;
+    l.block_pending = false;
+    for (auto const& d : l.data)
+      this->add_data(b.first, d.first, d.second);
+    l.data.clear();
+    this->finished(l, t);
+  }
+  // what could not be read is left to the cache
+  for (auto const& id : io_mgr_.get_failed_blocks()) {
+    load& l = loads_[id];
+    l.block_pending = false;
+    for (auto const& d : l.data)
+      this->add_data(id, d.first, d.second);
+    l.data.clear();
+    this->finished(l, t);
+  }
+  for (auto const& type : data_types_) {
+    for (auto const& d : io_mgr_.get_loaded_data_generic(type)) {
+      load& l = loads_[d.first];
+      if (l.block_pending)
+        l.data.emplace_back(type, d.second);
+      else
+        this->add_data(d.first, type, d.second);
+      this->finished(l, t);
+    }
+    for (auto const& id : io_mgr_.get_failed_data_generic(type))
+      this->finished(loads_[id], t);
+  }
+}
+
+void boxm2_block_prefetcher::fetch(unsigned n)
+{
+  if (n >= order_.size())
+    return;
+  double need = this->now();
+  unsigned end = unsigned(std::min<std::size_t>(std::size_t(n)+1+depth_, order_.size()));
+  for (next_ = std::max(next_, n); next_ < end; ++next_)
+    this->request(next_);
+
+  load& l = loads_[order_[n]];
+  this->harvest();
+  while (l.pending > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    this->harvest();
+  }
+  if (l.counted)
+    return;
+  l.counted = true;
+  load_time_ += l.finished - l.requested;
+  hidden_time_ += std::min(l.finished, need) - l.requested;
+  stall_time_ += this->now() - need;
+}
+
+std::ostream& operator<<(std::ostream &s, boxm2_block_prefetcher const& prefetch)
+{
+  s << "boxm2_block_prefetcher: " << prefetch.num_loads() << " files read, "
+    << "read time " << prefetch.load_time() << " s, "
+    << "stalled " << prefetch.stall_time() << " s, "
+    << "overlap " << prefetch.overlap_ratio();
+  return s;
+}
@@ -0,0 +1,129 @@
+#ifndef boxm2_block_prefetcher_h_
+#define boxm2_block_prefetcher_h_
+//:
+// \file
+// \brief boxm2_block_prefetcher reads the blocks a pass is about to visit ahead of time
+//
+//  A render or update pass visits the blocks of a scene in an order known
+//  in advance (e.g. the visibility order of a camera).  The prefetcher
+//  starts asynchronous reads (boxm2_asio_mgr) of the next few blocks of
+//  that order, and of their data, while the caller works on the current
+//  block, and puts them in the cache once they are read.  So the cache
+//  finds them loaded instead of reading them from disk.
+//
+//  Only the blocks and data already on disk are read; what is not is left
+//  to the cache to initialize.  The reads are polled and handed to the
+//  cache on the calling thread, so any cache implementing add_block() and
+//  add_data_base() will do.
+//  \verbatim
+//    std::vector<boxm2_block_id> vis_order = scene->get_vis_blocks(cam);
+//    boxm2_block_prefetcher prefetch(scene, cache, vis_order, types);
+//    for (unsigned n=0; n<vis_order.size(); ++n) {
+//      prefetch.fetch(n);
+//      boxm2_block* blk = cache->get_block(scene, vis_order[n]);
+//      ...
+//    }
+//  \endverbatim
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/io/boxm2_asio_mgr.h>
+#include <boxm2/io/boxm2_cache.h>
+#include <vpgl/vpgl_camera_double_sptr.h>
+
+class boxm2_block_prefetcher
+{
+ public:
+  //: prefetch the blocks in order, and the data of the given types, depth blocks ahead
+  boxm2_block_prefetcher(boxm2_scene_sptr const& scene, boxm2_cache_sptr const& cache,
+                         std::vector<boxm2_block_id> const& order,
+                         std::vector<std::string> const& data_types,
+                         unsigned depth = 2);
+
+  //: prefetch the blocks in the visibility order of a camera
+  boxm2_block_prefetcher(boxm2_scene_sptr const& scene, boxm2_cache_sptr const& cache,
+                         vpgl_camera_double_sptr cam,
+                         std::vector<std::string> const& data_types,
+                         unsigned depth = 2);
+
+  //: waits for the reads still going on, and puts them in the cache
+  ~boxm2_block_prefetcher();
+
+  //: the caller is about to work on block n of the order
+  //  Starts reading the blocks up to n+depth and waits until block n and
+  //  its data are in the cache.  Must be called with increasing n.
+  void fetch(unsigned n);
+
+  //: the block order
+  std::vector<boxm2_block_id> const& order() const { return order_; }
+
+  //: number of files read
+  unsigned num_loads() const { return num_loads_; }
+
+  //: seconds the reads of the blocks fetched so far took
+  double load_time() const { return load_time_; }
+
+  //: seconds fetch() waited for reads to finish
+  double stall_time() const { return stall_time_; }
+
+  //: fraction of the read time hidden behind the caller's work
+  double overlap_ratio() const { return load_time_ > 0.0 ? hidden_time_/load_time_ : 0.0; }
+
+ private:
+  //: the reads of one block and its data
+  struct load
+  {
+    double requested = 0.0;
+    double finished = 0.0;
+    //: reads not finished yet
+    unsigned pending = 0;
+    bool block_pending = false;
+    //: data read before its block, handed to the cache after it
+    std::vector<std::pair<std::string, boxm2_data_base*> > data;
+    //: the read times are in the totals
+    bool counted = false;
+  };
+
+  //: start reading block (and data) n of the order
+  void request(unsigned n);
+
+  //: hands the finished reads to the cache
+  void harvest();
+
+  //: one of the reads of l finished at time t
+  void finished(load& l, double t);
+
+  //: puts data in the cache, if it fits the block
+  void add_data(boxm2_block_id const& id, std::string const& type, boxm2_data_base* data);
+
+  //: seconds since construction
+  double now() const;
+
+  boxm2_scene_sptr scene_;
+  boxm2_cache_sptr cache_;
+  std::vector<boxm2_block_id> order_;
+  std::vector<std::string> data_types_;
+  unsigned depth_;
+
+  boxm2_asio_mgr io_mgr_;
+  std::map<boxm2_block_id, load> loads_;
+  //: index in order_ of the next block to request
+  unsigned next_;
+
+  std::chrono::steady_clock::time_point start_;
+  unsigned num_loads_;
+  double load_time_;
+  double hidden_time_;
+  double stall_time_;
+};
+
+//: shows the read times of a prefetcher
+std::ostream& operator<<(std::ostream &s, boxm2_block_prefetcher const& prefetch);
+
+#endif // boxm2_block_prefetcher_h_
@@ -50,6 +50,14 @@ class boxm2_cache: public vbl_ref_count
 
   virtual void replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement)=0;
 
+  //: puts a block read elsewhere (e.g. asynchronously) in the cache
+  //  Returns false, leaving the block to the caller, if the cache has the block already or cannot take it
+  virtual bool add_block(boxm2_scene_sptr & /*scene*/, boxm2_block* /*blk*/) { return false; }
+
+  //: puts data read elsewhere in the cache
+  //  Returns false, leaving the data to the caller, if the cache has the data already or cannot take it
+  virtual bool add_data_base(boxm2_scene_sptr & /*scene*/, boxm2_block_id /*id*/, const std::string& /*type*/, boxm2_data_base* /*data*/) { return false; }
+
   //: returns data pointer to data specified by ID and data_type
   template <boxm2_data_type T>
   boxm2_data<T>* get_data(boxm2_scene_sptr & scene, boxm2_block_id id, std::size_t num_bytes=0, bool read_only=true);
@@ -274,6 +274,26 @@ void boxm2_lru_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id
 
 }
 
+//: puts a block read elsewhere in the cache
+bool boxm2_lru_cache::add_block(boxm2_scene_sptr & scene, boxm2_block* blk)
+{
+  std::map<boxm2_block_id, boxm2_block*>& block_map = cached_blocks_[scene];
+  if (block_map.find(blk->block_id()) != block_map.end())
+    return false;
+  block_map[blk->block_id()] = blk;
+  return true;
+}
+
+//: puts data read elsewhere in the cache
+bool boxm2_lru_cache::add_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type, boxm2_data_base* data)
+{
+  std::map<boxm2_block_id, boxm2_data_base*>& data_map = this->cached_data_map(scene, type);
+  if (data_map.find(id) != data_map.end())
+    return false;
+  data_map[id] = data;
+  return true;
+}
+
 //: helper method returns a reference to correct data map (ensures one exists)
 std::map<boxm2_block_id, boxm2_data_base*>& boxm2_lru_cache::cached_data_map(boxm2_scene_sptr & scene, const std::string& prefix)
 {
@@ -45,6 +45,12 @@ class boxm2_lru_cache : public boxm2_cache
     //: replaces a database in the cache, deletes it
     void replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement) override;
 
+    //: puts a block read elsewhere in the cache
+    bool add_block(boxm2_scene_sptr & scene, boxm2_block* blk) override;
+
+    //: puts data read elsewhere in the cache
+    bool add_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type, boxm2_data_base* data) override;
+
     //: dumps writeable data to disk
     void write_to_disk() override;
 
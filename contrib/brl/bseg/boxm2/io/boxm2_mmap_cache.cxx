@@ -0,0 +1,696 @@
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "boxm2_mmap_cache.h"
+//:
+// \file
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
+#include <boxm2/boxm2_data_traits.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  define BOXM2_MMAP_CACHE_HAS_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+bool boxm2_mmap_cache::key::operator<(key const& that) const
+{
+  if (scene != that.scene) return scene < that.scene;
+  if (type != that.type) return type < that.type;
+  return id < that.id;
+}
+
+bool boxm2_mmap_cache::key::operator==(key const& that) const
+{
+  return scene == that.scene && type == that.type && id == that.id;
+}
+
+boxm2_mmap_cache::handle::handle(handle&& that) noexcept
+: cache_(that.cache_), key_(that.key_), block_(that.block_), data_(that.data_)
+{
+  that.cache_ = nullptr;
+}
+
+boxm2_mmap_cache::handle& boxm2_mmap_cache::handle::operator=(handle&& that) noexcept
+{
+  if (this != &that) {
+    this->release();
+    cache_ = that.cache_;
+    key_ = that.key_;
+    block_ = that.block_;
+    data_ = that.data_;
+    that.cache_ = nullptr;
+  }
+  return *this;
+}
+
+void boxm2_mmap_cache::handle::release()
+{
+  if (cache_)
+    cache_->unpin(key_, block_, data_);
+  cache_ = nullptr;
+  block_ = nullptr;
+  data_ = nullptr;
+}
+
+//: PUBLIC create method, for creating singleton instance of boxm2_cache
+void boxm2_mmap_cache::create(const boxm2_scene_sptr& scene, std::size_t max_bytes, map_mode mode)
+{
+  if (boxm2_cache::exists()) {
+    auto* current = dynamic_cast<boxm2_mmap_cache*>(instance_.ptr());
+    if (!current || current->mode() == mode)
+      return;
+    std::cout << "boxm2_mmap_cache:: writing out the current cache and creating one of another mode" << std::endl;
+    current->write_to_disk();
+  }
+  instance_ = new boxm2_mmap_cache(scene, max_bytes, mode);
+}
+
+boxm2_mmap_cache::boxm2_mmap_cache(const boxm2_scene_sptr& scene, std::size_t max_bytes, map_mode mode)
+: boxm2_cache(LOCAL), max_bytes_(max_bytes), mode_(mode),
+  clock_(0), hits_(0), misses_(0), evictions_(0),
+  bytes_cached_(0), bytes_mapped_(0), bytes_written_back_(0)
+{
+  if (scene)
+    this->keep_scene(scene);
+}
+
+//: destructor deletes the memory, as boxm2_lru_cache does
+boxm2_mmap_cache::~boxm2_mmap_cache()
+{
+  this->clear_cache();
+  // handles which outlive the cache cannot unpin any more
+  for (stripe& s : stripes_) {
+    for (entry& e : s.retired)
+      this->release_entry(e);
+    s.retired.clear();
+  }
+}
+
+boxm2_mmap_cache::stripe& boxm2_mmap_cache::stripe_of(key const& k)
+{
+  std::size_t h = std::hash<std::string>()(k.type);
+  h ^= std::size_t(k.id.i())*73856093u ^ std::size_t(k.id.j())*19349663u ^ std::size_t(k.id.k())*83492791u;
+  return stripes_[h % num_stripes];
+}
+
+std::map<boxm2_mmap_cache::key, boxm2_mmap_cache::entry>::iterator
+boxm2_mmap_cache::find(stripe& s, key const& k, std::unique_lock<std::mutex>& lock)
+{
+  auto it = s.entries.find(k);
+  while (it != s.entries.end() && it->second.evicting) {
+    s.evicted.wait(lock);
+    it = s.entries.find(k);
+  }
+  return it;
+}
+
+void boxm2_mmap_cache::keep_scene(boxm2_scene_sptr const& scene)
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  for (auto const& s : scenes_)
+    if (s == scene)
+      return;
+  scenes_.push_back(scene);
+}
+
+std::string boxm2_mmap_cache::file_path(key const& k) const
+{
+  if (k.type.empty())
+    return k.scene->data_path() + k.id.to_string() + ".bin";
+  return k.scene->data_path() + k.type + "_" + k.id.to_string() + ".bin";
+}
+
+char* boxm2_mmap_cache::map_file(std::string const& path, entry& e)
+{
+#ifdef BOXM2_MMAP_CACHE_HAS_MMAP
+  // write back needs the file open for writing, otherwise map it privately
+  bool shared = mode_ == WRITE_BACK;
+  int fd = ::open(path.c_str(), shared ? O_RDWR : O_RDONLY);
+  if (fd < 0 && shared) {
+    shared = false;
+    fd = ::open(path.c_str(), O_RDONLY);
+  }
+  if (fd < 0)
+    return nullptr;
+  void* addr = MAP_FAILED;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    addr = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ | PROT_WRITE,
+                  shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    return nullptr;
+  // a compressed file cannot be used in place; it is read and expanded instead
+  if (boxm2_compressed_file::is_compressed(static_cast<char*>(addr), std::size_t(st.st_size))) {
+    ::munmap(addr, std::size_t(st.st_size));
+    return nullptr;
+  }
+  e.mapped = std::size_t(st.st_size);
+  e.shared = shared;
+  return static_cast<char*>(addr);
+#else
+  (void)path; (void)e;
+  return nullptr;
+#endif
+}
+
+void boxm2_mmap_cache::insert(stripe& s, key const& k, entry& e)
+{
+  e.last_use = ++clock_;
+  bytes_cached_ += e.bytes;
+  bytes_mapped_ += e.mapped;
+  s.entries[k] = e;
+}
+
+bool boxm2_mmap_cache::erase(stripe& s, std::map<key, entry>::iterator it)
+{
+  bytes_cached_ -= it->second.bytes;
+  bool pinned = it->second.pins > 0;
+  if (pinned)
+    s.retired.push_back(it->second);
+  else
+    bytes_mapped_ -= it->second.mapped;
+  s.entries.erase(it);
+  return !pinned;
+}
+
+void boxm2_mmap_cache::write_entry(key const& k, entry& e, bool force)
+{
+  bool dirty = force || e.created || (e.block ? !e.block->read_only() : !e.data->read_only_);
+  if (!dirty)
+    return;
+  char* buffer;
+  std::size_t len;
+  if (e.block) {
+    buffer = e.block->buffer();
+    e.block->b_write(buffer);
+    len = e.mapped ? e.mapped : std::size_t(e.block->byte_count());
+  }
+  else {
+    buffer = e.data->data_buffer();
+    len = e.data->buffer_length();
+  }
+#ifdef BOXM2_MMAP_CACHE_HAS_MMAP
+  if (e.mapped && e.shared) {
+    ::msync(buffer, e.mapped, MS_SYNC);
+    bytes_written_back_ += len;
+    return;
+  }
+#endif
+  if (e.mapped) {
+    // write over the file in place; truncating it, as boxm2_sio_mgr does,
+    // would take the pages which are still mapped from under the buffer
+    std::fstream file(this->file_path(k).c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    file.write(buffer, len);
+  }
+  else if (e.block)
+    boxm2_sio_mgr::save_block(k.scene->data_path(), e.block);
+  else
+    boxm2_sio_mgr::save_block_data_base(k.scene->data_path(), k.id, e.data, k.type);
+  bytes_written_back_ += len;
+}
+
+void boxm2_mmap_cache::release_entry(entry& e)
+{
+#ifdef BOXM2_MMAP_CACHE_HAS_MMAP
+  if (e.mapped) {
+    char* buffer = e.block ? e.block->release_buffer() : e.data->release_buffer();
+    ::munmap(buffer, e.mapped);
+  }
+#endif
+  delete e.block;
+  delete e.data;
+  e.block = nullptr;
+  e.data = nullptr;
+}
+
+bool boxm2_mmap_cache::take_out(stripe& s, key const& k, bool write, bool force, unsigned long long last_use)
+{
+  entry e;
+  {
+    std::unique_lock<std::mutex> lock(s.mutex);
+    auto it = this->find(s, k, lock);
+    if (it == s.entries.end())
+      return false;
+    if (last_use && (it->second.pins > 0 || it->second.last_use != last_use))
+      return false;  // pinned, or used again meanwhile
+    // it stays in the index while it is written, so a thread asking for it
+    // again waits, then reads what was written
+    it->second.evicting = true;
+    e = it->second;
+  }
+  if (write)
+    this->write_entry(k, e, force);
+  bool release = false;
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.entries.find(k);
+    if (it != s.entries.end()) {
+      it->second.evicting = false;
+      release = this->erase(s, it);
+    }
+  }
+  s.evicted.notify_all();
+  if (release)
+    this->release_entry(e);
+  return true;
+}
+
+void boxm2_mmap_cache::evict_to_budget(key const* keep)
+{
+  std::lock_guard<std::mutex> evict_lock(evict_mutex_);
+  while (bytes_cached_ > max_bytes_)
+  {
+    // find the least recently used entry which is not pinned
+    stripe* victim_stripe = nullptr;
+    key victim;
+    unsigned long long oldest = 0;
+    for (stripe& s : stripes_) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (auto const& kv : s.entries) {
+        if ((keep && kv.first == *keep) || kv.second.pins > 0 || kv.second.evicting)
+          continue;
+        if (!victim_stripe || kv.second.last_use < oldest) {
+          victim_stripe = &s;
+          victim = kv.first;
+          oldest = kv.second.last_use;
+        }
+      }
+    }
+    if (!victim_stripe)
+      return;
+    if (this->take_out(*victim_stripe, victim, true, false, oldest))
+      ++evictions_;
+  }
+}
+
+boxm2_block* boxm2_mmap_cache::load_block(boxm2_scene_sptr & scene, key const& k, bool pin)
+{
+  boxm2_block_id id = k.id;
+  boxm2_block* blk;
+  stripe& s = this->stripe_of(k);
+  {
+    std::unique_lock<std::mutex> lock(s.mutex);
+    auto it = this->find(s, k, lock);
+    if (it != s.entries.end()) {
+      ++hits_;
+      it->second.last_use = ++clock_;
+      if (pin)
+        ++it->second.pins;
+      return it->second.block;
+    }
+    ++misses_;
+    if (!scene->block_exists(id))
+      return nullptr;
+    this->keep_scene(scene);
+
+    // a compressed file is read and expanded rather than mapped, so the
+    // file is loaded without the stripe lock, while a placeholder keeps
+    // other threads asking for it waiting
+    s.entries[k].evicting = true;
+    lock.unlock();
+    boxm2_block_metadata mdata = scene->get_block_metadata(id);
+    entry e;
+    if (char* bytes = this->map_file(this->file_path(k), e))
+      blk = new boxm2_block(id, mdata, bytes);
+    else
+      blk = boxm2_sio_mgr::load_block(scene->data_path(), id, mdata);
+    if (!blk) {
+      std::cout<<"boxm2_mmap_cache::initializing empty block "<<id<<std::endl;
+      blk = new boxm2_block(mdata);
+      e.created = true;
+    }
+    e.block = blk;
+    e.bytes = e.mapped ? e.mapped : std::size_t(blk->byte_count());
+    e.pins = pin ? 1 : 0;
+    lock.lock();
+    this->insert(s, k, e);
+  }
+  s.evicted.notify_all();
+  this->evict_to_budget(&k);
+  return blk;
+}
+
+//: realization of abstract "get_block(block_id)"
+boxm2_block* boxm2_mmap_cache::get_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  key k = { scene.ptr(), std::string(), id };
+  return this->load_block(scene, k, false);
+}
+
+boxm2_mmap_cache::handle boxm2_mmap_cache::pin_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  key k = { scene.ptr(), std::string(), id };
+  return handle(this, k, this->load_block(scene, k, true), nullptr);
+}
+
+boxm2_data_base* boxm2_mmap_cache::load_data_base(boxm2_scene_sptr & scene, key const& k, std::size_t num_bytes, bool read_only, bool pin)
+{
+  boxm2_block_id id = k.id;
+  if (!scene->block_exists(id))
+    return nullptr;
+  // the block is only needed for its size, but it must not be evicted meanwhile
+  std::size_t byte_length;
+  {
+    handle blk = this->pin_block(scene, id);
+    byte_length = blk.block()->num_cells() * boxm2_data_info::datasize(k.type);
+  }
+  if (num_bytes > 0 && num_bytes != byte_length) {
+    std::stringstream ss;
+    ss<<"Attempting to retrieve "<<num_bytes<<" bytes for datatype " << k.type <<" when actual buffer size should be "<<byte_length;
+    throw std::runtime_error(ss.str());
+  }
+
+  boxm2_data_base* data;
+  stripe& s = this->stripe_of(k);
+  {
+    std::unique_lock<std::mutex> lock(s.mutex);
+    auto it = this->find(s, k, lock);
+    if (it != s.entries.end()) {
+      ++hits_;
+      it->second.last_use = ++clock_;
+      if (pin)
+        ++it->second.pins;
+      if (!read_only)  // write-enable is enforced
+        it->second.data->enable_write();
+      return it->second.data;
+    }
+    ++misses_;
+
+    // loaded without the stripe lock, as in load_block()
+    s.entries[k].evicting = true;
+    lock.unlock();
+    entry e;
+    if (char* bytes = this->map_file(this->file_path(k), e))
+      data = new boxm2_data_base(bytes, e.mapped, id, read_only);
+    else
+      data = boxm2_sio_mgr::load_block_data_generic(scene->data_path(), id, k.type);
+
+    // if num_bytes is greater than zero, the data must have that many bytes
+    if (data && num_bytes > 0 && data->buffer_length() != byte_length) {
+      e.data = data;
+      this->release_entry(e);
+      e = entry();
+      data = nullptr;
+    }
+    if (!data) {
+      std::cout<<"boxm2_mmap_cache::initializing empty data "<<id<<" type: "<<k.type<<std::endl;
+      data = new boxm2_data_base(new char[byte_length], byte_length, id, read_only);
+      data->set_default_value(k.type, scene->get_block_metadata(id));
+      e.created = true;
+    }
+    if (!read_only)
+      data->enable_write();
+    e.data = data;
+    e.bytes = data->buffer_length();
+    e.pins = pin ? 1 : 0;
+    lock.lock();
+    this->insert(s, k, e);
+  }
+  s.evicted.notify_all();
+  this->evict_to_budget(&k);
+  return data;
+}
+
+//: get data by type and id
+boxm2_data_base* boxm2_mmap_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  key k = { scene.ptr(), type, id };
+  return this->load_data_base(scene, k, num_bytes, read_only, false);
+}
+
+boxm2_mmap_cache::handle boxm2_mmap_cache::pin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string const& type, std::size_t num_bytes, bool read_only)
+{
+  key k = { scene.ptr(), type, id };
+  return handle(this, k, nullptr, this->load_data_base(scene, k, num_bytes, read_only, true));
+}
+
+void boxm2_mmap_cache::unpin(key const& k, boxm2_block* block, boxm2_data_base* data)
+{
+  stripe& s = this->stripe_of(k);
+  std::unique_lock<std::mutex> lock(s.mutex);
+  auto it = s.entries.find(k);
+  if (it != s.entries.end() && it->second.block == block && it->second.data == data) {
+    if (it->second.pins > 0)
+      --it->second.pins;
+    return;
+  }
+  // the entry was taken out of the index since it was pinned
+  for (auto r = s.retired.begin(); r != s.retired.end(); ++r) {
+    if (r->block != block || r->data != data)
+      continue;
+    if (--r->pins == 0) {
+      entry e = *r;
+      s.retired.erase(r);
+      bytes_mapped_ -= e.mapped;
+      lock.unlock();
+      this->release_entry(e);
+    }
+    return;
+  }
+}
+
+//: returns a data_base pointer which is initialized to the default value of the type.
+boxm2_data_base* boxm2_mmap_cache::get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  boxm2_block_metadata mdata = scene->get_block_metadata(id);
+  boxm2_data_base* block_data;
+  if (num_bytes > 0) {
+    block_data = new boxm2_data_base(new char[num_bytes], num_bytes, id, read_only);
+    block_data->set_default_value(type, mdata);
+  }
+  else {
+    // the following constructor also sets the default values
+    block_data = new boxm2_data_base(mdata, type, read_only);
+  }
+  this->keep_scene(scene);
+
+  key k = { scene.ptr(), type, id };
+  entry old;
+  {
+    stripe& s = this->stripe_of(k);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    auto it = this->find(s, k, lock);
+    if (it != s.entries.end()) {
+      // throw away what is in the cache, once it is no longer pinned
+      old = it->second;
+      if (!this->erase(s, it))
+        old = entry();
+    }
+    entry e;
+    e.data = block_data;
+    e.bytes = block_data->buffer_length();
+    e.created = true;
+    this->insert(s, k, e);
+  }
+  this->release_entry(old);
+  this->evict_to_budget(&k);
+  return block_data;
+}
+
+//: removes data from this cache (may or may not write to disk first)
+void boxm2_mmap_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out)
+{
+  key k = { scene.ptr(), type, id };
+  this->take_out(this->stripe_of(k), k, write_out, true, 0);
+}
+
+//: replaces data in the cache with one here
+void boxm2_mmap_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement)
+{
+  this->keep_scene(scene);
+  key k = { scene.ptr(), type, id };
+  entry old;
+  {
+    stripe& s = this->stripe_of(k);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    auto it = this->find(s, k, lock);
+    if (it != s.entries.end()) {
+      // copy the read_only/write status of the old data
+      replacement->read_only_ = it->second.data->read_only_;
+      old = it->second;
+      if (!this->erase(s, it))
+        old = entry();
+    }
+    entry e;
+    e.data = replacement;
+    e.bytes = replacement->buffer_length();
+    e.created = true;
+    this->insert(s, k, e);
+  }
+  this->release_entry(old);
+  this->evict_to_budget(&k);
+}
+
+//: puts a block read elsewhere in the cache
+bool boxm2_mmap_cache::add_block(boxm2_scene_sptr & scene, boxm2_block* blk)
+{
+  this->keep_scene(scene);
+  key k = { scene.ptr(), std::string(), blk->block_id() };
+  {
+    stripe& s = this->stripe_of(k);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (this->find(s, k, lock) != s.entries.end())
+      return false;
+    entry e;
+    e.block = blk;
+    e.bytes = std::size_t(blk->byte_count());
+    this->insert(s, k, e);
+  }
+  this->evict_to_budget(&k);
+  return true;
+}
+
+//: puts data read elsewhere in the cache
+bool boxm2_mmap_cache::add_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type, boxm2_data_base* data)
+{
+  this->keep_scene(scene);
+  key k = { scene.ptr(), type, id };
+  {
+    stripe& s = this->stripe_of(k);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (this->find(s, k, lock) != s.entries.end())
+      return false;
+    entry e;
+    e.data = data;
+    e.bytes = data->buffer_length();
+    this->insert(s, k, e);
+  }
+  this->evict_to_budget(&k);
+  return true;
+}
+
+//: writes the dirty blocks and data to disk
+void boxm2_mmap_cache::write_to_disk()
+{
+  this->write_scene_to_disk(nullptr);
+}
+
+//: writes the dirty blocks and data of the specified scene to disk
+void boxm2_mmap_cache::write_to_disk(boxm2_scene_sptr & scene)
+{
+  this->write_scene_to_disk(scene.ptr());
+}
+
+void boxm2_mmap_cache::write_scene_to_disk(boxm2_scene* scene)
+{
+  for (stripe& s : stripes_) {
+    // pin the entries, so they are not evicted while they are written
+    // without the stripe lock
+    std::vector<std::pair<key, entry> > pinned;
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (auto& kv : s.entries)
+        if ((!scene || kv.first.scene == scene) && !kv.second.evicting) {
+          ++kv.second.pins;
+          pinned.emplace_back(kv.first, kv.second);
+        }
+    }
+    for (auto& kv : pinned) {
+      this->write_entry(kv.first, kv.second);
+      this->unpin(kv.first, kv.second.block, kv.second.data);
+    }
+  }
+}
+
+//: add a new scene to the cache
+bool boxm2_mmap_cache::add_scene(boxm2_scene_sptr & scene)
+{
+  {
+    std::lock_guard<std::mutex> lock(scenes_mutex_);
+    for (auto const& s : scenes_) {
+      if (s == scene) {
+        std::cout<<"The scene Already exists "<<std::endl;
+        return false;
+      }
+    }
+  }
+  this->keep_scene(scene);
+  return true;
+}
+
+//: writes out and drops the blocks and data of a scene
+bool boxm2_mmap_cache::remove_scene(boxm2_scene_sptr & scene)
+{
+  for (stripe& s : stripes_) {
+    std::vector<key> keys;
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (auto const& kv : s.entries)
+        if (kv.first.scene == scene.ptr())
+          keys.push_back(kv.first);
+    }
+    for (key const& k : keys)
+      this->take_out(s, k, true, false, 0);
+  }
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  for (auto it = scenes_.begin(); it != scenes_.end(); ++it) {
+    if (*it == scene) {
+      scenes_.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+//: delete all the memory
+//  Caution: make sure to call write to disk methods not to loose writable data
+void boxm2_mmap_cache::clear_cache()
+{
+  for (stripe& s : stripes_) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (auto it = s.entries.begin(); it != s.entries.end(); ) {
+      // entries being written back or loaded are left to their thread
+      auto next = std::next(it);
+      entry e = it->second;
+      if (!e.evicting && this->erase(s, it))
+        this->release_entry(e);
+      it = next;
+    }
+  }
+}
+
+//: return list of scenes with data in the cache
+std::vector<boxm2_scene_sptr> boxm2_mmap_cache::get_scenes()
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  return scenes_;
+}
+
+void boxm2_mmap_cache::set_max_bytes(std::size_t max_bytes)
+{
+  max_bytes_ = max_bytes;
+  this->evict_to_budget(nullptr);
+}
+
+boxm2_mmap_cache_stats boxm2_mmap_cache::stats() const
+{
+  boxm2_mmap_cache_stats s;
+  s.hits = hits_;
+  s.misses = misses_;
+  s.evictions = evictions_;
+  s.bytes_cached = bytes_cached_;
+  s.bytes_mapped = bytes_mapped_;
+  s.bytes_written_back = bytes_written_back_;
+  return s;
+}
+
+//: shows the counters of the cache
+std::ostream& operator<<(std::ostream &s, boxm2_mmap_cache_stats const& stats)
+{
+  return s << "boxm2_mmap_cache: hits=" << stats.hits << " misses=" << stats.misses
+           << " hit rate=" << stats.hit_rate() << " evictions=" << stats.evictions
+           << "\n  bytes cached=" << stats.bytes_cached << " mapped=" << stats.bytes_mapped
+           << " written back=" << stats.bytes_written_back;
+}
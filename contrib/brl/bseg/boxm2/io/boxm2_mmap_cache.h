@@ -0,0 +1,284 @@
+#ifndef boxm2_mmap_cache_h_
+#define boxm2_mmap_cache_h_
+//:
+// \file
+// \brief boxm2_mmap_cache is a singleton cache which maps block and data files into memory
+//
+//  Block and data files are mapped rather than read into heap buffers, so
+//  loading a block only costs the pages the caller touches.  Two ways of
+//  writing back are available:
+//  - COPY_ON_WRITE maps the files privately.  Changes stay in memory until
+//    the block or data is evicted or write_to_disk() is called, when the
+//    dirty ones are written over their files.
+//  - WRITE_BACK maps the files shared, so changes go to the files through
+//    the page cache, and are flushed with msync on eviction and write_to_disk().
+//  Data which is not on disk yet is kept on the heap and saved as with
+//  boxm2_lru_cache.  Without mmap (e.g. on Windows) everything is read
+//  into the heap through boxm2_sio_mgr, as are compressed files
+//  (boxm2_compressed_file), which are written back uncompressed.
+//
+//  The cache index is split over a number of stripes, each with its own
+//  lock, so several threads can fetch blocks and data at the same time.
+//  Once the bytes held go over the budget, the least recently used blocks
+//  and data are evicted (and written back if they are dirty).  A pointer
+//  returned by get_block() or get_data_base() is valid until it is evicted,
+//  which another thread may do at any time.  Threads should rather pin what
+//  they work on with pin_block() or pin_data_base(): pinned blocks and data
+//  are not evicted until their handle is released, even when that leaves
+//  the cache over its budget, and if they are removed or replaced their
+//  buffers are kept until the last handle is released.  Evicted entries are
+//  written back, and missing ones read, without holding the lock of their
+//  stripe; a thread asking for one meanwhile waits until it is done.
+//
+//  Blocks and data are dirty if they were not read from disk, or were
+//  asked for with read_only false.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boxm2/io/boxm2_cache.h>
+
+//: Counters of a boxm2_mmap_cache
+struct boxm2_mmap_cache_stats
+{
+  unsigned long long hits;
+  unsigned long long misses;
+  unsigned long long evictions;
+  //: bytes of blocks and data held, counted against the budget
+  std::size_t bytes_cached;
+  //: bytes of the files currently mapped
+  std::size_t bytes_mapped;
+  //: bytes of dirty blocks and data written back so far
+  std::size_t bytes_written_back;
+
+  //: fraction of the requests found in the cache
+  double hit_rate() const { return hits+misses > 0 ? double(hits)/double(hits+misses) : 0.0; }
+};
+
+class boxm2_mmap_cache : public boxm2_cache
+{
+ public:
+  enum map_mode { COPY_ON_WRITE, WRITE_BACK };
+
+ private:
+  //: a block (empty type) or data in the index
+  struct key
+  {
+    boxm2_scene* scene;
+    std::string type;
+    boxm2_block_id id;
+    bool operator<(key const& that) const;
+    bool operator==(key const& that) const;
+  };
+
+ public:
+  //: Keeps a block or data in the cache while it exists.
+  //  Obtained from pin_block() or pin_data_base(); it can be moved but not copied.
+  class handle
+  {
+   public:
+    handle() = default;
+    handle(handle&& that) noexcept;
+    handle& operator=(handle&& that) noexcept;
+    handle(handle const&) = delete;
+    handle& operator=(handle const&) = delete;
+    ~handle() { this->release(); }
+
+    //: lets the block or data be evicted again
+    void release();
+
+    boxm2_block* block() const { return block_; }
+    boxm2_data_base* data() const { return data_; }
+    explicit operator bool() const { return block_ != nullptr || data_ != nullptr; }
+
+   private:
+    friend class boxm2_mmap_cache;
+    handle(boxm2_mmap_cache* cache, key const& k, boxm2_block* block, boxm2_data_base* data)
+    : cache_(block || data ? cache : nullptr), key_(k), block_(block), data_(data) {}
+
+    boxm2_mmap_cache* cache_ = nullptr;
+    key key_;
+    boxm2_block* block_ = nullptr;
+    boxm2_data_base* data_ = nullptr;
+  };
+
+  //: create function used instead of constructor
+  //  A boxm2_mmap_cache of another mode is written to disk and replaced.
+  static void create(const boxm2_scene_sptr& scene,
+                     std::size_t max_bytes = std::size_t(1)<<30,
+                     map_mode mode = COPY_ON_WRITE);
+
+  //: returns block pointer to block specified by ID
+  boxm2_block* get_block(boxm2_scene_sptr & scene, boxm2_block_id id) override;
+
+  //: returns data_base pointer (THIS IS NECESSARY BECAUSE TEMPLATED FUNCTIONS CANNOT BE VIRTUAL)
+  boxm2_data_base* get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: as get_block, but the block is not evicted while the handle is held
+  handle pin_block(boxm2_scene_sptr & scene, boxm2_block_id id);
+
+  //: as get_data_base, but the data is not evicted while the handle is held
+  handle pin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string const& type, std::size_t num_bytes=0, bool read_only = true);
+
+  //: returns a data_base pointer which is initialized to the default value of the type.
+  //  If a block for this type exists on the cache, it is removed and replaced with the new one.
+  //  This method does not check whether a block of this type already exists on the disc nor writes it to the disc
+  boxm2_data_base* get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: removes data from this cache (may or may not write to disk first)
+  //  Pinned data stays valid until its handles are released, as does that
+  //  replaced by the functions below, but later changes to it are lost.
+  void remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out=true) override;
+
+  //: replaces a database in the cache, deletes it
+  void replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement) override;
+
+  //: puts a block read elsewhere in the cache
+  bool add_block(boxm2_scene_sptr & scene, boxm2_block* blk) override;
+
+  //: puts data read elsewhere in the cache
+  bool add_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type, boxm2_data_base* data) override;
+
+  //: writes the dirty blocks and data to disk
+  void write_to_disk() override;
+
+  //: writes the dirty blocks and data of the specified scene to disk
+  void write_to_disk(boxm2_scene_sptr & scene) override;
+
+  //: add a new scene to the cache
+  bool add_scene(boxm2_scene_sptr & scene) override;
+
+  //: writes out and drops the blocks and data of a scene
+  bool remove_scene(boxm2_scene_sptr & scene) override;
+
+  //: delete all the memory, caution: make sure to call write to disc methods not to loose writable data
+  void clear_cache() override;
+
+  //: return the list of scenes with any data in the cache
+  std::vector<boxm2_scene_sptr> get_scenes() override;
+
+  //: the byte budget; lowering it evicts straight away
+  std::size_t max_bytes() const { return max_bytes_.load(); }
+  void set_max_bytes(std::size_t max_bytes);
+
+  map_mode mode() const { return mode_; }
+
+  //: the counters so far
+  boxm2_mmap_cache_stats stats() const;
+
+ private:
+  //: hidden constructor (private so it cannot be called -- forces the class to be singleton)
+  boxm2_mmap_cache(const boxm2_scene_sptr& scene, std::size_t max_bytes, map_mode mode);
+
+  //: hidden destructor (private so it cannot be called -- forces the class to be singleton)
+  ~boxm2_mmap_cache() override;
+
+  struct entry
+  {
+    boxm2_block* block = nullptr;
+    boxm2_data_base* data = nullptr;
+    //: bytes counted against the budget
+    std::size_t bytes = 0;
+    //: length of the file mapping, 0 if the buffer is on the heap
+    std::size_t mapped = 0;
+    //: the mapping writes through to the file
+    bool shared = false;
+    //: not read from disk, so it is always written out
+    bool created = false;
+    //: number of handles held
+    unsigned pins = 0;
+    //: being written back before it is taken out of the index, or read into it
+    bool evicting = false;
+    unsigned long long last_use = 0;
+  };
+
+  struct stripe
+  {
+    std::mutex mutex;
+    //: notified when an entry which was evicting leaves the index or is loaded
+    std::condition_variable evicted;
+    std::map<key, entry> entries;
+    //: entries taken out of the index while pinned, released by their last unpin
+    std::vector<entry> retired;
+  };
+
+  enum { num_stripes = 16 };
+
+  stripe& stripe_of(key const& k);
+
+  //: register the scene, so it outlives its blocks and data
+  void keep_scene(boxm2_scene_sptr const& scene);
+
+  //: finds k in stripe s, whose lock is held, once it is no longer evicting
+  std::map<key, entry>::iterator find(stripe& s, key const& k, std::unique_lock<std::mutex>& lock);
+
+  //: the block of k, loaded if need be, and pinned if pin is true
+  boxm2_block* load_block(boxm2_scene_sptr & scene, key const& k, bool pin);
+
+  //: the data of k, loaded if need be, and pinned if pin is true
+  boxm2_data_base* load_data_base(boxm2_scene_sptr & scene, key const& k, std::size_t num_bytes, bool read_only, bool pin);
+
+  //: drops a pin taken by pin_block() or pin_data_base()
+  void unpin(key const& k, boxm2_block* block, boxm2_data_base* data);
+
+  //: maps a file, setting the mapping of e; null if it cannot be mapped
+  char* map_file(std::string const& path, entry& e);
+
+  //: puts a loaded entry in the index of stripe s, which is locked
+  void insert(stripe& s, key const& k, entry& e);
+
+  //: Takes an entry out of the index of stripe s, which is locked.
+  //  Returns false if it is pinned, in which case it is retired rather than
+  //  released by the caller.
+  bool erase(stripe& s, std::map<key, entry>::iterator it);
+
+  //: writes an entry to its file if it is dirty (or in any case if force)
+  void write_entry(key const& k, entry& e, bool force = false);
+
+  //: writes the dirty blocks and data of scene, or of all scenes if it is null
+  void write_scene_to_disk(boxm2_scene* scene);
+
+  //: unmaps or deletes the block or data of an entry taken out of the index
+  void release_entry(entry& e);
+
+  //: Takes the entry of k out of stripe s, after writing it back if write is true.
+  //  If last_use is not 0 the entry is being evicted, so it is left alone
+  //  if it is pinned or was used after last_use; otherwise a pinned entry
+  //  is retired.  The file is written without holding the stripe lock.
+  //  Returns false if the entry is left.
+  bool take_out(stripe& s, key const& k, bool write, bool force, unsigned long long last_use);
+
+  //: evict least recently used entries, other than keep and pinned ones, until within the budget
+  void evict_to_budget(key const* keep);
+
+  std::string file_path(key const& k) const;
+
+  stripe stripes_[num_stripes];
+  std::atomic<std::size_t> max_bytes_;
+  map_mode mode_;
+
+  //: the scenes of the entries
+  std::mutex scenes_mutex_;
+  std::vector<boxm2_scene_sptr> scenes_;
+
+  //: only one thread evicts at a time
+  std::mutex evict_mutex_;
+
+  std::atomic<unsigned long long> clock_;
+  std::atomic<unsigned long long> hits_;
+  std::atomic<unsigned long long> misses_;
+  std::atomic<unsigned long long> evictions_;
+  std::atomic<std::size_t> bytes_cached_;
+  std::atomic<std::size_t> bytes_mapped_;
+  std::atomic<std::size_t> bytes_written_back_;
+};
+
+//: shows the counters of the cache
+std::ostream& operator<<(std::ostream &s, boxm2_mmap_cache_stats const& stats);
+
+#endif // boxm2_mmap_cache_h_
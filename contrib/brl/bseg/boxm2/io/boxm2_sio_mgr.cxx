@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include "boxm2_sio_mgr.h"
+#include <boxm2/basic/boxm2_compressed_file.h>
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -48,6 +49,12 @@ boxm2_block* boxm2_sio_mgr::load_block(const std::string& dir, const boxm2_block
     std::cerr << "boxm2_sio_mgr:: FileSystem -" << fs_type << " is not implemented, yet!\n";
     return nullptr;
   }
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
   //instantiate new block
   return new boxm2_block(block_id, bytes);
 }
@@ -88,6 +95,12 @@ boxm2_block* boxm2_sio_mgr::load_block(const std::string& dir, const boxm2_block
     std::cerr << "boxm2_sio_mgr:: FileSystem -" << fs_type << " is not implemented, yet!\n";
     return nullptr;
   }
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
   //instantiate new block
   auto * returnboxm2_block = new boxm2_block(block_id,data, bytes);
   return returnboxm2_block;
@@ -143,8 +156,14 @@ boxm2_data_base* boxm2_sio_mgr::load_block_data_generic(const std::string& dir,
     std::cerr << "boxm2_sio_mgr:: FileSystem -" << fs_type << " is not implemented, yet!\n";
     return nullptr;
   }
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
   //instantiate new block
-  return new boxm2_data_base(bytes,numBytes,id);
+  return new boxm2_data_base(bytes,len,id);
 }
 
 // generically saves data_base * to disk (given prefix)
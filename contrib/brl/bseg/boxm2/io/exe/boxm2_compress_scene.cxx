@@ -0,0 +1,123 @@
+//:
+// \file
+// \brief Compresses the block and data files of a boxm2 or bstm scene, or expands them back
+//
+//  Every .bin file in the data directory is rewritten in the format of
+//  boxm2_compressed_file, which the caches read as they read the raw files.
+//  The data of the boxm2 types is shuffled by the size of its cells; that
+//  of other types (e.g. bstm) by -width.  Blocks and time trees are not
+//  shuffled.
+//  \verbatim
+//    boxm2_compress_scene -dir scene/data/ [-chunk 1024] [-level 6] [-width 4]
+//    boxm2_compress_scene -dir scene/data/ -expand
+//  \endverbatim
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "vul/vul_arg.h"
+#include "vul/vul_file.h"
+#include "vul/vul_file_iterator.h"
+#include <vpl/vpl_thread_pool.h>
+#include <boxm2/boxm2_data_traits.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
+
+//: the shuffle width for a file, from the type in its name
+static unsigned shuffle_width(std::string const& name, unsigned default_width)
+{
+  // blocks are "id_i_j_k.bin", bstm time trees "tt_id_i_j_k.bin"
+  std::string::size_type id = name.rfind("id_");
+  if (id == 0 || id == std::string::npos || name.find("tt_") == 0)
+    return 1;
+  std::string prefix = name.substr(0, id - 1);
+  std::size_t size = boxm2_data_info::datasize(prefix);
+  return size > 0 ? unsigned(size) : default_width;
+}
+
+static bool read_file(std::string const& path, std::vector<char>& bytes)
+{
+  std::ifstream is(path.c_str(), std::ios::in | std::ios::binary);
+  bytes.resize(std::size_t(vul_file::size(path)));
+  is.read(bytes.data(), std::streamsize(bytes.size()));
+  return bool(is);
+}
+
+//: converts a file; returns false on failure
+static bool convert(std::string const& path, bool expand, unsigned default_width,
+                    std::size_t chunk_size, int level, std::size_t& size_before, std::size_t& size_after)
+{
+  std::vector<char> bytes;
+  if (!read_file(path, bytes))
+    return false;
+  size_before = size_after = bytes.size();
+  bool compressed = boxm2_compressed_file::is_compressed(bytes.data(), bytes.size());
+  if (compressed != expand)
+    return true;  // nothing to do
+
+  // write next to the file, then put it in its place
+  std::string tmp = path + ".tmp";
+  if (expand) {
+    std::vector<char> raw(boxm2_compressed_file::raw_length(bytes.data(), bytes.size()));
+    if (!boxm2_compressed_file::decompress(bytes.data(), bytes.size(), raw.data()))
+      return false;
+    std::ofstream os(tmp.c_str(), std::ios::out | std::ios::binary);
+    os.write(raw.data(), std::streamsize(raw.size()));
+    if (!os)
+      return false;
+    size_after = raw.size();
+  }
+  else {
+    unsigned width = shuffle_width(vul_file::strip_extension(vul_file::strip_directory(path)), default_width);
+    if (!boxm2_compressed_file::write(tmp, bytes.data(), bytes.size(), width, chunk_size, level))
+      return false;
+    size_after = std::size_t(vul_file::size(tmp));
+  }
+#ifdef _WIN32
+  std::remove(path.c_str());
+#endif
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+int main(int argc, char** argv)
+{
+  vul_arg<std::string> dir("-dir", "data directory of the scene", "");
+  vul_arg<bool> expand("-expand", "expand compressed files back to raw files", false);
+  vul_arg<unsigned> chunk_kb("-chunk", "chunk size in KB", boxm2_compressed_file::default_chunk_size/1024);
+  vul_arg<int> level("-level", "zlib compression level (1-9)", 6);
+  vul_arg<unsigned> width("-width", "shuffle width of data types boxm2 does not know", 4);
+  vul_arg_parse(argc, argv);
+
+  if (!vul_file::is_directory(dir())) {
+    std::cerr << "boxm2_compress_scene: " << dir() << " is not a directory\n";
+    return 1;
+  }
+  std::vector<std::string> files;
+  for (vul_file_iterator fn = dir() + "/*.bin"; fn; ++fn)
+    files.push_back(fn());
+
+  // the files are converted in parallel, as are the chunks of each file
+  std::vector<std::size_t> before(files.size(), 0), after(files.size(), 0);
+  std::vector<char> ok(files.size(), 0);
+  vpl_parallel_for(std::size_t(0), files.size(), [&](std::size_t f) {
+    ok[f] = convert(files[f], expand(), width(), std::size_t(chunk_kb())*1024, level(), before[f], after[f]);
+  }, std::size_t(1));
+
+  std::size_t total_before = 0, total_after = 0;
+  int failed = 0;
+  for (std::size_t f = 0; f < files.size(); ++f) {
+    if (!ok[f]) {
+      std::cerr << "boxm2_compress_scene: cannot convert " << files[f] << '\n';
+      ++failed;
+    }
+    total_before += before[f];
+    total_after += after[f];
+  }
+  std::size_t raw = expand() ? total_after : total_before;
+  std::size_t packed = expand() ? total_before : total_after;
+  std::cout << files.size() << " files, " << total_before << " bytes before, " << total_after << " bytes after";
+  if (packed > 0)
+    std::cout << " (compression ratio " << double(raw)/double(packed) << ')';
+  std::cout << std::endl;
+  return failed ? 1 : 0;
+}
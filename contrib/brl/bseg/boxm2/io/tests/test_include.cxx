@@ -1,7 +1,9 @@
 #include <boxm2/io/boxm2_asio_mgr.h>
+#include <boxm2/io/boxm2_block_prefetcher.h>
 #include <boxm2/io/boxm2_cache.h>
 #include <boxm2/io/boxm2_dumb_cache.h>
 #include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_mmap_cache.h>
 #include <boxm2/io/boxm2_nn_cache.h>
 #include <boxm2/io/boxm2_sio_mgr.h>
 #include <boxm2/io/boxm2_stream_block_cache.h>
@@ -0,0 +1,84 @@
+//:
+// \file
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_traits.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/io/boxm2_block_prefetcher.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_sio_mgr.h>
+#include "testlib/testlib_test.h"
+#include "test_utils.h"
+#include "vul/vul_file.h"
+
+static void test_block_prefetcher()
+{
+  std::string dir = vul_file::get_cwd() + "/block_prefetcher_test/";
+  vul_file::make_directory_path(dir);
+  vul_file::delete_file_glob(dir + "*.bin");
+
+  // four blocks of 4x4x4 unrefined trees in a row
+  boxm2_scene_sptr scene = boxm2_test_utils::create_test_row_scene(4, vgl_vector_3d<unsigned>(4,4,4), 1.0, 4, dir);
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks = scene->blocks();
+  std::vector<boxm2_block_id> ids;
+  for (int i=0; i<4; ++i)
+    ids.push_back(boxm2_block_id(i,0,0));
+  std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // all the blocks are on disk; the alpha of blocks 0 and 1, the alpha
+  // of block 2 with the wrong size, and no alpha for block 3
+  const unsigned n_cells = 64;
+  for (int i=0; i<4; ++i) {
+    boxm2_block blk(blocks[ids[i]]);
+    boxm2_sio_mgr::save_block(dir, &blk);
+    if (i == 3)
+      continue;
+    unsigned n = i == 2 ? n_cells/2 : n_cells;
+    boxm2_data_base data(new char[n*sizeof(float)], n*sizeof(float), ids[i]);
+    for (unsigned c=0; c<n; ++c)
+      reinterpret_cast<float*>(data.data_buffer())[c] = 0.5f*c + i;
+    boxm2_sio_mgr::save_block_data_base(dir, ids[i], &data, alpha);
+  }
+
+  boxm2_lru_cache::create(scene);
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  std::vector<boxm2_block_id> order;
+  order.push_back(ids[2]); order.push_back(ids[0]); order.push_back(ids[3]); order.push_back(ids[1]);
+  {
+    boxm2_block_prefetcher prefetch(scene, cache, order, std::vector<std::string>(1, alpha), 2);
+    for (unsigned n=0; n<order.size(); ++n) {
+      prefetch.fetch(n);
+      TEST("Fetched block is in the cache", cache->get_block(scene, order[n])->block_id(), order[n]);
+    }
+    std::cout << prefetch << std::endl;
+    TEST("Files read", prefetch.num_loads(), 7);
+    TEST("Overlap ratio", prefetch.overlap_ratio() >= 0.0 && prefetch.overlap_ratio() <= 1.0, true);
+    TEST("Stall time", prefetch.stall_time() >= 0.0, true);
+  }
+
+  // the cache has what was read ahead, so it does not need the files any more
+  vul_file::delete_file_glob(dir + "*.bin");
+  bool same = true;
+  for (int i=0; i<2; ++i) {
+    boxm2_data_base* data = cache->get_data_base(scene, ids[i], alpha);
+    same = same && data->buffer_length() == n_cells*sizeof(float);
+    for (unsigned c=0; same && c<n_cells; ++c)
+      same = reinterpret_cast<float*>(data->data_buffer())[c] == 0.5f*c + i;
+  }
+  TEST("Prefetched data is in the cache", same, true);
+
+  // data of the wrong size was left to the cache to initialize
+  boxm2_data_base alpha_init(blocks[ids[2]], alpha);
+  boxm2_data_base* alpha2 = cache->get_data_base(scene, ids[2], alpha, n_cells*sizeof(float));
+  TEST("Data of the wrong size is not prefetched", alpha2->buffer_length() == n_cells*sizeof(float) &&
+       reinterpret_cast<float*>(alpha2->data_buffer())[0] == reinterpret_cast<float*>(alpha_init.data_buffer())[0], true);
+
+  cache->clear_cache();
+}
+
+TESTMAIN(test_block_prefetcher);
@@ -0,0 +1,153 @@
+//:
+// \file
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_traits.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
+#include <boxm2/io/boxm2_asio_mgr.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_sio_mgr.h>
+#include "testlib/testlib_test.h"
+#include "vul/vul_file.h"
+#include <vpl/vpl_thread_pool.h>
+
+static void test_codec()
+{
+  // smooth float data, whose length is not a multiple of the chunks nor of the floats
+  std::vector<float> values(2501);
+  for (unsigned i=0; i<values.size(); ++i)
+    values[i] = 100.0f + std::sin(0.01f*i);
+  const char* raw = reinterpret_cast<const char*>(values.data());
+  std::size_t len = values.size()*sizeof(float) - 2;
+
+  vpl_set_concurrency(4);
+  std::vector<char> file = boxm2_compressed_file::compress(raw, len, 4, 1000);
+  TEST("Compressed", boxm2_compressed_file::is_compressed(file.data(), file.size()), true);
+  TEST("Smaller", file.size() < len, true);
+  TEST("Raw length", boxm2_compressed_file::raw_length(file.data(), file.size()), len);
+  std::vector<char> back(len);
+  TEST("Decompressed in parallel", boxm2_compressed_file::decompress(file.data(), file.size(), back.data()) &&
+       std::memcmp(back.data(), raw, len) == 0, true);
+  vpl_set_concurrency(0);
+
+  std::vector<char> plain = boxm2_compressed_file::compress(raw, len, 1, 1000);
+  std::cout << len << " bytes, " << plain.size() << " compressed, " << file.size() << " shuffled and compressed" << std::endl;
+  TEST("Shuffling compresses floats better", file.size() < plain.size(), true);
+
+  std::vector<char> truncated(file.begin(), file.end() - 1);
+  TEST("Truncated file is not valid", boxm2_compressed_file::raw_length(truncated.data(), truncated.size()), 0);
+  std::vector<char> corrupt = file;
+  corrupt[corrupt.size()/2] ^= 0x5a;
+  TEST("Corrupt chunk is not decompressed",
+       boxm2_compressed_file::decompress(corrupt.data(), corrupt.size(), back.data()), false);
+
+  char* bytes = new char[len];
+  std::memcpy(bytes, raw, len);
+  char* before = bytes;
+  std::size_t n = len;
+  TEST("Raw buffer is not expanded", boxm2_compressed_file::expand(bytes, n) && bytes == before && n == len, true);
+
+  // raw data which starts with the magic, even followed by a plausible
+  // header, is not taken for a compressed file
+  std::memcpy(bytes, file.data(), 32);
+  TEST("Raw buffer with a header is not compressed", boxm2_compressed_file::is_compressed(bytes, len), false);
+  TEST("Raw buffer with a header is not expanded",
+       boxm2_compressed_file::expand(bytes, n) && bytes == before && n == len, true);
+  delete [] bytes;
+  std::vector<char> bad_chunk = file;
+  std::uint64_t packed = 1;
+  std::memcpy(&bad_chunk[32], &packed, 8);
+  TEST("Chunk table must account for the file", boxm2_compressed_file::is_compressed(bad_chunk.data(), bad_chunk.size()), false);
+  std::vector<char> bad_reserved = file;
+  bad_reserved[12] = 1;
+  TEST("Reserved field must be 0", boxm2_compressed_file::is_compressed(bad_reserved.data(), bad_reserved.size()), false);
+}
+
+static void test_compressed_scene()
+{
+  std::string dir = vul_file::get_cwd() + "/compressed_file_test/";
+  vul_file::make_directory_path(dir);
+  vul_file::delete_file_glob(dir + "*.bin");
+
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin(vgl_point_3d<double>(0,0,0));
+  scene->set_data_path(dir);
+  boxm2_block_id id(0,0,0);
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks;
+  blocks.emplace(id, boxm2_block_metadata(id, vgl_point_3d<double>(0,0,0), vgl_vector_3d<double>(1,1,1),
+                                          vgl_vector_3d<unsigned>(8,8,8), 1, 4, 100, 0.01));
+  scene->set_blocks(blocks);
+  std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // write the block and its alpha compressed
+  const unsigned n_cells = 512;
+  boxm2_block blk(blocks[id]);
+  char* blk_bytes = blk.buffer();
+  blk.b_write(blk_bytes);
+  boxm2_compressed_file::write(dir + id.to_string() + ".bin", blk_bytes, blk.byte_count());
+  std::vector<float> values(n_cells);
+  for (unsigned c=0; c<n_cells; ++c)
+    values[c] = 0.25f*(c%16);
+  boxm2_compressed_file::write(dir + alpha + "_" + id.to_string() + ".bin",
+                               reinterpret_cast<char*>(values.data()), n_cells*sizeof(float), sizeof(float));
+  TEST("Files are compressed", vul_file::size(dir + alpha + "_" + id.to_string() + ".bin") < n_cells*sizeof(float), true);
+
+  boxm2_block* loaded = boxm2_sio_mgr::load_block(dir, id, blocks[id]);
+  TEST("Compressed block is read", loaded && loaded->num_cells() == n_cells &&
+       std::memcmp(loaded->buffer(), blk_bytes, blk.byte_count()) == 0, true);
+  delete loaded;
+  boxm2_data_base* data = boxm2_sio_mgr::load_block_data_generic(dir, id, alpha);
+  TEST("Compressed data is read", data && data->buffer_length() == n_cells*sizeof(float) &&
+       std::memcmp(data->data_buffer(), values.data(), n_cells*sizeof(float)) == 0, true);
+  delete data;
+
+  // asynchronous reads are expanded too
+  boxm2_asio_mgr asio;
+  asio.load_block_data_generic(dir, id, alpha);
+  std::map<boxm2_block_id, boxm2_data_base*> got;
+  while (got.empty())
+    got = asio.get_loaded_data_generic(alpha);
+  TEST("Compressed data is read asynchronously", got[id]->buffer_length() == n_cells*sizeof(float) &&
+       std::memcmp(got[id]->data_buffer(), values.data(), n_cells*sizeof(float)) == 0, true);
+  delete got[id];
+
+  // and so through the cache, which writes it back uncompressed
+  boxm2_lru_cache::create(scene);
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  data = cache->get_data_base(scene, id, alpha, n_cells*sizeof(float), false);
+  TEST("Cache reads compressed data", std::memcmp(data->data_buffer(), values.data(), n_cells*sizeof(float)), 0);
+  cache->write_to_disk();
+  std::string alpha_file = dir + alpha + "_" + id.to_string() + ".bin";
+  TEST("Written back uncompressed", vul_file::size(alpha_file), n_cells*sizeof(float));
+  cache->clear_cache();
+
+  // a raw data file starting with the magic is read as it is
+  for (unsigned c=0; c<n_cells; ++c)
+    values[c] = float(c);
+  std::memcpy(values.data(), "BXZ1", 4);
+  boxm2_data_base raw_alpha(new char[n_cells*sizeof(float)], n_cells*sizeof(float), id);
+  std::memcpy(raw_alpha.data_buffer(), values.data(), n_cells*sizeof(float));
+  boxm2_sio_mgr::save_block_data_base(dir, id, &raw_alpha, alpha);
+  data = boxm2_sio_mgr::load_block_data_generic(dir, id, alpha);
+  TEST("Raw file starting with the magic is read raw", data && data->buffer_length() == n_cells*sizeof(float) &&
+       std::memcmp(data->data_buffer(), values.data(), n_cells*sizeof(float)) == 0, true);
+  delete data;
+  vul_file::delete_file_glob(dir + "*.bin");
+}
+
+static void test_compressed_file()
+{
+  test_codec();
+  test_compressed_scene();
+}
+
+TESTMAIN(test_compressed_file);
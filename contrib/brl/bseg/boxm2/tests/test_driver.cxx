@@ -8,6 +8,9 @@ DECLARE( test_wrappers );
 DECLARE( test_data );
 DECLARE( test_block );
 DECLARE( test_block_vis_graph );
+DECLARE( test_mmap_cache );
+DECLARE( test_block_prefetcher );
+DECLARE( test_compressed_file );
 
 
 
@@ -21,6 +24,9 @@ void register_tests()
   REGISTER( test_data );
   REGISTER( test_block );
   REGISTER( test_block_vis_graph );
+  REGISTER( test_mmap_cache );
+  REGISTER( test_block_prefetcher );
+  REGISTER( test_compressed_file );
 
 }
 
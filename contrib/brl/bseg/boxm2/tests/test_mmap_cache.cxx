@@ -0,0 +1,190 @@
+//:
+// \file
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_data_traits.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/basic/boxm2_compressed_file.h>
+#include <boxm2/io/boxm2_mmap_cache.h>
+#include <boxm2/io/boxm2_sio_mgr.h>
+#include "testlib/testlib_test.h"
+#include "test_utils.h"
+#include "vul/vul_file.h"
+#include <vpl/vpl_thread_pool.h>
+
+static float alpha_at(boxm2_data_base* data, unsigned c)
+{
+  return reinterpret_cast<float*>(data->data_buffer())[c];
+}
+
+static void test_mmap_cache()
+{
+  std::string dir = vul_file::get_cwd() + "/mmap_cache_test/";
+  vul_file::make_directory_path(dir);
+  vul_file::delete_file_glob(dir + "*.bin");
+
+  // a row of blocks of 4x4x4 unrefined trees
+  const unsigned n_blocks = 8;
+  boxm2_scene_sptr scene = boxm2_test_utils::create_test_row_scene(n_blocks, vgl_vector_3d<unsigned>(4,4,4), 1.0, 4, dir);
+  boxm2_block_id id0(0,0,0), id1(1,0,0);
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks = scene->blocks();
+  std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // all blocks are on disk, but only the alpha of the first one
+  for (auto& b : blocks) {
+    boxm2_block blk(b.second);
+    boxm2_sio_mgr::save_block(dir, &blk);
+  }
+  const unsigned n_cells = 64;
+  auto* alpha_disk = new boxm2_data_base(new char[n_cells*sizeof(float)], n_cells*sizeof(float), id0);
+  for (unsigned c=0; c<n_cells; ++c)
+    reinterpret_cast<float*>(alpha_disk->data_buffer())[c] = 0.5f*c;
+  boxm2_sio_mgr::save_block_data_base(dir, id0, alpha_disk, alpha);
+
+  boxm2_mmap_cache::create(scene, 1<<20);
+  auto* cache = static_cast<boxm2_mmap_cache*>(boxm2_cache::instance().ptr());
+  boxm2_block* blk = cache->get_block(scene, id0);
+  TEST("Block is loaded", blk && blk->block_id() == id0 && blk->num_cells() == n_cells, true);
+  boxm2_data_base* alpha0 = cache->get_data_base(scene, id0, alpha);
+  bool same = alpha0 && alpha0->buffer_length() == n_cells*sizeof(float);
+  for (unsigned c=0; same && c<n_cells; ++c)
+    same = alpha_at(alpha0, c) == 0.5f*c;
+  TEST("Data is loaded", same, true);
+  TEST("Data is found again", cache->get_data_base(scene, id0, alpha), alpha0);
+  boxm2_mmap_cache_stats stats = cache->stats();
+  std::cout << stats << std::endl;
+  TEST("Misses", stats.misses, 2);
+  TEST("Hits", stats.hits, 3);
+  TEST("Bytes cached", stats.bytes_cached, 64*16 + n_cells*sizeof(float));
+
+  // several threads asking for the same blocks get the same data
+  std::vector<boxm2_data_base*> got(64);
+  vpl_set_concurrency(8);
+  vpl_parallel_for(0u, 64u, [&](unsigned n) {
+    got[n] = cache->get_data_base(scene, n%2 ? id1 : id0, alpha);
+  }, 1u);
+  vpl_set_concurrency(0);
+  bool consistent = got[0] == alpha0 && got[1] != nullptr;
+  for (unsigned n=2; n<64; ++n)
+    consistent = consistent && got[n] == got[n%2];
+  TEST("Threads get the same data", consistent, true);
+  boxm2_data_base alpha_init(blocks[id1], alpha);
+  TEST("Data not on disk is initialized", alpha_at(got[1], 0), alpha_at(&alpha_init, 0));
+
+  // dirty data is written back when evicted
+  cache->get_data_base(scene, id0, alpha, 0, false);
+  reinterpret_cast<float*>(alpha0->data_buffer())[3] = 42.0f;
+  reinterpret_cast<float*>(got[1]->data_buffer())[5] = 7.0f;
+  cache->set_max_bytes(0);
+  stats = cache->stats();
+  std::cout << stats << std::endl;
+  TEST("Everything is evicted", stats.evictions == 4 && stats.bytes_cached == 0 && stats.bytes_mapped == 0, true);
+  TEST("Only the dirty data is written back", stats.bytes_written_back, 2*n_cells*sizeof(float));
+  boxm2_data_base* disk0 = boxm2_sio_mgr::load_block_data_generic(dir, id0, alpha);
+  boxm2_data_base* disk1 = boxm2_sio_mgr::load_block_data_generic(dir, id1, alpha);
+  TEST("Changed data is on disk", disk0 && disk1 && alpha_at(disk0, 3) == 42.0f &&
+       alpha_at(disk0, 4) == 2.0f && alpha_at(disk1, 5) == 7.0f, true);
+  delete disk0;
+  delete disk1;
+
+  cache->set_max_bytes(1<<20);
+  alpha0 = cache->get_data_base(scene, id0, alpha);
+  TEST("Written data is read again", alpha_at(alpha0, 3), 42.0f);
+
+  // pinned data is kept while other threads evict everything else
+  cache->set_max_bytes(0);
+  unsigned long long evictions = cache->stats().evictions;
+  {
+    boxm2_mmap_cache::handle pinned = cache->pin_data_base(scene, id0, alpha);
+    boxm2_data_base* pinned_data = pinned.data();
+    std::atomic<bool> intact(true);
+    vpl_set_concurrency(8);
+    vpl_parallel_for(0u, 256u, [&](unsigned n) {
+      boxm2_block_id id(n%n_blocks,0,0);
+      boxm2_mmap_cache::handle h = cache->pin_data_base(scene, id, alpha);
+      if (!h || h.data()->buffer_length() != n_cells*sizeof(float) ||
+          alpha_at(h.data(), 0) != (id == id0 ? 0.0f : alpha_at(&alpha_init, 0)) ||
+          alpha_at(pinned_data, 3) != 42.0f)
+        intact = false;
+    }, 1u);
+    vpl_set_concurrency(0);
+    TEST("Pinned data survives concurrent eviction",
+         intact && cache->get_data_base(scene, id0, alpha) == pinned_data, true);
+    TEST("Unpinned data is evicted", cache->stats().evictions > evictions + n_blocks, true);
+  }
+  cache->set_max_bytes(0);
+  TEST("Released data is evicted", cache->stats().bytes_cached, 0);
+
+  // replaced or removed data stays valid while it is pinned
+  cache->set_max_bytes(1<<20);
+  {
+    boxm2_mmap_cache::handle h = cache->pin_data_base(scene, id0, alpha);
+    auto* replacement = new boxm2_data_base(new char[n_cells*sizeof(float)], n_cells*sizeof(float), id0);
+    std::memset(replacement->data_buffer(), 0, n_cells*sizeof(float));
+    cache->replace_data_base(scene, id0, alpha, replacement);
+    TEST("Replacement is found", cache->get_data_base(scene, id0, alpha), replacement);
+    TEST("Replaced data is read through its handle", h.data() != replacement && alpha_at(h.data(), 3) == 42.0f, true);
+    TEST("Replaced data stays mapped", cache->stats().bytes_mapped, 64*16 + n_cells*sizeof(float));
+    boxm2_mmap_cache::handle h2 = cache->pin_data_base(scene, id0, alpha);
+    cache->remove_data_base(scene, id0, alpha, false);
+    TEST("Removed data is read through its handle", h2.data() == replacement && alpha_at(h2.data(), 3) == 0.0f, true);
+    h.release();
+    TEST("Replaced data is unmapped with its last handle", cache->stats().bytes_mapped, 64*16);
+  }
+
+  // threads asking for a compressed file while it is read get the one copy
+  std::vector<char> packed = boxm2_compressed_file::compress(alpha_disk->data_buffer(), n_cells*sizeof(float), sizeof(float));
+  if (!packed.empty()) {
+    boxm2_block_id id2(2,0,0);
+    {
+      std::ofstream file((dir + alpha + "_" + id2.to_string() + ".bin").c_str(), std::ios::binary);
+      file.write(packed.data(), packed.size());
+    }
+    std::vector<boxm2_data_base*> got2(32);
+    vpl_set_concurrency(8);
+    vpl_parallel_for(0u, 32u, [&](unsigned n) {
+      got2[n] = cache->get_data_base(scene, id2, alpha);
+    }, 1u);
+    vpl_set_concurrency(0);
+    bool one_copy = got2[0] && got2[0]->buffer_length() == n_cells*sizeof(float) && alpha_at(got2[0], 4) == 2.0f;
+    for (unsigned n=1; n<32; ++n)
+      one_copy = one_copy && got2[n] == got2[0];
+    TEST("Compressed data is loaded once", one_copy, true);
+    cache->remove_data_base(scene, id2, alpha, false);
+  }
+
+  // in WRITE_BACK mode changes go to the files through the shared mapping
+  boxm2_mmap_cache::create(scene, 1<<20, boxm2_mmap_cache::WRITE_BACK);
+  cache = static_cast<boxm2_mmap_cache*>(boxm2_cache::instance().ptr());
+  TEST("Cache of another mode replaces the first", cache->mode(), boxm2_mmap_cache::WRITE_BACK);
+  {
+    boxm2_mmap_cache::handle h = cache->pin_data_base(scene, id0, alpha, 0, false);
+    TEST("Data file is mapped", h && cache->stats().bytes_mapped == 64*16 + n_cells*sizeof(float), true);
+    reinterpret_cast<float*>(h.data()->data_buffer())[6] = 13.0f;
+    boxm2_data_base* disk = boxm2_sio_mgr::load_block_data_generic(dir, id0, alpha);
+    TEST("Changes reach the file before write back", disk && alpha_at(disk, 6) == 13.0f, true);
+    delete disk;
+  }
+  cache->set_max_bytes(0);
+  stats = cache->stats();
+  std::cout << stats << std::endl;
+  TEST("Mapped data is flushed on eviction",
+       stats.evictions == 2 && stats.bytes_written_back == n_cells*sizeof(float) && stats.bytes_mapped == 0, true);
+  boxm2_data_base* disk = boxm2_sio_mgr::load_block_data_generic(dir, id0, alpha);
+  TEST("Written back data is on disk", disk && alpha_at(disk, 6) == 13.0f && alpha_at(disk, 3) == 42.0f, true);
+  delete disk;
+
+  cache->clear_cache();
+  delete alpha_disk;
+  vul_file::delete_file_glob(dir + "*.bin");
+}
+
+TESTMAIN(test_mmap_cache);
@@ -290,6 +290,27 @@ bool boxm2_test_utils::create_test_simple_scene(boxm2_scene_sptr & scene)
   return true;
 }
 
+boxm2_scene_sptr boxm2_test_utils::create_test_row_scene(unsigned n_blocks,
+                                                         vgl_vector_3d<unsigned> const& n_trees,
+                                                         double tree_len,
+                                                         int max_level,
+                                                         std::string const& data_path)
+{
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin(vgl_point_3d<double>(0.0, 0.0, 0.0));
+  scene->set_data_path(data_path);
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks;
+  for (unsigned i=0; i<n_blocks; ++i) {
+    boxm2_block_id id(i,0,0);
+    blocks.emplace(id, boxm2_block_metadata(id, vgl_point_3d<double>(i*n_trees.x()*tree_len, 0.0, 0.0),
+                                            vgl_vector_3d<double>(tree_len, tree_len, tree_len),
+                                            n_trees, 1, max_level, 100, 0.01));
+  }
+  scene->set_blocks(blocks);
+  scene->set_appearances(std::vector<std::string>(1, boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()));
+  return scene;
+}
+
 vpgl_camera_double_sptr boxm2_test_utils::test_camera()
 {
   vnl_matrix_fixed<double, 3, 3> mk(0.0);
@@ -305,3 +326,12 @@ vpgl_camera_double_sptr boxm2_test_utils::test_camera()
   vpgl_camera_double_sptr cam = new vpgl_perspective_camera<double>(K,t,R);
   return cam;
 }
+
+vpgl_camera_double_sptr boxm2_test_utils::test_camera_above(unsigned ni)
+{
+  vpgl_calibration_matrix<double> K(100.0*ni, vgl_point_2d<double>(0.5*ni, 0.5*ni));
+  vnl_matrix_fixed<double, 3, 3> mr(0.0);
+  mr[0][0]=1.0; mr[1][1]=-1.0; mr[2][2]=-1.0;
+  vgl_rotation_3d<double> R(mr);
+  return new vpgl_perspective_camera<double>(K, vgl_point_3d<double>(0.5,0.5,100.0), R);
+}
@@ -32,11 +32,20 @@ class boxm2_test_utils
     static   std::map<boxm2_block_id,boxm2_block_metadata> generate_simple_metadata();
     static std::string   save_test_empty_scene();
     static bool create_test_simple_scene(boxm2_scene_sptr & scene);
+    //: a row of n_blocks blocks along x from the origin, of n_trees unrefined trees of side tree_len
+    //  The trees may be refined up to max_level; the appearance is BOXM2_MOG3_GREY.
+    static boxm2_scene_sptr create_test_row_scene(unsigned n_blocks,
+                                                  vgl_vector_3d<unsigned> const& n_trees,
+                                                  double tree_len,
+                                                  int max_level,
+                                                  std::string const& data_path = "");
     static void  test_block_equivalence(boxm2_block& a, boxm2_block& b);
 
     template <boxm2_data_type data_type>
     static void test_data_equivalence(boxm2_data<data_type>& a, boxm2_data<data_type>& b);
     static vpgl_camera_double_sptr test_camera();
+    //: a camera above the unit square looking down, which fills an ni x ni image
+    static vpgl_camera_double_sptr test_camera_above(unsigned ni);
     static const int init_level_ =1;
     static const int max_level_ =4;
     static const int treeLen_ = 64*64;
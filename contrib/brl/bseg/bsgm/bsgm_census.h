@@ -7,6 +7,8 @@
 #include <limits>
 #include <vgl/vgl_box_2d.h>
 #include <vil/vil_image_view.h>
+#include <vpl/vpl_thread_pool.h>
+#include <baml/baml_census.h>
 
 //:
 // \file
@@ -67,40 +69,21 @@ bool bsgm_compute_census_img(
 
   census.set_size( width, height );
   census_conf.set_size( width, height );
-
-  // Iterate over each pixel
-  T max_val = std::numeric_limits<T>::max();
-  for (int y = start_y; y < stop_y; y++) {
-    for (int x = start_x; x < stop_x; x++) {
-      T img_xy = img(x, y);
-      T center_max = T( std::min<T>( max_val, img_xy + tol ) );
-      T center_min = 0;
-      if (img_xy > tol)
-        center_min = T(std::max<T>(0, img_xy - tol));
-
-      unsigned long long cen = 0;
-      unsigned long long conf = 0;
-
-      int x_min = x - nbhd_rad, y_min = y - nbhd_rad;
-
-      for( int dy = 0; dy < nbhd_diam; dy++ ){
-        const T* img_x2y2 = &img( x_min, y_min + dy );
-        for( int dx = 0; dx < nbhd_diam; dx++, img_x2y2++ ){
-          // Record the sign of the sample-to-center difference in a bit at
-          // each pixel in a patch.
-          cen <<= 1;
-          if( *img_x2y2 < img_xy ) cen++;
-
-          // Also record whether the pixel differs significantly from the
-          // center in a separate "confidence" bit
-          conf <<= 1;
-          if( *img_x2y2 <= center_min || *img_x2y2 >= center_max ) conf++;
-        }
-      }
-      census(x, y) = cen;
-      census_conf(x, y) = conf;
-    }
+  census.fill( 0 );
+  census_conf.fill( 0 );
+
+  // The kernel needs contiguous rows; copy once rather than in each thread
+  vil_image_view<T> img_rows = img;
+  if( img.istep() != 1 ){
+    img_rows = vil_image_view<T>();
+    img_rows.deep_copy( img );
   }
+
+  // Rows are independent, so split them between threads
+  vpl_parallel_for_range( start_y, stop_y, [&]( int y0, int y1 ){
+    baml_compute_census_rows( img_rows, nbhd_diam, nbhd_diam, tol,
+      start_x, stop_x, y0, y1, census, census_conf );
+  }, 16 );
   return true;
 };
 
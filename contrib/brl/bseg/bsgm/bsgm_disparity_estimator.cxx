@@ -17,6 +17,26 @@
 #include "bsgm_error_checking.h"
 #include <brip/brip_line_generator.h>
 #include <bsta/bsta_histogram.h>
+#include <vil/vil_config.h>
+#include <vpl/vpl_thread_pool.h>
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+#  include <emmintrin.h>
+#  ifdef __SSE4_1__
+#    include <smmintrin.h>
+#  endif
+
+//: Unsigned 16 bit minimum, which SSE2 only has for signed values
+static inline __m128i
+bsgm_min_epu16( __m128i a, __m128i b )
+{
+#  ifdef __SSE4_1__
+  return _mm_min_epu16( a, b );
+#  else
+  const __m128i sign = _mm_set1_epi16( static_cast<short>(0x8000) );
+  return _mm_xor_si128( _mm_min_epi16( _mm_xor_si128( a, sign ), _mm_xor_si128( b, sign ) ), sign );
+#  endif
+}
+#endif
 
 //----------------------------------------------------------------------------
 bsgm_disparity_estimator::bsgm_disparity_estimator(
@@ -89,6 +109,7 @@ void bsgm_disparity_estimator::compute_xgrad_data(
   const vil_image_view<int>& min_disparity,
   const vgl_box_2d<int>& target_window)
 {
+  VUL_PROFILE_ZONE("bsgm xgradient cost");
   // target and reference images have same size
   int ni = static_cast<int>(grad_x_tar.ni()), nj = static_cast<int>(grad_x_tar.nj());
 
@@ -236,6 +257,7 @@ bsgm_disparity_estimator::run_multi_dp(
   const vil_image_view<float>& grad_y,
   const vil_image_view<int>& min_disparity)
 {
+  VUL_PROFILE_ZONE("bsgm dynamic programming");
   long long int volume_size = w_*h_*num_disparities_;
   long long int row_size = w_*num_disparities_;
   int num_dirs = params_.use_16_directions ? 16 : 8;
@@ -375,7 +397,7 @@ bsgm_disparity_estimator::run_multi_dp(
     // The 8 or 16 dynamic programming directions are set in the following
     // section.  Each even/odd dir index pair correspond to the same path but
     // in reverse.
-    int dx, dy, temp_dx = 0, temp_dy = 0;
+    int dx, dy;
     int x_start, y_start, x_end, y_end;
     bool alt_x = false, alt_y = false;
     int deriv_idx;
@@ -524,34 +546,40 @@ bsgm_disparity_estimator::run_multi_dp(
       throw std::runtime_error("Invalid start index");
     }
 
-    // Initialize previous row
-    for( long long int v = 0; v < row_size; v++ )
-      dir_cost_prev[v] = 0;
-
-    // Loop through rows
-    for( int y = y_start; y != y_end + y_inc; y += y_inc ){
-
-      // Re-initialize current row in case dir follows row
-      for( long long int v = 0; v < row_size; v++ )
-        dir_cost_cur[v] = 0;
-
-      // Swap path idx if necessary for directions 8-15
-      if( alt_x ) std::swap( dx, temp_dx );
-      if( alt_y && dy == 0 ) std::swap( dy, temp_dy );
-
-      for( int x = x_start; x != x_end + x_inc; x += x_inc ){
-
-        // Swap path idx if necessary for directions 8-15
-        if( alt_y ) std::swap( dy, temp_dy );
+    // Horizontal paths have no dependence between rows, so rows are run
+    // in parallel, each with its own row buffer.  The other paths depend
+    // on the previous row, and along directions 8,9,14,15 also on the
+    // previous pixel at every other pixel, so each of their rows is split
+    // into bands of pixels run in parallel, each band starting at a pixel
+    // which depends only on the previous row.  Each element of the total
+    // cost is updated by one thread, so the result does not depend on the
+    // number of threads.
+    const int num_x = (x_end - x_start)*x_inc + 1;
+    const int num_y = (y_end - y_start)*y_inc + 1;
+
+    // Run pixels [k0,k1) from x_start of row r from y_start
+    auto run_pixels = [&]( int r, int k0, int k1,
+                           const unsigned short* prev_row,
+                           unsigned short* cur_row ){
+      int y = y_start + r*y_inc;
+
+      // Path idx for directions 8-15, which alternate dx by row and dy
+      // by pixel, starting with 0
+      int step_x = ( alt_x && r%2 == 0 ) ? 0 : dx;
+
+      for( int k = k0; k < k1; k++ ){
+        int x = x_start + k*x_inc;
+        int step_y = ( alt_y && k%2 == 0 ) ? 0 : dy;
 
         // Quit early if invalid pixel
         if( invalid_tar(x,y) )
           continue;
 
         // If configured, compute a P2 weight based on local gradient
+        unsigned short pix_p2 = p2;
         if(!shad_step_dynamic_prog && params_.use_gradient_weighted_smoothing ){
           float g = deriv_img[deriv_idx](x,y);
-          p2 = (unsigned short)(p2_max + (p2_min-p2_max)* g);
+          pix_p2 = (unsigned short)(p2_max + (p2_min-p2_max)* g);
         }
         // If configured, compute p1, p2 values based on shadow data
         // shadow_step prob image and sun ray direction must be valid
@@ -564,7 +592,7 @@ bsgm_disparity_estimator::run_multi_dp(
           float ss = sp*1.5;
           if(ss > 1.0)ss = 1.0;
           // decrease p2 over shadow step interval
-          p2 = p2_max + (p2_min-p2_max)* ss;
+          pix_p2 = p2_max + (p2_min-p2_max)* ss;
 
           // In shadow, limit the dynamic program direction to that closest to opposite the sun ray dir
           // that is, update total cost along the direction towards the shadow casting step discontinuity from outside the shadow
@@ -593,26 +621,48 @@ bsgm_disparity_estimator::run_multi_dp(
         }
 
         // Compute the directional smoothing cost and add to total
-        if( dy == 0 )
-          compute_dir_cost(
-            &dir_cost_cur[(x+dx)*num_disparities_],
-            (*active_app_cost_)[y][x],
-            &dir_cost_cur[x*num_disparities_],
-            total_cost[y][x], dir_weight*p1, dir_weight*p2,// p1, p2,
-            min_disparity(x+dx,y+dy), min_disparity(x,y),
-            suppress_appearance, adj_weight);
-        else
-          compute_dir_cost(
-            &dir_cost_prev[(x+dx)*num_disparities_],
-            (*active_app_cost_)[y][x],
-            &dir_cost_cur[x*num_disparities_],
-            total_cost[y][x], dir_weight*p1, dir_weight*p2,// p1, p2,
-            min_disparity(x+dx,y+dy), min_disparity(x,y),
-            suppress_appearance, adj_weight);
+        compute_dir_cost(
+          &( step_y == 0 ? cur_row : prev_row )[(x+step_x)*num_disparities_],
+          (*active_app_cost_)[y][x],
+          &cur_row[x*num_disparities_],
+          total_cost[y][x], dir_weight*p1, dir_weight*pix_p2,// p1, p2,
+          min_disparity(x+step_x,y+step_y), min_disparity(x,y),
+          suppress_appearance, adj_weight);
       } //x
+    };
+
+    if( dy == 0 && !alt_y ){
+      vpl_parallel_for_range( 0, num_y, [&]( int r0, int r1 ){
+        std::vector<unsigned short> row_cost( row_size );
+        for( int r = r0; r < r1; r++ ){
+          std::fill( row_cost.begin(), row_cost.end(), (unsigned short)0 );
+          run_pixels( r, 0, num_x, row_cost.data(), row_cost.data() );
+        }
+      } );
+      continue;
+    }
+
+    // Bands hold an even number of pixels, after the first one
+    const int band_size = 2*static_cast<int>( std::max( 32LL, 8192/num_disparities_ ) );
+    const int num_bands = std::max( 1, (num_x - 1)/band_size );
+
+    // Initialize previous row
+    std::fill( dir_cost_prev.begin(), dir_cost_prev.end(), (unsigned short)0 );
+
+    // Loop through rows
+    for( int r = 0; r < num_y; r++ ){
+
+      // Re-initialize current row
+      std::fill( dir_cost_cur.begin(), dir_cost_cur.end(), (unsigned short)0 );
 
-      // Copy current row to previous
-      dir_cost_prev = dir_cost_cur;
+      vpl_parallel_for( 0, num_bands, [&]( int b ){
+        int k0 = b == 0 ? 0 : 1 + b*band_size;
+        int k1 = b == num_bands - 1 ? num_x : 1 + (b + 1)*band_size;
+        run_pixels( r, k0, k1, dir_cost_prev.data(), dir_cost_cur.data() );
+      }, 1 );
+
+      // Current row becomes the previous
+      dir_cost_prev.swap( dir_cost_cur );
     } //y
   } //dir
 
@@ -633,61 +683,100 @@ bsgm_disparity_estimator::compute_dir_cost(
   bool suppress_appearance,
   float adj_weight)
 {
+  const int num_d = static_cast<int>( num_disparities_ );
+
   // Compute the offset the aligns previous and current disparities
   int prev_offset = cur_min_disparity - prev_min_disparity;
 
-  const unsigned short* prc = prev_row_cost;
-
   // Compute jump cost from best previous disparity with p2 penalty
-  unsigned short min_prev_cost = *prc; prc++;
-  std::tuple<float, float, float, float, float> cst;
-  for( int d = 1; d < num_disparities_; d++, prc++ )
-    min_prev_cost = *prc < min_prev_cost ? *prc : min_prev_cost;
+  unsigned short min_prev_cost = *prev_row_cost;
+  int d = 1;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  if( num_d >= 8 ){
+    __m128i min8 = _mm_loadu_si128( (const __m128i*)prev_row_cost );
+    for( d = 8; d + 8 <= num_d; d += 8 )
+      min8 = bsgm_min_epu16( min8, _mm_loadu_si128( (const __m128i*)(prev_row_cost + d) ) );
+    unsigned short lanes[8];
+    _mm_storeu_si128( (__m128i*)lanes, min8 );
+    for( int i = 0; i < 8; i++ )
+      min_prev_cost = lanes[i] < min_prev_cost ? lanes[i] : min_prev_cost;
+  }
+#endif
+  for( ; d < num_d; d++ )
+    min_prev_cost = prev_row_cost[d] < min_prev_cost ? prev_row_cost[d] : min_prev_cost;
   unsigned short jump_cost = min_prev_cost + p2;
 
-  // Setup iteration pointers for coming loop
-  prc = prev_row_cost + prev_offset;
-  const unsigned char* cac = cur_app_cost;
-  unsigned short* crc = cur_row_cost;
-  unsigned short* tc = total_cost;
-  // Main loop through disparities
-  for( int d = 0; d < num_disparities_; d++, prc++, cac++, crc++, tc++ ){
+  // Disparities whose previous d-1, d and d+1 are all in range
+  int d_begin = 0, d_end = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  int d_lo = std::max( 0, 1 - prev_offset );
+  int d_hi = std::min( num_d, num_d - 1 - prev_offset );
+  if( !suppress_appearance && d_hi - d_lo >= 8 ){
+    d_begin = d_lo;
+    d_end = d_lo + ((d_hi - d_lo)/8)*8;
+
+    // The same sums as below, wrapping around in 16 bits
+    const __m128i jump8 = _mm_set1_epi16( static_cast<short>(jump_cost) );
+    const __m128i p1_8 = _mm_set1_epi16( static_cast<short>(p1) );
+    const __m128i min_prev8 = _mm_set1_epi16( static_cast<short>(min_prev_cost) );
+    const __m128i zero = _mm_setzero_si128();
+    for( d = d_begin; d < d_end; d += 8 ){
+      const unsigned short* prc = prev_row_cost + d + prev_offset;
+      __m128i best = bsgm_min_epu16( jump8, _mm_loadu_si128( (const __m128i*)prc ) );
+      best = bsgm_min_epu16( best, _mm_add_epi16( _mm_loadu_si128( (const __m128i*)(prc-1) ), p1_8 ) );
+      best = bsgm_min_epu16( best, _mm_add_epi16( _mm_loadu_si128( (const __m128i*)(prc+1) ), p1_8 ) );
+      __m128i app = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(cur_app_cost + d) ), zero );
+      __m128i crc = _mm_sub_epi16( _mm_add_epi16( app, best ), min_prev8 );
+      _mm_storeu_si128( (__m128i*)(cur_row_cost + d), crc );
+      __m128i tc = _mm_loadu_si128( (const __m128i*)(total_cost + d) );
+      _mm_storeu_si128( (__m128i*)(total_cost + d), _mm_add_epi16( tc, crc ) );
+    }
+  }
+#endif
 
-    // This is the index of d in the previous cost vector
-    int d_off = d + prev_offset;
+  // Loop through the remaining disparities in [d0,d1)
+  auto scalar_dir_cost = [&]( int d0, int d1 ){
+    for( int d = d0; d < d1; d++ ){
 
-    // The best cost for each disparity is the min of the jump with cost P2...
-    unsigned short best_cost = jump_cost;
+      // This is the index of d in the previous cost vector
+      int d_off = d + prev_offset;
+      const unsigned short* prc = prev_row_cost + d_off;
 
-    // ...the min of no disparity change with 0 cost...
-    if( d_off >= 0 && d_off < num_disparities_ ){
-      unsigned short prc_d = *prc;
-      best_cost = prc_d < best_cost ? prc_d: best_cost;
-    }
+      // The best cost for each disparity is the min of the jump with cost P2...
+      unsigned short best_cost = jump_cost;
 
-    // ...and +/- 1 disparity with P1 cost
-    // -1
-    if( d_off > 0 && d_off <= num_disparities_ ){
-      unsigned short prc_dm1 = *(prc-1) + p1;
-      best_cost = prc_dm1 < best_cost ? prc_dm1: best_cost;
-    }
-    // +1
-    if( d_off >= -1 && d_off < num_disparities_-1 ){
-      unsigned short prc_dp1 = *(prc+1) + p1;
-      best_cost = prc_dp1 < best_cost ? prc_dp1: best_cost;
-    }
+      // ...the min of no disparity change with 0 cost...
+      if( d_off >= 0 && d_off < num_d ){
+        unsigned short prc_d = *prc;
+        best_cost = prc_d < best_cost ? prc_d: best_cost;
+      }
 
-    // Add the appearance cost and subtract off lowest cost to prevent
-    // numerical overflow. Appearance cost is constant if suppressed
-    // so that best previous cost dominates.
-    if(suppress_appearance){
-       *crc =  vxl_byte(255) + best_cost - min_prev_cost;
-       *tc += (*crc)*adj_weight;
-    }else{
-      *crc = *cac + best_cost - min_prev_cost;
-      *tc += (*crc);
-    }
-  }// end of disparity loop
+      // ...and +/- 1 disparity with P1 cost
+      // -1
+      if( d_off > 0 && d_off <= num_d ){
+        unsigned short prc_dm1 = *(prc-1) + p1;
+        best_cost = prc_dm1 < best_cost ? prc_dm1: best_cost;
+      }
+      // +1
+      if( d_off >= -1 && d_off < num_d-1 ){
+        unsigned short prc_dp1 = *(prc+1) + p1;
+        best_cost = prc_dp1 < best_cost ? prc_dp1: best_cost;
+      }
+
+      // Add the appearance cost and subtract off lowest cost to prevent
+      // numerical overflow. Appearance cost is constant if suppressed
+      // so that best previous cost dominates.
+      if(suppress_appearance){
+         cur_row_cost[d] =  vxl_byte(255) + best_cost - min_prev_cost;
+         total_cost[d] += cur_row_cost[d]*adj_weight;
+      }else{
+        cur_row_cost[d] = cur_app_cost[d] + best_cost - min_prev_cost;
+        total_cost[d] += cur_row_cost[d];
+      }
+    }// end of disparity loop
+  };
+  scalar_dir_cost( 0, d_begin );
+  scalar_dir_cost( d_end, num_d );
 }
 
 //-------------------------------------------------------------------
@@ -700,6 +789,7 @@ bsgm_disparity_estimator::compute_best_disparity_img(
   vil_image_view<float>& disp_img,
   vil_image_view<unsigned short>& disp_cost )
 {
+  VUL_PROFILE_ZONE("bsgm disparity extraction");
   disp_img.set_size( w_, h_ );
   disp_cost.set_size( w_, h_ );
 
@@ -817,6 +907,8 @@ std::ostream& operator<<(std::ostream& os, const bsgm_disparity_estimator_params
      << "xgrad_weight:                    " << params.xgrad_weight << std::endl
      << "census_tol:                      " << params.census_tol << std::endl
      << "census_rad:                      " << params.census_rad << std::endl
+     << "tile_memory_budget:              " << params.tile_memory_budget << std::endl
+     << "tile_overlap:                    " << params.tile_overlap << std::endl
      << "print_timing:                    " << params.print_timing << std::endl
      ;
   return os;
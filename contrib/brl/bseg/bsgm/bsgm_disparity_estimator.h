@@ -13,6 +13,8 @@
 #include <utility>
 
 #include <vul/vul_timer.h>
+#include <vul/vul_profiler.h>
+#include <vpl/vpl_thread_pool.h>
 #include <vnl/vnl_math.h>
 #include <vil/vil_crop.h>
 #include <vil/vil_copy.h>
@@ -104,6 +106,15 @@ struct bsgm_disparity_estimator_params
   //: The length of the census kernel will be 2*census_rad+1. Must be 1,2,or 3.
   int census_rad;
 
+  //: If > 0, bsgm_multiscale_disparity_estimator runs the full resolution
+  // SGM on overlapping tiles which each need at most about this many bytes,
+  // rather than on the whole image. Computation fails if the budget is too
+  // small for any tile. See bsgm_tiled_disparity_estimator.
+  long long int tile_memory_budget;
+
+  //: The number of pixels by which each tile overlaps its neighbours.
+  int tile_overlap;
+
   //: Print detailed timing information to cerr.
   bool print_timing;
 
@@ -127,6 +138,8 @@ struct bsgm_disparity_estimator_params
     xgrad_weight(0.7f),
     census_tol(2),
     census_rad(2),
+    tile_memory_budget(0),
+    tile_overlap(64),
     print_timing(false)
     {}
 };
@@ -278,7 +291,7 @@ class bsgm_disparity_estimator
     const vil_image_view<int>& min_disparity);
 
   //: Pixel-wise directional cost
-  inline void compute_dir_cost(
+  void compute_dir_cost(
     const unsigned short* prev_row_cost,
     const unsigned char* cur_app_cost,
     unsigned short* cur_row_cost,
@@ -377,6 +390,7 @@ void bsgm_disparity_estimator::compute_census_data(
   const vgl_box_2d<int>& target_window,
   const vgl_box_2d<int>& reference_window)
 {
+  VUL_PROFILE_ZONE("bsgm census cost");
   vul_timer t;
 
   // target and reference images have same size
@@ -402,7 +416,6 @@ void bsgm_disparity_estimator::compute_census_data(
   if( census_diam > 7 ) census_diam = 7;
   if( census_diam < 3 ) census_diam = 3;
   float census_norm = 8.0f*cost_unit_/(float)(census_diam*census_diam);
-  bool only_32_bits = census_diam <= 5;
 
   // Compute census images
   vil_image_view<vxl_uint_64> census_tar, census_ref;
@@ -418,61 +431,62 @@ void bsgm_disparity_estimator::compute_census_data(
   /* std::cout << "compute census images " << t.real() << " msec." << std::endl; */
   /* t.mark(); */
 
-  // Construct a bit-set look-up table for use later
-  unsigned char bit_set_table[256];
-  bsgm_generate_bit_set_lut( bit_set_table );
+  // Look-up table of the updated appearance cost for each hamming distance
+  // and previous cost, saturated at 255
+  std::vector<unsigned char> cost_update( 65*256 );
+  for (int ham = 0; ham <= 64; ham++) {
+    float ham_norm = census_norm*ham;
+    for (int ac = 0; ac < 256; ac++) {
+      float ac_new = (float)ac + params_.census_weight*ham_norm;
+      cost_update[ham*256 + ac] = (unsigned char)( ac_new > 255.0f ? 255.0f : ac_new );
+    }
+  }
 
   // Compute the appearance cost volume
   // (keep track of SGM cost volume indices, and the corresponding target image indices)
-  for (int cost_y = 0, img_y = img_start_y; cost_y < h_; cost_y++, img_y++) {
-    for (int cost_x = 0, img_x = img_start_x; cost_x < w_; cost_x++, img_x++) {
-
-      unsigned char* ac = app_cost[cost_y][cost_x];
-
-      // If invalid pixel, fill with 255
-      if (invalid_tar(cost_x, cost_y)) {
-        for( int d = 0; d < num_disparities_; d++, ac++ )
-          *ac = 255;
-        continue;
-      }
-
-      // Target census values
-      vxl_uint_64 cen_t = census_tar(img_x, img_y);
-      vxl_uint_64 conf_t = census_conf_tar(img_x, img_y);
-
-      // Compute all costs
-      int img_x2 = img_x + min_disparity(cost_x, cost_y);
-      for (int d = 0; d < num_disparities_; d++, img_x2++, ac++) {
-
-        // Check valid match pixel
-        /* if (img_x2 < 0 || img_x2 >= w_) */
-        if (img_x2 < 0 || img_x2 >= ni)
-          *ac = 255;
-
-        // Compare census values using hamming distance
-        else {
-
-          // reference census values
-          vxl_uint_64 cen_r = census_ref(img_x2, img_y);
-          vxl_uint_64 conf_r = census_conf_ref(img_x2, img_y);
-
-          // census comparison
-          unsigned long long int cen_diff =
-            bsgm_compute_diff_string( cen_t, cen_r, conf_t, conf_r );
-
-          unsigned char ham =
-            bsgm_compute_hamming_lut( cen_diff, bit_set_table, only_32_bits );
-
-          float ham_norm = census_norm*ham;
-          // weighted update of appearance cost
-          float ac_new = (float)(*ac) + params_.census_weight*ham_norm;
-
-          *ac = (unsigned char)( ac_new > 255.0f ? 255.0f : ac_new );
+  // Rows are independent, so split them between threads
+  int nd = static_cast<int>(num_disparities_);
+  vpl_parallel_for_range(0, static_cast<int>(h_), [&](int y0, int y1) {
+    std::vector<unsigned char> ham(nd);
+    for (int cost_y = y0, img_y = img_start_y + y0; cost_y < y1; cost_y++, img_y++) {
+      const vxl_uint_64* cen_ref_row = &census_ref(0, img_y);
+      const vxl_uint_64* conf_ref_row = &census_conf_ref(0, img_y);
+      for (int cost_x = 0, img_x = img_start_x; cost_x < w_; cost_x++, img_x++) {
+
+        unsigned char* ac = app_cost[cost_y][cost_x];
+
+        // If invalid pixel, fill with 255
+        if (invalid_tar(cost_x, cost_y)) {
+          for( int d = 0; d < nd; d++ )
+            ac[d] = 255;
+          continue;
         }
 
-      } //d
-    } //j
-  } //i
+        // Disparities [d0, d1) have a match pixel inside the image, the
+        // others get the maximum cost
+        int img_x2 = img_x + min_disparity(cost_x, cost_y);
+        int d0 = std::min(nd, std::max(0, -img_x2));
+        int d1 = std::max(d0, std::min(nd, ni - img_x2));
+        for (int d = 0; d < d0; d++)
+          ac[d] = 255;
+        for (int d = d1; d < nd; d++)
+          ac[d] = 255;
+        if (d0 == d1)
+          continue;
+
+        // Compare census values using hamming distance, for all
+        // disparities at once
+        baml_census_hamming(
+          census_tar(img_x, img_y), census_conf_tar(img_x, img_y),
+          cen_ref_row + img_x2 + d0, conf_ref_row + img_x2 + d0,
+          d1 - d0, &ham[d0]);
+
+        // weighted update of appearance cost
+        for (int d = d0; d < d1; d++)
+          ac[d] = cost_update[ham[d]*256 + ac[d]];
+      }
+    }
+  }, 4);
   if (params_.print_timing)
     print_time("Census appearance cost", t);
   /* std::cout << "" << t.real() << " msec." << std::endl; */
@@ -492,6 +506,7 @@ bool bsgm_disparity_estimator::compute(
   const vgl_box_2d<int>& target_window,
   vgl_box_2d<int> reference_window)
 {
+  VUL_PROFILE_ZONE("bsgm compute");
   // validate target image is big enough for the cost volume
   if (target_window.is_empty()) {
     if (img_tar.ni() != w_ || img_tar.nj() != h_){
@@ -504,8 +519,8 @@ bool bsgm_disparity_estimator::compute(
       throw std::runtime_error("target window not the same size as cost volume");
     }
     // target image must be large enough to be indexable by the target window
-    if (target_window.min_x() < 0 || img_tar.ni() <= (unsigned)target_window.max_x() ||
-        target_window.min_y() < 0 || img_tar.nj() <= (unsigned)target_window.max_y()) {
+    if (target_window.min_x() < 0 || img_tar.ni() < (unsigned)target_window.max_x() ||
+        target_window.min_y() < 0 || img_tar.nj() < (unsigned)target_window.max_y()) {
       throw std::runtime_error("target window outside target image extents");
     }
 
@@ -515,8 +530,8 @@ bool bsgm_disparity_estimator::compute(
     }
 
     // reference image must be large enough to be indexable by the reference window
-    if (reference_window.min_x() < 0 || img_ref.ni() <= (unsigned)reference_window.max_x() ||
-        reference_window.min_y() < 0 || img_ref.nj() <= (unsigned)reference_window.max_y()) {
+    if (reference_window.min_x() < 0 || img_ref.ni() < (unsigned)reference_window.max_x() ||
+        reference_window.min_y() < 0 || img_ref.nj() < (unsigned)reference_window.max_y()) {
       throw std::runtime_error("reference window outside reference image extents");
     }
   }
@@ -113,8 +113,15 @@ bsgm_multiscale_disparity_estimator::bsgm_multiscale_disparity_estimator(
     }
   }
   coarse_de_ = new bsgm_disparity_estimator(params, coarse_w_, coarse_h_, num_coarse_disparities_ , ss_coarse_, sh_coarse_, sun_dir_tar_);
-  fine_de_ = new bsgm_disparity_estimator(
-    params, fine_w_, fine_h_, num_active_disparities, shadow_step_prob_, shadow_prob_, sun_dir_tar_);
+  fine_de_ = nullptr;
+  fine_tiled_de_ = nullptr;
+  if( params_.tile_memory_budget > 0 )
+    fine_tiled_de_ = new bsgm_tiled_disparity_estimator(
+      params, fine_w_, fine_h_, num_active_disparities, params_.tile_memory_budget,
+      params_.tile_overlap, shadow_step_prob_, shadow_prob_, sun_dir_tar_);
+  else
+    fine_de_ = new bsgm_disparity_estimator(
+      params, fine_w_, fine_h_, num_active_disparities, shadow_step_prob_, shadow_prob_, sun_dir_tar_);
 }
 
 
@@ -123,6 +130,7 @@ bsgm_multiscale_disparity_estimator::~bsgm_multiscale_disparity_estimator()
 {
   delete coarse_de_;
   delete fine_de_;
+  delete fine_tiled_de_;
 }
 
 vil_image_view<float> bsgm_multiscale_disparity_estimator::fill_1x1_holes(vil_image_view<float> const& img) {
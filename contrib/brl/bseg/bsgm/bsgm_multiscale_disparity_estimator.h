@@ -21,6 +21,7 @@
 #include <vil/algo/vil_gauss_reduce.h>
 
 #include "bsgm_disparity_estimator.h"
+#include "bsgm_tiled_disparity_estimator.h"
 
 //:
 // \file
@@ -28,6 +29,10 @@
 // \author Thomas Pollard
 // \date June 7, 2016
 //
+//  If params.tile_memory_budget > 0 the full resolution SGM runs on
+//  overlapping tiles (see bsgm_tiled_disparity_estimator), so that its cost
+//  volumes need not hold the whole image.
+//
 //  Modifications
 //   Jun, 2016 Yi Dong - add input parameter for function 'compute'
 // \endverbatim
@@ -95,7 +100,8 @@ class bsgm_multiscale_disparity_estimator
     const std::string& out_dir,
     bool write_total_cost = false )
   {
-    fine_de_->write_cost_debug_imgs(out_dir, write_total_cost);
+    if (fine_de_)
+      fine_de_->write_cost_debug_imgs(out_dir, write_total_cost);
   }
   vil_image_view<float> fill_1x1_holes(vil_image_view<float> const& img); 
  protected:
@@ -121,6 +127,8 @@ int bsgm_compute_median_of_image(
   //: Single-scale SGMs for coarse and fine scales
   bsgm_disparity_estimator* coarse_de_;
   bsgm_disparity_estimator* fine_de_;
+  //: Used instead of fine_de_ with a tile memory budget
+  bsgm_tiled_disparity_estimator* fine_tiled_de_;
   bsgm_disparity_estimator_params params_;
   //illumination-related data
   vil_image_view<float> shadow_step_prob_;
@@ -261,7 +269,12 @@ bool bsgm_multiscale_disparity_estimator::compute(
   }
 
   // Run fine-scale SGM
-  if( !fine_de_->compute( img_tar, img_ref, invalid_tar,
+  if( fine_tiled_de_ ){
+    if( !fine_tiled_de_->compute( img_tar, img_ref, invalid_tar,
+        min_disp_img_fine, invalid_disp, disp_tar, dynamic_range_factor, skip_error_check ) )
+      return false;
+  }
+  else if( !fine_de_->compute( img_tar, img_ref, invalid_tar,
       min_disp_img_fine, invalid_disp, disp_tar, dynamic_range_factor, skip_error_check ) )
     return false;
   
@@ -0,0 +1,150 @@
+// This is brl/bseg/bsgm/bsgm_tiled_disparity_estimator.cxx
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "bsgm_tiled_disparity_estimator.h"
+
+// Tiles are not split below this size
+static const int bsgm_min_tile_size = 32;
+
+
+//----------------------------------------------------------------------------
+bsgm_tiled_disparity_estimator::bsgm_tiled_disparity_estimator(
+  const bsgm_disparity_estimator_params& params,
+  int img_width,
+  int img_height,
+  int num_disparities,
+  long long int memory_budget,
+  int overlap,
+  vil_image_view<float> const& shadow_step_prob,
+  vil_image_view<float> const& shadow_prob,
+  vgl_vector_2d<float> const& sun_dir_tar) :
+    params_( params ),
+    w_( img_width ),
+    h_( img_height ),
+    num_disparities_( num_disparities ),
+    memory_budget_( memory_budget ),
+    overlap_( std::max( overlap, 0 ) ),
+    shadow_step_prob_( shadow_step_prob ),
+    shadow_prob_( shadow_prob ),
+    sun_dir_tar_( sun_dir_tar )
+{
+  // The census radius is limited to 3, and the gradients use a 3x3 kernel
+  int census_rad = std::min( std::max( params_.census_rad, 1 ), 3 );
+  margin_ = census_rad + 1;
+}
+
+
+//----------------------------------------------------------------------------
+long long int bsgm_tiled_disparity_estimator::tile_memory(
+  const vgl_box_2d<int>& window,
+  int ref_min_x,
+  int ref_max_x) const
+{
+  long long int win_size = static_cast<long long int>( window.width() )*window.height();
+  int crop_w = std::min( w_, std::max( window.max_x(), ref_max_x ) + margin_ ) -
+               std::max( 0, std::min( window.min_x(), ref_min_x ) - margin_ );
+  int crop_h = std::min( h_, window.max_y() + margin_ ) -
+               std::max( 0, window.min_y() - margin_ );
+  long long int crop_size = static_cast<long long int>( crop_w )*crop_h;
+
+  // Fused (1 byte) and total (2 byte) costs for each disparity, directional
+  // derivatives, disparity and disparity cost images in the window, and
+  // census (4 x 8 bytes) and gradient (4 x 4 bytes) images over the crop
+  return win_size*( 3LL*num_disparities_ + 26 ) + crop_size*48;
+}
+
+
+//----------------------------------------------------------------------------
+vgl_box_2d<int> bsgm_tiled_disparity_estimator::grow_tile(
+  const vgl_box_2d<int>& tile) const
+{
+  return vgl_box_2d<int>(
+    std::max( 0, tile.min_x() - overlap_ ), std::min( w_, tile.max_x() + overlap_ ),
+    std::max( 0, tile.min_y() - overlap_ ), std::min( h_, tile.max_y() + overlap_ ) );
+}
+
+
+//----------------------------------------------------------------------------
+bool bsgm_tiled_disparity_estimator::reference_columns(
+  const vgl_box_2d<int>& window,
+  const vil_image_view<int>& min_disparity,
+  int& ref_min_x,
+  int& ref_max_x) const
+{
+  int lo = std::numeric_limits<int>::max();
+  int hi = std::numeric_limits<int>::min();
+  for( int y = window.min_y(); y < window.max_y(); y++ ){
+    for( int x = window.min_x(); x < window.max_x(); x++ ){
+      lo = std::min( lo, min_disparity(x,y) );
+      hi = std::max( hi, min_disparity(x,y) );
+    }
+  }
+  if( lo > hi ) return false;
+
+  // img_ref( x + d, y ) for d in [min_disparity, min_disparity + num_disparities)
+  ref_min_x = std::max( 0, window.min_x() + lo );
+  ref_max_x = std::min( w_, window.max_x() - 1 + hi + num_disparities_ );
+  return ref_min_x < ref_max_x;
+}
+
+
+//----------------------------------------------------------------------------
+bool bsgm_tiled_disparity_estimator::plan_tiles(
+  const vil_image_view<int>& min_disparity)
+{
+  tiles_.clear();
+  if( w_ <= 0 || h_ <= 0 ) return true;
+
+  // Without a budget run a single tile
+  if( memory_budget_ <= 0 ){
+    tiles_.emplace_back( 0, w_, 0, h_ );
+    return true;
+  }
+
+  // Start from square tiles which would fit the budget if the reference
+  // columns were those of the window, then split those which do not
+  double per_pixel = 3.0*num_disparities_ + 26.0 + 48.0;
+  int side = static_cast<int>( std::sqrt( memory_budget_/per_pixel ) ) - 2*overlap_;
+  side = std::max( side, bsgm_min_tile_size );
+
+  for( int y = 0; y < h_; y += side )
+    for( int x = 0; x < w_; x += side )
+      if( !add_tile( vgl_box_2d<int>( x, std::min( w_, x + side ), y, std::min( h_, y + side ) ),
+                     min_disparity ) ){
+        tiles_.clear();
+        return false;
+      }
+  return true;
+}
+
+
+//----------------------------------------------------------------------------
+bool bsgm_tiled_disparity_estimator::add_tile(
+  const vgl_box_2d<int>& tile,
+  const vil_image_view<int>& min_disparity)
+{
+  vgl_box_2d<int> window = grow_tile( tile );
+  int ref_min_x, ref_max_x;
+  bool fits = !reference_columns( window, min_disparity, ref_min_x, ref_max_x ) ||
+              tile_memory( window, ref_min_x, ref_max_x ) <= memory_budget_;
+  bool splittable = tile.width() >= 2*bsgm_min_tile_size ||
+                    tile.height() >= 2*bsgm_min_tile_size;
+  if( fits ){
+    tiles_.push_back( tile );
+    return true;
+  }
+  if( !splittable ) return false;
+
+  // Split across the longer side
+  if( tile.width() >= tile.height() ){
+    int mid_x = ( tile.min_x() + tile.max_x() )/2;
+    return add_tile( vgl_box_2d<int>( tile.min_x(), mid_x, tile.min_y(), tile.max_y() ), min_disparity ) &&
+           add_tile( vgl_box_2d<int>( mid_x, tile.max_x(), tile.min_y(), tile.max_y() ), min_disparity );
+  }
+  int mid_y = ( tile.min_y() + tile.max_y() )/2;
+  return add_tile( vgl_box_2d<int>( tile.min_x(), tile.max_x(), tile.min_y(), mid_y ), min_disparity ) &&
+         add_tile( vgl_box_2d<int>( tile.min_x(), tile.max_x(), mid_y, tile.max_y() ), min_disparity );
+}
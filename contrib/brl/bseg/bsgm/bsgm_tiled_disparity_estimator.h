@@ -0,0 +1,213 @@
+// This is brl/bseg/bsgm/bsgm_tiled_disparity_estimator.h
+#ifndef bsgm_tiled_disparity_estimator_h_
+#define bsgm_tiled_disparity_estimator_h_
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <vil/vil_crop.h>
+#include <vil/vil_image_view.h>
+#include <vgl/vgl_box_2d.h>
+#include <vgl/vgl_vector_2d.h>
+
+#include "bsgm_disparity_estimator.h"
+
+//:
+// \file
+// \brief SGM on overlapping tiles, with a bound on the memory used.
+//
+// A bsgm_disparity_estimator holds cost volumes of w*h*num_disparities
+// elements (3 bytes each) for the whole image. This class splits the
+// target image into tiles, each small enough that one
+// bsgm_disparity_estimator for it (cost volumes, census and gradient
+// images of the image area it reads) fits in the given memory budget, and
+// runs them one after the other.
+//
+// Each tile is grown by the overlap on each side, so that the dynamic
+// program and the error checks see the context around it, and only the
+// disparities inside the tile itself are kept. The reference image is
+// read only over the columns which the per-pixel disparity ranges
+// (min_disparity to min_disparity+num_disparities-1) of the grown tile
+// can reach. A tile whose range covers too many columns for the budget is
+// split again. If a tile of the smallest size still does not fit, because
+// the budget is too small for the overlap or the disparity range, compute
+// fails rather than exceed the budget.
+//
+// With an overlap much larger than the distance over which the SGM paths
+// carry information the result matches a single bsgm_disparity_estimator;
+// differences are confined to a few pixels near the tile boundaries.
+
+
+class bsgm_tiled_disparity_estimator
+{
+ public:
+
+  //: Construct from parameters.
+  // The memory budget is in bytes. The shadow images, if given, must have
+  // the size of the image.
+  bsgm_tiled_disparity_estimator(
+    const bsgm_disparity_estimator_params& params,
+    int img_width,
+    int img_height,
+    int num_disparities,
+    long long int memory_budget,
+    int overlap,
+    vil_image_view<float> const& shadow_step_prob = vil_image_view<float>(),
+    vil_image_view<float> const& shadow_prob = vil_image_view<float>(),
+    vgl_vector_2d<float> const& sun_dir_tar = vgl_vector_2d<float>(0.0f, 0.0f));
+
+  //: Run SGM on each tile, with the arguments of
+  // bsgm_disparity_estimator::compute.
+  // Returns false if the images do not have the size given on construction,
+  // or if the image cannot be split into tiles which fit the memory budget.
+  template <class T>
+  bool compute(
+    const vil_image_view<T>& img_target,
+    const vil_image_view<T>& img_ref,
+    const vil_image_view<bool>& invalid_target,
+    const vil_image_view<int>& min_disparity,
+    float invalid_disparity,
+    vil_image_view<float>& disp_target,
+    float dynamic_range_factor = 1.0f,
+    bool skip_error_check = false);
+
+  //: The tiles (without overlap) used by the last call to compute
+  const std::vector< vgl_box_2d<int> >& tiles() const { return tiles_; }
+
+  //: Approximate number of bytes needed by a bsgm_disparity_estimator for
+  // a tile grown to \a window, reading the columns [ref_min_x, ref_max_x)
+  // of the reference image.
+  long long int tile_memory(
+    const vgl_box_2d<int>& window,
+    int ref_min_x,
+    int ref_max_x) const;
+
+ protected:
+
+  //: The tile grown by the overlap, clipped to the image
+  vgl_box_2d<int> grow_tile(const vgl_box_2d<int>& tile) const;
+
+  //: Columns [ref_min_x, ref_max_x) of the reference image which the
+  // disparities of pixels in \a window can reach. Returns false if none.
+  bool reference_columns(
+    const vgl_box_2d<int>& window,
+    const vil_image_view<int>& min_disparity,
+    int& ref_min_x,
+    int& ref_max_x) const;
+
+  //: Split the image into tiles which fit in the memory budget.
+  // Returns false if some part of the image does not fit in any tile.
+  bool plan_tiles(const vil_image_view<int>& min_disparity);
+
+  //: Add \a tile to tiles_, after splitting it until it fits the budget.
+  // Returns false if a tile too small to be split does not fit.
+  bool add_tile(
+    const vgl_box_2d<int>& tile,
+    const vil_image_view<int>& min_disparity);
+
+  bsgm_disparity_estimator_params params_;
+  int w_, h_;
+  int num_disparities_;
+  long long int memory_budget_;
+  int overlap_;
+
+  //: Pixels needed around a window by the census and gradient kernels
+  int margin_;
+
+  vil_image_view<float> shadow_step_prob_;
+  vil_image_view<float> shadow_prob_;
+  vgl_vector_2d<float> sun_dir_tar_;
+
+  std::vector< vgl_box_2d<int> > tiles_;
+};
+
+
+//----------------------------------------------------------------------------
+template <class T>
+bool bsgm_tiled_disparity_estimator::compute(
+  const vil_image_view<T>& img_tar,
+  const vil_image_view<T>& img_ref,
+  const vil_image_view<bool>& invalid_tar,
+  const vil_image_view<int>& min_disp,
+  float invalid_disp,
+  vil_image_view<float>& disp_tar,
+  float dynamic_range_factor,
+  bool skip_error_check)
+{
+  if (static_cast<int>(img_tar.ni()) != w_ || static_cast<int>(img_tar.nj()) != h_ ||
+      static_cast<int>(img_ref.ni()) != w_ || static_cast<int>(img_ref.nj()) != h_ ||
+      static_cast<int>(invalid_tar.ni()) != w_ || static_cast<int>(invalid_tar.nj()) != h_ ||
+      static_cast<int>(min_disp.ni()) != w_ || static_cast<int>(min_disp.nj()) != h_)
+    return false;
+
+  if (!plan_tiles(min_disp)) {
+    std::cerr << "Tiled SGM: a memory budget of " << memory_budget_
+              << " bytes is too small for the overlap and disparity range" << std::endl;
+    return false;
+  }
+  disp_tar.set_size(w_, h_);
+  if (params_.print_timing)
+    std::cerr << "Tiled SGM: " << tiles_.size() << " tiles" << std::endl;
+
+  bool use_shadow_step = !!shadow_step_prob_;
+  bool use_shadow = !!shadow_prob_;
+  for (const vgl_box_2d<int>& tile : tiles_) {
+
+    // The tile with its overlap, and the reference columns it can reach
+    vgl_box_2d<int> window = grow_tile(tile);
+    int ref_min_x, ref_max_x;
+    if (!reference_columns(window, min_disp, ref_min_x, ref_max_x)) {
+      for (int y = tile.min_y(); y < tile.max_y(); y++)
+        for (int x = tile.min_x(); x < tile.max_x(); x++)
+          disp_tar(x, y) = invalid_disp;
+      continue;
+    }
+
+    // Crop both images to the same region, holding the target window, the
+    // reference columns and the kernel margins around them. Disparities
+    // are unchanged since both crops start at the same column.
+    int crop_min_x = std::max(0, std::min(window.min_x(), ref_min_x) - margin_);
+    int crop_max_x = std::min(w_, std::max(window.max_x(), ref_max_x) + margin_);
+    int crop_min_y = std::max(0, window.min_y() - margin_);
+    int crop_max_y = std::min(h_, window.max_y() + margin_);
+    int crop_w = crop_max_x - crop_min_x, crop_h = crop_max_y - crop_min_y;
+    vil_image_view<T> tar_crop = vil_crop(img_tar, crop_min_x, crop_w, crop_min_y, crop_h);
+    vil_image_view<T> ref_crop = vil_crop(img_ref, crop_min_x, crop_w, crop_min_y, crop_h);
+
+    vgl_box_2d<int> tar_window(window.min_x() - crop_min_x, window.max_x() - crop_min_x,
+                               window.min_y() - crop_min_y, window.max_y() - crop_min_y);
+    vgl_box_2d<int> ref_window(ref_min_x - crop_min_x, ref_max_x - crop_min_x,
+                               window.min_y() - crop_min_y, window.max_y() - crop_min_y);
+
+    // Per-pixel inputs of the cost volume cover the window
+    int win_w = window.width(), win_h = window.height();
+    vil_image_view<bool> invalid_win =
+      vil_crop(invalid_tar, window.min_x(), win_w, window.min_y(), win_h);
+    vil_image_view<int> min_disp_win =
+      vil_crop(min_disp, window.min_x(), win_w, window.min_y(), win_h);
+    vil_image_view<float> shadow_step_win, shadow_win;
+    if (use_shadow_step)
+      shadow_step_win = vil_crop(shadow_step_prob_, window.min_x(), win_w, window.min_y(), win_h);
+    if (use_shadow)
+      shadow_win = vil_crop(shadow_prob_, window.min_x(), win_w, window.min_y(), win_h);
+
+    vil_image_view<float> disp_win;
+    {
+      bsgm_disparity_estimator sgm(params_, win_w, win_h, num_disparities_,
+                                   shadow_step_win, shadow_win, sun_dir_tar_);
+      if (!sgm.compute(tar_crop, ref_crop, invalid_win, min_disp_win, invalid_disp,
+                       disp_win, dynamic_range_factor, skip_error_check,
+                       tar_window, ref_window))
+        return false;
+    }
+
+    // Keep the disparities of the tile itself
+    for (int y = tile.min_y(); y < tile.max_y(); y++)
+      for (int x = tile.min_x(); x < tile.max_x(); x++)
+        disp_tar(x, y) = disp_win(x - window.min_x(), y - window.min_y());
+  }
+  return true;
+}
+
+#endif // bsgm_tiled_disparity_estimator_h_
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <vector>
+#include <testlib/testlib_test.h>
+
+#include <bsgm/bsgm_disparity_estimator.h>
+#include <vil/vil_image_view.h>
+#include <vnl/vnl_random.h>
+#include <vpl/vpl_thread_pool.h>
+
+
+// Gives access to the directional cost of a pixel
+class bsgm_test_disparity_estimator : public bsgm_disparity_estimator
+{
+ public:
+  bsgm_test_disparity_estimator(int num_disparities)
+    : bsgm_disparity_estimator(bsgm_disparity_estimator_params(), 1, 1, num_disparities) {}
+  using bsgm_disparity_estimator::compute_dir_cost;
+};
+
+
+// The directional cost recurrence one disparity at a time, as the scalar
+// loop of compute_dir_cost does it, wrapping around in 16 bits
+static void dir_cost_reference(
+  const std::vector<unsigned short>& prev_row_cost,
+  const std::vector<unsigned char>& cur_app_cost,
+  std::vector<unsigned short>& cur_row_cost,
+  std::vector<unsigned short>& total_cost,
+  unsigned short p1, unsigned short p2, int prev_offset)
+{
+  int num_d = static_cast<int>(prev_row_cost.size());
+  unsigned short min_prev_cost = *std::min_element(prev_row_cost.begin(), prev_row_cost.end());
+  unsigned short jump_cost = static_cast<unsigned short>(min_prev_cost + p2);
+  for (int d = 0; d < num_d; d++) {
+    int d_off = d + prev_offset;
+    unsigned short best_cost = jump_cost;
+    if (d_off >= 0 && d_off < num_d)
+      best_cost = std::min(best_cost, prev_row_cost[d_off]);
+    if (d_off > 0 && d_off <= num_d)
+      best_cost = std::min(best_cost, static_cast<unsigned short>(prev_row_cost[d_off-1] + p1));
+    if (d_off >= -1 && d_off < num_d-1)
+      best_cost = std::min(best_cost, static_cast<unsigned short>(prev_row_cost[d_off+1] + p1));
+    cur_row_cost[d] = static_cast<unsigned short>(cur_app_cost[d] + best_cost - min_prev_cost);
+    total_cost[d] = static_cast<unsigned short>(total_cost[d] + cur_row_cost[d]);
+  }
+}
+
+
+// compute_dir_cost, which takes eight disparities at a time with SSE2,
+// gives the same costs as the scalar recurrence, also where the sums wrap
+static void test_dir_cost()
+{
+  vnl_random rng(1234);
+  bool same = true;
+  for (int num_d : {8, 20, 37}) {
+    bsgm_test_disparity_estimator sgm(num_d);
+    for (int prev_offset = -3; prev_offset <= 3; prev_offset++) {
+      for (int trial = 0; trial < 20; trial++) {
+        // costs near the top of the 16 bit range make the sums with p1 and
+        // p2, and the running totals, wrap around
+        bool near_wrap = trial % 2 == 0;
+        unsigned short p1 = static_cast<unsigned short>(rng.lrand32(1, 800));
+        unsigned short p2 = static_cast<unsigned short>(rng.lrand32(p1, 4000));
+        std::vector<unsigned short> prev_row_cost(num_d), cur_row_cost(num_d), expected_cur(num_d);
+        std::vector<unsigned short> total_cost(num_d), expected_total(num_d);
+        std::vector<unsigned char> cur_app_cost(num_d);
+        for (int d = 0; d < num_d; d++) {
+          prev_row_cost[d] = static_cast<unsigned short>(near_wrap ? rng.lrand32(65535-1000, 65535) : rng.lrand32(0, 65535));
+          cur_app_cost[d] = static_cast<unsigned char>(rng.lrand32(0, 255));
+          total_cost[d] = expected_total[d] = static_cast<unsigned short>(rng.lrand32(0, 65535));
+        }
+        dir_cost_reference(prev_row_cost, cur_app_cost, expected_cur, expected_total, p1, p2, prev_offset);
+        sgm.compute_dir_cost(prev_row_cost.data(), cur_app_cost.data(), cur_row_cost.data(), total_cost.data(),
+                             p1, p2, 10, 10 + prev_offset);
+        same = same && cur_row_cost == expected_cur && total_cost == expected_total;
+      }
+    }
+  }
+  TEST("Directional costs match the scalar recurrence, also where they wrap", same, true);
+}
+
+
+// Run SGM with the given number of threads
+static vil_image_view<float> run_sgm(
+  const bsgm_disparity_estimator_params& params,
+  const vil_image_view<vxl_byte>& img_target,
+  const vil_image_view<vxl_byte>& img_reference,
+  const vil_image_view<bool>& invalid_target,
+  const vil_image_view<int>& min_disparity,
+  int num_disparities,
+  unsigned num_threads)
+{
+  vpl_set_concurrency(num_threads);
+  bsgm_disparity_estimator sgm(params, img_target.ni(), img_target.nj(), num_disparities);
+  vil_image_view<float> disp_target;
+  sgm.compute(img_target, img_reference, invalid_target, min_disparity,
+              -1000.0f, disp_target, 1.0f, true);
+  return disp_target;
+}
+
+
+static void test_disparity_estimator()
+{
+  // A random reference image, and a target image in which everything is
+  // shifted by true_disparity, except for a raised block
+  //   img_target(x,y) = img_reference(x + disparity, y)
+  // The appearance costs are not defined within the census radius of the
+  // image border, so the border is invalid.
+  // The image is wide enough for rows to be split between threads
+  int width = 1700, height = 40;
+  int true_disparity = 6, block_disparity = 9;
+  vnl_random rng(9667566);
+  vil_image_view<vxl_byte> img_reference(width, height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      img_reference(x, y) = static_cast<vxl_byte>(rng.lrand32(0, 255));
+
+  vil_image_view<vxl_byte> img_target(width, height);
+  vil_image_view<bool> invalid_target(width, height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      bool in_block = x >= 800 && x < 900 && y >= 10 && y < 30;
+      int xr = x + (in_block ? block_disparity : true_disparity);
+      invalid_target(x, y) = xr >= width - 3 || x < 3 || y < 3 || y >= height - 3;
+      img_target(x, y) = img_reference(xr < width ? xr : width - 1, y);
+    }
+  }
+
+  // Disparities [0, 20), except for a band of pixels starting at 2
+  vil_image_view<int> min_disparity(width, height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      min_disparity(x, y) = (y / 10) % 3 == 1 ? 2 : 0;
+  int num_disparities = 20;
+
+  bsgm_disparity_estimator_params params;
+  params.error_check_mode = 0;
+  params.perform_quadratic_interp = false;
+
+  for (int num_dirs = 8; num_dirs <= 16; num_dirs += 8) {
+    params.use_16_directions = num_dirs == 16;
+    vil_image_view<float> disp_1 = run_sgm(params, img_target, img_reference, invalid_target,
+                                           min_disparity, num_disparities, 1);
+    vil_image_view<float> disp_3 = run_sgm(params, img_target, img_reference, invalid_target,
+                                           min_disparity, num_disparities, 3);
+
+    // count valid pixels with the correct disparity
+    int num_correct = 0, num_checked = 0;
+    bool same = true;
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        same = same && disp_1(x, y) == disp_3(x, y);
+        if (invalid_target(x, y))
+          continue;
+        bool in_block = x >= 800 && x < 900 && y >= 10 && y < 30;
+        num_checked++;
+        if (disp_1(x, y) == (in_block ? block_disparity : true_disparity))
+          num_correct++;
+      }
+    }
+    TEST(num_dirs == 8 ? "Disparity recovered, 8 directions" : "Disparity recovered, 16 directions",
+         num_correct > 0.95 * num_checked, true);
+    TEST("Same disparities with 1 and 3 threads", same, true);
+  }
+  vpl_set_concurrency(0);
+
+  test_dir_cost();
+}
+
+TESTMAIN(test_disparity_estimator);
@@ -2,11 +2,15 @@
 
 
 DECLARE(test_compute_invalid_map);
+DECLARE(test_disparity_estimator);
+DECLARE(test_tiled_disparity_estimator);
 
 void
 register_tests()
 {
   REGISTER(test_compute_invalid_map);
+  REGISTER(test_disparity_estimator);
+  REGISTER(test_tiled_disparity_estimator);
 }
 
 DEFINE_MAIN;
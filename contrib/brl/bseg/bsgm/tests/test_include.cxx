@@ -7,6 +7,7 @@
 #include <bsgm/bsgm_prob_align_pointsets_3d.h>
 #include <bsgm/bsgm_prob_pairwise_dsm.h>
 #include <bsgm/bsgm_remove_spikes.h>
+#include <bsgm/bsgm_tiled_disparity_estimator.h>
 
 
 int main() { return 0; }
@@ -0,0 +1,147 @@
+#include <testlib/testlib_test.h>
+
+#include <bsgm/bsgm_disparity_estimator.h>
+#include <bsgm/bsgm_multiscale_disparity_estimator.h>
+#include <bsgm/bsgm_tiled_disparity_estimator.h>
+#include <vil/vil_image_view.h>
+#include <vnl/vnl_random.h>
+
+
+// Fraction of valid pixels with the same disparity in both images
+static double fraction_same(
+  const vil_image_view<float>& disp_a,
+  const vil_image_view<float>& disp_b,
+  const vil_image_view<bool>& invalid)
+{
+  long num_same = 0, num_valid = 0;
+  for (unsigned y = 0; y < invalid.nj(); y++) {
+    for (unsigned x = 0; x < invalid.ni(); x++) {
+      if (invalid(x, y))
+        continue;
+      num_valid++;
+      if (disp_a(x, y) == disp_b(x, y))
+        num_same++;
+    }
+  }
+  return num_valid > 0 ? double(num_same) / num_valid : 0.0;
+}
+
+
+static void test_tiled_disparity_estimator()
+{
+  // A random reference image, and a target image with a disparity of 6
+  // on the left, 14 on the right and 10 in a raised block
+  //   img_target(x,y) = img_reference(x + disparity, y)
+  // The appearance costs are not defined within the census radius of the
+  // image border, so the border is invalid.
+  int width = 320, height = 200;
+  vnl_random rng(1234567);
+  vil_image_view<vxl_byte> img_reference(width, height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      img_reference(x, y) = static_cast<vxl_byte>(rng.lrand32(0, 255));
+
+  vil_image_view<vxl_byte> img_target(width, height);
+  vil_image_view<bool> invalid_target(width, height);
+  vil_image_view<int> min_disparity(width, height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int disparity = x < width / 2 ? 6 : 14;
+      if (x >= 100 && x < 140 && y >= 60 && y < 120)
+        disparity = 10;
+      int xr = x + disparity;
+      invalid_target(x, y) = xr >= width - 3 || x < 3 || y < 3 || y >= height - 3;
+      img_target(x, y) = img_reference(xr < width ? xr : width - 1, y);
+      // search a range of 16 disparities around the expected ones
+      min_disparity(x, y) = x < width / 2 ? 0 : 6;
+    }
+  }
+  int num_disparities = 16;
+
+  bsgm_disparity_estimator_params params;
+  params.error_check_mode = 0;
+  params.perform_quadratic_interp = false;
+  float invalid_disp = -1000.0f;
+
+  vil_image_view<float> disp_whole;
+  {
+    bsgm_disparity_estimator sgm(params, width, height, num_disparities);
+    sgm.compute(img_target, img_reference, invalid_target, min_disparity,
+                invalid_disp, disp_whole, 1.0f, true);
+  }
+
+  // A budget large enough for the whole image gives one tile, and the
+  // same result
+  bsgm_tiled_disparity_estimator one_tile(params, width, height, num_disparities,
+                                          1000000000LL, 32);
+  vil_image_view<float> disp_one;
+  bool good = one_tile.compute(img_target, img_reference, invalid_target,
+                               min_disparity, invalid_disp, disp_one, 1.0f, true);
+  TEST("One tile computed", good && one_tile.tiles().size() == 1, true);
+  TEST_NEAR("One tile matches the whole image",
+            fraction_same(disp_whole, disp_one, invalid_target), 1.0, 1e-12);
+
+  // A small budget gives several tiles, which together cover the image
+  long long int budget = 2000000;
+  bsgm_tiled_disparity_estimator tiled(params, width, height, num_disparities,
+                                       budget, 32);
+  vil_image_view<float> disp_tiled;
+  good = tiled.compute(img_target, img_reference, invalid_target,
+                       min_disparity, invalid_disp, disp_tiled, 1.0f, true);
+  const std::vector<vgl_box_2d<int> >& tiles = tiled.tiles();
+  std::vector<int> coverage(width * height, 0);
+  for (const vgl_box_2d<int>& tile : tiles)
+    for (int y = tile.min_y(); y < tile.max_y(); y++)
+      for (int x = tile.min_x(); x < tile.max_x(); x++)
+        coverage[y * width + x]++;
+  bool covered = true;
+  for (int c : coverage)
+    covered = covered && c == 1;
+  std::cout << tiles.size() << " tiles" << std::endl;
+  TEST("Tiled computed", good && tiles.size() > 4, true);
+  TEST("Tiles cover each pixel once", covered, true);
+
+  double same = fraction_same(disp_whole, disp_tiled, invalid_target);
+  std::cout << "Tiled and whole image agree at " << 100.0 * same << "% of pixels" << std::endl;
+  TEST("Tiles are stitched without seams", same > 0.99, true);
+
+  // A budget too small for even the smallest tile is refused, rather than
+  // exceeded
+  bsgm_tiled_disparity_estimator too_small(params, width, height, num_disparities,
+                                           200000LL, 32);
+  vil_image_view<float> disp_too_small;
+  good = too_small.compute(img_target, img_reference, invalid_target,
+                           min_disparity, invalid_disp, disp_too_small, 1.0f, true);
+  TEST("Budget too small for a tile", good || !too_small.tiles().empty(), false);
+
+  // The multiscale estimator drives the tiled one at full resolution
+  vil_image_view<float> disp_multiscale, disp_multiscale_tiled;
+  {
+    bsgm_multiscale_disparity_estimator multiscale(params, width, height, 32, num_disparities);
+    multiscale.compute(img_target, img_reference, invalid_target, -8,
+                       invalid_disp, 2, disp_multiscale, 1.0f, true);
+  }
+  // The per-pixel search ranges of the fine level vary more, so the tiles
+  // read more reference columns and need a larger budget
+  params.tile_memory_budget = 3000000;
+  params.tile_overlap = 32;
+  {
+    bsgm_multiscale_disparity_estimator multiscale(params, width, height, 32, num_disparities);
+    good = multiscale.compute(img_target, img_reference, invalid_target, -8,
+                              invalid_disp, 2, disp_multiscale_tiled, 1.0f, true);
+  }
+  // Where the coarse disparities are invalid, near the border, the fine
+  // search range is outside the image and the result is arbitrary; only
+  // compare pixels with a disparity in the coarse search range
+  vil_image_view<bool> outside_range(width, height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      outside_range(x, y) = invalid_target(x, y) ||
+                            disp_multiscale(x, y) < -8.0f || disp_multiscale(x, y) >= 24.0f;
+  same = fraction_same(disp_multiscale, disp_multiscale_tiled, outside_range);
+  std::cout << "Multiscale with and without tiles agree at " << 100.0 * same
+            << "% of pixels" << std::endl;
+  TEST("Multiscale with a tile memory budget", good && same > 0.99, true);
+}
+
+TESTMAIN(test_tiled_disparity_estimator);
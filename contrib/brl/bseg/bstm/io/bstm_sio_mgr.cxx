@@ -7,6 +7,7 @@
 #endif
 #include <sys/stat.h>  //for getting file sizes
 #include "vul/vul_file.h"
+#include <boxm2/basic/boxm2_compressed_file.h>
 
 bstm_block* bstm_sio_mgr::load_block(const std::string& dir, const bstm_block_id& block_id, const bstm_block_metadata& data )
 {
@@ -24,6 +25,13 @@ bstm_block* bstm_sio_mgr::load_block(const std::string& dir, const bstm_block_id
     return nullptr;
   }
 
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
+
   //instantiate new block
   return new bstm_block(block_id,data, bytes);
 }
@@ -44,8 +52,15 @@ bstm_time_block* bstm_sio_mgr::load_time_block(const std::string& dir, const bst
     return nullptr;
   }
 
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
+
   //instantiate new block
-  return new bstm_time_block(block_id,data, bytes, numBytes);
+  return new bstm_time_block(block_id,data, bytes, len);
 }
 
 // loads a generic bstm_data_base* from disk (given data_type string prefix)
@@ -66,8 +81,15 @@ bstm_data_base* bstm_sio_mgr::load_block_data_generic(const std::string& dir, co
       return nullptr;
   }
 
+  // compressed files are expanded as they are read
+  std::size_t len = numBytes;
+  if (!boxm2_compressed_file::expand(bytes, len)) {
+    delete [] bytes;
+    return nullptr;
+  }
+
   //instantiate new block
-  return new bstm_data_base(bytes,numBytes,id);
+  return new bstm_data_base(bytes,len,id);
 }
 
 
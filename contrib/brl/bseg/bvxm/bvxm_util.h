@@ -75,6 +75,14 @@ class bvxm_util
                                  vgl_h_matrix_2d<double> invH,
                                  bvxm_voxel_slab<T> &slab_out);
 
+  //: Warps rows [y0, y1) of slab_out only, without smoothing slab_in.
+  //  Different row ranges of the same slab_out may be warped on different threads.
+  template <class T, class M>
+  static void warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
+                                 vgl_h_matrix_2d<double> const& invH,
+                                 bvxm_voxel_slab<T> &slab_out,
+                                 unsigned y0, unsigned y1);
+
   template <class T>
   static void warp_slab_nearest_neighbor(bvxm_voxel_slab<T> const& slab_in,
                                          vgl_h_matrix_2d<double> invH,
@@ -190,7 +198,15 @@ void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
   slab_in_smooth.deep_copy(slab_in);
   smooth_gaussian(slab_in_smooth, xstd, ystd);
 
+  warp_slab_bilinear(slab_in_smooth, invH, slab_out, 0, slab_out.ny());
+}
+
+template <class T, class M>
+void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in, vgl_h_matrix_2d<double> const& invH,
+                                   bvxm_voxel_slab<T> &slab_out, unsigned y_begin, unsigned y_end)
+{
   // perform bilinear interpolation.
+  vnl_matrix_fixed<double,3,3> Hd = invH.get_matrix();
   vnl_matrix_fixed<float,3,3> H;
   // convert H to a float matrix
   vnl_matrix_fixed<float,3,3>::iterator Hit = H.begin();
@@ -198,18 +214,16 @@ void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
   for (; Hit != H.end(); ++Hit, ++Hdit)
     *Hit = (float)(*Hdit);
 
-  slab_out.fill(T(0.0)); // this should work whether T is a vector_fixed or a scalar
-
-  typename bvxm_voxel_slab<T>::iterator out_it = slab_out.begin();
-
   // if z > 1, it would be more efficient to put the z loop as the inner-most.
   // z will probably be 1 most of the time though, so leave it here for now.
   for (unsigned z=0; z<slab_out.nz(); ++z)
   {
-    for (unsigned y=0; y<slab_out.ny(); ++y)
+    for (unsigned y=y_begin; y<y_end; ++y)
     {
-      for (unsigned x=0; x<slab_out.nx(); ++x, ++out_it)
+      for (unsigned x=0; x<slab_out.nx(); ++x)
       {
+        T& out = slab_out(x,y,z);
+        out = T(0.0); // this should work whether T is a vector_fixed or a scalar
         vnl_vector_fixed<float,3> pix_in_homg = H*vnl_vector_fixed<float,3>((float)x,(float)y,1.0f);
         // normalize homogeneous coordinate
 
@@ -233,10 +247,10 @@ void bvxm_util::warp_slab_bilinear(bvxm_voxel_slab<M> const& slab_in,
 
         for (unsigned i=0; i<4; ++i) {
           // check if input pixel is inbounds
-          if (xvals[i] < slab_in_smooth.nx() &&
-              yvals[i] < slab_in_smooth.ny()) {
+          if (xvals[i] < slab_in.nx() &&
+              yvals[i] < slab_in.ny()) {
             // pixel is good
-            (*out_it) += slab_in_smooth(xvals[i],yvals[i],z)*weights[i];
+            out += slab_in(xvals[i],yvals[i],z)*weights[i];
           }
         }
       } //x
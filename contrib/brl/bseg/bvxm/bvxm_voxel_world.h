@@ -88,10 +88,12 @@
 
 #include <vil/vil_image_view.h>
 #include <vpgl/vpgl_camera_double_sptr.h>
+#include <vpl/vpl_thread_pool.h>
 
 #include "bvxm_image_metadata.h"
 #include "bvxm_mog_grey_processor.h"
 #include "grid/bvxm_voxel_grid.h"
+#include "grid/bvxm_voxel_slab_pipeline.h"
 #include "bvxm_voxel_traits.h"
 #include "bvxm_world_params.h"
 #include "bvxm_util.h"
@@ -543,9 +545,6 @@ bool bvxm_voxel_world::update_impl(bvxm_image_metadata const& metadata,
   typedef typename bvxm_voxel_traits<APM_T>::obs_datatype obs_datatype;
   typedef typename bvxm_voxel_traits<OCCUPANCY>::voxel_datatype ocp_datatype;
 
-  // the appearance model processor
-  typename bvxm_voxel_traits<APM_T>::appearance_processor apm_processor;
-
   vgl_vector_3d<unsigned int> grid_size = params_->num_voxels(scale_idx);
   ocp_datatype min_vox_prob = params_->min_occupancy_prob();
   ocp_datatype max_vox_prob = params_->max_occupancy_prob();
@@ -570,22 +569,25 @@ bool bvxm_voxel_world::update_impl(bvxm_image_metadata const& metadata,
     return false;
   }
 
-  // temporary voxel grids to hold preX and PI*visX values
-  bvxm_voxel_grid<float> preX(grid_size);
-  bvxm_voxel_grid<float> PIvisX(grid_size);
+  // temporary slabs to hold preX and PI*visX values of each level
+  std::vector<bvxm_voxel_slab<float> > preX, PIvisX;
+  for (unsigned z=0; z<(unsigned)grid_size.z(); ++z) {
+    preX.emplace_back(grid_size.x(), grid_size.y(), 1);
+    PIvisX.emplace_back(grid_size.x(), grid_size.y(), 1);
+  }
 
   bvxm_voxel_slab<float> PIPX(grid_size.x(),grid_size.y(),1);
   bvxm_voxel_slab<float> PXvisX(grid_size.x(), grid_size.y(),1);
 
   bvxm_voxel_slab<float> preX_accum(image_slab.nx(),image_slab.ny(),1);
   bvxm_voxel_slab<float> visX_accum(image_slab.nx(),image_slab.ny(),1);
-  bvxm_voxel_slab<float> img_scratch(image_slab.nx(),image_slab.ny(),1);
   bvxm_voxel_slab<float> PIPX_img(image_slab.nx(), image_slab.ny(),1);
   bvxm_voxel_slab<float> PX_img(image_slab.nx(), image_slab.ny(),1);
   bvxm_voxel_slab<float> mask_slab(image_slab.nx(), image_slab.ny(),1);
 
   preX_accum.fill(0.0f);
   visX_accum.fill(1.0f);
+  mask_slab.fill(0.0f);
 
   // slabs for holding backprojections of visX
   bvxm_voxel_slab<float> visX(grid_size.x(),grid_size.y(),1);
@@ -602,77 +604,78 @@ bool bvxm_voxel_world::update_impl(bvxm_image_metadata const& metadata,
   bvxm_voxel_grid_base_sptr apm_grid_base = this->get_grid<APM_T>(bin_index,scale_idx, use_momory);
   bvxm_voxel_grid<apm_datatype> *apm_grid  = static_cast<bvxm_voxel_grid<apm_datatype>*>(apm_grid_base.ptr());
 
-  typename bvxm_voxel_grid<ocp_datatype>::const_iterator ocp_slab_it = ocp_grid->begin();
-  typename bvxm_voxel_grid<apm_datatype>::iterator apm_slab_it = apm_grid->begin();
-  typename bvxm_voxel_grid<float>::iterator preX_slab_it = preX.begin();
-  typename bvxm_voxel_grid<float>::iterator PIvisX_slab_it = PIvisX.begin();
+  // the next level is read, and the last one written, while a level is updated;
+  // each level is updated in bands of rows on several threads
+  bvxm_voxel_slab_pipeline pass1(grid_size.z());
+  unsigned ocp_g = pass1.add_grid(ocp_grid, false);
+  unsigned apm_g = pass1.add_grid(apm_grid, true);
 
-  for (unsigned z=0; z<(unsigned)grid_size.z(); ++z, ++ocp_slab_it, ++apm_slab_it, ++preX_slab_it, ++PIvisX_slab_it)
+  bool io_ok = pass1.run([&](unsigned z)
   {
     std::cout << '.';
     std::cout.flush();
 
-    if ( (ocp_slab_it == ocp_grid->end()) || (apm_slab_it == apm_grid->end()) ) {
-      std::cerr << "error: reached end of grid slabs at z = " << z << ".  nz = " << grid_size.z() << '\n';
-      return false;
-    }
-
-    // backproject image onto voxel plane
-    bvxm_util::warp_slab_bilinear(image_slab, H_plane_to_img[z], frame_backproj);
-#ifdef BVXM_DEBUG
-    bvxm_util::write_slab_as_image(frame_backproj,"C:/research/registration/output/frame_backproj.tiff");
-#endif
-    // transform preX to voxel plane for this level
-    bvxm_util::warp_slab_bilinear(preX_accum, H_plane_to_img[z], *preX_slab_it);
-    // transform visX to voxel plane for this level
-    bvxm_util::warp_slab_bilinear(visX_accum, H_plane_to_img[z], visX);
+    bvxm_voxel_slab<ocp_datatype> const& ocp_slab = pass1.slab<ocp_datatype>(ocp_g, z);
+    bvxm_voxel_slab<apm_datatype>& apm_slab = pass1.slab<apm_datatype>(apm_g, z);
 
-    // initialize PIvisX with PI(X)
-    bvxm_voxel_slab<float> PI = apm_processor.prob_density(*apm_slab_it, frame_backproj);
-
-    // now multiply by visX
-    bvxm_util::multiply_slabs(visX,PI,*PIvisX_slab_it);
-
-    // update appearance model, using PX*visX as the weights
-    bvxm_util::multiply_slabs(visX,*ocp_slab_it,PXvisX);
-    apm_processor.update(*apm_slab_it, frame_backproj, PXvisX);
-
-    // multiply to get PIPX
-    bvxm_util::multiply_slabs(PI,*ocp_slab_it,PIPX);
-#ifdef BVXM_DEBUG
-    bvxm_util::write_slab_as_image(PI,"PI.tiff");
-    bvxm_util::write_slab_as_image(*ocp_slab_it,"PX.tiff");
-#endif
-    // warp PIPX back to image domain
-    bvxm_util::warp_slab_bilinear(PIPX, H_img_to_plane[z], PIPX_img);
-
-    // multiply PIPX by visX and add to preX_accum
-    typename bvxm_voxel_slab<float>::iterator PIPX_img_it = PIPX_img.begin();
-    typename bvxm_voxel_slab<float>::iterator visX_accum_it = visX_accum.begin();
-    typename bvxm_voxel_slab<float>::iterator preX_accum_it = preX_accum.begin();
-
-    for (; preX_accum_it != preX_accum.end(); ++preX_accum_it, ++PIPX_img_it, ++visX_accum_it) {
-      *preX_accum_it += (*PIPX_img_it) * (*visX_accum_it);
-    }
+    vpl_parallel_for_range(0u, (unsigned)grid_size.y(), [&](unsigned y0, unsigned y1)
+    {
+      // backproject image onto voxel plane
+      bvxm_util::warp_slab_bilinear(image_slab, H_plane_to_img[z], frame_backproj, y0, y1);
+      // transform preX to voxel plane for this level
+      bvxm_util::warp_slab_bilinear(preX_accum, H_plane_to_img[z], preX[z], y0, y1);
+      // transform visX to voxel plane for this level
+      bvxm_util::warp_slab_bilinear(visX_accum, H_plane_to_img[z], visX, y0, y1);
+
+      bvxm_voxel_slab<ocp_datatype> ocp_rows = ocp_slab.rows(y0, y1);
+      bvxm_voxel_slab<apm_datatype> apm_rows = apm_slab.rows(y0, y1);
+      bvxm_voxel_slab<obs_datatype> frame_rows = frame_backproj.rows(y0, y1);
+      bvxm_voxel_slab<float> visX_rows = visX.rows(y0, y1);
+      bvxm_voxel_slab<float> PIvisX_rows = PIvisX[z].rows(y0, y1);
+      bvxm_voxel_slab<float> PXvisX_rows = PXvisX.rows(y0, y1);
+      bvxm_voxel_slab<float> PIPX_rows = PIPX.rows(y0, y1);
+
+      // initialize PIvisX with PI(X)
+      typename bvxm_voxel_traits<APM_T>::appearance_processor apm_processor;
+      bvxm_voxel_slab<float> PI = apm_processor.prob_density(apm_rows, frame_rows);
+
+      // now multiply by visX
+      bvxm_util::multiply_slabs(visX_rows,PI,PIvisX_rows);
+
+      // update appearance model, using PX*visX as the weights
+      bvxm_util::multiply_slabs(visX_rows,ocp_rows,PXvisX_rows);
+      apm_processor.update(apm_rows, frame_rows, PXvisX_rows);
+
+      // multiply to get PIPX
+      bvxm_util::multiply_slabs(PI,ocp_rows,PIPX_rows);
+    });
 #ifdef BVXM_DEBUG
-    bvxm_util::write_slab_as_image(PIPX_img,"PIPX_img.tiff");
-    bvxm_util::write_slab_as_image(visX_accum,"visX_accum.tiff");
-    bvxm_util::write_slab_as_image(preX_accum,"preX_accum.tiff");
+    bvxm_util::write_slab_as_image(frame_backproj,"frame_backproj.tiff");
+    bvxm_util::write_slab_as_image(ocp_slab,"PX.tiff");
 #endif
-    // scale and offset voxel probabilities to get (1-P(X))
-    // transform (1-P(X)) to image plane to accumulate visX for next level
-    bvxm_util::warp_slab_bilinear(*ocp_slab_it, H_img_to_plane[z], PX_img);
-
-    if (return_mask) {
-      bvxm_util::add_slabs(PX_img,mask_slab,mask_slab);
-    }
 
-    // note: doing scale and offset in image domain so invalid pixels become 1.0 and don't affect visX
-    typename bvxm_voxel_slab<float>::iterator PX_img_it = PX_img.begin();
-    visX_accum_it = visX_accum.begin();
-    for (; visX_accum_it != visX_accum.end(); ++visX_accum_it, ++PX_img_it) {
-      *visX_accum_it *= (1 - *PX_img_it);
-    }
+    vpl_parallel_for_range(0u, image_slab.ny(), [&](unsigned y0, unsigned y1)
+    {
+      // warp PIPX back to image domain
+      bvxm_util::warp_slab_bilinear(PIPX, H_img_to_plane[z], PIPX_img, y0, y1);
+      // transform P(X) to image plane to accumulate visX for next level
+      bvxm_util::warp_slab_bilinear(ocp_slab, H_img_to_plane[z], PX_img, y0, y1);
+
+      for (unsigned y=y0; y<y1; ++y) {
+        for (unsigned x=0; x<image_slab.nx(); ++x) {
+          // multiply PIPX by visX and add to preX_accum
+          preX_accum(x,y) += PIPX_img(x,y) * visX_accum(x,y);
+          if (return_mask)
+            mask_slab(x,y) += PX_img(x,y);
+          // note: doing scale and offset in image domain so invalid pixels become 1.0 and don't affect visX
+          visX_accum(x,y) *= (1 - PX_img(x,y));
+        }
+      }
+    });
+  });
+  if (!io_ok) {
+    std::cerr << "error: cannot read or write the occupancy and appearance grids in pass 1\n";
+    return false;
   }
   // now traverse a second time, computing new P(X) along the way.
 
@@ -683,39 +686,47 @@ bool bvxm_voxel_world::update_impl(bvxm_image_metadata const& metadata,
   bvxm_util::write_slab_as_image(preX_accum,"preX_accum.tiff");
 #endif
   std::cout << "\nPass 2:" << std::endl;
-  PIvisX_slab_it = PIvisX.begin();
-  preX_slab_it = preX.begin();
-  typename bvxm_voxel_grid<ocp_datatype>::iterator ocp_slab_it2 = ocp_grid->begin();
-  for (unsigned z = 0; z < (unsigned)grid_size.z(); ++z, ++PIvisX_slab_it, ++preX_slab_it, ++ocp_slab_it2)
+  bvxm_voxel_slab_pipeline pass2(grid_size.z());
+  unsigned ocp_g2 = pass2.add_grid(ocp_grid, true);
+
+  io_ok = pass2.run([&](unsigned z)
   {
     std::cout << '.';
     std::cout.flush();
-    // transform preX_sum to current level
-    bvxm_util::warp_slab_bilinear(preX_accum, H_plane_to_img[z], preX_accum_vox);
-
-    // transform visX_sum to current level
-    bvxm_util::warp_slab_bilinear(visX_accum, H_plane_to_img[z], visX_accum_vox);
 
-    const float preX_sum_thresh = 0.01f;
+    bvxm_voxel_slab<ocp_datatype>& ocp_slab = pass2.slab<ocp_datatype>(ocp_g2, z);
 
-    typename bvxm_voxel_slab<float>::const_iterator preX_it = preX_slab_it->begin(),
-                                                    PIvisX_it = PIvisX_slab_it->begin(),
-                                                    preX_sum_it = preX_accum_vox.begin(),
-                                                    visX_sum_it = visX_accum_vox.begin();
-    typename bvxm_voxel_slab<float>::iterator PX_it = ocp_slab_it2->begin();
-
-    for (; PX_it != ocp_slab_it2->end(); ++PX_it, ++preX_it, ++PIvisX_it, ++preX_sum_it, ++visX_sum_it) {
-      // if preX_sum is zero at the voxel, no ray passed through the voxel (out of image)
-      if (*preX_sum_it > preX_sum_thresh) {
-        float multiplier = (*PIvisX_it + *preX_it) / *preX_sum_it;
-        float ray_norm = 1 - *visX_sum_it; // normalize based on probability that a surface voxel is located along the ray. This was not part of the original Pollard + Mundy algorithm.
-        *PX_it *= multiplier * ray_norm;
+    vpl_parallel_for_range(0u, (unsigned)grid_size.y(), [&](unsigned y0, unsigned y1)
+    {
+      // transform preX_sum to current level
+      bvxm_util::warp_slab_bilinear(preX_accum, H_plane_to_img[z], preX_accum_vox, y0, y1);
+
+      // transform visX_sum to current level
+      bvxm_util::warp_slab_bilinear(visX_accum, H_plane_to_img[z], visX_accum_vox, y0, y1);
+
+      const float preX_sum_thresh = 0.01f;
+
+      for (unsigned y=y0; y<y1; ++y) {
+        for (unsigned x=0; x<(unsigned)grid_size.x(); ++x) {
+          float& PX = ocp_slab(x,y);
+          float preX_sum = preX_accum_vox(x,y);
+          // if preX_sum is zero at the voxel, no ray passed through the voxel (out of image)
+          if (preX_sum > preX_sum_thresh) {
+            float multiplier = (PIvisX[z](x,y) + preX[z](x,y)) / preX_sum;
+            float ray_norm = 1 - visX_accum_vox(x,y); // normalize based on probability that a surface voxel is located along the ray. This was not part of the original Pollard + Mundy algorithm.
+            PX *= multiplier * ray_norm;
+          }
+          if (PX < min_vox_prob)
+            PX = min_vox_prob;
+          if (PX > max_vox_prob)
+            PX = max_vox_prob;
+        }
       }
-      if (*PX_it < min_vox_prob)
-        *PX_it = min_vox_prob;
-      if (*PX_it > max_vox_prob)
-        *PX_it = max_vox_prob;
-    }
+    });
+  });
+  if (!io_ok) {
+    std::cerr << "error: cannot read or write the occupancy grid in pass 2\n";
+    return false;
   }
   std::cout << "\ndone." << std::endl;
 
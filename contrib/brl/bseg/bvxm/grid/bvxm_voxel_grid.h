@@ -80,6 +80,10 @@ class bvxm_voxel_grid : public bvxm_voxel_grid_base
   void increment_observations(){storage_->increment_observations();}
   //: zero the number of observations
   void zero_observations(){storage_->zero_observations();}
+  //: copy slice slice_idx into a slab of one slice the caller owns
+  bool read_slab(unsigned slice_idx, bvxm_voxel_slab<T>& slab) {return storage_->read_slab(slice_idx, slab);}
+  //: copy a slab of one slice into slice slice_idx
+  bool write_slab(unsigned slice_idx, bvxm_voxel_slab<T> const& slab) {return storage_->write_slab(slice_idx, slab);}
   // access to data via iterators
   typedef bvxm_voxel_slab_iterator<T> iterator;
   typedef bvxm_voxel_slab_const_iterator<T> const_iterator;
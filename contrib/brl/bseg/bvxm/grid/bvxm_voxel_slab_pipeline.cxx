@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <thread>
+#include "bvxm_voxel_slab_pipeline.h"
+//:
+// \file
+
+bvxm_voxel_slab_pipeline::bvxm_voxel_slab_pipeline(unsigned nz, unsigned max_slabs)
+  : nz_(nz), max_slabs_(std::max(max_slabs, 1u)),
+    next_read_(0), updated_(0), next_written_(0), failed_(false), io_failed_(false)
+{}
+
+void bvxm_voxel_slab_pipeline::io_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (next_written_ < nz_ && !failed_)
+  {
+    // writing frees a slot, so it comes before reading; a slice is read
+    // only once the slice that last used its slot has been written
+    cond_.wait(lock, [this] {
+      return failed_ || next_written_ < updated_ ||
+             (next_read_ < nz_ && next_read_ < next_written_ + max_slabs_);
+    });
+    if (failed_)
+      break;
+    bool write = next_written_ < updated_;
+    unsigned z = write ? next_written_ : next_read_;
+    lock.unlock();
+    bool ok = true;
+    try {
+      for (auto& c : channels_) {
+        unsigned slot = z % max_slabs_;
+        ok = write ? (!c->write_back_ || c->write(z, slot)) : c->read(z, slot);
+        if (!ok) {
+          std::cerr << "bvxm_voxel_slab_pipeline: cannot " << (write ? "write" : "read") << " slice " << z << '\n';
+          break;
+        }
+      }
+    }
+    catch (...) {
+      ok = false;
+    }
+    lock.lock();
+    if (!ok)
+      failed_ = io_failed_ = true;
+    else if (write)
+      ++next_written_;
+    else
+      ++next_read_;
+    cond_.notify_all();
+  }
+}
+
+bool bvxm_voxel_slab_pipeline::run(std::function<void(unsigned)> const& update)
+{
+  next_read_ = updated_ = next_written_ = 0;
+  failed_ = io_failed_ = false;
+
+  std::thread io([this] { io_loop(); });
+  std::exception_ptr error;
+  for (unsigned z = 0; z < nz_; ++z)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this, z] { return failed_ || next_read_ > z; });
+      if (failed_)
+        break;
+    }
+    try {
+      update(z);
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error)
+      failed_ = true;
+    else
+      updated_ = z + 1;
+    cond_.notify_all();
+    if (error)
+      break;
+  }
+  io.join();
+  if (error)
+    std::rethrow_exception(error);
+  return !io_failed_;
+}
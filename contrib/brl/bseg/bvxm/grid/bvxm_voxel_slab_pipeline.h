@@ -0,0 +1,111 @@
+#ifndef bvxm_voxel_slab_pipeline_h_
+#define bvxm_voxel_slab_pipeline_h_
+//:
+// \file
+// \brief Updates voxel grids slice by slice while the slices around it are read and written
+//
+//  The slices of the grids added to the pipeline are read, in order of z,
+//  on a thread of their own, which also writes back the slices that are
+//  updated.  So slice z+1 is read, and slice z-1 written, while slice z is
+//  updated by the function given to run(), which may itself update the
+//  slice on several threads.  No more than max_slabs slices of each grid
+//  are in memory at once: reading waits for the oldest slice to be written.
+//
+//  The grids must not be used other than through the pipeline while it runs.
+//  \verbatim
+//    bvxm_voxel_slab_pipeline pipeline(nz);
+//    unsigned ocp = pipeline.add_grid(ocp_grid, false);
+//    unsigned apm = pipeline.add_grid(apm_grid, true);
+//    pipeline.run([&](unsigned z) {
+//      bvxm_voxel_slab<float>& ocp_slab = pipeline.slab<float>(ocp, z);
+//      ...
+//    });
+//  \endverbatim
+
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+#include "bvxm_voxel_grid.h"
+#include "bvxm_voxel_slab.h"
+
+class bvxm_voxel_slab_pipeline
+{
+ public:
+  //: A pipeline over slices [0, nz) keeping up to max_slabs slices of each grid in memory
+  bvxm_voxel_slab_pipeline(unsigned nz, unsigned max_slabs = 3);
+
+  //: Adds a grid, whose slices are written back after their update if write_back is true
+  //  \returns the index of the grid in the pipeline
+  template <class T>
+  unsigned add_grid(bvxm_voxel_grid<T>* grid, bool write_back)
+  {
+    assert(grid->grid_size().z() == nz_);
+    channels_.emplace_back(new channel<T>(grid, write_back, max_slabs_));
+    return (unsigned)channels_.size() - 1;
+  }
+
+  //: Slice z of grid g; only valid in the update of slice z
+  template <class T>
+  bvxm_voxel_slab<T>& slab(unsigned g, unsigned z)
+  {
+    auto* c = dynamic_cast<channel<T>*>(channels_[g].get());
+    assert(c);
+    return c->slabs_[z % max_slabs_];
+  }
+
+  //: Calls update(z) for each slice z in turn, reading and writing the grids around it
+  //  \returns false if a slice could not be read or written.  An exception
+  //  thrown by update stops the pipeline and is passed on.
+  bool run(std::function<void(unsigned)> const& update);
+
+ private:
+  struct channel_base
+  {
+    explicit channel_base(bool write_back) : write_back_(write_back) {}
+    virtual ~channel_base() = default;
+    virtual bool read(unsigned z, unsigned slot) = 0;
+    virtual bool write(unsigned z, unsigned slot) = 0;
+    bool write_back_;
+  };
+
+  template <class T>
+  struct channel : public channel_base
+  {
+    channel(bvxm_voxel_grid<T>* grid, bool write_back, unsigned n_slots)
+      : channel_base(write_back), grid_(grid)
+    {
+      for (unsigned s = 0; s < n_slots; ++s)
+        slabs_.emplace_back(grid->grid_size().x(), grid->grid_size().y(), 1);
+    }
+    bool read(unsigned z, unsigned slot) override { return grid_->read_slab(z, slabs_[slot]); }
+    bool write(unsigned z, unsigned slot) override { return grid_->write_slab(z, slabs_[slot]); }
+
+    bvxm_voxel_grid<T>* grid_;
+    std::vector<bvxm_voxel_slab<T> > slabs_;
+  };
+
+  //: reads and writes the slices until all are written, or the pipeline fails
+  void io_loop();
+
+  unsigned nz_;
+  unsigned max_slabs_;
+  std::vector<std::unique_ptr<channel_base> > channels_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  //: slices [0, next_read_) are read, [0, updated_) updated and [0, next_written_) written
+  unsigned next_read_;
+  unsigned updated_;
+  unsigned next_written_;
+  bool failed_;
+  bool io_failed_;
+};
+
+#endif // bvxm_voxel_slab_pipeline_h_
@@ -3,6 +3,7 @@
 //:
 // \file
 
+#include <algorithm>
 #include <vgl/vgl_vector_3d.h>
 #include "bvxm_voxel_slab.h"
 
@@ -23,6 +24,27 @@ class bvxm_voxel_storage
   //: Commit currently active slab to memory.
   virtual void put_slab() = 0;
 
+  //: Copy slice slice_idx into a slab of one slice the caller owns.
+  //  Unlike get_slab(), the slab stays valid when other slices are accessed.
+  virtual bool read_slab(unsigned slice_idx, bvxm_voxel_slab<T>& slab)
+  {
+    bvxm_voxel_slab<T> active = this->get_slab(slice_idx, 1);
+    if (active.size() < slab.size() || slab.size() == 0)
+      return false;
+    std::copy(active.begin(), active.begin() + slab.size(), slab.begin());
+    return true;
+  }
+  //: Copy a slab of one slice into slice slice_idx.
+  virtual bool write_slab(unsigned slice_idx, bvxm_voxel_slab<T> const& slab)
+  {
+    bvxm_voxel_slab<T> active = this->get_slab(slice_idx, 1);
+    if (active.size() < slab.size() || slab.size() == 0)
+      return false;
+    std::copy(slab.begin(), slab.end(), active.begin());
+    this->put_slab();
+    return true;
+  }
+
   //: return number of observations
   virtual unsigned num_observations() const = 0;
   //: increment the number of observations
@@ -50,6 +50,10 @@ class bvxm_voxel_storage_disk : public bvxm_voxel_storage<T>
   bool initialize_data(T const& value) override;
   bvxm_voxel_slab<T> get_slab(unsigned slice_idx, unsigned slab_thickness) override;
   void put_slab() override;
+  //: reads the slice straight into the slab
+  bool read_slab(unsigned slice_idx, bvxm_voxel_slab<T>& slab) override;
+  //: writes the slab straight to the file, leaving the active slab as it is
+  bool write_slab(unsigned slice_idx, bvxm_voxel_slab<T> const& slab) override;
 
   //: return number of observations
   unsigned num_observations() const override;
@@ -73,6 +77,9 @@ class bvxm_voxel_storage_disk : public bvxm_voxel_storage<T>
   // currently active slab starting index
   int active_slab_start_;
 
+  //: opens the file if it is not open; returns false if it cannot be opened
+  bool open_file();
+
   //: convert slab start index to file position
   vil_streampos slab_filepos(unsigned slab_index);
 
@@ -269,6 +269,63 @@ void bvxm_voxel_storage_disk<T>::put_slab()
   return;
 }
 
+template <class T>
+bool bvxm_voxel_storage_disk<T>::read_slab(unsigned slice_idx, bvxm_voxel_slab<T>& slab)
+{
+  if (slice_idx >= this->grid_size_.z() || slab.size() != this->grid_size_.x()*this->grid_size_.y()) {
+    std::cerr << "error: voxel_storage_disk: cannot read slice " << slice_idx << " into a slab of size " << slab.size() << '\n';
+    return false;
+  }
+  if (!open_file())
+    return false;
+  vil_streampos slice_pos = this->slab_filepos(slice_idx);
+  if (fio_->tell() != slice_pos)
+    fio_->seek(slice_pos);
+  vil_streampos nbytes = slab.size()*sizeof(T);
+  return fio_->read(reinterpret_cast<char*>(slab.first_voxel()), nbytes) == nbytes;
+}
+
+template <class T>
+bool bvxm_voxel_storage_disk<T>::write_slab(unsigned slice_idx, bvxm_voxel_slab<T> const& slab)
+{
+  if (slice_idx >= this->grid_size_.z() || slab.size() != this->grid_size_.x()*this->grid_size_.y()) {
+    std::cerr << "error: voxel_storage_disk: cannot write a slab of size " << slab.size() << " to slice " << slice_idx << '\n';
+    return false;
+  }
+  if (!open_file())
+    return false;
+  vil_streampos slice_pos = this->slab_filepos(slice_idx);
+  if (fio_->tell() != slice_pos) {
+    fio_->seek(slice_pos);
+    if (fio_->tell() != slice_pos) {
+      std::cerr << "error seeking to file position " << slice_pos << std::endl;
+      return false;
+    }
+  }
+  vil_streampos nbytes = slab.size()*sizeof(T);
+  return fio_->write(reinterpret_cast<const char*>(slab.first_voxel()), nbytes) == nbytes;
+}
+
+template <class T>
+bool bvxm_voxel_storage_disk<T>::open_file()
+{
+  if (fio_)
+    return true;
+#ifdef BVXM_USE_FSTREAM64
+  fio_ = new vil_stream_fstream64(storage_fname_.c_str(),"rw");
+#else
+  fio_ = new vil_stream_fstream(storage_fname_.c_str(),"rw");
+#endif
+  if (!fio_->ok()) {
+    std::cerr << "error opening file " << storage_fname_ << " for read/write!\n";
+    fio_->ref();
+    fio_->unref();
+    fio_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
 template <class T>
 unsigned bvxm_voxel_storage_disk<T>::num_observations() const
 {
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vul/vul_file.h"
+#include <vpl/vpl_thread_pool.h>
+
+#include "vgl/vgl_vector_3d.h"
+
+#include "../bvxm_voxel_grid.h"
+#include "../bvxm_voxel_slab.h"
+#include "../bvxm_voxel_slab_pipeline.h"
+
+static bool slab_is(bvxm_voxel_slab<float> const& slab, float val)
+{
+  for (float v : slab)
+    if (v != val)
+      return false;
+  return true;
+}
+
+static void test_voxel_slab_pipeline()
+{
+  std::string storage_fname("bvxm_voxel_slab_pipeline_test_temp.vox");
+  std::string empty_fname("bvxm_voxel_slab_pipeline_test_empty.vox");
+  vul_file::delete_file_glob(storage_fname);
+  vul_file::delete_file_glob(empty_fname);
+  vgl_vector_3d<unsigned> grid_size(30,20,24);
+
+  {
+    // slice z of the disk grid holds z, and of the memory grid 10*z
+    bvxm_voxel_grid<float> disk_grid(storage_fname, grid_size);
+    disk_grid.initialize_data(0.0f);
+    bvxm_voxel_grid<float> mem_grid(grid_size);
+    bvxm_voxel_grid<float>::iterator disk_it = disk_grid.begin(), mem_it = mem_grid.begin();
+    for (unsigned z=0; z<grid_size.z(); ++z, ++disk_it, ++mem_it) {
+      disk_it->fill(float(z));
+      mem_it->fill(10.0f*z);
+    }
+
+    // add the memory grid to the disk grid, in bands of rows on several threads
+    vpl_set_concurrency(4);
+    bvxm_voxel_slab_pipeline pipeline(grid_size.z(), 2);
+    unsigned disk_g = pipeline.add_grid(&disk_grid, true);
+    unsigned mem_g = pipeline.add_grid(&mem_grid, false);
+    std::vector<unsigned> order;
+    bool read_ok = true;
+    std::vector<const float*> slots;
+    bool ok = pipeline.run([&](unsigned z) {
+      order.push_back(z);
+      bvxm_voxel_slab<float>& sum = pipeline.slab<float>(disk_g, z);
+      bvxm_voxel_slab<float>& other = pipeline.slab<float>(mem_g, z);
+      read_ok = read_ok && slab_is(sum, float(z)) && slab_is(other, 10.0f*z);
+      slots.push_back(sum.first_voxel());
+      vpl_parallel_for_range(0u, sum.ny(), [&](unsigned y0, unsigned y1) {
+        for (unsigned y=y0; y<y1; ++y)
+          for (unsigned x=0; x<sum.nx(); ++x)
+            sum(x,y) += other(x,y);
+      }, 1u);
+    });
+    vpl_set_concurrency(0);
+    TEST("Pipeline runs", ok, true);
+    bool in_order = order.size() == grid_size.z();
+    for (unsigned z=0; z<order.size(); ++z)
+      in_order = in_order && order[z] == z;
+    TEST("Slices are updated in order", in_order, true);
+    TEST("Slices are read before their update", read_ok, true);
+    bool bounded = true;
+    for (unsigned z=2; z<slots.size(); ++z)
+      bounded = bounded && slots[z] == slots[z-2] && slots[z] != slots[z-1];
+    TEST("Slices share a ring of max_slabs slabs", bounded, true);
+
+    bool written = true;
+    bvxm_voxel_grid<float>::const_iterator disk_cit = disk_grid.begin(), mem_cit = mem_grid.begin();
+    for (unsigned z=0; z<grid_size.z(); ++z, ++disk_cit, ++mem_cit)
+      written = written && slab_is(*disk_cit, 11.0f*z) && slab_is(*mem_cit, 10.0f*z);
+    TEST("Updated slices are written back, others are not", written, true);
+
+    // an exception in an update stops the pipeline and is passed on
+    bool thrown = false;
+    unsigned last = 0;
+    try {
+      pipeline.run([&](unsigned z) {
+        last = z;
+        if (z == 5)
+          throw std::runtime_error("update failed");
+      });
+    }
+    catch (std::runtime_error const&) {
+      thrown = true;
+    }
+    TEST("Update exception is passed on", thrown && last == 5, true);
+  }
+
+  {
+    // the file of this grid has a header but no slices
+    bvxm_voxel_grid<float> empty_grid(empty_fname, grid_size);
+    bvxm_voxel_slab_pipeline pipeline(grid_size.z());
+    pipeline.add_grid(&empty_grid, false);
+    unsigned n_updated = 0;
+    bool ok = pipeline.run([&](unsigned) { ++n_updated; });
+    TEST("Pipeline fails when slices cannot be read", ok || n_updated > 0, false);
+  }
+
+  vul_file::delete_file_glob(storage_fname);
+  vul_file::delete_file_glob(empty_fname);
+}
+
+TESTMAIN(test_voxel_slab_pipeline);
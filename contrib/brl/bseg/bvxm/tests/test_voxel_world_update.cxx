@@ -1,3 +1,5 @@
+#include <string>
+#include <vector>
 #include "testlib/testlib_test.h"
 #include "vul/vul_file.h"
 
@@ -7,11 +9,100 @@
 #include <bvxm/bvxm_voxel_world.h>
 #include <bvxm/bvxm_world_params.h>
 #include <bvxm/bvxm_mog_grey_processor.h>
+#include <bvxm/bvxm_mog_rgb_processor.h>
 #include "vil/vil_image_view.h"
+#include "vnl/vnl_math.h"
 #include "vpgl/vpgl_proj_camera.h"
 #include "vpl/vpl.h"
+#include <vpl/vpl_thread_pool.h>
 
 
+//: updates a world with a few grey and rgb images on n_threads threads
+static bool update_world(bvxm_voxel_world& world, std::string const& model_dir, unsigned n_threads,
+                         vil_image_view<float>& prob_map)
+{
+  if (vul_file::is_directory(model_dir))
+    vul_file::delete_file_glob(model_dir + "/*");
+  else
+    vul_file::make_directory(model_dir);
+  bvxm_world_params_sptr params = new bvxm_world_params;
+  vpgl_lvcs_sptr lvcs = new vpgl_lvcs();
+  params->set_params(model_dir, vgl_point_3d<float>(0.f,0.f,0.f), vgl_vector_3d<unsigned>(40,30,12), 1.0f, lvcs);
+  world.set_params(params);
+  world.clean_grids();
+
+  vnl_matrix_fixed<double,3,4> camera_matrix(0.0);
+  camera_matrix.put(0,0,1); camera_matrix.put(0,2,0.3); camera_matrix.put(0,3,2);
+  camera_matrix.put(1,1,1); camera_matrix.put(1,2,0.2); camera_matrix.put(1,3,2);
+  camera_matrix.put(2,3,1);
+  vpgl_camera_double_sptr camera = new vpgl_proj_camera<double>(camera_matrix);
+
+  vil_image_view<vxl_byte> grey(50,40,1), rgb(50,40,3);
+  for (unsigned j=0; j<grey.nj(); ++j)
+    for (unsigned i=0; i<grey.ni(); ++i) {
+      grey(i,j) = vxl_byte((7*i + 13*j) % 256);
+      for (unsigned p=0; p<3; ++p)
+        rgb(i,j,p) = vxl_byte((5*i + 11*j + 40*p) % 256);
+    }
+  bvxm_image_metadata grey_obs(new vil_image_view<vxl_byte>(grey), camera);
+  bvxm_image_metadata rgb_obs(new vil_image_view<vxl_byte>(rgb), camera);
+
+  vpl_set_concurrency(n_threads);
+  prob_map.set_size(grey.ni(), grey.nj(), 1);
+  vil_image_view<bool> mask(grey.ni(), grey.nj(), 1);
+  bool result = world.update<APM_MOG_GREY>(grey_obs, prob_map, mask, 0) &&
+                world.update<APM_MOG_RGB>(rgb_obs, prob_map, mask, 0) &&
+                world.update<APM_MOG_GREY>(grey_obs, prob_map, mask, 0);
+  vpl_set_concurrency(0);
+  return result;
+}
+
+//: true if the grids of the two worlds hold the same values
+template <bvxm_voxel_type VOX_T, class F>
+static bool same_grids(bvxm_voxel_world& world_a, bvxm_voxel_world& world_b, F value)
+{
+  typedef typename bvxm_voxel_traits<VOX_T>::voxel_datatype vox_datatype;
+  bvxm_voxel_grid_base_sptr grid_a = world_a.get_grid<VOX_T>(0,0), grid_b = world_b.get_grid<VOX_T>(0,0);
+  auto* a = static_cast<bvxm_voxel_grid<vox_datatype>*>(grid_a.ptr());
+  auto* b = static_cast<bvxm_voxel_grid<vox_datatype>*>(grid_b.ptr());
+  typename bvxm_voxel_grid<vox_datatype>::const_iterator a_it = a->begin(), b_it = b->begin();
+  for (unsigned z=0; z<a->grid_size().z(); ++z, ++a_it, ++b_it)
+    if (!(value(*a_it) == value(*b_it)))
+      return false;
+  return true;
+}
+
+static void test_parallel_update()
+{
+  // the grids and probabilities do not depend on the number of threads
+  bvxm_voxel_world world_1, world_4;
+  vil_image_view<float> prob_map_1, prob_map_4;
+  bool result = update_world(world_1, "test_world_dir_1", 1, prob_map_1);
+  result = update_world(world_4, "test_world_dir_4", 4, prob_map_4) && result;
+  TEST("parallel world update", result, true);
+
+  // pixels no voxel projects to are 0/0
+  bool same_probs = prob_map_1.size() == prob_map_4.size();
+  for (unsigned j=0; same_probs && j<prob_map_1.nj(); ++j)
+    for (unsigned i=0; i<prob_map_1.ni(); ++i)
+      same_probs = same_probs && (prob_map_1(i,j) == prob_map_4(i,j) ||
+                                  (vnl_math::isnan(prob_map_1(i,j)) && vnl_math::isnan(prob_map_4(i,j))));
+  TEST("same pixel probabilities on 1 and 4 threads", same_probs, true);
+
+  auto ocp = [](bvxm_voxel_slab<float> const& slab) { return std::vector<float>(slab.begin(), slab.end()); };
+  auto grey = [](bvxm_voxel_slab<bvxm_mog_grey_processor::apm_datatype> const& slab) {
+    bvxm_voxel_slab<float> c = bvxm_mog_grey_processor().expected_color(slab);
+    return std::vector<float>(c.begin(), c.end());
+  };
+  auto rgb = [](bvxm_voxel_slab<bvxm_mog_rgb_processor::apm_datatype> const& slab) {
+    bvxm_voxel_slab<bvxm_mog_rgb_processor::obs_datatype> c = bvxm_mog_rgb_processor().expected_color(slab);
+    return std::vector<bvxm_mog_rgb_processor::obs_datatype>(c.begin(), c.end());
+  };
+  TEST("same occupancy on 1 and 4 threads", same_grids<OCCUPANCY>(world_1, world_4, ocp), true);
+  TEST("same grey appearance on 1 and 4 threads", same_grids<APM_MOG_GREY>(world_1, world_4, grey), true);
+  TEST("same rgb appearance on 1 and 4 threads", same_grids<APM_MOG_RGB>(world_1, world_4, rgb), true);
+}
+
 static void test_voxel_world_update()
 {
   std::string model_dir("test_world_dir");
@@ -76,6 +167,8 @@ static void test_voxel_world_update()
   TEST("world update", result, true);
 
   //TO DO: check update for other processors
+
+  test_parallel_update();
 }
 
 TESTMAIN( test_voxel_world_update );
@@ -0,0 +1,88 @@
+// This is mul/vil3d/algo/vil3d_exact_distance_transform.cxx
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "vil3d_exact_distance_transform.h"
+//:
+// \file
+#include <vil3d/vil3d_slice.h>
+#include <vpl/vpl_thread_pool.h>
+#include <cassert>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: Compute d2 and, if nearest is not null, the nearest feature.
+static void vil3d_exact_distance_transform_3d(const vil3d_image_view<bool>& mask,
+                                              vil3d_image_view<vxl_uint_32>& d2,
+                                              vil3d_image_view<vxl_uint_32>* nearest)
+{
+  assert(mask.nplanes()==1);
+  const unsigned ni = mask.ni(), nj = mask.nj(), nk = mask.nk();
+  assert(vxl_int_64(ni)*ni + vxl_int_64(nj)*nj + vxl_int_64(nk)*nk < vxl_int_64(vil_edt_infinity));
+  d2.set_size(ni,nj,nk,1);
+  if (nearest) nearest->set_size(ni,nj,nk,1);
+  if (ni==0 || nj==0 || nk==0) return;
+
+  // In each slice; the slice views share memory with d2 and nearest.
+  vpl_parallel_for(0u, nk, [&](unsigned k)
+  {
+    vil_image_view<vxl_uint_32> d2_k = vil3d_slice_ij(d2,k);
+    if (!nearest)
+    {
+      vil_exact_distance_transform_r2(vil3d_slice_ij(mask,k),d2_k);
+      return;
+    }
+    vil_image_view<vxl_uint_32> nearest_k = vil3d_slice_ij(*nearest,k);
+    vil_exact_distance_transform_r2(vil3d_slice_ij(mask,k),d2_k,nearest_k);
+  }, 1u);
+
+  // Along k, one row of lines at a time.
+  const std::ptrdiff_t kstep = d2.kstep();
+  vpl_parallel_for(0u, nj, [&](unsigned j)
+  {
+    vil_edt_workspace ws;
+    std::vector<vxl_uint_32> line(nk), arg(nk);
+    for (unsigned i=0;i<ni;++i)
+    {
+      vxl_uint_32* d = &d2(i,j,0);
+      if (!nearest)
+      {
+        vil_exact_distance_transform_1d(d,kstep,nk,d,kstep,nullptr,0,ws);
+        continue;
+      }
+      // Indices within slices, made into indices within the volume.
+      for (unsigned k=0;k<nk;++k) line[k] = (*nearest)(i,j,k);
+      vil_exact_distance_transform_1d(d,kstep,nk,d,kstep,arg.data(),1,ws);
+      for (unsigned k=0;k<nk;++k)
+        (*nearest)(i,j,k) = arg[k]==vil_edt_infinity ? vil_edt_infinity
+                                                      : line[arg[k]] + arg[k]*ni*nj;
+    }
+  }, 1u);
+}
+
+void vil3d_exact_distance_transform_r2(const vil3d_image_view<bool>& mask,
+                                       vil3d_image_view<vxl_uint_32>& d2)
+{
+  vil3d_exact_distance_transform_3d(mask,d2,nullptr);
+}
+
+void vil3d_exact_distance_transform_r2(const vil3d_image_view<bool>& mask,
+                                       vil3d_image_view<vxl_uint_32>& d2,
+                                       vil3d_image_view<vxl_uint_32>& nearest)
+{
+  vil3d_exact_distance_transform_3d(mask,d2,&nearest);
+}
+
+void vil3d_exact_distance_transform(const vil3d_image_view<bool>& mask,
+                                    vil3d_image_view<float>& distance)
+{
+  vil3d_image_view<vxl_uint_32> d2;
+  vil3d_exact_distance_transform_3d(mask,d2,nullptr);
+  distance.set_size(d2.ni(),d2.nj(),d2.nk(),1);
+  for (unsigned k=0;k<d2.nk();++k)
+    for (unsigned j=0;j<d2.nj();++j)
+      for (unsigned i=0;i<d2.ni();++i)
+        distance(i,j,k) = d2(i,j,k)==vil_edt_infinity ? std::numeric_limits<float>::max()
+                                                       : float(std::sqrt(double(d2(i,j,k))));
+}
@@ -0,0 +1,35 @@
+// This is mul/vil3d/algo/vil3d_exact_distance_transform.h
+#ifndef vil3d_exact_distance_transform_h_
+#define vil3d_exact_distance_transform_h_
+//:
+// \file
+// \brief Exact Euclidean distance transform of 3D masks, in linear time
+//
+// Each slice is transformed by vil_exact_distance_transform (the slices
+// shared between threads), then the squared distances are combined along
+// k with the same lower envelope of parabolas (the rows shared between
+// threads). Unlike vil3d_distance_transform the distances are exact.
+// The sum of the squares of the image dimensions must be below 2^32.
+
+#include <vxl_config.h>
+#include <vil/algo/vil_exact_distance_transform.h>
+#include <vil3d/vil3d_image_view.h>
+
+//: Squared Euclidean distance from each voxel to the nearest true voxel of mask.
+//  Voxels are vil_edt_infinity if mask has no true voxel.
+void vil3d_exact_distance_transform_r2(const vil3d_image_view<bool>& mask,
+                                       vil3d_image_view<vxl_uint_32>& d2);
+
+//: Squared distance from each voxel to the nearest true voxel of mask, and that voxel.
+//  nearest(i,j,k) is the raster index (k*nj+j)*ni+i of the nearest true
+//  voxel of mask (or vil_edt_infinity, if there are none).
+void vil3d_exact_distance_transform_r2(const vil3d_image_view<bool>& mask,
+                                       vil3d_image_view<vxl_uint_32>& d2,
+                                       vil3d_image_view<vxl_uint_32>& nearest);
+
+//: Euclidean distance from each voxel to the nearest true voxel of mask.
+//  Voxels are the largest float if mask has no true voxel.
+void vil3d_exact_distance_transform(const vil3d_image_view<bool>& mask,
+                                    vil3d_image_view<float>& distance);
+
+#endif // vil3d_exact_distance_transform_h_
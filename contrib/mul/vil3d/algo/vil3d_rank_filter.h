@@ -7,8 +7,12 @@
 
 #include <iostream>
 #include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <vil/algo/vil_rank_filter.h>
 #include <vil3d/algo/vil3d_structuring_element.h>
 #include <vil3d/vil3d_image_view.h>
+#include <vpl/vpl_thread_pool.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -53,9 +57,91 @@ inline T vil3d_sorted_value(const vil3d_image_view<T>& image, unsigned plane,
   return values[std::size_t(r*(values.size()-1))];
 }
 
+//: Rank filter over a box, using sliding histograms (see vil_rank_filter.h)
+//  dest(i,j,k) is value number r*(n-1) of the sorted values of the n voxels
+//  src(i+a,j+b,k+c) inside the image, for ilo<=a<=ihi, jlo<=b<=jhi and
+//  klo<=c<=khi. The box must contain (0,0,0). Only for vxl_byte and
+//  vxl_uint_16 voxels. Each column histogram covers (jhi-jlo+1)*(khi-klo+1)
+//  voxels, which must not exceed 65535. Slices are processed concurrently
+//  on the vpl thread pool. The cost per voxel grows only with khi-klo.
+template<class T>
+inline void vil3d_rank_filter_box(const vil3d_image_view<T>& src,
+                                  vil3d_image_view<T>& dest,
+                                  int ilo, int ihi, int jlo, int jhi, int klo, int khi,
+                                  double r)
+{
+  assert(ilo<=0 && ihi>=0 && jlo<=0 && jhi>=0 && klo<=0 && khi>=0);
+  assert((jhi-jlo+1)*(khi-klo+1)<=65535);
+  const int ni = src.ni(), nj = src.nj(), nk = src.nk(), np = src.nplanes();
+  dest.set_size(ni,nj,nk,np);
+  if (ni==0 || nj==0 || nk==0) return;
+
+  // Column histograms of 16 bit data are large, so split rows into strips.
+  const int width = sizeof(T)==1 ? ni : std::min(ni,128);
+  const int n_strips = (ni+width-1)/width;
+  const unsigned n_items = unsigned(n_strips*nk*np);
+
+  vpl_parallel_for_range(0u,n_items,[&](unsigned first, unsigned last)
+  {
+    vil_rank_histogram<T> hist;
+    for (unsigned item=first;item<last;++item)
+    {
+      const int p = item/(n_strips*nk), k = (item/n_strips)%nk, s = item%n_strips;
+      const int x0 = s*width, x1 = std::min(ni,x0+width);
+      const int c_first = std::max(0,x0+ilo), c_last = std::min(ni-1,x1-1+ihi);
+      const int s0 = std::max(0,k+klo), s1 = std::min(nk-1,k+khi);
+      hist.set_size(c_last-c_first+1);
+      int row0 = 0, row1 = -1;
+      for (int y=0;y<nj;++y)
+      {
+        const int r0 = std::max(0,y+jlo), r1 = std::min(nj-1,y+jhi);
+        for (int row=row0;row<r0 && row<=row1;++row)
+          for (int z=s0;z<=s1;++z)
+            for (int c=c_first;c<=c_last;++c)
+              hist.remove(c-c_first,src(c,row,z,p));
+        for (int row=std::max(row1+1,r0);row<=r1;++row)
+          for (int z=s0;z<=s1;++z)
+            for (int c=c_first;c<=c_last;++c)
+              hist.add(c-c_first,src(c,row,z,p));
+        row0 = r0; row1 = r1;
+        const std::size_t n_col = std::size_t(r1-r0+1)*(s1-s0+1);
+
+        for (int x=x0;x<x1;++x)
+        {
+          const int k0 = std::max(0,x+ilo), k1 = std::min(ni-1,x+ihi);
+          if (x==x0) hist.set_window(k0-c_first,k1-c_first);
+          else       hist.move_window(k0-c_first,k1-c_first);
+          const std::size_t n = n_col*(k1-k0+1);
+          dest(x,y,k,p) = hist.rank(std::size_t(r*(n-1)));
+        }
+      }
+    }
+  });
+}
+
+//: Apply vil3d_rank_filter_box if it can be used; otherwise return false.
+template<class T>
+inline bool vil3d_rank_filter_if_box(const vil3d_image_view<T>&, vil3d_image_view<T>&,
+                                     const vil3d_structuring_element&, double, std::false_type)
+{
+  return false;
+}
+
+template<class T>
+inline bool vil3d_rank_filter_if_box(const vil3d_image_view<T>& src, vil3d_image_view<T>& dest,
+                                     const vil3d_structuring_element& e, double r, std::true_type)
+{
+  if (!vil3d_structuring_element_is_box(e) ||
+      (e.max_j()-e.min_j()+1)*(e.max_k()-e.min_k()+1)>65535)
+    return false;
+  vil3d_rank_filter_box(src,dest,e.min_i(),e.max_i(),e.min_j(),e.max_j(),e.min_k(),e.max_k(),r);
+  return true;
+}
+
 //: Apply rank filter to a 3D image
 //  Each voxel in the output is the n-th ranked voxel
 //  in the region under the structuring element, where n = r*volume_of_element
+//  Boxes of vxl_byte or vxl_uint_16 voxels are done by vil3d_rank_filter_box.
 template<class T>
 inline void vil3d_rank_filter(const vil3d_image_view<T>& src_image,
                         vil3d_image_view<T>& dest_image,
@@ -63,6 +149,9 @@ inline void vil3d_rank_filter(const vil3d_image_view<T>& src_image,
                         double r)
 {
   assert(src_image.nplanes()==1);
+  if (vil3d_rank_filter_if_box(src_image,dest_image,element,r,
+                               std::integral_constant<bool,vil_rank_histogram_supported<T>::value>()))
+    return;
   unsigned ni = src_image.ni(); assert(ni>0);
   unsigned nj = src_image.nj(); assert(nj>0);
   unsigned nk = src_image.nk(); assert(nk>0);
@@ -233,3 +233,23 @@ void vil3d_compute_offsets(std::vector<std::ptrdiff_t>& offset,
     offset[a] = element.p_i()[a]*istep + element.p_j()[a]*jstep
               + element.p_k()[a]*kstep;
 }
+
+//: True if element is a filled box which contains (0,0,0).
+bool vil3d_structuring_element_is_box(const vil3d_structuring_element& element)
+{
+  const int ilo = element.min_i(), jlo = element.min_j(), klo = element.min_k();
+  if (ilo>0 || element.max_i()<0 || jlo>0 || element.max_j()<0 || klo>0 || element.max_k()<0)
+    return false;
+  const std::size_t ni = element.max_i()-ilo+1, nj = element.max_j()-jlo+1;
+  const std::size_t nk = element.max_k()-klo+1, n = element.p_i().size();
+  if (n!=ni*nj*nk) return false;
+  // n points in a box of n voxels fill it if none is repeated.
+  std::vector<bool> seen(n,false);
+  for (std::size_t a=0;a<n;++a)
+  {
+    const std::size_t index = ((element.p_k()[a]-klo)*nj + (element.p_j()[a]-jlo))*ni + (element.p_i()[a]-ilo);
+    if (seen[index]) return false;
+    seen[index] = true;
+  }
+  return true;
+}
@@ -121,4 +121,8 @@ void vil3d_compute_offsets(std::vector<std::ptrdiff_t>& offset,
                            std::ptrdiff_t jstep,
                            std::ptrdiff_t kstep);
 
+//: True if element is a filled box which contains (0,0,0).
+//  Such elements allow separable, constant time per voxel filters.
+bool vil3d_structuring_element_is_box(const vil3d_structuring_element& element);
+
 #endif // vil3d_structuring_element_h_
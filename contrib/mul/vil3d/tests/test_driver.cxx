@@ -38,6 +38,7 @@ DECLARE( test_algo_abs_shuffle_distance );
 DECLARE( test_algo_make_distance_filter );
 DECLARE( test_algo_exp_distance_transform );
 DECLARE( test_algo_find_blobs );
+DECLARE( test_algo_rank_filter );
 
 
 void
@@ -80,6 +81,7 @@ register_tests()
   REGISTER( test_algo_make_distance_filter );
   REGISTER( test_algo_exp_distance_transform );
   REGISTER( test_algo_find_blobs );
+  REGISTER( test_algo_rank_filter );
 }
 
 DEFINE_MAIN;
@@ -6,6 +6,7 @@
 //  \brief 2D Normalised correlation
 //  \author Tim Cootes
 
+#include <type_traits>
 #include <vil/algo/vil_normalised_correlation_2d.h>
 #include <vimt/vimt_image_2d_of.h>
 #include <vgl/vgl_fwd.h>
@@ -13,6 +14,10 @@
 //: Evaluate dot product between kernel and (normalised) src_im
 // Assumes that the kernel has been normalised to have zero mean
 // and unit variance.
+// For a floating point accumT this uses vil_normalised_correlation_2d_fast,
+// which sums in double, and gives 0 where the variance under the kernel is
+// no more than 1e-12 of the mean square (rather than only where it is 0).
+// Otherwise it uses vil_normalised_correlation_2d, summing in accumT.
 // \relatesalso vimt_image_2d_of
 template <class srcT, class destT, class kernelT, class accumT>
 inline void vimt_normalised_correlation_2d(const vimt_image_2d_of<srcT>& src_im,
@@ -21,7 +26,10 @@ inline void vimt_normalised_correlation_2d(const vimt_image_2d_of<srcT>& src_im,
                                            vgl_point_2d<double> kernel_ref_pt,
                                            accumT ac)
 {
-  vil_normalised_correlation_2d(src_im.image(),dest_im.image(),kernel,ac);
+  if (std::is_floating_point<accumT>::value)
+    vil_normalised_correlation_2d_fast(src_im.image(),dest_im.image(),kernel);
+  else
+    vil_normalised_correlation_2d(src_im.image(),dest_im.image(),kernel,ac);
   vimt_transform_2d offset;
   offset.set_translation(-kernel_ref_pt.x(),-kernel_ref_pt.y());
   dest_im.set_world2im(offset * src_im.world2im());
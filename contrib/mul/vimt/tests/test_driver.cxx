@@ -15,6 +15,7 @@ DECLARE( test_resample_bilin );
 DECLARE( test_image_bounds_and_centre_2d );
 DECLARE( test_v2i );
 DECLARE( test_reflect );
+DECLARE( test_normalised_correlation_2d );
 
 void
 register_tests()
@@ -34,6 +35,7 @@ register_tests()
   REGISTER( test_image_bounds_and_centre_2d );
   REGISTER( test_v2i );
   REGISTER( test_reflect );
+  REGISTER( test_normalised_correlation_2d );
 }
 
 DEFINE_MAIN;
@@ -0,0 +1,51 @@
+// This is mul/vimt/tests/test_normalised_correlation_2d.cxx
+#include <cmath>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vimt/algo/vimt_normalised_correlation_2d.h>
+#include "vgl/vgl_point_2d.h"
+
+static void test_normalised_correlation_2d()
+{
+  // a flat image with a small bump on the left, and a large one on the right
+  vimt_image_2d_of<float> image;
+  image.image().set_size(12,5);
+  image.image().fill(1000.0f);
+  image.image()(2,2) = 1000.0625f;
+  image.image()(9,2) = 1010.0f;
+
+  // zero mean and unit variance
+  vil_image_view<double> kernel(3,3,1);
+  kernel.fill(-std::sqrt(1.0/8.0));
+  kernel(1,1) = std::sqrt(8.0);
+  vgl_point_2d<double> kernel_ref_pt(1,1);
+
+  vimt_image_2d_of<double> fast, slow;
+  vimt_normalised_correlation_2d(image,fast,kernel,kernel_ref_pt,double());
+  vil_normalised_correlation_2d(image.image(),slow.image(),kernel,double());
+  TEST("Size", fast.image().ni() == 10 && fast.image().nj() == 3, true);
+  // a single bump under the kernel centre correlates to 9, whatever its height
+  TEST_NEAR("Peak on the bump", fast.image()(8,1), 9.0, 1e-9);
+  TEST_NEAR("Near-constant window is not taken as constant", fast.image()(1,1), 9.0, 1e-4);
+  TEST_NEAR("Near-constant window as vil_normalised_correlation_2d", fast.image()(1,1), slow.image()(1,1), 1e-4);
+  TEST("Constant window gives 0", fast.image()(5,1), 0.0);
+  TEST_NEAR("Reference point", fast.world2im()(vgl_point_2d<double>(1,1)).x(), 0.0, 1e-12);
+
+  // an integer accumT sums as vil_normalised_correlation_2d does
+  vimt_image_2d_of<int> int_image;
+  int_image.image().set_size(6,5);
+  int_image.image().fill(100);
+  int_image.image()(2,2) = 101;
+  vimt_image_2d_of<double> int_sums, int_slow;
+  vimt_normalised_correlation_2d(int_image,int_sums,kernel,kernel_ref_pt,long());
+  vil_normalised_correlation_2d(int_image.image(),int_slow.image(),kernel,long());
+  bool same = true;
+  for (unsigned j=0; j<int_sums.image().nj(); ++j)
+    for (unsigned i=0; i<int_sums.image().ni(); ++i)
+      same = same && int_sums.image()(i,j) == int_slow.image()(i,j);
+  TEST("Integer accumT matches vil_normalised_correlation_2d", same, true);
+}
+
+TESTMAIN(test_normalised_correlation_2d);
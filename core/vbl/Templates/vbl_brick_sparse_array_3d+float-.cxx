@@ -0,0 +1,2 @@
+#include "vbl/vbl_brick_sparse_array_3d.hxx"
+VBL_BRICK_SPARSE_ARRAY_3D_INSTANTIATE(float);
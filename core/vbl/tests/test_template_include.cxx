@@ -3,6 +3,7 @@
 #include "vbl/vbl_array_3d.hxx"
 #include "vbl/vbl_attributes.hxx"
 #include "vbl/vbl_big_sparse_array_3d.hxx"
+#include "vbl/vbl_brick_sparse_array_3d.hxx"
 #include "vbl/vbl_bounding_box.hxx"
 #include "vbl/vbl_local_minima.hxx"
 #include "vbl/vbl_quadruple.hxx"
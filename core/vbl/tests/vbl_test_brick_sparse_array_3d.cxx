@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include "testlib/testlib_test.h"
+#include "vbl/vbl_brick_sparse_array_3d.h"
+#include "vbl/vbl_sparse_array_3d.h"
+
+static void
+vbl_test_brick_sparse_array_3d()
+{
+  vbl_brick_sparse_array_3d<double> x;
+  const double d = 1.23;
+  x(1, 2, 3) = d;
+  x(100, 200, 300) = 100.2003;
+  TEST("Something in (1,2,3)", x.fullp(1, 2, 3), true);
+  TEST("Content of x(1,2,3) is correct", x(1, 2, 3), d);
+  TEST("Something in (100,200,300)", x.fullp(100, 200, 300), true);
+  TEST("Nothing in (2,3,4) yet", x.fullp(2, 3, 4), false);
+  TEST("put into empty location", x.put(2, 3, 4, 7), true);
+  TEST("Something in (2,3,4) now", x.fullp(2, 3, 4), true);
+  TEST("Content of x(2,3,4) is correct", x(2, 3, 4), 7);
+  TEST("put does not overwrite", x.put(2, 3, 4, 8), false);
+  TEST("Content of x(2,3,4) unchanged", x(2, 3, 4), 7);
+  TEST("count_nonempty", x.count_nonempty(), 3);
+  TEST("count_bricks", x.count_bricks(), 2);
+  TEST("get_addr of empty location", x.get_addr(5, 5, 5) == nullptr, true);
+  TEST("get_addr of filled location", x.get_addr(1, 2, 3) != nullptr && *x.get_addr(1, 2, 3) == d, true);
+  TEST("Large coordinates", (x(1 << 23, 3, 1 << 22) = 5.0, x.fullp(1 << 23, 3, 1 << 22)), true);
+  x.erase(1 << 23, 3, 1 << 22);
+  TEST("erase releases the brick", x.count_bricks() == 2 && !x.fullp(1 << 23, 3, 1 << 22), true);
+
+  // Coordinates beyond 2^24-1 cannot be packed into a brick key.
+  const unsigned too_big = 1u << 24, biggest = too_big - 1;
+  TEST("put beyond the largest coordinate fails", x.put(too_big, 0, 0, 1.0), false);
+  TEST("put at the largest coordinate", x.put(biggest, biggest, biggest, 2.0), true);
+  TEST("no wrap-around onto (0,2,3)", x.fullp(too_big + 1, 2, 3) || x.get_addr(1, too_big + 2, 3) != nullptr, false);
+  bool thrown = false;
+  try
+  {
+    x(0, 0, too_big) = 3.0;
+  }
+  catch (const std::out_of_range &)
+  {
+    thrown = true;
+  }
+  TEST("operator() beyond the largest coordinate throws", thrown, true);
+  TEST("out of range accesses leave the array unchanged", x.count_nonempty() == 4 && x.count_bricks() == 3, true);
+  x.erase(biggest, biggest, biggest);
+
+  std::ostringstream os;
+  os << x;
+  TEST("print", os.str(), "(1,2,3): 1.23\n(2,3,4): 7\n(100,200,300): 100.2\n");
+
+  // Compare against vbl_sparse_array_3d with random accumulation and erasure.
+  vbl_brick_sparse_array_3d<int> b;
+  vbl_sparse_array_3d<int> m;
+  std::srand(17);
+  for (int n = 0; n < 20000; ++n)
+  {
+    const unsigned i = 500 + std::rand() % 40, j = std::rand() % 40, k = 70000 + std::rand() % 40;
+    if (std::rand() % 5 == 0)
+    {
+      if (m.fullp(i, j, k))
+      {
+        m.erase(vbl_make_triple(i, j, k));
+        b.erase(i, j, k);
+      }
+    }
+    else
+    {
+      m(i, j, k) += n;
+      b(i, j, k) += n;
+    }
+  }
+  TEST("same number of elements", b.count_nonempty(), m.count_nonempty());
+  bool same = true;
+  std::size_t visited = 0;
+  for (vbl_brick_sparse_array_3d<int>::const_iterator p = b.begin(); p != b.end(); ++p, ++visited)
+  {
+    const vbl_triple<unsigned, unsigned, unsigned> idx = (*p).first;
+    same = same && m.fullp(idx.first, idx.second, idx.third) && m(idx.first, idx.second, idx.third) == (*p).second;
+  }
+  TEST("iteration visits every element once", visited, m.count_nonempty());
+  TEST("same contents", same, true);
+
+  // Copies are deep.
+  vbl_brick_sparse_array_3d<int> c = b;
+  c(500, 0, 70000) = -1;
+  TEST("copy is independent", b.fullp(500, 0, 70000) && b(500, 0, 70000) == -1, false);
+  TEST("copy has the same elements", c.count_nonempty() >= b.count_nonempty(), true);
+
+  b.clear();
+  TEST("clear", b.count_nonempty() == 0 && b.count_bricks() == 0 && b.begin() == b.end(), true);
+}
+
+TESTMAIN(vbl_test_brick_sparse_array_3d);
@@ -0,0 +1,278 @@
+// This is core/vbl/vbl_brick_sparse_array_3d.h
+#ifndef vbl_brick_sparse_array_3d_h_
+#define vbl_brick_sparse_array_3d_h_
+//:
+// \file
+// \brief Sparse 3d array stored as dense 8x8x8 bricks
+//
+// vbl_brick_sparse_array_3d has the same interface as vbl_sparse_array_3d,
+// but instead of one std::map node per element it allocates a dense brick
+// of 8x8x8 cells, plus a 512 bit occupancy mask, the first time any cell of
+// the brick is filled. Bricks are found through a hash table keyed by the
+// brick coordinates, and the most recently used brick is remembered, so the
+// spatially coherent access typical of voxel accumulation rarely needs a
+// hash lookup at all.
+//
+// Compared with vbl_sparse_array_3d this gives O(1) access and a per-element
+// overhead of one bit plus the unused cells of partially filled bricks,
+// instead of a map node (three pointers, colour and key) per element. It
+// is the better choice when filled cells cluster in space; for a handful of
+// isolated cells spread over a huge volume vbl_sparse_array_3d is smaller.
+//
+// Iteration visits the bricks in the order they were created, and within a
+// brick the cells in (i,j,k) order with k varying fastest. The iterator
+// dereferences to a std::pair of the (i,j,k) index and the value, just as
+// the vbl_sparse_array_3d iterator does.
+//
+// Each coordinate must be at most max_coordinate (2^24-1): put() refuses
+// locations beyond it, operator() throws std::out_of_range, and the
+// queries report them empty. Addresses returned by get_addr()
+// and references returned by operator() stay valid until the cell is
+// erased or the array is cleared.
+//
+// Example usage:
+// \code
+//  vbl_brick_sparse_array_3d<float> acc;
+//  for (auto const& p : points)
+//    acc(p.i, p.j, p.k) += p.weight;
+//  for (auto it = acc.begin(); it != acc.end(); ++it)
+//    std::cout << (*it).first.first << ' ' << (*it).second << '\n';
+// \endcode
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vbl_triple.h"
+
+//: Sparse 3d array of dense 8x8x8 bricks allocated on demand
+template <class T>
+class vbl_brick_sparse_array_3d
+{
+public:
+  typedef std::size_t size_type;
+
+  //: The type of objects used to index the sparse array
+  typedef vbl_triple<unsigned, unsigned, unsigned> Index_type;
+
+  //: The type of values stored by the sparse array
+  typedef T T_type;
+
+  //: The type of values of the controlled sequence
+  typedef std::pair<Index_type, T> sequence_value_type;
+
+  //: Number of cells along each side of a brick.
+  enum
+  {
+    brick_side = 8,
+    brick_volume = brick_side * brick_side * brick_side,
+    //: Largest coordinate along each axis.
+    max_coordinate = 0xffffff
+  };
+
+  class const_iterator;
+
+  vbl_brick_sparse_array_3d() = default;
+
+  //: Put a value into location (i,j,k).
+  //  Returns false (and leaves the array unchanged) if the location was
+  //  already filled, or is beyond max_coordinate.
+  bool
+  put(unsigned i, unsigned j, unsigned k, const T & t);
+
+  //: Return contents of location (i,j,k).
+  //  The location is filled with T() if it has not been filled yet.
+  //  Throws std::out_of_range if the location is beyond max_coordinate.
+  T &
+  operator()(unsigned i, unsigned j, unsigned k);
+
+  //: Return contents of (i,j,k).  Assertion failure if not yet filled.
+  const T &
+  operator()(unsigned i, unsigned j, unsigned k) const;
+
+  //: Return true if location (i,j,k) has been filled.
+  bool
+  fullp(unsigned i, unsigned j, unsigned k) const;
+
+  //: Return the address of location (i,j,k).  0 if not yet filled.
+  T *
+  get_addr(unsigned i, unsigned j, unsigned k);
+
+  //: Erase element at location (i,j,k). Assertion failure if not yet filled.
+  //  A brick is released when its last element is erased.
+  void
+  erase(unsigned i, unsigned j, unsigned k);
+
+  //: Empty the sparse array.
+  void
+  clear();
+
+  //: Return number of locations that have been filled.
+  size_type
+  count_nonempty() const
+  {
+    return count_;
+  }
+
+  //: Return number of bricks allocated.
+  size_type
+  count_bricks() const
+  {
+    return bricks_.size();
+  }
+
+  //: Iterator pointing at the first filled location, in brick order.
+  const_iterator
+  begin() const;
+
+  //: Iterator pointing just beyond the last filled location.
+  const_iterator
+  end() const;
+
+  //: Print the Array to a stream in "(i,j,k): value" format.
+  std::ostream &
+  print(std::ostream &) const;
+
+private:
+  //: One dense block of cells, with a bit per cell saying whether it is filled.
+  // Cell (i,j,k) of the brick is at offset (i*8+j)*8+k, so mask[i] holds
+  // the bits of the i-th 8x8 slice.
+  struct brick
+  {
+    unsigned bi, bj, bk;    //!< brick coordinates, i.e. cell coordinates / 8
+    vxl_uint_64 mask[brick_side];
+    unsigned count;         //!< number of filled cells
+    std::unique_ptr<T[]> data;
+
+    brick(unsigned i, unsigned j, unsigned k);
+    brick(const brick & b);
+    brick(brick &&) = default;
+    brick &
+    operator=(const brick & b);
+    brick &
+    operator=(brick &&) = default;
+
+    bool
+    filled(unsigned o) const
+    {
+      return ((mask[o >> 6] >> (o & 63)) & 1) != 0;
+    }
+  };
+
+  static vxl_uint_64
+  key(unsigned bi, unsigned bj, unsigned bk);
+
+  //: True if (i,j,k) can be stored, i.e. no coordinate is beyond max_coordinate.
+  static bool
+  in_range(unsigned i, unsigned j, unsigned k)
+  {
+    return (i | j | k) <= unsigned(max_coordinate);
+  }
+
+  static unsigned
+  offset(unsigned i, unsigned j, unsigned k)
+  {
+    return ((i & (brick_side - 1)) * brick_side + (j & (brick_side - 1))) * brick_side + (k & (brick_side - 1));
+  }
+
+  //: Index of the brick containing (i,j,k), or -1 if there is none (or it is out of range).
+  long
+  find_brick(unsigned i, unsigned j, unsigned k) const;
+
+  //: The brick containing (i,j,k), created if need be.  Throws std::out_of_range if (i,j,k) is out of range.
+  brick &
+  get_brick(unsigned i, unsigned j, unsigned k);
+
+  //: Mark cell o of brick b as filled, and return it.
+  T &
+  fill_cell(brick & b, unsigned o);
+
+  std::vector<brick> bricks_;
+  std::unordered_map<vxl_uint_64, unsigned> index_;
+  size_type count_{ 0 };
+  //: The brick used by the last non-const access, to skip the hash lookup.
+  long last_{ -1 };
+};
+
+//: Iterator over the filled locations of a vbl_brick_sparse_array_3d.
+template <class T>
+class vbl_brick_sparse_array_3d<T>::const_iterator
+{
+public:
+  const_iterator() = default;
+
+  //: The index and value of the current location.
+  sequence_value_type
+  operator*() const
+  {
+    return sequence_value_type(index(), value());
+  }
+
+  //: The (i,j,k) index of the current location.
+  Index_type
+  index() const;
+
+  //: The value at the current location.
+  const T &
+  value() const
+  {
+    return (*bricks_)[b_].data[o_];
+  }
+
+  const_iterator &
+  operator++();
+
+  const_iterator
+  operator++(int)
+  {
+    const_iterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool
+  operator==(const const_iterator & that) const
+  {
+    return b_ == that.b_ && o_ == that.o_;
+  }
+
+  bool
+  operator!=(const const_iterator & that) const
+  {
+    return !operator==(that);
+  }
+
+private:
+  friend class vbl_brick_sparse_array_3d<T>;
+  const_iterator(const std::vector<brick> * bricks, std::size_t b, unsigned o)
+    : bricks_(bricks)
+    , b_(b)
+    , o_(o)
+  {}
+
+  //: Move forward to the first filled cell at or after (b_, o_).
+  void
+  settle();
+
+  const std::vector<brick> * bricks_{ nullptr };
+  std::size_t b_{ 0 };
+  unsigned o_{ 0 };
+};
+
+//: Stream operator - print the Array to a stream in "(i,j,k): value" format.
+template <class T>
+inline std::ostream &
+operator<<(std::ostream & s, const vbl_brick_sparse_array_3d<T> & a)
+{
+  return a.print(s);
+}
+
+#define VBL_BRICK_SPARSE_ARRAY_3D_INSTANTIATE(T) extern "please include vbl/vbl_brick_sparse_array_3d.hxx instead"
+
+#endif // vbl_brick_sparse_array_3d_h_
@@ -0,0 +1,273 @@
+// This is core/vbl/vbl_brick_sparse_array_3d.hxx
+#ifndef vbl_brick_sparse_array_3d_hxx_
+#define vbl_brick_sparse_array_3d_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "vbl_brick_sparse_array_3d.h"
+#include <cassert>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+template <class T>
+vbl_brick_sparse_array_3d<T>::brick::brick(unsigned i, unsigned j, unsigned k)
+  : bi(i)
+  , bj(j)
+  , bk(k)
+  , count(0)
+  , data(new T[brick_volume]())
+{
+  std::fill(mask, mask + brick_side, vxl_uint_64(0));
+}
+
+template <class T>
+vbl_brick_sparse_array_3d<T>::brick::brick(const brick & b)
+  : bi(b.bi)
+  , bj(b.bj)
+  , bk(b.bk)
+  , count(b.count)
+  , data(new T[brick_volume])
+{
+  std::copy(b.mask, b.mask + brick_side, mask);
+  std::copy(b.data.get(), b.data.get() + brick_volume, data.get());
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::brick &
+vbl_brick_sparse_array_3d<T>::brick::operator=(const brick & b)
+{
+  if (this != &b)
+    *this = brick(b);
+  return *this;
+}
+
+template <class T>
+vxl_uint_64
+vbl_brick_sparse_array_3d<T>::key(unsigned bi, unsigned bj, unsigned bk)
+{
+  // 21 bits per brick coordinate, i.e. cell coordinates up to 2^24-1
+  assert(bi <= 0x1fffff && bj <= 0x1fffff && bk <= 0x1fffff);
+  return (vxl_uint_64(bi) << 42) | (vxl_uint_64(bj) << 21) | vxl_uint_64(bk);
+}
+
+template <class T>
+long
+vbl_brick_sparse_array_3d<T>::find_brick(unsigned i, unsigned j, unsigned k) const
+{
+  if (!in_range(i, j, k))
+    return -1L;
+  typename std::unordered_map<vxl_uint_64, unsigned>::const_iterator p = index_.find(key(i >> 3, j >> 3, k >> 3));
+  return p == index_.end() ? -1L : long(p->second);
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::brick &
+vbl_brick_sparse_array_3d<T>::get_brick(unsigned i, unsigned j, unsigned k)
+{
+  const unsigned bi = i >> 3, bj = j >> 3, bk = k >> 3;
+  if (last_ >= 0)
+  {
+    brick & b = bricks_[last_];
+    if (b.bi == bi && b.bj == bj && b.bk == bk)
+      return b;
+  }
+  if (!in_range(i, j, k))
+  {
+    std::ostringstream msg;
+    msg << "vbl_brick_sparse_array_3d: location (" << i << ',' << j << ',' << k << ") is beyond the largest coordinate "
+        << unsigned(max_coordinate);
+    throw std::out_of_range(msg.str());
+  }
+  std::pair<typename std::unordered_map<vxl_uint_64, unsigned>::iterator, bool> res =
+    index_.insert(std::make_pair(key(bi, bj, bk), unsigned(bricks_.size())));
+  if (res.second)
+    bricks_.emplace_back(bi, bj, bk);
+  last_ = long(res.first->second);
+  return bricks_[last_];
+}
+
+template <class T>
+T &
+vbl_brick_sparse_array_3d<T>::fill_cell(brick & b, unsigned o)
+{
+  if (!b.filled(o))
+  {
+    b.mask[o >> 6] |= vxl_uint_64(1) << (o & 63);
+    ++b.count;
+    ++count_;
+  }
+  return b.data[o];
+}
+
+template <class T>
+bool
+vbl_brick_sparse_array_3d<T>::put(unsigned i, unsigned j, unsigned k, const T & t)
+{
+  if (!in_range(i, j, k))
+    return false;
+  brick & b = get_brick(i, j, k);
+  const unsigned o = offset(i, j, k);
+  if (b.filled(o))
+    return false;
+  fill_cell(b, o) = t;
+  return true;
+}
+
+template <class T>
+T &
+vbl_brick_sparse_array_3d<T>::operator()(unsigned i, unsigned j, unsigned k)
+{
+  return fill_cell(get_brick(i, j, k), offset(i, j, k));
+}
+
+template <class T>
+const T &
+vbl_brick_sparse_array_3d<T>::operator()(unsigned i, unsigned j, unsigned k) const
+{
+  const long b = find_brick(i, j, k);
+  assert(b >= 0 && bricks_[b].filled(offset(i, j, k)));
+  return bricks_[b].data[offset(i, j, k)];
+}
+
+template <class T>
+bool
+vbl_brick_sparse_array_3d<T>::fullp(unsigned i, unsigned j, unsigned k) const
+{
+  const long b = find_brick(i, j, k);
+  return b >= 0 && bricks_[b].filled(offset(i, j, k));
+}
+
+template <class T>
+T *
+vbl_brick_sparse_array_3d<T>::get_addr(unsigned i, unsigned j, unsigned k)
+{
+  const long b = find_brick(i, j, k);
+  if (b < 0 || !bricks_[b].filled(offset(i, j, k)))
+    return nullptr;
+  last_ = b;
+  return &bricks_[b].data[offset(i, j, k)];
+}
+
+template <class T>
+void
+vbl_brick_sparse_array_3d<T>::erase(unsigned i, unsigned j, unsigned k)
+{
+  const long b = find_brick(i, j, k);
+  const unsigned o = offset(i, j, k);
+  assert(b >= 0 && bricks_[b].filled(o));
+
+  brick & br = bricks_[b];
+  br.mask[o >> 6] &= ~(vxl_uint_64(1) << (o & 63));
+  br.data[o] = T();
+  --br.count;
+  --count_;
+  if (br.count > 0)
+    return;
+
+  // Release the empty brick by moving the last brick into its slot. The
+  // cells of the moved brick keep their addresses, since only the owning
+  // pointer moves.
+  index_.erase(key(br.bi, br.bj, br.bk));
+  const unsigned last = unsigned(bricks_.size()) - 1;
+  if (unsigned(b) != last)
+  {
+    bricks_[b] = std::move(bricks_[last]);
+    index_[key(bricks_[b].bi, bricks_[b].bj, bricks_[b].bk)] = unsigned(b);
+  }
+  bricks_.pop_back();
+  last_ = -1;
+}
+
+template <class T>
+void
+vbl_brick_sparse_array_3d<T>::clear()
+{
+  bricks_.clear();
+  index_.clear();
+  count_ = 0;
+  last_ = -1;
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::const_iterator
+vbl_brick_sparse_array_3d<T>::begin() const
+{
+  const_iterator it(&bricks_, 0, 0);
+  it.settle();
+  return it;
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::const_iterator
+vbl_brick_sparse_array_3d<T>::end() const
+{
+  return const_iterator(&bricks_, bricks_.size(), 0);
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::Index_type
+vbl_brick_sparse_array_3d<T>::const_iterator::index() const
+{
+  const brick & b = (*bricks_)[b_];
+  return Index_type(b.bi * brick_side + (o_ >> 6), b.bj * brick_side + ((o_ >> 3) & 7), b.bk * brick_side + (o_ & 7));
+}
+
+template <class T>
+void
+vbl_brick_sparse_array_3d<T>::const_iterator::settle()
+{
+  while (b_ < bricks_->size())
+  {
+    const brick & b = (*bricks_)[b_];
+    while (o_ < brick_volume)
+    {
+      // Bits of the current 64 cell word at or after o_.
+      vxl_uint_64 w = b.mask[o_ >> 6] >> (o_ & 63);
+      if (w == 0)
+      {
+        o_ = (o_ | 63) + 1;
+        continue;
+      }
+      while ((w & 1) == 0)
+      {
+        w >>= 1;
+        ++o_;
+      }
+      return;
+    }
+    ++b_;
+    o_ = 0;
+  }
+  o_ = 0; // the end() iterator
+}
+
+template <class T>
+typename vbl_brick_sparse_array_3d<T>::const_iterator &
+vbl_brick_sparse_array_3d<T>::const_iterator::operator++()
+{
+  ++o_;
+  settle();
+  return *this;
+}
+
+template <class T>
+std::ostream &
+vbl_brick_sparse_array_3d<T>::print(std::ostream & out) const
+{
+  for (const_iterator p = begin(); p != end(); ++p)
+  {
+    const Index_type idx = p.index();
+    out << '(' << idx.first << ',' << idx.second << ',' << idx.third << "): " << p.value() << '\n';
+  }
+  return out;
+}
+
+#undef VBL_BRICK_SPARSE_ARRAY_3D_INSTANTIATE
+#define VBL_BRICK_SPARSE_ARRAY_3D_INSTANTIATE(T) template class vbl_brick_sparse_array_3d<T>
+
+#endif // vbl_brick_sparse_array_3d_hxx_
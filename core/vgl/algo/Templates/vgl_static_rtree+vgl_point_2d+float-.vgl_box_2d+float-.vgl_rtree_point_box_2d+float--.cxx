@@ -0,0 +1,10 @@
+#include <vgl/algo/vgl_static_rtree.hxx>
+#include "vgl/vgl_point_2d.h"
+#include "vgl/vgl_box_2d.h"
+#include <vgl/algo/vgl_rtree_c.h>
+
+using v = vgl_point_2d<float>;
+using b = vgl_box_2d<float>;
+using c = vgl_rtree_point_box_2d<float>;
+
+VGL_STATIC_RTREE_INSTANTIATE(v, b, c);
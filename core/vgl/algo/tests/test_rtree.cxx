@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -7,6 +8,8 @@
 #include "vgl/vgl_polygon.h"
 #include <vgl/algo/vgl_rtree.h>
 #include <vgl/algo/vgl_rtree_c.h>
+#include <vgl/algo/vgl_static_rtree.h>
+#include <vpl/vpl_thread_pool.h>
 #include "vnl/vnl_random.h"
 #include "testlib/testlib_test.h"
 
@@ -181,11 +184,107 @@ test_box_box()
   TEST("number found by poly box probe", n, 3);
 }
 
+static void
+test_static_rtree()
+{
+  std::cout << "\n<<<<<<<   test static rtree >>>>>>>>>>>>>>\n";
+  using PC_ = vgl_rtree_point_box_2d<float>;
+  using BC_ = vgl_rtree_box_box_2d<float>;
+
+  vnl_random r(1234);
+  std::vector<vgl_point_2d<float>> pts;
+  std::vector<vgl_box_2d<float>> boxes;
+  for (unsigned i = 0; i < 5000; ++i)
+  {
+    const float x = static_cast<float>(r.drand32(0.0, 100.0));
+    const float y = static_cast<float>(r.drand32(0.0, 100.0));
+    pts.emplace_back(x, y);
+    boxes.emplace_back(x, x + static_cast<float>(r.drand32(0.0, 2.0)), y, y + static_cast<float>(r.drand32(0.0, 2.0)));
+  }
+
+  const vgl_static_rtree<PC_::v_type, PC_::b_type, PC_> ptree(pts);
+  const vgl_static_rtree<BC_::v_type, BC_::b_type, BC_> btree(boxes, 8);
+  TEST("point tree size", ptree.size(), pts.size());
+  TEST("box tree size", btree.size(), boxes.size());
+  std::cout << "Static point tree: " << ptree.nodes() << " nodes, depth " << ptree.depth() << '\n';
+  TEST("point tree nodes nearly full", ptree.nodes() <= 5000 / 15 + ptree.depth(), true);
+  TEST("point tree bounds", ptree.bounds().contains(pts[17]), true);
+
+  // Compare region queries against a brute force search.
+  std::vector<PC_::b_type> pregions;
+  std::vector<BC_::b_type> bregions;
+  bool points_ok = true, boxes_ok = true;
+  for (unsigned q = 0; q < 200; ++q)
+  {
+    const float x = static_cast<float>(r.drand32(-10.0, 100.0));
+    const float y = static_cast<float>(r.drand32(-10.0, 100.0));
+    const float s = static_cast<float>(r.drand32(0.0, 20.0));
+    pregions.emplace_back(x, x + s, y, y + s);
+    bregions.emplace_back(x, x + s, y, y + s);
+
+    std::vector<vgl_point_2d<float>> pfound, pexpected;
+    ptree.get(pregions.back(), pfound);
+    for (const auto & p : pts)
+      if (PC_::meet(pregions.back(), p))
+        pexpected.push_back(p);
+    points_ok = points_ok && pfound.size() == pexpected.size() &&
+                std::is_permutation(pfound.begin(), pfound.end(), pexpected.begin());
+
+    std::vector<vgl_box_2d<float>> bfound, bexpected;
+    btree.get(bregions.back(), bfound);
+    for (const auto & b : boxes)
+      if (BC_::meet(bregions.back(), b))
+        bexpected.push_back(b);
+    boxes_ok = boxes_ok && bfound.size() == bexpected.size() &&
+               std::is_permutation(bfound.begin(), bfound.end(), bexpected.begin());
+  }
+  TEST("static point tree agrees with brute force", points_ok, true);
+  TEST("static box tree agrees with brute force", boxes_ok, true);
+
+  // Batched queries on several threads give the same answers.
+  std::vector<std::vector<vgl_point_2d<float>>> batch;
+  vpl_set_concurrency(4);
+  ptree.get(pregions, batch);
+  vpl_set_concurrency(0);
+  bool batch_ok = batch.size() == pregions.size();
+  for (unsigned q = 0; batch_ok && q < pregions.size(); ++q)
+  {
+    std::vector<vgl_point_2d<float>> single;
+    ptree.get(pregions[q], single);
+    batch_ok = single == batch[q];
+  }
+  TEST("batched queries", batch_ok, true);
+
+  // Polygon probe, and construction from a dynamic tree.
+  vgl_rtree<PC_::v_type, PC_::b_type, PC_> dtree;
+  for (unsigned i = 0; i < 1000; ++i)
+    dtree.add(pts[i]);
+  const vgl_static_rtree<PC_::v_type, PC_::b_type, PC_> stree(dtree);
+  TEST("static tree from dynamic tree", stree.size(), dtree.size());
+  vgl_polygon<float> poly(1);
+  poly.push_back(10.0f, 50.0f);
+  poly.push_back(50.0f, 10.0f);
+  poly.push_back(90.0f, 50.0f);
+  poly.push_back(50.0f, 90.0f);
+  const vgl_rtree_polygon_probe<PC_::v_type, PC_::b_type, PC_> probe(poly);
+  std::vector<vgl_point_2d<float>> sfound, dfound;
+  stree.get(probe, sfound);
+  dtree.get(probe, dfound);
+  TEST("polygon probe agrees with dynamic tree",
+       sfound.size() == dfound.size() && std::is_permutation(sfound.begin(), sfound.end(), dfound.begin()), true);
+
+  const vgl_static_rtree<PC_::v_type, PC_::b_type, PC_> etree;
+  std::vector<vgl_point_2d<float>> none;
+  etree.get(pregions[0], none);
+  TEST("empty static tree", etree.empty() && none.empty(), true);
+}
+
 static void
 test_rtree()
 {
   test_point_box();
   test_box_box();
+  test_static_rtree();
 }
 
 TESTMAIN(test_rtree);
@@ -0,0 +1,169 @@
+// This is core/vgl/algo/vgl_static_rtree.h
+#ifndef vgl_static_rtree_h_
+#define vgl_static_rtree_h_
+//:
+// \file
+// \brief Read-only, bulk-loaded 2-d rtree with a packed array layout
+//
+// vgl_static_rtree is the read-only counterpart of vgl_rtree. It is built in
+// one go from all its elements using Sort-Tile-Recursive (STR) packing,
+// which gives nearly full nodes with little overlap, and it stores the tree
+// in flat arrays rather than heap-allocated nodes:
+// - the nodes are stored level by level, and the children of a node are
+//   contiguous, so a node is just the index range of its children;
+// - the bounds of all nodes (and of all elements) are kept as separate
+//   min_x, min_y, max_x, max_y arrays, so that all the children of a node
+//   are tested against a query box in one tight loop which the compiler can
+//   vectorise.
+//
+// The template arguments are the same as for vgl_rtree, and the same C
+// classes (e.g. vgl_rtree_point_box_2d, vgl_rtree_box_box_2d) can be used.
+// In addition, B must be an axis aligned 2-d box, i.e. provide min_x(),
+// min_y(), max_x(), max_y() and a B(xmin, xmax, ymin, ymax) constructor, and
+// C must define t_type, the coordinate type of B.
+//
+// Elements are only ever reported if C::meet(region, v) is true, so the
+// results of get() agree with a brute force search using C::meet.
+
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vgl_rtree.h"
+
+//: Read-only rtree, built by Sort-Tile-Recursive bulk loading.
+template <class V, class B, class C>
+class vgl_static_rtree
+{
+public:
+  typedef typename C::t_type T;
+  typedef vgl_rtree_probe<V, B, C> probe;
+
+  //: Default number of children (or elements) per node.
+  enum
+  {
+    default_node_capacity = 16
+  };
+
+  //: Empty tree.
+  vgl_static_rtree() = default;
+
+  //: Bulk load the given elements.
+  explicit vgl_static_rtree(const std::vector<V> & vs, unsigned node_capacity = default_node_capacity)
+  {
+    build(vs, node_capacity);
+  }
+
+  //: Bulk load the elements currently stored in a dynamic rtree.
+  explicit vgl_static_rtree(const vgl_rtree<V, B, C> & tree, unsigned node_capacity = default_node_capacity);
+
+  //: Replace the contents of the tree by the given elements.
+  void
+  build(const std::vector<V> & vs, unsigned node_capacity = default_node_capacity);
+
+  //: get elements in the given region.
+  void
+  get(const B & region, std::vector<V> & vs) const;
+
+  //: get elements which meet the given probe.
+  void
+  get(const probe & region, std::vector<V> & vs) const;
+
+  //: Run get(regions[i], results[i]) for every region, in parallel on the vpl thread pool.
+  void
+  get(const std::vector<B> & regions, std::vector<std::vector<V>> & results) const;
+
+  //: get all elements in the tree (in leaf order).
+  void
+  get_all(std::vector<V> & vs) const
+  {
+    vs.insert(vs.end(), elements_.begin(), elements_.end());
+  }
+
+  //: return true iff the tree has no elements.
+  bool
+  empty() const
+  {
+    return elements_.empty();
+  }
+
+  //: return number of elements stored in the tree.
+  unsigned
+  size() const
+  {
+    return static_cast<unsigned>(elements_.size());
+  }
+
+  //: return number of nodes used by the tree.
+  unsigned
+  nodes() const
+  {
+    return static_cast<unsigned>(first_.size());
+  }
+
+  //: number of levels in the tree (0 if empty).
+  unsigned
+  depth() const
+  {
+    return depth_;
+  }
+
+  //: Bounds of all the elements in the tree.
+  B
+  bounds() const;
+
+private:
+  // Packed bounds of nodes or elements, one array per coordinate.
+  struct boxes
+  {
+    std::vector<T> min_x, min_y, max_x, max_y;
+    void
+    resize(std::size_t n)
+    {
+      min_x.resize(n);
+      min_y.resize(n);
+      max_x.resize(n);
+      max_y.resize(n);
+    }
+    void
+    set(std::size_t i, const B & b)
+    {
+      min_x[i] = b.min_x();
+      min_y[i] = b.min_y();
+      max_x[i] = b.max_x();
+      max_y[i] = b.max_y();
+    }
+    B
+    get(std::size_t i) const
+    {
+      return B(min_x[i], max_x[i], min_y[i], max_y[i]);
+    }
+  };
+
+  //: Sort-Tile-Recursive ordering of the entries idx, given their box centres.
+  static void
+  str_order(std::vector<unsigned> & idx, const std::vector<double> & cx, const std::vector<double> & cy, unsigned cap);
+
+  //: Mark in hit[0..n) which of the boxes [first, first+n) overlap the query.
+  static void
+  overlap(const boxes & bx, unsigned first, unsigned n, T qx0, T qy0, T qx1, T qy1, unsigned char * hit);
+
+  //: elements, in leaf order.
+  std::vector<V> elements_;
+  //: bounds of the elements.
+  boxes element_bounds_;
+
+  // Nodes are stored root first, then level by level down to the leaves.
+  // The children (elements for leaves) of node i are [first_[i], first_[i]+count_[i]).
+  std::vector<unsigned> first_;
+  std::vector<unsigned> count_;
+  boxes node_bounds_;
+  //: index of the first leaf node; nodes >= this are leaves.
+  unsigned first_leaf_{ 0 };
+  unsigned node_capacity_{ default_node_capacity };
+  unsigned depth_{ 0 };
+};
+
+#define VGL_STATIC_RTREE_INSTANTIATE(V, B, C) extern "you must include vgl_static_rtree.hxx first"
+
+#endif // vgl_static_rtree_h_
@@ -0,0 +1,269 @@
+// This is core/vgl/algo/vgl_static_rtree.hxx
+#ifndef vgl_static_rtree_hxx_
+#define vgl_static_rtree_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include "vgl_static_rtree.h"
+#include <vpl/vpl_thread_pool.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Sort-Tile-Recursive ordering of idx by the box centres cx, cy.
+// On exit, each consecutive run of cap indices forms a compact group.
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::str_order(std::vector<unsigned> & idx,
+                                     const std::vector<double> & cx,
+                                     const std::vector<double> & cy,
+                                     unsigned cap)
+{
+  const std::size_t n = idx.size();
+  const std::size_t n_groups = (n + cap - 1) / cap;
+  const std::size_t n_slices = static_cast<std::size_t>(std::ceil(std::sqrt(double(n_groups))));
+  const std::size_t slice_size = ((n_groups + n_slices - 1) / n_slices) * cap;
+
+  std::sort(idx.begin(), idx.end(), [&cx](unsigned a, unsigned b) { return cx[a] < cx[b]; });
+  for (std::size_t s = 0; s < n; s += slice_size)
+  {
+    const std::size_t e = std::min(n, s + slice_size);
+    std::sort(idx.begin() + s, idx.begin() + e, [&cy](unsigned a, unsigned b) { return cy[a] < cy[b]; });
+  }
+}
+
+template <class V, class B, class C>
+vgl_static_rtree<V, B, C>::vgl_static_rtree(const vgl_rtree<V, B, C> & tree, unsigned node_capacity)
+{
+  std::vector<V> vs;
+  tree.get_all(vs);
+  build(vs, node_capacity);
+}
+
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::build(const std::vector<V> & vs, unsigned node_capacity)
+{
+  node_capacity_ = std::max(2u, node_capacity);
+  const unsigned cap = node_capacity_;
+  elements_.clear();
+  first_.clear();
+  count_.clear();
+  node_bounds_.resize(0);
+  element_bounds_.resize(0);
+  first_leaf_ = 0;
+  depth_ = 0;
+  if (vs.empty())
+    return;
+
+  // Order the elements so that each run of cap elements makes a leaf.
+  const std::size_t n = vs.size();
+  std::vector<B> entry_bounds(n);
+  std::vector<double> cx(n), cy(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    C::init(entry_bounds[i], vs[i]);
+    cx[i] = double(entry_bounds[i].min_x()) + double(entry_bounds[i].max_x());
+    cy[i] = double(entry_bounds[i].min_y()) + double(entry_bounds[i].max_y());
+  }
+  std::vector<unsigned> order(n);
+  std::iota(order.begin(), order.end(), 0u);
+  str_order(order, cx, cy, cap);
+
+  elements_.resize(n);
+  element_bounds_.resize(n);
+  std::vector<B> sorted_bounds(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    elements_[i] = vs[order[i]];
+    element_bounds_.set(i, entry_bounds[order[i]]);
+    sorted_bounds[i] = entry_bounds[order[i]];
+  }
+
+  // Build the levels bottom up. Each level is a list of nodes referring to a
+  // contiguous range of the (already ordered) level below.
+  struct level
+  {
+    std::vector<unsigned> first, count;
+    std::vector<B> bounds;
+  };
+  std::vector<level> levels;
+  std::vector<B> below = sorted_bounds;
+  while (true)
+  {
+    level lv;
+    const std::size_t m = below.size();
+    for (std::size_t f = 0; f < m; f += cap)
+    {
+      const unsigned cnt = static_cast<unsigned>(std::min<std::size_t>(cap, m - f));
+      B b = below[f];
+      for (unsigned k = 1; k < cnt; ++k)
+        C::update(b, below[f + k]);
+      lv.first.push_back(static_cast<unsigned>(f));
+      lv.count.push_back(cnt);
+      lv.bounds.push_back(b);
+    }
+    const std::size_t g = lv.first.size();
+    if (g > 1)
+    {
+      // Order the nodes of this level so that the next level up packs well.
+      std::vector<double> ncx(g), ncy(g);
+      for (std::size_t i = 0; i < g; ++i)
+      {
+        ncx[i] = double(lv.bounds[i].min_x()) + double(lv.bounds[i].max_x());
+        ncy[i] = double(lv.bounds[i].min_y()) + double(lv.bounds[i].max_y());
+      }
+      std::vector<unsigned> nord(g);
+      std::iota(nord.begin(), nord.end(), 0u);
+      str_order(nord, ncx, ncy, cap);
+      level sorted;
+      for (unsigned i : nord)
+      {
+        sorted.first.push_back(lv.first[i]);
+        sorted.count.push_back(lv.count[i]);
+        sorted.bounds.push_back(lv.bounds[i]);
+      }
+      lv = sorted;
+    }
+    below = lv.bounds;
+    levels.push_back(lv);
+    if (g == 1)
+      break;
+  }
+
+  // Lay the levels out root first, and turn child indices into node indices.
+  depth_ = static_cast<unsigned>(levels.size());
+  std::vector<unsigned> offset(depth_);
+  unsigned total = 0;
+  for (unsigned k = depth_; k-- > 0;)
+  {
+    offset[k] = total;
+    total += static_cast<unsigned>(levels[k].first.size());
+  }
+  first_.resize(total);
+  count_.resize(total);
+  node_bounds_.resize(total);
+  for (unsigned k = 0; k < depth_; ++k)
+  {
+    const level & lv = levels[k];
+    const unsigned child_offset = k == 0 ? 0 : offset[k - 1];
+    for (std::size_t i = 0; i < lv.first.size(); ++i)
+    {
+      first_[offset[k] + i] = lv.first[i] + child_offset;
+      count_[offset[k] + i] = lv.count[i];
+      node_bounds_.set(offset[k] + i, lv.bounds[i]);
+    }
+  }
+  first_leaf_ = offset[0];
+}
+
+template <class V, class B, class C>
+B
+vgl_static_rtree<V, B, C>::bounds() const
+{
+  return empty() ? B() : node_bounds_.get(0);
+}
+
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::overlap(const boxes & bx,
+                                   unsigned first,
+                                   unsigned n,
+                                   T qx0,
+                                   T qy0,
+                                   T qx1,
+                                   T qy1,
+                                   unsigned char * hit)
+{
+  const T * x0 = &bx.min_x[first];
+  const T * y0 = &bx.min_y[first];
+  const T * x1 = &bx.max_x[first];
+  const T * y1 = &bx.max_y[first];
+  // Branch free, so that the loop is vectorised.
+  for (unsigned k = 0; k < n; ++k)
+    hit[k] = (x0[k] <= qx1) & (x1[k] >= qx0) & (y0[k] <= qy1) & (y1[k] >= qy0);
+}
+
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::get(const B & region, std::vector<V> & vs) const
+{
+  if (empty())
+    return;
+  const T qx0 = region.min_x(), qy0 = region.min_y(), qx1 = region.max_x(), qy1 = region.max_y();
+  unsigned char root_hit;
+  overlap(node_bounds_, 0, 1, qx0, qy0, qx1, qy1, &root_hit);
+  if (!root_hit)
+    return;
+
+  std::vector<unsigned char> hit(node_capacity_);
+  std::vector<unsigned> stack(1, 0u);
+  stack.reserve(depth_ * node_capacity_);
+  while (!stack.empty())
+  {
+    const unsigned i = stack.back();
+    stack.pop_back();
+    const unsigned f = first_[i], cnt = count_[i];
+    if (i >= first_leaf_)
+    {
+      overlap(element_bounds_, f, cnt, qx0, qy0, qx1, qy1, &hit[0]);
+      for (unsigned k = 0; k < cnt; ++k)
+        if (hit[k] && C::meet(region, elements_[f + k]))
+          vs.push_back(elements_[f + k]);
+    }
+    else
+    {
+      overlap(node_bounds_, f, cnt, qx0, qy0, qx1, qy1, &hit[0]);
+      // Push in reverse so that the children are visited in order.
+      for (unsigned k = cnt; k-- > 0;)
+        if (hit[k])
+          stack.push_back(f + k);
+    }
+  }
+}
+
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::get(const probe & region, std::vector<V> & vs) const
+{
+  if (empty() || !region.meets(node_bounds_.get(0)))
+    return;
+  std::vector<unsigned> stack(1, 0u);
+  while (!stack.empty())
+  {
+    const unsigned i = stack.back();
+    stack.pop_back();
+    const unsigned f = first_[i], cnt = count_[i];
+    if (i >= first_leaf_)
+    {
+      for (unsigned k = 0; k < cnt; ++k)
+        if (region.meets(elements_[f + k]))
+          vs.push_back(elements_[f + k]);
+    }
+    else
+    {
+      for (unsigned k = cnt; k-- > 0;)
+        if (region.meets(node_bounds_.get(f + k)))
+          stack.push_back(f + k);
+    }
+  }
+}
+
+template <class V, class B, class C>
+void
+vgl_static_rtree<V, B, C>::get(const std::vector<B> & regions, std::vector<std::vector<V>> & results) const
+{
+  results.assign(regions.size(), std::vector<V>());
+  // Hand out the queries in small batches, which keeps the threads busy
+  // even if some queries return many more elements than others.
+  vpl_parallel_for(
+    std::size_t(0), regions.size(), [&](std::size_t i) { get(regions[i], results[i]); }, std::size_t(64));
+}
+
+#undef VGL_STATIC_RTREE_INSTANTIATE
+#define VGL_STATIC_RTREE_INSTANTIATE(V, B, C) template class vgl_static_rtree<V, B, C>
+
+#endif // vgl_static_rtree_hxx_
@@ -0,0 +1,89 @@
+// This is core/vgl/examples/vgl_rtree_benchmark.cxx
+// Compare build and query times of the dynamic vgl_rtree with the
+// bulk-loaded vgl_static_rtree, for a set of random boxes.
+//
+// Usage: vgl_rtree_benchmark [n_boxes [n_queries [n_threads]]]
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vgl/vgl_box_2d.h"
+#include <vgl/algo/vgl_rtree.h>
+#include <vgl/algo/vgl_rtree_c.h>
+#include <vgl/algo/vgl_static_rtree.h>
+#include "vnl/vnl_random.h"
+#include "vul/vul_timer.h"
+#include <vpl/vpl_thread_pool.h>
+
+int
+main(int argc, char ** argv)
+{
+  const unsigned n_boxes = argc > 1 ? std::atoi(argv[1]) : 200000;
+  const unsigned n_queries = argc > 2 ? std::atoi(argv[2]) : 20000;
+  if (argc > 3)
+    vpl_set_concurrency(std::atoi(argv[3]));
+
+  using C = vgl_rtree_box_box_2d<float>;
+  vnl_random r(42);
+  std::vector<C::v_type> boxes;
+  for (unsigned i = 0; i < n_boxes; ++i)
+  {
+    const float x = static_cast<float>(r.drand32(0.0, 10000.0));
+    const float y = static_cast<float>(r.drand32(0.0, 10000.0));
+    boxes.emplace_back(x, x + static_cast<float>(r.drand32(1.0, 30.0)), y, y + static_cast<float>(r.drand32(1.0, 30.0)));
+  }
+  std::vector<C::b_type> queries;
+  for (unsigned i = 0; i < n_queries; ++i)
+  {
+    const float x = static_cast<float>(r.drand32(0.0, 10000.0));
+    const float y = static_cast<float>(r.drand32(0.0, 10000.0));
+    queries.emplace_back(x, x + 100.0f, y, y + 100.0f);
+  }
+
+  vul_timer t;
+  vgl_rtree<C::v_type, C::b_type, C> dynamic_tree;
+  for (const auto & b : boxes)
+    dynamic_tree.add(b);
+  const long dynamic_build = t.real();
+
+  t.mark();
+  const vgl_static_rtree<C::v_type, C::b_type, C> static_tree(boxes);
+  const long static_build = t.real();
+
+  std::size_t dynamic_hits = 0, static_hits = 0, batch_hits = 0;
+  t.mark();
+  for (const auto & q : queries)
+  {
+    std::vector<C::v_type> found;
+    dynamic_tree.get(q, found);
+    dynamic_hits += found.size();
+  }
+  const long dynamic_query = t.real();
+
+  t.mark();
+  for (const auto & q : queries)
+  {
+    std::vector<C::v_type> found;
+    static_tree.get(q, found);
+    static_hits += found.size();
+  }
+  const long static_query = t.real();
+
+  t.mark();
+  std::vector<std::vector<C::v_type>> found;
+  static_tree.get(queries, found);
+  const long batch_query = t.real();
+  for (const auto & f : found)
+    batch_hits += f.size();
+
+  std::cout << n_boxes << " boxes, " << n_queries << " queries (times in ms)\n"
+            << "dynamic vgl_rtree:  build " << dynamic_build << ", query " << dynamic_query << ", " << dynamic_tree.nodes()
+            << " nodes, " << dynamic_hits << " hits\n"
+            << "vgl_static_rtree:   build " << static_build << ", query " << static_query << ", " << static_tree.nodes()
+            << " nodes, " << static_hits << " hits\n"
+            << "batched, " << vpl_concurrency() << " threads: query " << batch_query << ", "
+            << batch_hits << " hits\n";
+  return 0;
+}
@@ -0,0 +1,237 @@
+// This is core/vidl/tests/test_convert_rows.cxx
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil/vil_image_view.h"
+#include "vil/vil_crop.h"
+#include "vil/vil_transpose.h"
+#include <vidl/vidl_convert_rows.h>
+#include <vidl/vidl_convert.h>
+#include <vidl/vidl_color.h>
+#include <vidl/vidl_frame.h>
+#include <vidl/vidl_pixel_iterator.h>
+
+namespace
+{
+//: Pseudo-random bytes, so that the tests are repeatable.
+std::vector<vxl_byte>
+random_bytes(unsigned n, unsigned seed)
+{
+  std::vector<vxl_byte> data(n);
+  for (auto & d : data)
+  {
+    seed = seed * 1103515245u + 12345u;
+    d = static_cast<vxl_byte>(seed >> 16);
+  }
+  return data;
+}
+
+//: Convert a frame pixel by pixel with the pixel iterators, as vidl_convert_frame does by default.
+bool
+convert_by_pixel(const vidl_frame & in_frame, vidl_frame & out_frame)
+{
+  std::unique_ptr<vidl_pixel_iterator> in_itr(vidl_make_pixel_iterator(in_frame));
+  std::unique_ptr<vidl_pixel_iterator> out_itr(vidl_make_pixel_iterator(out_frame));
+  vidl_pixel_traits in_t = vidl_pixel_format_traits(in_frame.pixel_format());
+  vidl_pixel_traits out_t = vidl_pixel_format_traits(out_frame.pixel_format());
+  vidl_color_conv_fptr color_conv = vidl_color_converter_func(in_t.color, *in_t.type, out_t.color, *out_t.type);
+  if (!in_itr || !out_itr || !color_conv)
+    return false;
+  vxl_byte in_pixel[32], out_pixel[32];
+  for (unsigned c = 0; c < in_frame.ni() * in_frame.nj(); ++c, ++*in_itr, ++*out_itr)
+  {
+    in_itr->get_data(in_pixel);
+    color_conv(in_pixel, out_pixel);
+    out_itr->set_data(out_pixel);
+  }
+  return true;
+}
+
+//: Compare vidl_convert_frame with the pixel by pixel conversion.
+bool
+same_as_by_pixel(vidl_pixel_format in_fmt, vidl_pixel_format out_fmt, unsigned ni, unsigned nj)
+{
+  std::vector<vxl_byte> in = random_bytes(vidl_pixel_format_buffer_size(ni, nj, in_fmt), ni * nj + in_fmt);
+  const unsigned out_size = vidl_pixel_format_buffer_size(ni, nj, out_fmt);
+  std::vector<vxl_byte> fast(out_size, 0), slow(out_size, 0);
+  vidl_shared_frame in_frame(in.data(), ni, nj, in_fmt);
+  vidl_shared_frame fast_frame(fast.data(), ni, nj, out_fmt), slow_frame(slow.data(), ni, nj, out_fmt);
+  return vidl_convert_frame(in_frame, fast_frame) && convert_by_pixel(in_frame, slow_frame) && fast == slow;
+}
+} // namespace
+
+
+static void
+test_row_kernels()
+{
+  std::cout << "Testing the row kernels against vidl_color\n";
+  const unsigned lengths[] = { 1, 2, 7, 8, 9, 16, 17, 31, 64, 77 };
+  bool yuv422_rgb = true, yuv422_mono = true, yuvp_rgb = true, rgb_yuv422 = true, rgb_mono = true, swap = true,
+       mono16 = true;
+  for (unsigned n : lengths)
+  {
+    const std::vector<vxl_byte> src = random_bytes(3 * n + 2, n);
+    std::vector<vxl_byte> out(3 * n), out2(3 * n);
+    vxl_byte r, g, b, y, u, v;
+
+    vidl_convert_row_uyvy_to_rgb(src.data(), out.data(), n);
+    vidl_convert_row_yuyv_to_rgb(src.data(), out2.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      const vxl_byte * m = &src[4 * (i / 2)];
+      const bool has_v = 2 * (i / 2) + 1 < n;
+      vidl_color_convert_yuv2rgb(m[1 + 2 * (i % 2)], m[0], has_v ? m[2] : 128, r, g, b);
+      yuv422_rgb = yuv422_rgb && out[3 * i] == r && out[3 * i + 1] == g && out[3 * i + 2] == b;
+      vidl_color_convert_yuv2rgb(m[2 * (i % 2)], m[1], has_v ? m[3] : 128, r, g, b);
+      yuv422_rgb = yuv422_rgb && out2[3 * i] == r && out2[3 * i + 1] == g && out2[3 * i + 2] == b;
+    }
+
+    vidl_convert_row_uyvy_to_mono(src.data(), out.data(), n);
+    vidl_convert_row_yuyv_to_mono(src.data(), out2.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+      yuv422_mono = yuv422_mono && out[i] == src[2 * i + 1] && out2[i] == src[2 * i];
+
+    const vxl_byte * uc = src.data() + n;
+    const vxl_byte * vc = uc + (n + 1) / 2;
+    vidl_convert_row_yuvp_to_rgb(src.data(), uc, vc, out.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      vidl_color_convert_yuv2rgb(src[i], uc[i / 2], vc[i / 2], r, g, b);
+      yuvp_rgb = yuvp_rgb && out[3 * i] == r && out[3 * i + 1] == g && out[3 * i + 2] == b;
+    }
+
+    vidl_convert_row_rgb_to_uyvy(src.data(), out.data(), n);
+    vidl_convert_row_rgb_to_yuyv(src.data(), out2.data(), n);
+    for (unsigned i = 0; i < n; i += 2)
+    {
+      vxl_byte y2 = 0, u2, v2;
+      vidl_color_convert_rgb2yuv(src[3 * i], src[3 * i + 1], src[3 * i + 2], y, u, v);
+      if (i + 1 < n)
+      {
+        vidl_color_convert_rgb2yuv(src[3 * i + 3], src[3 * i + 4], src[3 * i + 5], y2, u2, v2);
+        u = (u + u2) / 2;
+        v = (v + v2) / 2;
+        rgb_yuv422 = rgb_yuv422 && out[2 * i + 2] == v && out[2 * i + 3] == y2 && out2[2 * i + 2] == y2 &&
+                     out2[2 * i + 3] == v;
+      }
+      rgb_yuv422 = rgb_yuv422 && out[2 * i] == u && out[2 * i + 1] == y && out2[2 * i] == y && out2[2 * i + 1] == u;
+    }
+
+    vidl_convert_row_rgb_to_mono(src.data(), out.data(), n);
+    vidl_convert_row_bgr_to_mono(src.data(), out2.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      vxl_byte rgb_grey, bgr_grey;
+      const vxl_byte bgr[3] = { src[3 * i + 2], src[3 * i + 1], src[3 * i] };
+      vidl_color_converter<VIDL_PIXEL_COLOR_RGB, VIDL_PIXEL_COLOR_MONO>::convert(&src[3 * i], &rgb_grey);
+      vidl_color_converter<VIDL_PIXEL_COLOR_RGB, VIDL_PIXEL_COLOR_MONO>::convert(bgr, &bgr_grey);
+      rgb_mono = rgb_mono && out[i] == rgb_grey && out2[i] == bgr_grey;
+    }
+
+    vidl_convert_row_swap_rb(src.data(), out.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+      swap = swap && out[3 * i] == src[3 * i + 2] && out[3 * i + 1] == src[3 * i + 1] && out[3 * i + 2] == src[3 * i];
+
+    std::vector<vxl_uint_16> wide(n);
+    for (unsigned i = 0; i < n; ++i)
+      wide[i] = static_cast<vxl_uint_16>(src[2 * i] << 8 | src[2 * i + 1]);
+    vidl_convert_row_mono16_to_mono(wide.data(), out.data(), n);
+    vidl_convert_row_mono_to_mono16(src.data(), wide.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+      mono16 = mono16 && out[i] == src[2 * i] && wide[i] == src[i] << 8;
+  }
+  TEST("UYVY and YUYV to RGB", yuv422_rgb, true);
+  TEST("UYVY and YUYV to MONO", yuv422_mono, true);
+  TEST("Planar YUV to RGB", yuvp_rgb, true);
+  TEST("RGB to UYVY and YUYV", rgb_yuv422, true);
+  TEST("RGB and BGR to MONO", rgb_mono, true);
+  TEST("RGB to BGR", swap, true);
+  TEST("MONO_16 to and from MONO_8", mono16, true);
+
+  // In place
+  std::vector<vxl_byte> rgb = random_bytes(30, 5), bgr(30);
+  vidl_convert_row_swap_rb(rgb.data(), bgr.data(), 10);
+  vidl_convert_row_swap_rb(rgb.data(), rgb.data(), 10);
+  TEST("Swap in place", rgb, bgr);
+}
+
+
+static void
+test_frame_conversions()
+{
+  std::cout << "Testing frame conversions against the pixel iterators\n";
+  const vidl_pixel_format pairs[][2] = {
+    { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24 },  { VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24 },
+    { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24P }, { VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24P },
+    { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8 },  { VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24 },  { VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24P },
+    { VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_MONO_8 },  { VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_RGB_24 },
+    { VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_RGB_24P }, { VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_MONO_8 },    { VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_MONO_8 },   { VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_BGR_24 },
+    { VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_RGB_24 },    { VIDL_PIXEL_FORMAT_MONO_16, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_MONO_8, VIDL_PIXEL_FORMAT_MONO_16 }
+  };
+  for (const auto & p : pairs)
+  {
+    TEST(("Same result for " + vidl_pixel_format_to_string(p[0]) + " to " + vidl_pixel_format_to_string(p[1])).c_str(),
+         same_as_by_pixel(p[0], p[1], 38, 12) && same_as_by_pixel(p[0], p[1], 2, 2),
+         true);
+  }
+  TEST("Odd sized YUV_420P", same_as_by_pixel(VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24, 7, 5), true);
+}
+
+
+static void
+test_strided_views()
+{
+  std::cout << "Testing conversion into strided views\n";
+  const unsigned ni = 22, nj = 10;
+  const vidl_pixel_format formats[] = { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_YUV_420P,
+                                        VIDL_PIXEL_FORMAT_BGR_24 };
+  for (vidl_pixel_format fmt : formats)
+  {
+    std::vector<vxl_byte> data = random_bytes(vidl_pixel_format_buffer_size(ni, nj, fmt), 11);
+    vidl_shared_frame frame(data.data(), ni, nj, fmt);
+    const std::string name = vidl_pixel_format_to_string(fmt);
+
+    // Reference: convert to a contiguous RGB_24 frame
+    vil_image_view<vxl_byte> expected(ni, nj, 1, 3);
+    vidl_memory_chunk_frame rgb_frame(expected, VIDL_PIXEL_FORMAT_RGB_24);
+    vidl_convert_frame(frame, rgb_frame);
+
+    vil_image_view<vxl_byte> big(ni + 6, nj + 4, 3);
+    vil_image_view<vxl_byte> cropped = vil_crop(big, 3, ni, 2, nj);
+    bool ok = vidl_convert_to_view(frame, cropped, VIDL_PIXEL_COLOR_RGB);
+    TEST(("Planar cropped view from " + name).c_str(), ok && vil_image_view_deep_equality(cropped, expected), true);
+
+    vil_image_view<vxl_byte> flipped(nj, ni, 1, 3);
+    vil_image_view<vxl_byte> transposed = vil_transpose(flipped);
+    ok = vidl_convert_to_view(frame, transposed, VIDL_PIXEL_COLOR_RGB);
+    TEST(("Transposed view from " + name).c_str(),
+         ok && transposed.top_left_ptr() == flipped.top_left_ptr() && vil_image_view_deep_equality(transposed, expected),
+         true);
+
+    vil_image_view<vxl_byte> grey_expected(ni, nj), grey_big(ni + 1, nj);
+    vidl_memory_chunk_frame grey_frame(grey_expected, VIDL_PIXEL_FORMAT_MONO_8);
+    vidl_convert_frame(frame, grey_frame);
+    vil_image_view<vxl_byte> grey = vil_crop(grey_big, 1, ni, 0, nj);
+    ok = vidl_convert_to_view(frame, grey, VIDL_PIXEL_COLOR_MONO);
+    TEST(("Cropped grey view from " + name).c_str(), ok && vil_image_view_deep_equality(grey, grey_expected), true);
+  }
+}
+
+
+static void
+test_convert_rows()
+{
+  test_row_kernels();
+  test_frame_conversions();
+  test_strided_views();
+}
+
+TESTMAIN(test_convert_rows);
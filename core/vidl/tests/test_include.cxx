@@ -2,6 +2,7 @@
 #include "vidl/vidl_v4l2_pixel_format.h"
 #include "vidl/vidl_color.h"
 #include "vidl/vidl_convert.h"
+#include "vidl/vidl_convert_rows.h"
 #include "vidl/vidl_exception.h"
 #include "vidl/vidl_frame.h"
 #include "vidl/vidl_frame_sptr.h"
@@ -11,6 +12,8 @@
 #include "vidl/vidl_istream_sptr.h"
 #include "vidl/vidl_istream_image_resource.h"
 #include "vidl/vidl_image_list_istream.h"
+#include "vidl/vidl_frame_pool.h"
+#include "vidl/vidl_pipelined_istream.h"
 #include "vidl/vidl_ostream.h"
 #include "vidl/vidl_ostream_sptr.h"
 #include "vidl/vidl_image_list_ostream.h"
@@ -0,0 +1,260 @@
+// This is core/vidl/tests/test_pipelined_istream.cxx
+#include <iostream>
+#include <string>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include <vidl/vidl_pipelined_istream.h>
+#include <vidl/vidl_image_list_istream.h>
+#include <vidl/vidl_frame_pool.h>
+#include <vidl/vidl_frame.h>
+#include <vidl/vidl_convert.h>
+#include "vil/vil_image_view.h"
+#include "vil/vil_save.h"
+#include "vul/vul_file.h"
+#include "vul/vul_temp_filename.h"
+#include "vpl/vpl.h"
+
+namespace
+{
+//: A stream of generated frames which, like vidl_ffmpeg_istream, overwrites one buffer on each advance.
+// Pixel (i,j) of frame n is (n+i+j)%256.
+class test_shared_istream : public vidl_istream
+{
+public:
+  test_shared_istream(unsigned n, vidl_pixel_format fmt = VIDL_PIXEL_FORMAT_MONO_8)
+    : n_(n)
+    , fmt_(fmt)
+    , buffer_(vidl_pixel_format_buffer_size(8, 6, fmt))
+  {}
+  bool
+  is_open() const override
+  {
+    return true;
+  }
+  bool
+  is_valid() const override
+  {
+    return index_ < n_;
+  }
+  bool
+  is_seekable() const override
+  {
+    return true;
+  }
+  int
+  num_frames() const override
+  {
+    return int(n_);
+  }
+  unsigned int
+  frame_number() const override
+  {
+    return index_;
+  }
+  unsigned int
+  width() const override
+  {
+    return 8;
+  }
+  unsigned int
+  height() const override
+  {
+    return 6;
+  }
+  vidl_pixel_format
+  format() const override
+  {
+    return fmt_;
+  }
+  double
+  frame_rate() const override
+  {
+    return 30.0;
+  }
+  double
+  duration() const override
+  {
+    return n_ / 30.0;
+  }
+  void
+  close() override
+  {}
+  bool
+  advance() override
+  {
+    if (index_ == unsigned(-1) || index_ < n_)
+      ++index_;
+    fill();
+    return is_valid();
+  }
+  vidl_frame_sptr
+  read_frame() override
+  {
+    advance();
+    return current_frame();
+  }
+  vidl_frame_sptr
+  current_frame() override
+  {
+    if (!is_valid())
+      return nullptr;
+    return new vidl_shared_frame(buffer_.data(), 8, 6, fmt_);
+  }
+  bool
+  seek_frame(unsigned int n) override
+  {
+    if (n >= n_)
+      return false;
+    index_ = n;
+    fill();
+    return true;
+  }
+
+private:
+  void
+  fill()
+  {
+    for (unsigned k = 0; k < buffer_.size(); ++k)
+      buffer_[k] = static_cast<unsigned char>(index_ + k % 8 + k / 8);
+  }
+  unsigned n_;
+  unsigned index_{ unsigned(-1) };
+  vidl_pixel_format fmt_;
+  std::vector<unsigned char> buffer_;
+};
+
+bool
+frame_ok(const vidl_frame_sptr & f, unsigned n)
+{
+  if (!f || f->ni() != 8 || f->nj() != 6 || f->pixel_format() != VIDL_PIXEL_FORMAT_MONO_8)
+    return false;
+  const auto * d = static_cast<const unsigned char *>(f->data());
+  for (unsigned k = 0; k < f->size(); ++k)
+    if (d[k] != static_cast<unsigned char>(n + k % 8 + k / 8))
+      return false;
+  return true;
+}
+} // namespace
+
+
+static void
+test_frame_pool()
+{
+  std::cout << "Testing vidl_frame_pool\n";
+  vidl_frame_pool pool(4);
+  vidl_frame_sptr a = pool.acquire(10, 10, VIDL_PIXEL_FORMAT_RGB_24);
+  TEST("Frame size", a && a->size() == 300 && a->pixel_format() == VIDL_PIXEL_FORMAT_RGB_24, true);
+  vidl_frame_sptr b = pool.acquire(10, 10, VIDL_PIXEL_FORMAT_RGB_24);
+  TEST("Frames in use are not shared", a->data() != b->data(), true);
+  const void * a_data = a->data();
+  a = nullptr;
+  vidl_frame_sptr c = pool.acquire(10, 10, VIDL_PIXEL_FORMAT_RGB_24);
+  TEST("Released buffer is reused", c->data() == a_data && pool.num_allocated() == 2, true);
+
+  // A view of the frame keeps the buffer in use.
+  vil_image_view_base_sptr view = vidl_convert_wrap_in_view(*c);
+  c = nullptr;
+  vidl_frame_sptr d = pool.acquire(10, 10, VIDL_PIXEL_FORMAT_RGB_24);
+  TEST("Buffer wrapped by a view is not reused", d->data() != a_data, true);
+  TEST("Pool size", pool.size(), 3u);
+
+  vidl_frame_sptr e = pool.acquire(4, 4, VIDL_PIXEL_FORMAT_MONO_8);
+  TEST("Other sizes allocated", e->size() == 16 && pool.num_allocated() == 4, true);
+}
+
+
+static void
+test_shared_frames()
+{
+  std::cout << "Testing vidl_pipelined_istream with shared frame buffers\n";
+  vidl_istream_sptr source = new test_shared_istream(20);
+  vidl_pipelined_istream pipe(source, 3);
+  TEST("Open", pipe.is_open() && !pipe.is_valid(), true);
+  TEST("Properties", pipe.width() == 8 && pipe.height() == 6 && pipe.num_frames() == 20 && pipe.is_seekable(), true);
+
+  bool ok = true;
+  std::vector<vidl_frame_sptr> kept;
+  unsigned count = 0;
+  while (pipe.advance())
+  {
+    ok = ok && pipe.frame_number() == count && frame_ok(pipe.current_frame(), count);
+    if (count % 5 == 0)
+      kept.push_back(pipe.current_frame());
+    ++count;
+  }
+  TEST("All frames read in order", ok && count == 20, true);
+  TEST("Frames kept by the caller are not overwritten",
+       frame_ok(kept[0], 0) && frame_ok(kept[1], 5) && frame_ok(kept[3], 15),
+       true);
+  TEST("Buffers are recycled", pipe.frame_pool().num_allocated() < 20, true);
+  TEST("Stays at the end", !pipe.advance() && !pipe.is_valid() && !pipe.current_frame(), true);
+
+  TEST("Seek", pipe.seek_frame(7) && pipe.frame_number() == 7 && frame_ok(pipe.current_frame(), 7), true);
+  TEST("Advance after seek", pipe.advance() && frame_ok(pipe.current_frame(), 8), true);
+  vil_image_view_base_sptr view = pipe.current_view();
+  vil_image_view<vxl_byte> img = view;
+  TEST("Wrapped view", img && img.ni() == 8 && img.nj() == 6 && img(3, 2) == 8 + 3 + 2, true);
+  TEST("View shares the frame buffer", img.top_left_ptr() == pipe.current_frame()->data(), true);
+
+  pipe.read_frame();
+  pipe.read_frame();
+  pipe.close();
+  TEST("Closed", !pipe.is_open() && !pipe.advance(), true);
+  TEST("Source left at the last frame read", source->frame_number(), 10u);
+
+  // Starts where the source is.
+  vidl_pipelined_istream pipe2(source, 2);
+  TEST("Starts at the source frame", pipe2.is_valid() && frame_ok(pipe2.current_frame(), 10), true);
+  TEST("Continues from the source frame", pipe2.advance() && pipe2.frame_number() == 11, true);
+
+  // Formats which can't be wrapped are converted.
+  vidl_pipelined_istream pipe3(new test_shared_istream(3, VIDL_PIXEL_FORMAT_UYVY_422), 2);
+  pipe3.advance();
+  vil_image_view_base_sptr yuv = pipe3.current_view();
+  TEST("Converted view", yuv && yuv->ni() == 8 && yuv->nj() == 6 && yuv->nplanes() == 3, true);
+}
+
+
+static void
+test_image_list()
+{
+  std::cout << "Testing vidl_pipelined_istream with vidl_image_list_istream\n";
+  const std::string dir = vul_temp_filename();
+  vul_file::make_directory(dir);
+  std::vector<std::string> paths;
+  for (unsigned n = 0; n < 6; ++n)
+  {
+    vil_image_view<vxl_byte> img(8, 6);
+    for (unsigned j = 0; j < 6; ++j)
+      for (unsigned i = 0; i < 8; ++i)
+        img(i, j) = vxl_byte(n + i + j);
+    paths.push_back(dir + "/frame" + std::to_string(n) + ".pgm");
+    vil_save(img, paths.back().c_str());
+  }
+
+  vidl_istream_sptr list = new vidl_image_list_istream(paths);
+  vidl_pipelined_istream pipe(list, 4);
+  bool ok = true;
+  unsigned count = 0;
+  while (pipe.advance())
+    ok = ok && pipe.frame_number() == count && frame_ok(pipe.current_frame(), count), ++count;
+  TEST("Image list frames read in order", ok && count == 6, true);
+  TEST("Image list frames are not copied", pipe.frame_pool().num_allocated(), 0u);
+  TEST("Seek", pipe.seek_frame(2) && frame_ok(pipe.current_frame(), 2), true);
+  pipe.close();
+
+  for (const auto & p : paths)
+    vpl_unlink(p.c_str());
+  vpl_rmdir(dir.c_str());
+}
+
+
+static void
+test_pipelined_istream()
+{
+  test_frame_pool();
+  test_shared_frames();
+  test_image_list();
+}
+
+TESTMAIN(test_pipelined_istream);
@@ -0,0 +1,103 @@
+//:
+// \file
+// \brief Tool to time the conversion of 4K frames between the common pixel formats
+//   For each pair of formats, reports the time per frame of vidl_convert_frame
+//   and of the generic pixel by pixel conversion it replaces, and the time to
+//   convert into a cropped (non-contiguous) view.  Run with an optional
+//   number of repeats (default 10).
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "vxl_config.h" // for vxl_byte
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vul/vul_timer.h"
+#include "vil/vil_image_view.h"
+#include "vil/vil_crop.h"
+#include "vil/vil_plane.h"
+#include <vidl/vidl_convert.h>
+#include <vidl/vidl_color.h>
+#include <vidl/vidl_frame.h>
+#include <vidl/vidl_pixel_iterator.h>
+
+constexpr unsigned NI = 3840;
+constexpr unsigned NJ = 2160;
+
+//: The generic conversion, through pixel iterators
+static void
+convert_by_pixel(const vidl_frame & in_frame, vidl_frame & out_frame)
+{
+  std::unique_ptr<vidl_pixel_iterator> in_itr(vidl_make_pixel_iterator(in_frame));
+  std::unique_ptr<vidl_pixel_iterator> out_itr(vidl_make_pixel_iterator(out_frame));
+  vidl_pixel_traits in_t = vidl_pixel_format_traits(in_frame.pixel_format());
+  vidl_pixel_traits out_t = vidl_pixel_format_traits(out_frame.pixel_format());
+  vidl_color_conv_fptr color_conv = vidl_color_converter_func(in_t.color, *in_t.type, out_t.color, *out_t.type);
+  vxl_byte in_pixel[32], out_pixel[32];
+  for (unsigned c = 0; c < in_frame.ni() * in_frame.nj(); ++c, ++*in_itr, ++*out_itr)
+  {
+    in_itr->get_data(in_pixel);
+    color_conv(in_pixel, out_pixel);
+    out_itr->set_data(out_pixel);
+  }
+}
+
+//: Milliseconds per frame
+template <class F>
+static double
+time_ms(F f, int n_loops)
+{
+  vul_timer timer;
+  for (int n = 0; n < n_loops; ++n)
+    f();
+  return double(timer.real()) / n_loops;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int n_loops = argc > 1 ? std::atoi(argv[1]) : 10;
+  const vidl_pixel_format pairs[][2] = {
+    { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24 },  { VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24 },
+    { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24P }, { VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24 },  { VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_UYVY_422 },  { VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_MONO_8 },
+    { VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_MONO_8 },    { VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_RGB_24 },
+    { VIDL_PIXEL_FORMAT_MONO_16, VIDL_PIXEL_FORMAT_MONO_8 }
+  };
+
+  std::vector<vxl_byte> in(NI * NJ * 3), out(NI * NJ * 3);
+  for (std::size_t k = 0; k < in.size(); ++k)
+    in[k] = vxl_byte(k * 7 + k / 4096);
+  vil_image_view<vxl_byte> big(NI + 16, NJ + 16, 3);
+
+  std::cout << NI << 'x' << NJ << " frames, ms per frame\n"
+            << std::setw(28) << "conversion" << std::setw(12) << "by pixel" << std::setw(12) << "frame"
+            << std::setw(12) << "view" << '\n';
+  const double copy = time_ms([&]() { std::memcpy(out.data(), in.data(), NI * NJ * 3); }, n_loops);
+  std::cout << std::setw(28) << "memcpy RGB_24" << std::setw(12) << "" << std::setw(12) << copy << '\n';
+
+  for (const auto & p : pairs)
+  {
+    vidl_shared_frame in_frame(in.data(), NI, NJ, p[0]);
+    vidl_shared_frame out_frame(out.data(), NI, NJ, p[1]);
+    const double slow = time_ms([&]() { convert_by_pixel(in_frame, out_frame); }, 1);
+    const double fast = time_ms([&]() { vidl_convert_frame(in_frame, out_frame); }, n_loops);
+
+    std::cout << std::setw(28) << (vidl_pixel_format_to_string(p[0]) + " to " + vidl_pixel_format_to_string(p[1]))
+              << std::setw(12) << slow << std::setw(12) << fast;
+    const vidl_pixel_color color = vidl_pixel_format_color(p[1]);
+    if (color == VIDL_PIXEL_COLOR_RGB || color == VIDL_PIXEL_COLOR_MONO)
+    {
+      vil_image_view<vxl_byte> view =
+        vil_crop(color == VIDL_PIXEL_COLOR_RGB ? big : vil_plane(big, 0), 8, NI, 8, NJ);
+      std::cout << std::setw(12) << time_ms([&]() { vidl_convert_to_view(in_frame, view, color); }, n_loops);
+    }
+    std::cout << '\n';
+  }
+  return 0;
+}
@@ -11,9 +11,11 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <vector>
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -22,6 +24,7 @@
 #include "vidl_pixel_format.h"
 #include "vidl_pixel_iterator.hxx"
 #include "vidl_color.h"
+#include "vidl_convert_rows.h"
 #include <vidl/vidl_config.h>
 #if VIDL_HAS_FFMPEG
 // make use of the convert function using ffmpeg
@@ -29,6 +32,7 @@
 #endif
 
 #include "vil/vil_convert.h"
+#include "vil/vil_image_view.h"
 #include "vil/vil_new.h"
 #include "vil/vil_memory_chunk.h"
 #include <cassert>
@@ -121,10 +125,18 @@ convert_generic(const vidl_frame & in_frame, vidl_frame & out_frame)
 //=============================================================================
 // Start of pixel conversion specializations
 // Write optimized conversion specializations below
+//
+// Most of these use the row kernels of vidl_convert_rows.h.  Packed 4:2:2
+// frames are converted as a single row, so that frames of odd width keep
+// their macropixels.
 
-// RGB_24 to UYVY_422
-template <>
-struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_UYVY_422>
+//: Number of pixels converted at a time through a temporary buffer (even)
+constexpr unsigned int chunk_size = 4096;
+
+
+//: Apply a row kernel to the whole frame as one row
+template <class inT, class outT, void (*F)(const inT *, outT *, unsigned)>
+struct row_conversion
 {
   enum
   {
@@ -133,35 +145,16 @@ struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_UYVY_422>
   static bool
   apply(const vidl_frame & in_frame, vidl_frame & out_frame)
   {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_UYVY_422);
-    const auto * rgb = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * uyvy = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
-    {
-      const vxl_byte & r1 = *(rgb++);
-      const vxl_byte & g1 = *(rgb++);
-      const vxl_byte & b1 = *(rgb++);
-      const vxl_byte & r2 = *(rgb++);
-      const vxl_byte & g2 = *(rgb++);
-      const vxl_byte & b2 = *(rgb++);
-      vxl_byte y1, u1, v1, y2, u2, v2;
-      vidl_color_convert_rgb2yuv(r1, g1, b1, y1, u1, v1);
-      vidl_color_convert_rgb2yuv(r2, g2, b2, y2, u2, v2);
-      *(uyvy++) = (u1 + u2) / 2u;
-      *(uyvy++) = y1;
-      *(uyvy++) = (v1 + v2) / 2u;
-      *(uyvy++) = y2;
-    }
+    F(static_cast<const inT *>(in_frame.data()), static_cast<outT *>(out_frame.data()), in_frame.ni() * in_frame.nj());
     return true;
   }
 };
 
 
-// UYVY_422 to RGB_24
-template <>
-struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24>
+//: Apply a row kernel producing interleaved RGB, and split the result into planes
+// \p B is the number of input bytes per pixel.
+template <void (*F)(const vxl_byte *, vxl_byte *, unsigned), unsigned B>
+struct to_planar_conversion
 {
   enum
   {
@@ -170,35 +163,32 @@ struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24>
   static bool
   apply(const vidl_frame & in_frame, vidl_frame & out_frame)
   {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_UYVY_422);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24);
-    const auto * uyvy = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * rgb = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
+    const unsigned int n = in_frame.ni() * in_frame.nj();
+    const auto * src = static_cast<const vxl_byte *>(in_frame.data());
+    auto * red = static_cast<vxl_byte *>(out_frame.data());
+    vxl_byte * green = red + n;
+    vxl_byte * blue = green + n;
+    vxl_byte rgb[3 * chunk_size];
+    for (unsigned int i = 0; i < n; i += chunk_size)
     {
-      const vxl_byte & u1 = *(uyvy++);
-      const vxl_byte & y1 = *(uyvy++);
-      const vxl_byte & v1 = *(uyvy++);
-      const vxl_byte & y2 = *(uyvy++);
-      vxl_byte r, g, b;
-      vidl_color_convert_yuv2rgb(y1, u1, v1, r, g, b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-      vidl_color_convert_yuv2rgb(y2, u1, v1, r, g, b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
+      const unsigned int m = std::min(chunk_size, n - i);
+      F(src + B * i, rgb, m);
+      for (unsigned int k = 0; k < m; ++k)
+      {
+        red[i + k] = rgb[3 * k];
+        green[i + k] = rgb[3 * k + 1];
+        blue[i + k] = rgb[3 * k + 2];
+      }
     }
     return true;
   }
 };
 
 
-// UYVY_422 to MONO_8
-template <>
-struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8>
+//: Interleave planar RGB and apply a row kernel to the result
+// \p B is the number of output bytes per pixel.
+template <void (*F)(const vxl_byte *, vxl_byte *, unsigned), unsigned B>
+struct from_planar_conversion
 {
   enum
   {
@@ -207,28 +197,33 @@ struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8>
   static bool
   apply(const vidl_frame & in_frame, vidl_frame & out_frame)
   {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_UYVY_422);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_MONO_8);
-    const auto * uyvy = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * mono = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
+    const unsigned int n = in_frame.ni() * in_frame.nj();
+    const auto * red = static_cast<const vxl_byte *>(in_frame.data());
+    const vxl_byte * green = red + n;
+    const vxl_byte * blue = green + n;
+    auto * dst = static_cast<vxl_byte *>(out_frame.data());
+    vxl_byte rgb[3 * chunk_size];
+    for (unsigned int i = 0; i < n; i += chunk_size)
     {
-      ++uyvy;
-      const vxl_byte & y1 = *(uyvy++);
-      ++uyvy;
-      const vxl_byte & y2 = *(uyvy++);
-      *(mono++) = y1;
-      *(mono++) = y2;
+      const unsigned int m = std::min(chunk_size, n - i);
+      for (unsigned int k = 0; k < m; ++k)
+      {
+        rgb[3 * k] = red[i + k];
+        rgb[3 * k + 1] = green[i + k];
+        rgb[3 * k + 2] = blue[i + k];
+      }
+      F(rgb, dst + B * i, m);
     }
     return true;
   }
 };
 
 
-// RGB_24 to YUYV_422
-template <>
-struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_YUYV_422>
+//: Planar YUV with half width chroma, a row at a time
+// \p CSY is the vertical chroma shift.  Frames with odd dimensions fall
+// back on the generic conversion.
+template <vidl_pixel_format out_Fmt, unsigned CSY>
+struct yuvp_conversion
 {
   enum
   {
@@ -237,173 +232,179 @@ struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_YUYV_422>
   static bool
   apply(const vidl_frame & in_frame, vidl_frame & out_frame)
   {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_YUYV_422);
-    const auto * rgb = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * yuyv = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
+    const unsigned int ni = in_frame.ni(), nj = in_frame.nj(), n = ni * nj;
+    if (ni % 2 != 0 || nj % (1u << CSY) != 0)
+      return convert_generic(in_frame, out_frame);
+
+    const auto * y = static_cast<const vxl_byte *>(in_frame.data());
+    const vxl_byte * u = y + n;
+    const vxl_byte * v = u + (ni / 2) * (nj >> CSY);
+    auto * dst = static_cast<vxl_byte *>(out_frame.data());
+    if (out_Fmt == VIDL_PIXEL_FORMAT_MONO_8)
+    {
+      // The Y plane is the greyscale image
+      std::memcpy(dst, y, n);
+      return true;
+    }
+    std::vector<vxl_byte> rgb(out_Fmt == VIDL_PIXEL_FORMAT_RGB_24P ? 3 * ni : 0);
+    for (unsigned int j = 0; j < nj; ++j)
     {
-      const vxl_byte & r1 = *(rgb++);
-      const vxl_byte & g1 = *(rgb++);
-      const vxl_byte & b1 = *(rgb++);
-      const vxl_byte & r2 = *(rgb++);
-      const vxl_byte & g2 = *(rgb++);
-      const vxl_byte & b2 = *(rgb++);
-      vxl_byte y1, u1, v1, y2, u2, v2;
-      vidl_color_convert_rgb2yuv(r1, g1, b1, y1, u1, v1);
-      vidl_color_convert_rgb2yuv(r2, g2, b2, y2, u2, v2);
-      *(yuyv++) = y1;
-      *(yuyv++) = (u1 + u2) / 2u;
-      *(yuyv++) = y2;
-      *(yuyv++) = (v1 + v2) / 2u;
+      const unsigned int c = (j >> CSY) * (ni / 2);
+      if (out_Fmt == VIDL_PIXEL_FORMAT_RGB_24)
+      {
+        vidl_convert_row_yuvp_to_rgb(y + j * ni, u + c, v + c, dst + 3 * j * ni, ni);
+        continue;
+      }
+      vidl_convert_row_yuvp_to_rgb(y + j * ni, u + c, v + c, rgb.data(), ni);
+      for (unsigned int i = 0; i < ni; ++i)
+      {
+        dst[j * ni + i] = rgb[3 * i];
+        dst[n + j * ni + i] = rgb[3 * i + 1];
+        dst[2 * n + j * ni + i] = rgb[3 * i + 2];
+      }
     }
     return true;
   }
 };
 
 
+// RGB_24 to UYVY_422
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_UYVY_422>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_rgb_to_uyvy>
+{};
+
+// RGB_24 to YUYV_422
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_YUYV_422>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_rgb_to_yuyv>
+{};
+
+// UYVY_422 to RGB_24
+template <>
+struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_uyvy_to_rgb>
+{};
+
 // YUYV_422 to RGB_24
 template <>
 struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24>
-{
-  enum
-  {
-    defined = true
-  };
-  static bool
-  apply(const vidl_frame & in_frame, vidl_frame & out_frame)
-  {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_YUYV_422);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24);
-    const auto * yuyv = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * rgb = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
-    {
-      const vxl_byte & y1 = *(yuyv++);
-      const vxl_byte & u1 = *(yuyv++);
-      const vxl_byte & y2 = *(yuyv++);
-      const vxl_byte & v1 = *(yuyv++);
-      vxl_byte r, g, b;
-      vidl_color_convert_yuv2rgb(y1, u1, v1, r, g, b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-      vidl_color_convert_yuv2rgb(y2, u1, v1, r, g, b);
-      *(rgb++) = r;
-      *(rgb++) = g;
-      *(rgb++) = b;
-    }
-    return true;
-  }
-};
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_yuyv_to_rgb>
+{};
 
+// UYVY_422 to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_MONO_8>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_uyvy_to_mono>
+{};
 
-// RGB_24P to YUYV_422
+// YUYV_422 to MONO_8
 template <>
-struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_YUYV_422>
-{
-  enum
-  {
-    defined = true
-  };
-  static bool
-  apply(const vidl_frame & in_frame, vidl_frame & out_frame)
-  {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24P);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_YUYV_422);
-    const auto * red = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    const vxl_byte * green = red + in_frame.ni() * in_frame.nj();
-    const vxl_byte * blue = green + in_frame.ni() * in_frame.nj();
-    auto * yuyv = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
-    {
-      const vxl_byte & r1 = *(red++);
-      const vxl_byte & g1 = *(green++);
-      const vxl_byte & b1 = *(blue++);
-      const vxl_byte & r2 = *(red++);
-      const vxl_byte & g2 = *(green++);
-      const vxl_byte & b2 = *(blue++);
-      vxl_byte y1, u1, v1, y2, u2, v2;
-      vidl_color_convert_rgb2yuv(r1, g1, b1, y1, u1, v1);
-      vidl_color_convert_rgb2yuv(r2, g2, b2, y2, u2, v2);
-      *(yuyv++) = y1;
-      *(yuyv++) = (u1 + u2) / 2u;
-      *(yuyv++) = y2;
-      *(yuyv++) = (v1 + v2) / 2u;
-    }
-    return true;
-  }
-};
+struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_MONO_8>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_yuyv_to_mono>
+{};
+
+// RGB_24 to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_MONO_8>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_rgb_to_mono>
+{};
+
+// BGR_24 to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_MONO_8>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_bgr_to_mono>
+{};
+
+// RGB_24 to BGR_24
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24, VIDL_PIXEL_FORMAT_BGR_24>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_swap_rb>
+{};
+
+// BGR_24 to RGB_24
+template <>
+struct convert<VIDL_PIXEL_FORMAT_BGR_24, VIDL_PIXEL_FORMAT_RGB_24>
+  : row_conversion<vxl_byte, vxl_byte, &vidl_convert_row_swap_rb>
+{};
+
+// MONO_16 to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_MONO_16, VIDL_PIXEL_FORMAT_MONO_8>
+  : row_conversion<vxl_uint_16, vxl_byte, &vidl_convert_row_mono16_to_mono>
+{};
+
+// MONO_8 to MONO_16
+template <>
+struct convert<VIDL_PIXEL_FORMAT_MONO_8, VIDL_PIXEL_FORMAT_MONO_16>
+  : row_conversion<vxl_byte, vxl_uint_16, &vidl_convert_row_mono_to_mono16>
+{};
+
+// UYVY_422 to RGB_24P
+template <>
+struct convert<VIDL_PIXEL_FORMAT_UYVY_422, VIDL_PIXEL_FORMAT_RGB_24P>
+  : to_planar_conversion<&vidl_convert_row_uyvy_to_rgb, 2>
+{};
 
 // YUYV_422 to RGB_24P
 template <>
 struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_RGB_24P>
-{
-  enum
-  {
-    defined = true
-  };
-  static bool
-  apply(const vidl_frame & in_frame, vidl_frame & out_frame)
-  {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_YUYV_422);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_RGB_24P);
-    const auto * yuyv = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * red = reinterpret_cast<vxl_byte *>(out_frame.data());
-    vxl_byte * green = red + out_frame.ni() * out_frame.nj();
-    vxl_byte * blue = green + out_frame.ni() * out_frame.nj();
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
-    {
-      const vxl_byte & y1 = *(yuyv++);
-      const vxl_byte & u1 = *(yuyv++);
-      const vxl_byte & y2 = *(yuyv++);
-      const vxl_byte & v1 = *(yuyv++);
-      vxl_byte r, g, b;
-      vidl_color_convert_yuv2rgb(y1, u1, v1, r, g, b);
-      *(red++) = r;
-      *(green++) = g;
-      *(blue++) = b;
-      vidl_color_convert_yuv2rgb(y2, u1, v1, r, g, b);
-      *(red++) = r;
-      *(green++) = g;
-      *(blue++) = b;
-    }
-    return true;
-  }
-};
+  : to_planar_conversion<&vidl_convert_row_yuyv_to_rgb, 2>
+{};
 
-// YUYV_422 to MONO_8
+// RGB_24P to UYVY_422
 template <>
-struct convert<VIDL_PIXEL_FORMAT_YUYV_422, VIDL_PIXEL_FORMAT_MONO_8>
-{
-  enum
-  {
-    defined = true
-  };
-  static bool
-  apply(const vidl_frame & in_frame, vidl_frame & out_frame)
-  {
-    assert(in_frame.pixel_format() == VIDL_PIXEL_FORMAT_YUYV_422);
-    assert(out_frame.pixel_format() == VIDL_PIXEL_FORMAT_MONO_8);
-    const auto * yuyv = reinterpret_cast<const vxl_byte *>(in_frame.data());
-    auto * mono = reinterpret_cast<vxl_byte *>(out_frame.data());
-    unsigned int num_half_pix = (in_frame.ni() * in_frame.nj() + 1) / 2;
-    for (unsigned int c = 0; c < num_half_pix; ++c)
-    {
-      const vxl_byte & y1 = *(yuyv++);
-      ++yuyv;
-      const vxl_byte & y2 = *(yuyv++);
-      ++yuyv;
-      *(mono++) = y1;
-      *(mono++) = y2;
-    }
-    return true;
-  }
-};
+struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_UYVY_422>
+  : from_planar_conversion<&vidl_convert_row_rgb_to_uyvy, 2>
+{};
+
+// RGB_24P to YUYV_422
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_YUYV_422>
+  : from_planar_conversion<&vidl_convert_row_rgb_to_yuyv, 2>
+{};
+
+// RGB_24P to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_RGB_24P, VIDL_PIXEL_FORMAT_MONO_8>
+  : from_planar_conversion<&vidl_convert_row_rgb_to_mono, 1>
+{};
+
+// YUV_420P to RGB_24
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_RGB_24, 1>
+{};
+
+// YUV_420P to RGB_24P
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_RGB_24P>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_RGB_24P, 1>
+{};
+
+// YUV_420P to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_420P, VIDL_PIXEL_FORMAT_MONO_8>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_MONO_8, 1>
+{};
+
+// YUV_422P to RGB_24
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_RGB_24>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_RGB_24, 0>
+{};
+
+// YUV_422P to RGB_24P
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_RGB_24P>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_RGB_24P, 0>
+{};
+
+// YUV_422P to MONO_8
+template <>
+struct convert<VIDL_PIXEL_FORMAT_YUV_422P, VIDL_PIXEL_FORMAT_MONO_8>
+  : yuvp_conversion<VIDL_PIXEL_FORMAT_MONO_8, 0>
+{};
 
 
 // End of pixel conversion specializations
@@ -506,6 +507,107 @@ bool intermediate_rgb24_conversion(vidl_frame const& in_frame, vidl_frame& out_f
 }
 #endif
 
+//: Convert row \p j of a frame to interleaved RGB or to monochrome
+using row_converter_func = void (*)(const vidl_frame & frame, unsigned j, vxl_byte * out);
+
+
+//: Copy a row of \p B bytes per pixel, or the first plane of a planar frame
+template <unsigned B>
+void
+copy_row(const vidl_frame & frame, unsigned j, vxl_byte * out)
+{
+  std::memcpy(out, static_cast<const vxl_byte *>(frame.data()) + B * frame.ni() * j, B * frame.ni());
+}
+
+
+//: Apply a row kernel to a row of \p B bytes per pixel
+template <void (*F)(const vxl_byte *, vxl_byte *, unsigned), unsigned B>
+void
+kernel_row(const vidl_frame & frame, unsigned j, vxl_byte * out)
+{
+  F(static_cast<const vxl_byte *>(frame.data()) + B * frame.ni() * j, out, frame.ni());
+}
+
+
+//: Convert a row of planar YUV with half width chroma and vertical chroma shift \p CSY
+template <unsigned CSY>
+void
+yuvp_row(const vidl_frame & frame, unsigned j, vxl_byte * out)
+{
+  const unsigned int ni = frame.ni(), nj = frame.nj();
+  const auto * y = static_cast<const vxl_byte *>(frame.data());
+  const vxl_byte * u = y + ni * nj + (j >> CSY) * (ni / 2);
+  const vxl_byte * v = u + (ni / 2) * (nj >> CSY);
+  vidl_convert_row_yuvp_to_rgb(y + ni * j, u, v, out, ni);
+}
+
+
+//: The row conversion from a frame to RGB or monochrome, if there is one
+row_converter_func
+view_row_converter(const vidl_frame & frame, bool mono)
+{
+  const bool even_ni = frame.ni() % 2 == 0;
+  switch (frame.pixel_format())
+  {
+    case VIDL_PIXEL_FORMAT_MONO_8:
+      return mono ? &copy_row<1> : nullptr;
+    case VIDL_PIXEL_FORMAT_RGB_24:
+      return mono ? &kernel_row<&vidl_convert_row_rgb_to_mono, 3> : &copy_row<3>;
+    case VIDL_PIXEL_FORMAT_BGR_24:
+      return mono ? &kernel_row<&vidl_convert_row_bgr_to_mono, 3> : &kernel_row<&vidl_convert_row_swap_rb, 3>;
+    case VIDL_PIXEL_FORMAT_UYVY_422: // rows must start on a macropixel
+      if (!even_ni)
+        return nullptr;
+      return mono ? &kernel_row<&vidl_convert_row_uyvy_to_mono, 2> : &kernel_row<&vidl_convert_row_uyvy_to_rgb, 2>;
+    case VIDL_PIXEL_FORMAT_YUYV_422:
+      if (!even_ni)
+        return nullptr;
+      return mono ? &kernel_row<&vidl_convert_row_yuyv_to_mono, 2> : &kernel_row<&vidl_convert_row_yuyv_to_rgb, 2>;
+    case VIDL_PIXEL_FORMAT_YUV_420P:
+      if (!even_ni || frame.nj() % 2 != 0)
+        return nullptr;
+      return mono ? &copy_row<1> : &yuvp_row<1>;
+    case VIDL_PIXEL_FORMAT_YUV_422P:
+      if (!even_ni)
+        return nullptr;
+      return mono ? &copy_row<1> : &yuvp_row<0>;
+    default:
+      return nullptr;
+  }
+}
+
+
+//: Convert the common formats a row at a time, straight into a byte view of any layout
+// The view must already have the size of the frame, and 1 or 3 planes.
+// Returns false if the format is not one of those handled here.
+bool
+convert_rows_to_view(const vidl_frame & frame, vil_image_view<vxl_byte> & img)
+{
+  const unsigned int ni = img.ni(), np = img.nplanes();
+  const row_converter_func convert_row = view_row_converter(frame, np == 1);
+  if (!convert_row)
+    return false;
+
+  const std::ptrdiff_t istep = img.istep(), pstep = img.planestep();
+  const bool direct = istep == std::ptrdiff_t(np) && (np == 1 || pstep == 1);
+  std::vector<vxl_byte> temp(direct ? 0 : ni * np);
+  for (unsigned int j = 0; j < img.nj(); ++j)
+  {
+    vxl_byte * row = img.top_left_ptr() + j * img.jstep();
+    if (direct)
+    {
+      convert_row(frame, j, row);
+      continue;
+    }
+    convert_row(frame, j, temp.data());
+    const vxl_byte * t = temp.data();
+    for (unsigned int i = 0; i < ni; ++i, row += istep)
+      for (unsigned int p = 0; p < np; ++p)
+        row[p * pstep] = *t++;
+  }
+  return true;
+}
+
 } // end anonymous namespace
 
 //--------------------------------------------------------------------------------
@@ -710,6 +812,13 @@ vidl_convert_to_view(const vidl_frame & frame, vil_image_view_base & image, vidl
     return true;
   }
 
+  // The common formats are converted a row at a time, straight into the view,
+  // whatever its layout
+  if (image.pixel_format() == VIL_PIXEL_FORMAT_BYTE &&
+      (require_color == VIDL_PIXEL_COLOR_MONO || require_color == VIDL_PIXEL_COLOR_RGB) &&
+      convert_rows_to_view(frame, static_cast<vil_image_view<vxl_byte> &>(image)))
+    return true;
+
   vidl_pixel_format default_format = VIDL_PIXEL_FORMAT_UNKNOWN;
   if (image.pixel_format() == VIL_PIXEL_FORMAT_BYTE)
   {
@@ -745,7 +854,7 @@ vidl_convert_to_view(const vidl_frame & frame, vil_image_view_base & image, vidl
 
   // use an intermediate format
   vidl_pixel_format out_fmt;
-  switch (in_color)
+  switch (require_color)
   {
     case VIDL_PIXEL_COLOR_MONO:
       out_fmt = VIDL_PIXEL_FORMAT_MONO_8;
@@ -0,0 +1,408 @@
+// This is core/vidl/vidl_convert_rows.cxx
+//:
+// \file
+//
+// The SSE2 versions below compute in 16 bit lanes (32 bit for sums of
+// products) and use the same integer coefficients, shifts and
+// saturations as vidl_color.h, so they agree exactly with the scalar
+// code, which also converts whatever is left at the end of a row.
+//
+//-----------------------------------------------------------------------------
+
+#include <cstring>
+#include "vidl_convert_rows.h"
+#include "vidl_color.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vil/vil_config.h>
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+#  include <emmintrin.h>
+#endif
+
+
+namespace
+{
+
+//: Scalar conversion of packed 4:2:2 to RGB from pixel \p i (even) on.
+// \p Y0 and \p C0 are the offsets of the first luma and the U byte in a macropixel.
+template <unsigned Y0, unsigned C0>
+inline void
+yuv422_to_rgb_scalar(const vxl_byte * src, vxl_byte * rgb, unsigned i, unsigned n)
+{
+  for (; i + 1 < n; i += 2)
+  {
+    const vxl_byte * m = src + 2 * i;
+    vxl_byte * p = rgb + 3 * i;
+    vidl_color_convert_yuv2rgb(m[Y0], m[C0], m[C0 + 2], p[0], p[1], p[2]);
+    vidl_color_convert_yuv2rgb(m[Y0 + 2], m[C0], m[C0 + 2], p[3], p[4], p[5]);
+  }
+  if (i < n)
+  {
+    const vxl_byte * m = src + 2 * i;
+    vxl_byte * p = rgb + 3 * i;
+    vidl_color_convert_yuv2rgb(m[Y0], m[C0], 128, p[0], p[1], p[2]);
+  }
+}
+
+
+//: Scalar conversion of RGB to packed 4:2:2 from pixel \p i (even) on.
+template <unsigned Y0, unsigned C0>
+inline void
+rgb_to_yuv422_scalar(const vxl_byte * rgb, vxl_byte * dst, unsigned i, unsigned n)
+{
+  vxl_byte y1, u1, v1, y2, u2, v2;
+  for (; i + 1 < n; i += 2)
+  {
+    const vxl_byte * p = rgb + 3 * i;
+    vxl_byte * m = dst + 2 * i;
+    vidl_color_convert_rgb2yuv(p[0], p[1], p[2], y1, u1, v1);
+    vidl_color_convert_rgb2yuv(p[3], p[4], p[5], y2, u2, v2);
+    m[C0] = (u1 + u2) / 2u;
+    m[Y0] = y1;
+    m[C0 + 2] = (v1 + v2) / 2u;
+    m[Y0 + 2] = y2;
+  }
+  if (i < n)
+  {
+    const vxl_byte * p = rgb + 3 * i;
+    vxl_byte * m = dst + 2 * i;
+    vidl_color_convert_rgb2yuv(p[0], p[1], p[2], y1, u1, v1);
+    m[C0] = u1;
+    m[Y0] = y1;
+  }
+}
+
+
+//: Scalar conversion of RGB (R0 = 0) or BGR (R0 = 2) to monochrome from pixel \p i on.
+template <unsigned R0>
+inline void
+rgb_to_mono_scalar(const vxl_byte * rgb, vxl_byte * mono, unsigned i, unsigned n)
+{
+  for (const vxl_byte * p = rgb + 3 * i; i < n; ++i, p += 3)
+    mono[i] = static_cast<vxl_byte>((306 * p[R0] + 601 * p[1] + 117 * p[2 - R0]) >> 10);
+}
+
+
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+
+//: Convert 8 pixels to RGB and store them in 24 bytes at \p rgb.
+// \p y holds the 16 bit luma of each pixel and \p uv the 16 bit U and V
+// of each pair of pixels, in the order U0 V0 U1 V1 ...
+inline void
+yuv_to_rgb_sse2(__m128i y, __m128i uv, vxl_byte * rgb)
+{
+  const __m128i low16 = _mm_set1_epi32(0x0000FFFF);
+  uv = _mm_sub_epi16(uv, _mm_set1_epi16(128));
+  // U and V of each pair, for both of its pixels
+  const __m128i u = _mm_or_si128(_mm_and_si128(uv, low16), _mm_slli_epi32(uv, 16));
+  const __m128i v = _mm_or_si128(_mm_andnot_si128(low16, uv), _mm_srli_epi32(uv, 16));
+
+  // (x * c) >> 10 is exactly the high half of (x << 6) * c
+  const __m128i dr = _mm_mulhi_epi16(_mm_slli_epi16(v, 6), _mm_set1_epi16(1436));
+  const __m128i db = _mm_mulhi_epi16(_mm_slli_epi16(u, 6), _mm_set1_epi16(1814));
+  // but the green sum is shifted as a whole
+  __m128i dg = _mm_srai_epi32(_mm_madd_epi16(uv, _mm_set1_epi32((731 << 16) | 352)), 10);
+  dg = _mm_or_si128(_mm_and_si128(dg, low16), _mm_slli_epi32(dg, 16));
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i r = _mm_packus_epi16(_mm_add_epi16(y, dr), zero);
+  const __m128i g = _mm_packus_epi16(_mm_sub_epi16(y, dg), zero);
+  const __m128i b = _mm_packus_epi16(_mm_add_epi16(y, db), zero);
+
+  // R G B 0 in each 32 bit lane
+  const __m128i rg = _mm_unpacklo_epi8(r, g);
+  const __m128i b0 = _mm_unpacklo_epi8(b, zero);
+  const __m128i p0 = _mm_unpacklo_epi16(rg, b0);
+  const __m128i p1 = _mm_unpackhi_epi16(rg, b0);
+
+  // Squeeze out the zeros: two pixels to 6 bytes in each 64 bit lane,
+  // then four pixels to the low 12 bytes.
+  const __m128i pix_a = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+  const __m128i pix_b = _mm_set_epi32(0x0000FFFF, static_cast<int>(0xFF000000), 0x0000FFFF, static_cast<int>(0xFF000000));
+  const __m128i lane0 = _mm_set_epi32(0, 0, -1, -1);
+  __m128i q0 = _mm_or_si128(_mm_and_si128(p0, pix_a), _mm_and_si128(_mm_srli_epi64(p0, 8), pix_b));
+  __m128i q1 = _mm_or_si128(_mm_and_si128(p1, pix_a), _mm_and_si128(_mm_srli_epi64(p1, 8), pix_b));
+  q0 = _mm_or_si128(_mm_and_si128(q0, lane0), _mm_srli_si128(_mm_andnot_si128(lane0, q0), 2));
+  q1 = _mm_or_si128(_mm_and_si128(q1, lane0), _mm_srli_si128(_mm_andnot_si128(lane0, q1), 2));
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb), _mm_or_si128(q0, _mm_slli_si128(q1, 12)));
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(rgb + 16), _mm_srli_si128(q1, 4));
+}
+
+
+//: Spread 4 pixels of 3 bytes, in the low 12 bytes of \p q, to one per 32 bit lane.
+inline __m128i
+spread_rgb_sse2(__m128i q)
+{
+  const __m128i e = _mm_unpacklo_epi64(q, _mm_srli_si128(q, 6));
+  const __m128i pix_a = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+  const __m128i pix_b = _mm_set_epi32(0x00FFFFFF, 0, 0x00FFFFFF, 0);
+  return _mm_or_si128(_mm_and_si128(e, pix_a), _mm_and_si128(_mm_slli_epi64(e, 8), pix_b));
+}
+
+
+//: Load 8 pixels of 3 bytes as two registers of 4 pixels, one per 32 bit lane.
+inline void
+load_rgb_sse2(const vxl_byte * rgb, __m128i & q0, __m128i & q1)
+{
+  const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb));
+  const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(rgb + 16));
+  q0 = spread_rgb_sse2(a);
+  q1 = spread_rgb_sse2(_mm_or_si128(_mm_srli_si128(a, 12), _mm_slli_si128(b, 4)));
+}
+
+
+//: c0*R + c1*G + c2*B for 4 pixels, one per 32 bit lane.
+// \p coef holds c0 c1 c2 0 c0 c1 c2 0 as 16 bit values.
+inline __m128i
+dot_rgb_sse2(__m128i pix, __m128i coef)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pix, zero), coef);
+  __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pix, zero), coef);
+  lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+  hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+  return _mm_unpacklo_epi64(_mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0)),
+                            _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+
+//: Mean of each pair of the 4 chroma values of \p u and of \p v, as U0 V0 U1 V1.
+inline __m128i
+pair_chroma_sse2(__m128i u, __m128i v)
+{
+  u = _mm_srli_epi32(_mm_add_epi32(u, _mm_srli_epi64(u, 32)), 1);
+  v = _mm_srli_epi32(_mm_add_epi32(v, _mm_srli_epi64(v, 32)), 1);
+  return _mm_or_si128(_mm_and_si128(u, _mm_set_epi32(0, -1, 0, -1)), _mm_slli_epi64(v, 32));
+}
+
+#endif // VXL_HAS_SSE2_HARDWARE_SUPPORT
+
+
+template <unsigned Y0, unsigned C0>
+inline void
+yuv422_to_rgb(const vxl_byte * src, vxl_byte * rgb, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i low8 = _mm_set1_epi16(0x00FF);
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i));
+    const __m128i y = Y0 ? _mm_srli_epi16(m, 8) : _mm_and_si128(m, low8);
+    const __m128i uv = Y0 ? _mm_and_si128(m, low8) : _mm_srli_epi16(m, 8);
+    yuv_to_rgb_sse2(y, uv, rgb + 3 * i);
+  }
+#endif
+  yuv422_to_rgb_scalar<Y0, C0>(src, rgb, i, n);
+}
+
+
+template <unsigned Y0>
+inline void
+yuv422_to_mono(const vxl_byte * src, vxl_byte * mono, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i low8 = _mm_set1_epi16(0x00FF);
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i + 16));
+    const __m128i y = Y0 ? _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8))
+                         : _mm_packus_epi16(_mm_and_si128(a, low8), _mm_and_si128(b, low8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(mono + i), y);
+  }
+#endif
+  for (; i < n; ++i)
+    mono[i] = src[2 * i + Y0];
+}
+
+
+template <unsigned Y0, unsigned C0>
+inline void
+rgb_to_yuv422(const vxl_byte * rgb, vxl_byte * dst, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i cy = _mm_set_epi16(0, 117, 601, 306, 0, 117, 601, 306);
+  const __m128i cu = _mm_set_epi16(0, 512, -340, -172, 0, 512, -340, -172);
+  const __m128i cv = _mm_set_epi16(0, -83, -429, 512, 0, -83, -429, 512);
+  const __m128i c128 = _mm_set1_epi32(128);
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i q0, q1;
+    load_rgb_sse2(rgb + 3 * i, q0, q1);
+    const __m128i y = _mm_packs_epi32(_mm_srai_epi32(dot_rgb_sse2(q0, cy), 10), _mm_srai_epi32(dot_rgb_sse2(q1, cy), 10));
+    const __m128i u0 = _mm_add_epi32(_mm_srai_epi32(dot_rgb_sse2(q0, cu), 10), c128);
+    const __m128i u1 = _mm_add_epi32(_mm_srai_epi32(dot_rgb_sse2(q1, cu), 10), c128);
+    const __m128i v0 = _mm_add_epi32(_mm_srai_epi32(dot_rgb_sse2(q0, cv), 10), c128);
+    const __m128i v1 = _mm_add_epi32(_mm_srai_epi32(dot_rgb_sse2(q1, cv), 10), c128);
+    const __m128i uv = _mm_packs_epi32(pair_chroma_sse2(u0, v0), pair_chroma_sse2(u1, v1));
+    const __m128i m = Y0 ? _mm_or_si128(uv, _mm_slli_epi16(y, 8)) : _mm_or_si128(y, _mm_slli_epi16(uv, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), m);
+  }
+#endif
+  rgb_to_yuv422_scalar<Y0, C0>(rgb, dst, i, n);
+}
+
+
+template <unsigned R0>
+inline void
+rgb_to_mono(const vxl_byte * rgb, vxl_byte * mono, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i cy = R0 ? _mm_set_epi16(0, 306, 601, 117, 0, 306, 601, 117)
+                        : _mm_set_epi16(0, 117, 601, 306, 0, 117, 601, 306);
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i q0, q1;
+    load_rgb_sse2(rgb + 3 * i, q0, q1);
+    const __m128i y = _mm_packs_epi32(_mm_srli_epi32(dot_rgb_sse2(q0, cy), 10), _mm_srli_epi32(dot_rgb_sse2(q1, cy), 10));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(mono + i), _mm_packus_epi16(y, y));
+  }
+#endif
+  rgb_to_mono_scalar<R0>(rgb, mono, i, n);
+}
+
+} // namespace
+
+
+//: Convert UYVY 4:2:2 to interleaved RGB
+void
+vidl_convert_row_uyvy_to_rgb(const vxl_byte * uyvy, vxl_byte * rgb, unsigned n)
+{
+  yuv422_to_rgb<1, 0>(uyvy, rgb, n);
+}
+
+
+//: Convert YUYV 4:2:2 to interleaved RGB
+void
+vidl_convert_row_yuyv_to_rgb(const vxl_byte * yuyv, vxl_byte * rgb, unsigned n)
+{
+  yuv422_to_rgb<0, 1>(yuyv, rgb, n);
+}
+
+
+//: Extract the luma of UYVY 4:2:2
+void
+vidl_convert_row_uyvy_to_mono(const vxl_byte * uyvy, vxl_byte * mono, unsigned n)
+{
+  yuv422_to_mono<1>(uyvy, mono, n);
+}
+
+
+//: Extract the luma of YUYV 4:2:2
+void
+vidl_convert_row_yuyv_to_mono(const vxl_byte * yuyv, vxl_byte * mono, unsigned n)
+{
+  yuv422_to_mono<0>(yuyv, mono, n);
+}
+
+
+//: Convert planar YUV with half width chroma (as in YUV_420P and YUV_422P) to interleaved RGB
+void
+vidl_convert_row_yuvp_to_rgb(const vxl_byte * y, const vxl_byte * u, const vxl_byte * v, vxl_byte * rgb, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8)
+  {
+    vxl_uint_32 u4, v4;
+    std::memcpy(&u4, u + i / 2, 4);
+    std::memcpy(&v4, v + i / 2, 4);
+    const __m128i uv = _mm_unpacklo_epi8(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(u4)), _mm_cvtsi32_si128(static_cast<int>(v4))), zero);
+    const __m128i y8 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + i)), zero);
+    yuv_to_rgb_sse2(y8, uv, rgb + 3 * i);
+  }
+#endif
+  for (vxl_byte * p = rgb + 3 * i; i < n; ++i, p += 3)
+    vidl_color_convert_yuv2rgb(y[i], u[i / 2], v[i / 2], p[0], p[1], p[2]);
+}
+
+
+//: Convert interleaved RGB to UYVY 4:2:2, averaging the chroma of each pair of pixels
+void
+vidl_convert_row_rgb_to_uyvy(const vxl_byte * rgb, vxl_byte * uyvy, unsigned n)
+{
+  rgb_to_yuv422<1, 0>(rgb, uyvy, n);
+}
+
+
+//: Convert interleaved RGB to YUYV 4:2:2, averaging the chroma of each pair of pixels
+void
+vidl_convert_row_rgb_to_yuyv(const vxl_byte * rgb, vxl_byte * yuyv, unsigned n)
+{
+  rgb_to_yuv422<0, 1>(rgb, yuyv, n);
+}
+
+
+//: Convert interleaved RGB to monochrome
+void
+vidl_convert_row_rgb_to_mono(const vxl_byte * rgb, vxl_byte * mono, unsigned n)
+{
+  rgb_to_mono<0>(rgb, mono, n);
+}
+
+
+//: Convert interleaved BGR to monochrome
+void
+vidl_convert_row_bgr_to_mono(const vxl_byte * bgr, vxl_byte * mono, unsigned n)
+{
+  rgb_to_mono<2>(bgr, mono, n);
+}
+
+
+//: Swap the first and third channels of interleaved RGB (or BGR)
+void
+vidl_convert_row_swap_rb(const vxl_byte * in, vxl_byte * out, unsigned n)
+{
+  for (unsigned i = 0; i < n; ++i, in += 3, out += 3)
+  {
+    const vxl_byte first = in[0];
+    out[0] = in[2];
+    out[1] = in[1];
+    out[2] = first;
+  }
+}
+
+
+//: Convert 16 bit to 8 bit monochrome, keeping the high byte
+void
+vidl_convert_row_mono16_to_mono(const vxl_uint_16 * in, vxl_byte * out, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+  }
+#endif
+  for (; i < n; ++i)
+    vidl_type_convert(in[i], out[i]);
+}
+
+
+//: Convert 8 bit to 16 bit monochrome, as the high byte
+void
+vidl_convert_row_mono_to_mono16(const vxl_byte * in, vxl_uint_16 * out, unsigned n)
+{
+  unsigned i = 0;
+#ifdef VXL_HAS_SSE2_HARDWARE_SUPPORT
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(zero, a));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(zero, a));
+  }
+#endif
+  for (; i < n; ++i)
+    vidl_type_convert(in[i], out[i]);
+}
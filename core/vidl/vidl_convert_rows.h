@@ -0,0 +1,75 @@
+// This is core/vidl/vidl_convert_rows.h
+#ifndef vidl_convert_rows_h_
+#define vidl_convert_rows_h_
+//:
+// \file
+// \brief Conversion of rows of pixels between the common 8 bit formats
+//
+// These kernels convert \p n contiguous pixels at a time, and are the
+// building blocks of the fast paths in vidl_convert_frame and
+// vidl_convert_to_view.  Where SSE2 is available they work on 8 or 16
+// pixels at once.  In all cases the results are exactly those of the
+// integer per pixel functions in vidl_color.h, so it makes no difference
+// to the output whether a conversion goes through here or through the
+// generic pixel iterators.
+//
+// Packed 4:2:2 rows (UYVY and YUYV) start on a macropixel.  If \p n is
+// odd the last macropixel only holds the Y and U of the last pixel,
+// and that pixel is given a neutral V.
+
+#include <vxl_config.h>
+#include <vidl/vidl_export.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Convert UYVY 4:2:2 to interleaved RGB
+VIDL_EXPORT void
+vidl_convert_row_uyvy_to_rgb(const vxl_byte * uyvy, vxl_byte * rgb, unsigned n);
+
+//: Convert YUYV 4:2:2 to interleaved RGB
+VIDL_EXPORT void
+vidl_convert_row_yuyv_to_rgb(const vxl_byte * yuyv, vxl_byte * rgb, unsigned n);
+
+//: Extract the luma of UYVY 4:2:2
+VIDL_EXPORT void
+vidl_convert_row_uyvy_to_mono(const vxl_byte * uyvy, vxl_byte * mono, unsigned n);
+
+//: Extract the luma of YUYV 4:2:2
+VIDL_EXPORT void
+vidl_convert_row_yuyv_to_mono(const vxl_byte * yuyv, vxl_byte * mono, unsigned n);
+
+//: Convert planar YUV with half width chroma (as in YUV_420P and YUV_422P) to interleaved RGB
+//  \p u and \p v hold (n+1)/2 values; pixel i takes the chroma at i/2.
+VIDL_EXPORT void
+vidl_convert_row_yuvp_to_rgb(const vxl_byte * y, const vxl_byte * u, const vxl_byte * v, vxl_byte * rgb, unsigned n);
+
+//: Convert interleaved RGB to UYVY 4:2:2, averaging the chroma of each pair of pixels
+VIDL_EXPORT void
+vidl_convert_row_rgb_to_uyvy(const vxl_byte * rgb, vxl_byte * uyvy, unsigned n);
+
+//: Convert interleaved RGB to YUYV 4:2:2, averaging the chroma of each pair of pixels
+VIDL_EXPORT void
+vidl_convert_row_rgb_to_yuyv(const vxl_byte * rgb, vxl_byte * yuyv, unsigned n);
+
+//: Convert interleaved RGB to monochrome
+VIDL_EXPORT void
+vidl_convert_row_rgb_to_mono(const vxl_byte * rgb, vxl_byte * mono, unsigned n);
+
+//: Convert interleaved BGR to monochrome
+VIDL_EXPORT void
+vidl_convert_row_bgr_to_mono(const vxl_byte * bgr, vxl_byte * mono, unsigned n);
+
+//: Swap the first and third channels of interleaved RGB (or BGR)
+VIDL_EXPORT void
+vidl_convert_row_swap_rb(const vxl_byte * in, vxl_byte * out, unsigned n);
+
+//: Convert 16 bit to 8 bit monochrome, keeping the high byte
+VIDL_EXPORT void
+vidl_convert_row_mono16_to_mono(const vxl_uint_16 * in, vxl_byte * out, unsigned n);
+
+//: Convert 8 bit to 16 bit monochrome, as the high byte
+VIDL_EXPORT void
+vidl_convert_row_mono_to_mono16(const vxl_byte * in, vxl_uint_16 * out, unsigned n);
+
+#endif // vidl_convert_rows_h_
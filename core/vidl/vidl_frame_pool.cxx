@@ -0,0 +1,78 @@
+// This is core/vidl/vidl_frame_pool.cxx
+//:
+// \file
+//
+//-----------------------------------------------------------------------------
+
+#include <cstring>
+#include "vidl_frame_pool.h"
+#include "vidl_frame.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: Return a frame of the given size and format
+vidl_frame_sptr
+vidl_frame_pool::acquire(unsigned ni, unsigned nj, vidl_pixel_format fmt)
+{
+  const unsigned long size = vidl_pixel_format_buffer_size(ni, nj, fmt);
+  vil_memory_chunk_sptr chunk;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A chunk referred to only by the pool is free: nothing else can
+    // take a new reference to it, so it is safe to hand out.
+    for (const auto & c : chunks_)
+      if (c->ref_count() == 1 && c->size() == size)
+      {
+        chunk = c;
+        break;
+      }
+    if (!chunk)
+    {
+      chunk = new vil_memory_chunk(size, VIL_PIXEL_FORMAT_BYTE);
+      ++num_allocated_;
+      if (chunks_.size() < max_size_)
+        chunks_.push_back(chunk);
+      else
+      {
+        // Replace a free chunk of the wrong size, if there is one.
+        for (auto & c : chunks_)
+          if (c->ref_count() == 1)
+          {
+            c = chunk;
+            break;
+          }
+      }
+    }
+  }
+  return new vidl_memory_chunk_frame(ni, nj, fmt, chunk);
+}
+
+
+//: Return a copy of \p frame in a frame from the pool
+vidl_frame_sptr
+vidl_frame_pool::copy(const vidl_frame & frame)
+{
+  vidl_frame_sptr f = acquire(frame.ni(), frame.nj(), frame.pixel_format());
+  if (frame.data() && frame.size() == f->size())
+    std::memcpy(f->data(), frame.data(), f->size());
+  return f;
+}
+
+
+//: Number of buffers held for reuse (free or in use)
+unsigned int
+vidl_frame_pool::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<unsigned int>(chunks_.size());
+}
+
+
+//: Release all the buffers held for reuse
+void
+vidl_frame_pool::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  chunks_.clear();
+}
@@ -0,0 +1,64 @@
+// This is core/vidl/vidl_frame_pool.h
+#ifndef vidl_frame_pool_h_
+#define vidl_frame_pool_h_
+//:
+// \file
+// \brief A pool of frame buffers that are reused once released
+//
+// Allocating a new buffer for every frame of a video, only to free it
+// again a frame or two later, is wasteful.  A vidl_frame_pool hands out
+// vidl_memory_chunk_frame objects whose memory is taken from chunks that
+// nothing else refers to any more (neither frames nor image views
+// wrapping them), and only allocates when there are none of the right
+// size.  acquire() may be called from any thread.
+
+#include <mutex>
+#include <vector>
+#include "vidl_frame_sptr.h"
+#include "vidl_pixel_format.h"
+#include <vil/vil_memory_chunk.h>
+
+//: A pool of frame buffers that are reused once released
+class VIDL_EXPORT vidl_frame_pool
+{
+public:
+  //: Constructor
+  // \param max_size  the largest number of buffers kept for reuse
+  explicit vidl_frame_pool(unsigned int max_size = 16)
+    : max_size_(max_size)
+  {}
+
+  //: Return a frame of the given size and format
+  // The frame's memory is recycled if possible; its contents are undefined.
+  vidl_frame_sptr
+  acquire(unsigned ni, unsigned nj, vidl_pixel_format fmt);
+
+  //: Return a copy of \p frame in a frame from the pool
+  vidl_frame_sptr
+  copy(const vidl_frame & frame);
+
+  //: Number of buffers held for reuse (free or in use)
+  unsigned int
+  size() const;
+
+  //: Number of buffers allocated, rather than reused, since construction
+  unsigned int
+  num_allocated() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_allocated_;
+  }
+
+  //: Release all the buffers held for reuse
+  // Frames that are still in use keep their memory.
+  void
+  clear();
+
+private:
+  unsigned int max_size_;
+  unsigned int num_allocated_{ 0 };
+  std::vector<vil_memory_chunk_sptr> chunks_;
+  mutable std::mutex mutex_;
+};
+
+#endif // vidl_frame_pool_h_
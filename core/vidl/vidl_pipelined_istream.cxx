@@ -0,0 +1,209 @@
+// This is core/vidl/vidl_pipelined_istream.cxx
+//:
+// \file
+//
+//-----------------------------------------------------------------------------
+
+#include "vidl_pipelined_istream.h"
+#include "vidl_frame.h"
+#include "vidl_convert.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vil/vil_image_view.h>
+
+
+//: Constructor - wrap \p source, decoding up to \p num_ahead frames ahead
+vidl_pipelined_istream::vidl_pipelined_istream(const vidl_istream_sptr & source, unsigned int num_ahead)
+  : source_(source && source->is_open() ? source : nullptr)
+  , num_ahead_(num_ahead > 0 ? num_ahead : 1)
+  , is_seekable_(false)
+  , num_frames_(-1)
+  , width_(0)
+  , height_(0)
+  , format_(VIDL_PIXEL_FORMAT_UNKNOWN)
+  , frame_rate_(0.0)
+  , duration_(0.0)
+  , current_(nullptr)
+  , frame_number_(static_cast<unsigned int>(-1))
+  , valid_(false)
+  , pool_(num_ahead_ + 4)
+{
+  if (!source_)
+    return;
+  is_seekable_ = source_->is_seekable();
+  num_frames_ = source_->num_frames();
+  width_ = source_->width();
+  height_ = source_->height();
+  format_ = source_->format();
+  frame_rate_ = source_->frame_rate();
+  duration_ = source_->duration();
+  // Start where the source is.
+  frame_number_ = source_->frame_number();
+  valid_ = source_->is_valid();
+  if (valid_)
+    current_ = detach(source_->current_frame());
+}
+
+
+//: A frame that does not share the source's buffer or frame object
+// The frame reference counts are not thread safe, so even a frame that
+// owns its memory is given a new frame object for the caller.
+vidl_frame_sptr
+vidl_pipelined_istream::detach(const vidl_frame_sptr & frame)
+{
+  if (!frame)
+    return nullptr;
+  if (const auto * cf = dynamic_cast<const vidl_memory_chunk_frame *>(frame.ptr()))
+    if (cf->memory_chunk())
+      return new vidl_memory_chunk_frame(cf->ni(), cf->nj(), cf->pixel_format(), cf->memory_chunk());
+  return pool_.copy(*frame);
+}
+
+
+//: The loop run by the background thread
+void
+vidl_pipelined_istream::decode_loop()
+{
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stopping_ || queue_.size() < num_ahead_; });
+      if (stopping_)
+        return;
+    }
+    item next;
+    next.valid = source_->advance();
+    next.number = source_->frame_number();
+    next.frame = next.valid ? detach(source_->current_frame()) : nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(next);
+      if (!next.valid)
+        finished_ = true;
+    }
+    cond_.notify_all();
+    if (!next.valid)
+      return;
+  }
+}
+
+
+//: Start decoding ahead, if not already started
+void
+vidl_pipelined_istream::start()
+{
+  if (running_ || !source_)
+    return;
+  stopping_ = false;
+  finished_ = false;
+  running_ = true;
+  thread_ = std::thread(&vidl_pipelined_istream::decode_loop, this);
+}
+
+
+//: Stop decoding ahead and drop the frames decoded
+void
+vidl_pipelined_istream::stop()
+{
+  if (!running_)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cond_.notify_all();
+  thread_.join();
+  running_ = false;
+  queue_.clear();
+}
+
+
+//: Stop decoding and release the source
+void
+vidl_pipelined_istream::close()
+{
+  if (!source_)
+    return;
+  const bool decoded_ahead = running_;
+  stop();
+  if (decoded_ahead && is_seekable_ && valid_)
+    source_->seek_frame(frame_number_);
+  source_ = nullptr;
+  current_ = nullptr;
+  valid_ = false;
+  pool_.clear();
+}
+
+
+//: Advance to the next frame
+bool
+vidl_pipelined_istream::advance()
+{
+  if (!source_)
+    return false;
+  start();
+  item next;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return !queue_.empty(); });
+    next = queue_.front();
+    // Leave the end of the stream in the queue for later calls.
+    if (next.valid)
+      queue_.pop_front();
+  }
+  cond_.notify_all();
+  current_ = next.frame;
+  frame_number_ = next.number;
+  valid_ = next.valid;
+  return valid_;
+}
+
+
+//: Read the next frame from the stream (advance and acquire)
+vidl_frame_sptr
+vidl_pipelined_istream::read_frame()
+{
+  advance();
+  return current_frame();
+}
+
+
+//: Return the current frame as an image view
+vil_image_view_base_sptr
+vidl_pipelined_istream::current_view()
+{
+  if (!valid_ || !current_)
+    return nullptr;
+  vil_image_view_base_sptr view = vidl_convert_wrap_in_view(*current_);
+  if (view)
+    return view;
+  // The buffer can not be wrapped (e.g. YUV 4:2:2), so convert it.
+  const std::type_info & type = vidl_pixel_format_typeid(current_->pixel_format());
+  if (type == typeid(vxl_uint_16))
+    view = new vil_image_view<vxl_uint_16>;
+  else if (type == typeid(vxl_ieee_32))
+    view = new vil_image_view<float>;
+  else if (type == typeid(bool))
+    view = new vil_image_view<bool>;
+  else
+    view = new vil_image_view<vxl_byte>;
+  return vidl_convert_to_view(*current_, *view) ? view : nullptr;
+}
+
+
+//: Seek to the given frame number
+bool
+vidl_pipelined_istream::seek_frame(unsigned int frame_nr)
+{
+  if (!source_ || !is_seekable_)
+    return false;
+  stop();
+  // Decoding ahead restarts from wherever the source is left.
+  const bool ok = source_->seek_frame(frame_nr);
+  frame_number_ = source_->frame_number();
+  valid_ = source_->is_valid();
+  current_ = valid_ ? detach(source_->current_frame()) : nullptr;
+  return ok;
+}
@@ -0,0 +1,212 @@
+// This is core/vidl/vidl_pipelined_istream.h
+#ifndef vidl_pipelined_istream_h_
+#define vidl_pipelined_istream_h_
+//:
+// \file
+// \brief An input stream that decodes frames ahead on a background thread
+//
+// vidl_istream::advance() and read_frame() decode on the caller's thread,
+// so a processing loop stops while each frame is read.  This stream wraps
+// another one and keeps up to N frames decoded ahead of the caller on a
+// background thread, so that the loop only waits if it is faster than
+// the decoder.
+//
+// Frames whose buffers belong to the source (such as the vidl_shared_frame
+// buffers of vidl_ffmpeg_istream, which are overwritten by the next
+// advance()) are copied into buffers from a vidl_frame_pool, which are
+// reused once the caller lets go of them.  Frames that own their memory
+// (vidl_memory_chunk_frame, as vidl_image_list_istream gives) are passed
+// on without a copy.  current_view() wraps the current frame in a
+// vil_image_view without a copy where the pixel format allows.
+//
+// While decoding ahead the source is used only by the background thread,
+// so it must not be used directly until this stream is closed.  Closing
+// (or destroying) this stream seeks a seekable source back to the frame
+// last returned, so that the two agree on the position.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "vidl_istream.h"
+#include "vidl_istream_sptr.h"
+#include "vidl_frame_pool.h"
+#include <vil/vil_image_view_base.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: An input stream that decodes frames ahead on a background thread
+class VIDL_EXPORT vidl_pipelined_istream : public vidl_istream
+{
+public:
+  //: Constructor - wrap \p source, decoding up to \p num_ahead frames ahead
+  explicit vidl_pipelined_istream(const vidl_istream_sptr & source, unsigned int num_ahead = 4);
+
+  //: Destructor
+  ~vidl_pipelined_istream() override { close(); }
+
+  //: Return true if the stream is open for reading
+  bool
+  is_open() const override
+  {
+    return bool(source_);
+  }
+
+  //: Return true if the stream is in a valid state
+  bool
+  is_valid() const override
+  {
+    return is_open() && valid_;
+  }
+
+  //: Return true if the stream supports seeking
+  bool
+  is_seekable() const override
+  {
+    return is_seekable_;
+  }
+
+  //: Return the number of frames if known
+  //  returns -1 for non-seekable streams
+  int
+  num_frames() const override
+  {
+    return num_frames_;
+  }
+
+  //: Return the current frame number
+  unsigned int
+  frame_number() const override
+  {
+    return frame_number_;
+  }
+
+  //: Return the width of each frame
+  unsigned int
+  width() const override
+  {
+    return width_;
+  }
+
+  //: Return the height of each frame
+  unsigned int
+  height() const override
+  {
+    return height_;
+  }
+
+  //: Return the pixel format
+  vidl_pixel_format
+  format() const override
+  {
+    return format_;
+  }
+
+  //: Return the frame rate (FPS, 0.0 if unspecified)
+  double
+  frame_rate() const override
+  {
+    return frame_rate_;
+  }
+
+  //: Return the duration in seconds (0.0 if unknown)
+  double
+  duration() const override
+  {
+    return duration_;
+  }
+
+  //: Stop decoding and release the source
+  // The source is not closed, but a seekable source is returned to the
+  // frame last returned by this stream.
+  void
+  close() override;
+
+  //: Advance to the next frame
+  bool
+  advance() override;
+
+  //: Read the next frame from the stream (advance and acquire)
+  vidl_frame_sptr
+  read_frame() override;
+
+  //: Return the current frame in the stream
+  vidl_frame_sptr
+  current_frame() override
+  {
+    return valid_ ? current_ : nullptr;
+  }
+
+  //: Return the current frame as an image view
+  // The frame buffer is wrapped without a copy if the pixel format allows,
+  // and otherwise converted (see vidl_convert_to_view).
+  // Returns a null pointer if there is no current frame.
+  vil_image_view_base_sptr
+  current_view();
+
+  //: Seek to the given frame number
+  // \returns true if successful
+  bool
+  seek_frame(unsigned int frame_number) override;
+
+  //: The pool of buffers that frames are copied into
+  const vidl_frame_pool &
+  frame_pool() const
+  {
+    return pool_;
+  }
+
+private:
+  //: A decoded frame, as the source gave it
+  struct item
+  {
+    unsigned int number;
+    vidl_frame_sptr frame;
+    bool valid;
+  };
+
+  //: Start decoding ahead, if not already started
+  void
+  start();
+
+  //: Stop decoding ahead and drop the frames decoded
+  void
+  stop();
+
+  //: The loop run by the background thread
+  void
+  decode_loop();
+
+  //: A frame that does not share the source's buffer or frame object
+  vidl_frame_sptr
+  detach(const vidl_frame_sptr & frame);
+
+  vidl_istream_sptr source_;
+  unsigned int num_ahead_;
+
+  //: Stream properties, read before decoding starts
+  bool is_seekable_;
+  int num_frames_;
+  unsigned int width_;
+  unsigned int height_;
+  vidl_pixel_format format_;
+  double frame_rate_;
+  double duration_;
+
+  //: The frame last returned to the caller
+  vidl_frame_sptr current_;
+  unsigned int frame_number_;
+  bool valid_;
+
+  vidl_frame_pool pool_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<item> queue_;
+  bool running_{ false };
+  bool stopping_{ false };
+  bool finished_{ false };
+};
+
+#endif // vidl_pipelined_istream_h_
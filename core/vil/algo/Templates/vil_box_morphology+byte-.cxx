@@ -0,0 +1,3 @@
+#include "vxl_config.h"
+#include <vil/algo/vil_box_morphology.hxx>
+VIL_BOX_MORPHOLOGY_INSTANTIATE(vxl_byte);
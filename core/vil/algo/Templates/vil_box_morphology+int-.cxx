@@ -0,0 +1,2 @@
+#include <vil/algo/vil_box_morphology.hxx>
+VIL_BOX_MORPHOLOGY_INSTANTIATE(int);
@@ -0,0 +1,3 @@
+#include "vxl_config.h"
+#include <vil/algo/vil_rank_filter.hxx>
+VIL_RANK_FILTER_INSTANTIATE(vxl_byte);
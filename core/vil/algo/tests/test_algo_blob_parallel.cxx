@@ -0,0 +1,151 @@
+// This is core/vil/algo/tests/test_algo_blob_parallel.cxx
+#include <iostream>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "testlib/testlib_test.h"
+#include <vil/algo/vil_blob.h>
+#include <vil/algo/vil_blob_parallel.h>
+#include "vil/vil_blocked_image_resource.h"
+#include "vil/vil_new.h"
+#include <vpl/vpl_thread_pool.h>
+
+//: Random mask with blobs of all shapes; density p percent.
+static vil_image_view<bool>
+random_mask(unsigned ni, unsigned nj, unsigned p, unsigned seed)
+{
+  vil_image_view<bool> mask(ni, nj);
+  unsigned long x = seed;
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      x = x * 1103515245ul + 12345ul;
+      mask(i, j) = ((x >> 16) % 100) < p;
+    }
+  return mask;
+}
+
+static bool
+same_labels(const vil_image_view<unsigned> & a, const vil_image_view<unsigned> & b)
+{
+  if (a.ni() != b.ni() || a.nj() != b.nj())
+    return false;
+  for (unsigned j = 0; j < a.nj(); ++j)
+    for (unsigned i = 0; i < a.ni(); ++i)
+      if (a(i, j) != b(i, j))
+        return false;
+  return true;
+}
+
+//: Check the statistics against the label image.
+static bool
+stats_ok(const vil_image_view<unsigned> & labels, const std::vector<vil_blob_stats> & stats)
+{
+  std::vector<vil_blob_stats> ref;
+  for (unsigned j = 0; j < labels.nj(); ++j)
+    for (unsigned i = 0; i < labels.ni(); ++i)
+    {
+      const unsigned l = labels(i, j);
+      if (!l)
+        continue;
+      if (l > ref.size())
+        ref.resize(l);
+      vil_blob_stats & s = ref[l - 1];
+      if (s.area++ == 0)
+      {
+        s.i_min = s.i_max = i;
+        s.j_min = s.j_max = j;
+      }
+      s.i_min = std::min(s.i_min, i);
+      s.i_max = std::max(s.i_max, i);
+      s.j_max = j;
+    }
+  if (ref.size() != stats.size())
+    return false;
+  for (unsigned k = 0; k < ref.size(); ++k)
+    if (ref[k].area != stats[k].area || ref[k].i_min != stats[k].i_min || ref[k].i_max != stats[k].i_max ||
+        ref[k].j_min != stats[k].j_min || ref[k].j_max != stats[k].j_max)
+      return false;
+  return true;
+}
+
+static void
+test_in_memory(vil_blob_connectivity conn, const char * name)
+{
+  std::cout << "In memory, " << name << '\n';
+  const unsigned sizes[] = { 1, 7, 32, 1000 };
+  const unsigned densities[] = { 30, 55, 70 };
+  for (unsigned p : densities)
+  {
+    const vil_image_view<bool> mask = random_mask(203, 151, p, p);
+    vil_image_view<unsigned> ref;
+    vil_blob_labels(mask, conn, ref);
+    for (unsigned ts : sizes)
+    {
+      vil_image_view<unsigned> labels;
+      std::vector<vil_blob_stats> stats;
+      vil_blob_labels_parallel(mask, conn, labels, stats, ts);
+      std::cout << "density " << p << "%, tile size " << ts << ": " << stats.size() << " blobs\n";
+      TEST("labels equal vil_blob_labels", same_labels(labels, ref), true);
+      TEST("statistics", stats_ok(labels, stats), true);
+    }
+  }
+  // A spiral: one blob crossing every tile seam many times.
+  vil_image_view<bool> spiral(64, 64);
+  spiral.fill(false);
+  for (unsigned r = 0; r < 16; ++r)
+  {
+    const unsigned lo = 2 * r, hi = 63 - 2 * r;
+    for (unsigned k = lo; k <= hi; ++k)
+    {
+      spiral(k, lo) = spiral(hi, k) = spiral(k, hi) = true;
+      if (k > lo + 1)
+        spiral(lo, k) = true;
+    }
+    if (lo + 2 <= hi)
+      spiral(lo + 1, lo + 2) = true;
+  }
+  vil_image_view<unsigned> ref, labels;
+  vil_blob_labels(spiral, conn, ref);
+  vil_blob_labels_parallel(spiral, conn, labels);
+  TEST("spiral", same_labels(labels, ref), true);
+}
+
+static void
+test_blocked(vil_blob_connectivity conn)
+{
+  const unsigned ni = 157, nj = 121;
+  const vil_image_view<bool> mask = random_mask(ni, nj, 55, 3);
+  vil_image_view<vxl_byte> bytes(ni, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      bytes(i, j) = mask(i, j) ? 255 : 0;
+  vil_image_resource_sptr src_mem = vil_new_image_resource_of_view(bytes);
+  vil_image_resource_sptr dest_mem = vil_new_image_resource(ni, nj, 1, VIL_PIXEL_FORMAT_UINT_32);
+  vil_blocked_image_resource_sptr src = vil_new_blocked_image_facade(src_mem, 37, 29);
+  vil_blocked_image_resource_sptr dest = vil_new_blocked_image_facade(dest_mem, 37, 29);
+
+  std::vector<vil_blob_stats> stats;
+  TEST("blocked labelling succeeds", vil_blob_labels_blocked(src, conn, dest, stats), true);
+  vil_image_view<unsigned> ref, labels = dest_mem->get_view();
+  vil_blob_labels(mask, conn, ref);
+  TEST("blocked labels equal vil_blob_labels", same_labels(labels, ref), true);
+  TEST("blocked statistics", stats_ok(labels, stats), true);
+
+  vil_blocked_image_resource_sptr bad = vil_new_blocked_image_facade(src_mem, 16, 16);
+  TEST("mismatched blocking rejected", vil_blob_labels_blocked(src, conn, bad, stats), false);
+}
+
+static void
+test_algo_blob_parallel()
+{
+  vpl_set_concurrency(4);
+  test_in_memory(vil_blob_4_conn, "4-connected");
+  test_in_memory(vil_blob_8_conn, "8-connected");
+  test_blocked(vil_blob_4_conn);
+  test_blocked(vil_blob_8_conn);
+  vpl_set_concurrency(0);
+}
+
+TESTMAIN(test_algo_blob_parallel);
@@ -0,0 +1,164 @@
+// This is core/vil/algo/tests/test_algo_box_morphology.cxx
+#include <iostream>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "testlib/testlib_test.h"
+#include "vxl_config.h"
+#include <vil/algo/vil_box_morphology.h>
+#include <vil/algo/vil_binary_dilate.h>
+#include <vil/algo/vil_binary_erode.h>
+#include <vil/algo/vil_greyscale_dilate.h>
+#include <vil/algo/vil_greyscale_erode.h>
+
+static vil_structuring_element
+box_element(int ilo, int ihi, int jlo, int jhi)
+{
+  std::vector<int> pi, pj;
+  for (int j = jlo; j <= jhi; ++j)
+    for (int i = ilo; i <= ihi; ++i)
+    {
+      pi.push_back(i);
+      pj.push_back(j);
+    }
+  return vil_structuring_element(pi, pj);
+}
+
+static unsigned long
+next_random(unsigned long & x)
+{
+  x = x * 1103515245ul + 12345ul;
+  return x >> 8;
+}
+
+template <class T>
+static bool
+same_image(const vil_image_view<T> & a, const vil_image_view<T> & b)
+{
+  if (a.ni() != b.ni() || a.nj() != b.nj() || a.nplanes() != b.nplanes())
+    return false;
+  for (unsigned p = 0; p < a.nplanes(); ++p)
+    for (unsigned j = 0; j < a.nj(); ++j)
+      for (unsigned i = 0; i < a.ni(); ++i)
+        if (a(i, j, p) != b(i, j, p))
+          return false;
+  return true;
+}
+
+//: Pixel by pixel binary dilation or erosion, with a constant border.
+static vil_image_view<bool>
+binary_reference(const vil_image_view<bool> & src, const vil_structuring_element & element, bool dilate)
+{
+  const vil_border<vil_image_view<bool>> border = vil_border_create_constant(src, !dilate);
+  const vil_border_accessor<vil_image_view<bool>> accessor = vil_border_create_accessor(src, border);
+  vil_image_view<bool> dest(src.ni(), src.nj());
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+      dest(i, j) = dilate ? vil_binary_dilate(accessor, 0, element, i, j) : vil_binary_erode(accessor, 0, element, i, j);
+  return dest;
+}
+
+static const int boxes[][4] = { { 0, 0, 0, 0 },    { -1, 1, -1, 1 },   { -3, 0, 0, 2 },   { 0, 5, -4, 0 },
+                                { -9, 9, -9, 9 },  { -63, 1, 0, 0 },   { 0, 0, -20, 3 },  { -64, 64, -1, 1 },
+                                { -150, 10, -2, 60 } };
+
+template <class T>
+static void
+test_greyscale(const char * type_name)
+{
+  std::cout << "Greyscale box morphology on " << type_name << '\n';
+  unsigned long x = 7;
+  vil_image_view<T> src(131, 47);
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+      src(i, j) = T(next_random(x) % 200) - T(50);
+
+  for (const auto & b : boxes)
+  {
+    const vil_structuring_element element = box_element(b[0], b[1], b[2], b[3]);
+    vil_image_view<T> fast, ref(src.ni(), src.nj());
+    vil_greyscale_dilate_box(src, fast, b[0], b[1], b[2], b[3]);
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        ref(i, j) = vil_greyscale_dilate(src, 0, element, i, j);
+    std::cout << "box [" << b[0] << ',' << b[1] << "]x[" << b[2] << ',' << b[3] << "]\n";
+    TEST("dilation", same_image(fast, ref), true);
+
+    vil_greyscale_erode_box(src, fast, b[0], b[1], b[2], b[3]);
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        ref(i, j) = vil_greyscale_erode(src, 0, element, i, j);
+    TEST("erosion", same_image(fast, ref), true);
+  }
+
+  // vil_greyscale_dilate uses the box method for rectangles, on views with any steps.
+  vil_image_view<T> transposed(src.nj(), src.ni());
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+      transposed(j, i) = src(i, j);
+  vil_image_view<T> view(transposed.memory_chunk(),
+                         transposed.top_left_ptr(),
+                         src.ni(),
+                         src.nj(),
+                         1,
+                         transposed.jstep(),
+                         transposed.istep(),
+                         transposed.planestep());
+  const vil_structuring_element element = box_element(-2, 3, -1, 4);
+  vil_image_view<T> a, b;
+  vil_greyscale_dilate(view, a, element);
+  vil_greyscale_dilate_box(src, b, -2, 3, -1, 4);
+  TEST("vil_greyscale_dilate on transposed view", same_image(a, b), true);
+}
+
+static void
+test_binary()
+{
+  std::cout << "Binary box morphology\n";
+  const unsigned sizes[][2] = { { 1, 1 }, { 64, 5 }, { 65, 9 }, { 200, 31 } };
+  for (const auto & sz : sizes)
+  {
+    unsigned long x = sz[0];
+    vil_image_view<bool> src(sz[0], sz[1]);
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        src(i, j) = next_random(x) % 100 < 15;
+    std::cout << "Image " << sz[0] << 'x' << sz[1] << '\n';
+    bool dilate_ok = true, erode_ok = true;
+    for (const auto & b : boxes)
+    {
+      const vil_structuring_element element = box_element(b[0], b[1], b[2], b[3]);
+      vil_image_view<bool> fast;
+      vil_binary_dilate_box(src, fast, b[0], b[1], b[2], b[3]);
+      const vil_image_view<bool> dilated = binary_reference(src, element, true);
+      dilate_ok = dilate_ok && same_image(fast, dilated);
+      // Erode the dilated image, which has large true regions.
+      vil_binary_erode_box(dilated, fast, b[0], b[1], b[2], b[3]);
+      erode_ok = erode_ok && same_image(fast, binary_reference(dilated, element, false));
+    }
+    TEST("binary dilation", dilate_ok, true);
+    TEST("binary erosion", erode_ok, true);
+  }
+
+  vil_image_view<bool> src(100, 20), a, b;
+  src.fill(false);
+  src(50, 10) = true;
+  vil_structuring_element line;
+  line.set_to_line_i(-70, 0);
+  vil_binary_dilate(src, a, line);
+  b = binary_reference(src, line, true);
+  TEST("vil_binary_dilate with a line", same_image(a, b), true);
+  TEST("line reaches right edge", a(99, 10) && a(50, 10) && !a(49, 10) && !a(99, 9), true);
+}
+
+static void
+test_algo_box_morphology()
+{
+  test_greyscale<vxl_byte>("vxl_byte");
+  test_greyscale<float>("float");
+  test_greyscale<int>("int");
+  test_binary();
+}
+
+TESTMAIN(test_algo_box_morphology);
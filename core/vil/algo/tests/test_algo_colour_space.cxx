@@ -2,11 +2,96 @@
 #include <cmath>
 #include "testlib/testlib_test.h"
 #include <vil/algo/vil_colour_space.h>
+#include <vil/vil_image_view.h>
 // not used? #include <iostream>
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
 
+//: True if each pixel of dest is f applied to the same pixel of src
+template <class T, class F>
+static bool
+matches_per_pixel(const vil_image_view<T> & src, const vil_image_view<T> & dest, F f)
+{
+  if (dest.ni() != src.ni() || dest.nj() != src.nj() || dest.nplanes() != 3)
+    return false;
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+    {
+      const T in[3] = { src(i, j, 0), src(i, j, 1), src(i, j, 2) };
+      T out[3];
+      f(in, out);
+      if (out[0] != dest(i, j, 0) || out[1] != dest(i, j, 1) || out[2] != dest(i, j, 2))
+        return false;
+    }
+  return true;
+}
+
+static void
+test_colour_space_images()
+{
+  // Planar and interleaved images with the same contents
+  vil_image_view<float> planar(17, 5, 3);
+  vil_image_view<unsigned char> planar_b(17, 5, 3);
+  for (unsigned p = 0; p < 3; ++p)
+    for (unsigned j = 0; j < 5; ++j)
+      for (unsigned i = 0; i < 17; ++i)
+      {
+        planar(i, j, p) = float((i * 7 + j * 13 + p * 5) % 11) / 10.0f;
+        planar_b(i, j, p) = static_cast<unsigned char>((i * 37 + j * 101 + p * 59) % 256);
+      }
+  vil_image_view<float> interleaved(17, 5, 1, 3);
+  for (unsigned p = 0; p < 3; ++p)
+    for (unsigned j = 0; j < 5; ++j)
+      for (unsigned i = 0; i < 17; ++i)
+        interleaved(i, j, p) = planar(i, j, p);
+  TEST("Interleaved source", interleaved.istep(), 3);
+
+  vil_image_view<float> dest, dest_i(17, 5, 1, 3);
+  vil_colour_space_RGB_to_YUV(planar, dest);
+  TEST("RGB_to_YUV planar",
+       matches_per_pixel(planar, dest, [](const float * in, float * out) { vil_colour_space_RGB_to_YUV(in, out); }),
+       true);
+  vil_colour_space_RGB_to_YUV(interleaved, dest_i);
+  TEST("RGB_to_YUV interleaved",
+       dest_i.istep() == 3 && matches_per_pixel(interleaved, dest_i, [](const float * in, float * out) {
+         vil_colour_space_RGB_to_YUV(in, out);
+       }),
+       true);
+  vil_colour_space_RGB_to_YIQ(interleaved, dest);
+  TEST("RGB_to_YIQ interleaved to planar",
+       matches_per_pixel(planar, dest, [](const float * in, float * out) { vil_colour_space_RGB_to_YIQ(in, out); }),
+       true);
+  vil_colour_space_RGB_to_YPbPr_601(planar, dest);
+  TEST("RGB_to_YPbPr_601",
+       matches_per_pixel(
+         planar, dest, [](const float * in, float * out) { vil_colour_space_RGB_to_YPbPr_601(in, out); }),
+       true);
+
+  vil_image_view<float> yuv;
+  vil_colour_space_RGB_to_YUV(planar, yuv);
+  vil_image_view<float> in_place;
+  in_place.deep_copy(yuv);
+  vil_colour_space_YUV_to_RGB(in_place, in_place);
+  TEST("YUV_to_RGB in place",
+       matches_per_pixel(yuv, in_place, [](const float * in, float * out) { vil_colour_space_YUV_to_RGB(in, out); }),
+       true);
+
+  vil_image_view<unsigned char> ycbcr, rgb_b;
+  vil_colour_space_RGB_to_YCbCr_601(planar_b, ycbcr);
+  TEST("RGB_to_YCbCr_601",
+       matches_per_pixel(planar_b,
+                         ycbcr,
+                         [](const unsigned char * in, unsigned char * out) { vil_colour_space_RGB_to_YCbCr_601(in, out); }),
+       true);
+  vil_colour_space_YCbCr_601_to_RGB(ycbcr, rgb_b);
+  TEST("YCbCr_601_to_RGB",
+       matches_per_pixel(ycbcr,
+                         rgb_b,
+                         [](const unsigned char * in, unsigned char * out) { vil_colour_space_YCbCr_601_to_RGB(in, out); }),
+       true);
+}
+
 static void
 test_algo_colour_space()
 {
@@ -122,6 +207,8 @@ test_algo_colour_space()
        unsigned_blue_rgb[0] - unsigned_color2[0] < 1 && unsigned_blue_rgb[1] - unsigned_color2[1] < 1 &&
          unsigned_blue_rgb[2] - unsigned_color2[2] < 1,
        true);
+
+  test_colour_space_images();
 }
 
 TESTMAIN(test_algo_colour_space);
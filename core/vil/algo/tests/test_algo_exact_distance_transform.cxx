@@ -0,0 +1,99 @@
+// This is core/vil/algo/tests/test_algo_exact_distance_transform.cxx
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "testlib/testlib_test.h"
+#include <vil/algo/vil_exact_distance_transform.h>
+#include <vpl/vpl_thread_pool.h>
+
+static vil_image_view<bool>
+random_mask(unsigned ni, unsigned nj, unsigned per_mille, unsigned long seed)
+{
+  vil_image_view<bool> mask(ni, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      seed = seed * 1103515245ul + 12345ul;
+      mask(i, j) = (seed >> 8) % 1000 < per_mille;
+    }
+  return mask;
+}
+
+//: Check d2 and nearest against a search of every feature.
+static bool
+matches_brute_force(const vil_image_view<bool> & mask,
+                    const vil_image_view<vxl_uint_32> & d2,
+                    const vil_image_view<vxl_uint_32> & nearest)
+{
+  const unsigned ni = mask.ni(), nj = mask.nj();
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      vxl_uint_32 best = vil_edt_infinity;
+      for (unsigned v = 0; v < nj; ++v)
+        for (unsigned u = 0; u < ni; ++u)
+          if (mask(u, v))
+          {
+            const int di = int(u) - int(i), dj = int(v) - int(j);
+            best = std::min(best, vxl_uint_32(di * di + dj * dj));
+          }
+      if (d2(i, j) != best)
+        return false;
+      const vxl_uint_32 n = nearest(i, j);
+      if (best == vil_edt_infinity)
+      {
+        if (n != vil_edt_infinity)
+          return false;
+        continue;
+      }
+      // The nearest pixel must be a feature at the right distance.
+      const int u = n % ni, v = n / ni;
+      if (!mask(u, v) || vxl_uint_32((u - int(i)) * (u - int(i)) + (v - int(j)) * (v - int(j))) != best)
+        return false;
+    }
+  return true;
+}
+
+static void
+test_algo_exact_distance_transform()
+{
+  std::cout << "Testing vil_exact_distance_transform\n";
+  const unsigned sizes[][2] = { { 1, 1 }, { 1, 40 }, { 40, 1 }, { 37, 23 }, { 300, 7 } };
+  const unsigned densities[] = { 0, 1, 20, 300 };
+  for (const auto & sz : sizes)
+    for (unsigned p : densities)
+    {
+      const vil_image_view<bool> mask = random_mask(sz[0], sz[1], p, sz[0] + p);
+      vil_image_view<vxl_uint_32> d2, nearest, d2_only;
+      vpl_set_concurrency(3);
+      vil_exact_distance_transform_r2(mask, d2, nearest);
+      vpl_set_concurrency(1);
+      vil_exact_distance_transform_r2(mask, d2_only);
+      vpl_set_concurrency(0);
+      std::cout << sz[0] << 'x' << sz[1] << ", density " << p << "/1000\n";
+      TEST("squared distance and nearest feature", matches_brute_force(mask, d2, nearest), true);
+      bool same = true;
+      for (unsigned j = 0; j < mask.nj(); ++j)
+        for (unsigned i = 0; i < mask.ni(); ++i)
+          same = same && d2(i, j) == d2_only(i, j);
+      TEST("same without nearest feature", same, true);
+    }
+
+  // Single feature: distances are exact, unlike the chamfer transform.
+  vil_image_view<bool> mask(50, 40);
+  mask.fill(false);
+  mask(10, 5) = true;
+  vil_image_view<float> distance;
+  vil_exact_distance_transform(mask, distance);
+  TEST_NEAR("distance to (13,9)", distance(13, 9), 5.0f, 1e-6);
+  TEST_NEAR("distance to (49,39)", distance(49, 39), std::sqrt(39.0f * 39 + 34 * 34), 1e-4);
+  mask.fill(false);
+  vil_exact_distance_transform(mask, distance);
+  TEST("no features", distance(3, 3), std::numeric_limits<float>::max());
+}
+
+TESTMAIN(test_algo_exact_distance_transform);
@@ -0,0 +1,232 @@
+// This is core/vil/algo/tests/test_algo_integral_image.cxx
+#include <iostream>
+#include <cmath>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vxl_config.h" // for vxl_byte
+#include <vil/vil_plane.h>
+#include <vil/algo/vil_integral_image.h>
+#include <vil/algo/vil_correlate_2d.h>
+#include <vil/algo/vil_correlate_2d_fft.h>
+#include <vil/algo/vil_normalised_correlation_2d.h>
+
+//: Pseudo-random image, so that the tests are repeatable.
+template <class T>
+static void
+fill_image(vil_image_view<T> & im, unsigned seed, unsigned range)
+{
+  for (unsigned p = 0; p < im.nplanes(); ++p)
+    for (unsigned j = 0; j < im.nj(); ++j)
+      for (unsigned i = 0; i < im.ni(); ++i)
+      {
+        seed = seed * 1103515245u + 12345u;
+        im(i, j, p) = T((seed >> 16) % range);
+      }
+}
+
+//: Scale kernel to zero mean and unit variance, over all planes.
+static void
+normalise_kernel(vil_image_view<float> & k)
+{
+  double sum = 0, sum_sq = 0, n = double(k.size());
+  for (unsigned p = 0; p < k.nplanes(); ++p)
+    for (unsigned j = 0; j < k.nj(); ++j)
+      for (unsigned i = 0; i < k.ni(); ++i)
+      {
+        sum += k(i, j, p);
+        sum_sq += double(k(i, j, p)) * k(i, j, p);
+      }
+  const double mean = sum / n, sd = std::sqrt(sum_sq / n - mean * mean);
+  for (unsigned p = 0; p < k.nplanes(); ++p)
+    for (unsigned j = 0; j < k.nj(); ++j)
+      for (unsigned i = 0; i < k.ni(); ++i)
+        k(i, j, p) = float((k(i, j, p) - mean) / sd);
+}
+
+static double
+max_difference(const vil_image_view<double> & a, const vil_image_view<double> & b)
+{
+  double d = 0;
+  for (unsigned j = 0; j < a.nj(); ++j)
+    for (unsigned i = 0; i < a.ni(); ++i)
+      d = std::max(d, std::fabs(a(i, j) - b(i, j)));
+  return d;
+}
+
+static void
+test_integral_image()
+{
+  std::cout << "***************************\n"
+            << " Testing vil_integral_image\n"
+            << "***************************\n";
+
+  vil_image_view<vxl_byte> src(23, 17, 2);
+  fill_image(src, 1, 256);
+  vil_integral_image<vxl_int_64> integral(src, 1);
+  TEST("Size", integral.ni() == 23 && integral.nj() == 17, true);
+  TEST("Sum image size", integral.sum_image().ni() == 24 && integral.sum_image().nj() == 18, true);
+
+  bool sums_ok = true;
+  for (unsigned j0 = 0; j0 <= 17; j0 += 3)
+    for (unsigned j1 = j0; j1 <= 17; j1 += 4)
+      for (unsigned i0 = 0; i0 <= 23; i0 += 5)
+        for (unsigned i1 = i0; i1 <= 23; i1 += 2)
+        {
+          vxl_int_64 s = 0, s2 = 0;
+          for (unsigned j = j0; j < j1; ++j)
+            for (unsigned i = i0; i < i1; ++i)
+            {
+              s += src(i, j, 1);
+              s2 += vxl_int_64(src(i, j, 1)) * src(i, j, 1);
+            }
+          if (integral.sum(i0, j0, i1, j1) != s || integral.sum_sq(i0, j0, i1, j1) != s2)
+            sums_ok = false;
+        }
+  TEST("Rectangle sums are exact", sums_ok, true);
+
+  // A view with a step other than one.
+  vil_image_view<vxl_byte> flipped(src.nj(), src.ni(), 2);
+  for (unsigned p = 0; p < 2; ++p)
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        flipped(j, i, p) = src(i, j, p);
+  vil_image_view<vxl_byte> transposed(flipped.memory_chunk(),
+                                      flipped.top_left_ptr(),
+                                      src.ni(),
+                                      src.nj(),
+                                      2,
+                                      flipped.jstep(),
+                                      flipped.istep(),
+                                      flipped.planestep());
+  vil_integral_image<double> integral_t(transposed, 1);
+  TEST("Strided view gives the same sums",
+       integral_t.sum(2, 3, 20, 15) == double(integral.sum(2, 3, 20, 15)) &&
+         integral_t.sum_sq(2, 3, 20, 15) == double(integral.sum_sq(2, 3, 20, 15)),
+       true);
+
+  std::cout << "Box mean and variance\n";
+  vil_image_view<float> mean, var;
+  vil_box_mean_variance(src, 4, 3, mean, var, vxl_int_64(), 1);
+  TEST("Mean size", mean.ni() == 20 && mean.nj() == 15, true);
+  TEST("Variance size", var.ni() == 20 && var.nj() == 15, true);
+  double mean_err = 0, var_err = 0;
+  for (unsigned j = 0; j < mean.nj(); ++j)
+    for (unsigned i = 0; i < mean.ni(); ++i)
+    {
+      double s = 0, s2 = 0;
+      for (unsigned b = 0; b < 3; ++b)
+        for (unsigned a = 0; a < 4; ++a)
+        {
+          s += src(i + a, j + b, 1);
+          s2 += double(src(i + a, j + b, 1)) * src(i + a, j + b, 1);
+        }
+      const double m = s / 12;
+      mean_err = std::max(mean_err, std::fabs(mean(i, j) - m));
+      var_err = std::max(var_err, std::fabs(var(i, j) - (s2 / 12 - m * m)));
+    }
+  TEST_NEAR("Box mean", mean_err, 0.0, 1e-4);
+  TEST_NEAR("Box variance", var_err, 0.0, 1e-2);
+
+  vil_image_view<vxl_byte> flat(8, 8);
+  flat.fill(7);
+  vil_box_mean_variance(flat, 3, 3, mean, var, double());
+  TEST("Constant image has zero variance", var(2, 2) == 0.0f && mean(2, 2) == 7.0f, true);
+}
+
+static void
+test_correlate_2d_fft()
+{
+  std::cout << "****************************\n"
+            << " Testing vil_correlate_2d_fft\n"
+            << "****************************\n";
+
+  TEST("Good FFT size of 1", vil_fft_good_size(1), 1u);
+  TEST("Good FFT size of 7", vil_fft_good_size(7), 8u);
+  TEST("Good FFT size of 61", vil_fft_good_size(61), 64u);
+  TEST("Good FFT size of 91", vil_fft_good_size(91), 96u);
+  TEST("Good FFT size of 125", vil_fft_good_size(125), 125u);
+
+  // Odd sizes, so that the transforms are padded.
+  vil_image_view<double> src(37, 29), kernel(11, 7);
+  fill_image(src, 2, 100);
+  fill_image(kernel, 3, 21);
+  vil_image_view<double> direct, fft;
+  vil_correlate_2d(src, direct, kernel, double());
+  vil_correlate_2d_fft(src, kernel, fft);
+  TEST("Size", fft.ni() == direct.ni() && fft.nj() == direct.nj(), true);
+  TEST_NEAR("Same as vil_correlate_2d", max_difference(direct, fft), 0.0, 1e-6);
+
+  // Sums over planes.
+  vil_image_view<double> src3(20, 18, 3), kernel3(6, 5, 3);
+  fill_image(src3, 4, 50);
+  fill_image(kernel3, 5, 9);
+  vil_correlate_2d_fft(src3, kernel3, fft);
+  vil_image_view<double> sum(fft.ni(), fft.nj());
+  sum.fill(0.0);
+  for (unsigned p = 0; p < 3; ++p)
+  {
+    vil_correlate_2d(vil_plane(src3, p), direct, vil_plane(kernel3, p), double());
+    for (unsigned j = 0; j < sum.nj(); ++j)
+      for (unsigned i = 0; i < sum.ni(); ++i)
+        sum(i, j) += direct(i, j);
+  }
+  TEST_NEAR("Three planes", max_difference(sum, fft), 0.0, 1e-6);
+
+  // Kernel the same size as the image.
+  vil_correlate_2d_fft(src, src, fft);
+  double s2 = 0;
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+      s2 += src(i, j) * src(i, j);
+  TEST("Full size kernel gives one value", fft.ni() == 1 && fft.nj() == 1, true);
+  TEST_NEAR("Full size kernel", fft(0, 0), s2, 1e-6 * s2);
+}
+
+static void
+test_normalised_correlation(unsigned kni, unsigned knj, unsigned np)
+{
+  std::cout << "Normalised correlation with " << kni << 'x' << knj << 'x' << np << " kernel\n";
+  vil_image_view<vxl_byte> src(50, 40, np);
+  fill_image(src, 6, 256);
+  // Make part of the image flat, where the variance is zero.
+  for (unsigned p = 0; p < np; ++p)
+    for (unsigned j = 0; j < 20; ++j)
+      for (unsigned i = 0; i < 25; ++i)
+        src(i, j, p) = 99;
+  vil_image_view<float> kernel(kni, knj, np);
+  fill_image(kernel, 7, 256);
+  normalise_kernel(kernel);
+
+  vil_image_view<double> slow, fast;
+  vil_normalised_correlation_2d(src, slow, kernel, double());
+  vil_normalised_correlation_2d_fast(src, fast, kernel);
+  TEST("Size", fast.ni() == slow.ni() && fast.nj() == slow.nj(), true);
+  TEST_NEAR("Same as vil_normalised_correlation_2d", max_difference(slow, fast), 0.0, 1e-6);
+  TEST("Zero where the image is flat", fast(0, 0), 0.0);
+
+  // A copy of the kernel in the image correlates perfectly.
+  for (unsigned p = 0; p < np; ++p)
+    for (unsigned j = 0; j < knj; ++j)
+      for (unsigned i = 0; i < kni; ++i)
+        src(i + 30, j + 20, p) = vxl_byte(128 + 20 * kernel(i, j, p));
+  vil_normalised_correlation_2d_fast(src, fast, kernel);
+  TEST_NEAR("Match with the kernel", fast(30, 20) / (kni * knj * np), 1.0, 1e-2);
+}
+
+static void
+test_algo_integral_image()
+{
+  test_integral_image();
+  test_correlate_2d_fft();
+  std::cout << "*****************************************\n"
+            << " Testing vil_normalised_correlation_2d_fast\n"
+            << "*****************************************\n";
+  test_normalised_correlation(5, 3, 1);   // direct
+  test_normalised_correlation(19, 17, 1); // FFT
+  test_normalised_correlation(7, 6, 3);
+  test_normalised_correlation(11, 9, 3);
+}
+
+TESTMAIN(test_algo_integral_image);
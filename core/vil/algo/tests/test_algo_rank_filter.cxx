@@ -0,0 +1,137 @@
+// This is core/vil/algo/tests/test_algo_rank_filter.cxx
+#include <iostream>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "testlib/testlib_test.h"
+#include "vxl_config.h"
+#include <vil/algo/vil_median.h>
+#include <vil/algo/vil_rank_filter.h>
+#include <vpl/vpl_thread_pool.h>
+
+//: Rectangular structuring element [ilo,ihi]x[jlo,jhi].
+static vil_structuring_element
+box_element(int ilo, int ihi, int jlo, int jhi)
+{
+  std::vector<int> pi, pj;
+  for (int j = jlo; j <= jhi; ++j)
+    for (int i = ilo; i <= ihi; ++i)
+    {
+      pi.push_back(i);
+      pj.push_back(j);
+    }
+  return vil_structuring_element(pi, pj);
+}
+
+//: Random image, with values spread over [0,max_value].
+template <class T>
+static vil_image_view<T>
+random_image(unsigned ni, unsigned nj, unsigned np, unsigned max_value, unsigned seed)
+{
+  vil_image_view<T> image(ni, nj, np);
+  unsigned long x = seed;
+  for (unsigned p = 0; p < np; ++p)
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = 0; i < ni; ++i)
+      {
+        x = x * 1103515245ul + 12345ul;
+        image(i, j, p) = T((x >> 8) % (max_value + 1));
+      }
+  return image;
+}
+
+//: True if dest is the brute force rank filter of src.
+template <class T>
+static bool
+matches_sorted_value(const vil_image_view<T> & src,
+                     const vil_image_view<T> & dest,
+                     const vil_structuring_element & element,
+                     double r)
+{
+  if (dest.ni() != src.ni() || dest.nj() != src.nj() || dest.nplanes() != src.nplanes())
+    return false;
+  std::vector<T> values;
+  for (unsigned p = 0; p < src.nplanes(); ++p)
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        if (dest(i, j, p) != vil_sorted_value(src, p, element, i, j, values, r))
+          return false;
+  return true;
+}
+
+template <class T>
+static void
+test_rank_filter_type(unsigned max_value, const char * type_name)
+{
+  std::cout << "Testing vil_rank_filter_box on " << type_name << '\n';
+  const vil_image_view<T> src = random_image<T>(61, 43, 2, max_value, 17);
+  const int boxes[][4] = { { 0, 0, 0, 0 }, { -1, 1, -1, 1 }, { -3, 2, 0, 4 }, { -7, 7, -5, 5 }, { -40, 30, -2, 50 } };
+  const double ranks[] = { 0.0, 0.25, 0.5, 1.0 };
+  for (const auto & b : boxes)
+  {
+    const vil_structuring_element element = box_element(b[0], b[1], b[2], b[3]);
+    for (double r : ranks)
+    {
+      vil_image_view<T> dest;
+      vil_rank_filter_box(src, dest, b[0], b[1], b[2], b[3], r);
+      std::cout << "box [" << b[0] << ',' << b[1] << "]x[" << b[2] << ',' << b[3] << "], r=" << r << '\n';
+      TEST("matches vil_sorted_value", matches_sorted_value(src, dest, element, r), true);
+    }
+  }
+
+  // Narrow 16 bit strips, and more threads than columns.
+  const vil_image_view<T> wide = random_image<T>(300, 9, 1, max_value, 5);
+  vil_image_view<T> dest1, dest8;
+  vpl_set_concurrency(1);
+  vil_median_box(wide, dest1, 4, 2);
+  vpl_set_concurrency(8);
+  vil_median_box(wide, dest8, 4, 2);
+  vpl_set_concurrency(3);
+  TEST("median box matches vil_sorted_value", matches_sorted_value(wide, dest1, box_element(-4, 4, -2, 2), 0.5), true);
+  bool same = true;
+  for (unsigned j = 0; j < wide.nj(); ++j)
+    for (unsigned i = 0; i < wide.ni(); ++i)
+      same = same && dest1(i, j) == dest8(i, j);
+  TEST("result independent of thread count", same, true);
+
+  // vil_median switches to the histogram method for boxes only.
+  const vil_image_view<T> plane = random_image<T>(37, 29, 1, max_value, 9);
+  vil_structuring_element disk;
+  disk.set_to_disk(2.5);
+  vil_image_view<T> med;
+  vil_median(plane, med, disk);
+  TEST("vil_median with a disk", matches_sorted_value(plane, med, disk, 0.5), true);
+  const vil_structuring_element box = box_element(-2, 3, -1, 1);
+  vil_median(plane, med, box);
+  TEST("vil_median with a box", matches_sorted_value(plane, med, box, 0.5), true);
+}
+
+static void
+test_is_box()
+{
+  vil_structuring_element line;
+  line.set_to_line_i(-2, 2);
+  TEST("line is a box", vil_structuring_element_is_box(line), true);
+  TEST("rectangle is a box", vil_structuring_element_is_box(box_element(-1, 2, -3, 0)), true);
+  vil_structuring_element disk;
+  disk.set_to_disk(2.5);
+  TEST("disk is not a box", vil_structuring_element_is_box(disk), false);
+  TEST("box not containing origin", vil_structuring_element_is_box(box_element(1, 2, 0, 1)), false);
+  std::vector<int> pi = { 0, 0, 1, 1 }, pj = { 0, 1, 0, 0 };
+  TEST("repeated point", vil_structuring_element_is_box(vil_structuring_element(pi, pj)), false);
+}
+
+static void
+test_algo_rank_filter()
+{
+  vpl_set_concurrency(3);
+  test_is_box();
+  test_rank_filter_type<vxl_byte>(255, "vxl_byte");
+  test_rank_filter_type<vxl_uint_16>(65535, "vxl_uint_16");
+  // Few distinct values, so many ties.
+  test_rank_filter_type<vxl_uint_16>(3, "vxl_uint_16 with ties");
+  vpl_set_concurrency(0);
+}
+
+TESTMAIN(test_algo_rank_filter);
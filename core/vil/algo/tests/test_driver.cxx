@@ -5,6 +5,7 @@ DECLARE(test_algo_colour_space);
 DECLARE(test_algo_correlate_1d);
 DECLARE(test_algo_convolve_1d);
 DECLARE(test_algo_correlate_2d);
+DECLARE(test_algo_integral_image);
 DECLARE(test_algo_convolve_2d);
 DECLARE(test_algo_exp_filter_1d);
 DECLARE(test_algo_gauss_filter);
@@ -18,6 +19,9 @@ DECLARE(test_algo_histogram);
 DECLARE(test_algo_histogram_equalise);
 DECLARE(test_algo_distance_transform);
 DECLARE(test_algo_blob);
+DECLARE(test_algo_blob_parallel);
+DECLARE(test_algo_box_morphology);
+DECLARE(test_algo_exact_distance_transform);
 DECLARE(test_algo_find_peaks);
 DECLARE(test_algo_find_plateaus);
 DECLARE(test_algo_region_finder);
@@ -28,6 +32,7 @@ DECLARE(test_binary_erode);
 DECLARE(test_greyscale_dilate);
 DECLARE(test_greyscale_erode);
 DECLARE(test_median);
+DECLARE(test_algo_rank_filter);
 DECLARE(test_suppress_non_max);
 DECLARE(test_algo_suppress_non_plateau);
 DECLARE(test_algo_sobel);
@@ -46,6 +51,7 @@ register_tests()
   REGISTER(test_algo_correlate_1d);
   REGISTER(test_algo_convolve_1d);
   REGISTER(test_algo_correlate_2d);
+  REGISTER(test_algo_integral_image);
   REGISTER(test_algo_convolve_2d);
   REGISTER(test_algo_exp_filter_1d);
   REGISTER(test_algo_gauss_filter);
@@ -59,6 +65,9 @@ register_tests()
   REGISTER(test_algo_histogram_equalise);
   REGISTER(test_algo_distance_transform);
   REGISTER(test_algo_blob);
+  REGISTER(test_algo_blob_parallel);
+  REGISTER(test_algo_box_morphology);
+  REGISTER(test_algo_exact_distance_transform);
   REGISTER(test_algo_find_peaks);
   REGISTER(test_algo_find_plateaus);
   REGISTER(test_algo_region_finder);
@@ -69,6 +78,7 @@ register_tests()
   REGISTER(test_greyscale_dilate);
   REGISTER(test_greyscale_erode);
   REGISTER(test_median);
+  REGISTER(test_algo_rank_filter);
   REGISTER(test_suppress_non_max);
   REGISTER(test_algo_suppress_non_plateau);
   REGISTER(test_algo_sobel);
@@ -4,6 +4,8 @@
 #include <vil/algo/vil_binary_erode.h>
 #include <vil/algo/vil_binary_opening.h>
 #include <vil/algo/vil_blob.h>
+#include <vil/algo/vil_blob_parallel.h>
+#include <vil/algo/vil_box_morphology.h>
 #include <vil/algo/vil_cartesian_differential_invariants.h>
 #include <vil/algo/vil_checker_board.h>
 #include <vil/algo/vil_colour_space.h>
@@ -12,7 +14,9 @@
 #include <vil/algo/vil_corners.h>
 #include <vil/algo/vil_correlate_1d.h>
 #include <vil/algo/vil_correlate_2d.h>
+#include <vil/algo/vil_correlate_2d_fft.h>
 #include <vil/algo/vil_distance_transform.h>
+#include <vil/algo/vil_exact_distance_transform.h>
 #include <vil/algo/vil_dog_filter_5tap.h>
 #include <vil/algo/vil_dog_pyramid.h>
 #include <vil/algo/vil_exp_filter_1d.h>
@@ -32,8 +36,10 @@
 #include <vil/algo/vil_grid_merge.h>
 #include <vil/algo/vil_histogram.h>
 #include <vil/algo/vil_histogram_equalise.h>
+#include <vil/algo/vil_integral_image.h>
 #include <vil/algo/vil_line_filter.h>
 #include <vil/algo/vil_median.h>
+#include <vil/algo/vil_rank_filter.h>
 #include <vil/algo/vil_normalised_correlation_2d.h>
 #include <vil/algo/vil_orientations.h>
 #include <vil/algo/vil_quad_distance_function.h>
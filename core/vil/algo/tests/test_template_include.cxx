@@ -1,4 +1,5 @@
 #include <vil/algo/vil_abs_shuffle_distance.hxx>
+#include <vil/algo/vil_box_morphology.hxx>
 #include <vil/algo/vil_cartesian_differential_invariants.hxx>
 #include <vil/algo/vil_checker_board.hxx>
 #include <vil/algo/vil_fft.hxx>
@@ -8,6 +9,7 @@
 #include <vil/algo/vil_greyscale_erode.hxx>
 #include <vil/algo/vil_line_filter.hxx>
 #include <vil/algo/vil_median.hxx>
+#include <vil/algo/vil_rank_filter.hxx>
 #include <vil/algo/vil_region_finder.hxx>
 #include <vil/algo/vil_sobel_1x3.hxx>
 #include <vil/algo/vil_sobel_3x3.hxx>
@@ -0,0 +1,491 @@
+// This is core/vil/algo/vil_blob_parallel.cxx
+//:
+// \file
+// \brief Block-parallel connected component labelling.
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "vil_blob_parallel.h"
+#include <vil/vil_blocked_image_resource.h>
+#include <vil/vil_crop.h>
+#include <vpl/vpl_thread_pool.h>
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <cassert>
+
+namespace
+{
+//: Statistics of a blob, plus the raster index of its first pixel.
+struct blob_info
+{
+  std::size_t area;
+  unsigned i_min, j_min, i_max, j_max;
+  vxl_uint_64 first;
+};
+
+//: A tile of the image, labelled independently of the others.
+struct tile
+{
+  unsigned i0, j0, ni, nj;
+  //: Global label of local label l is base + l.
+  unsigned base{ 0 };
+  //: Blob l (l>=1) of the tile is blobs[l-1]. Local labels are in raster order.
+  std::vector<blob_info> blobs;
+  //: Local labels of the outermost rows and columns of the tile.
+  std::vector<unsigned> top, bottom, left, right;
+};
+
+//: Union-find over labels 0..n-1 which may be used from many threads at once.
+// Every set is represented by its smallest label, and a parent is always
+// smaller than its child, so a compare-and-swap on the parent suffices to
+// link two roots, and path halving is safe.
+class concurrent_disjoint_sets
+{
+  std::vector<std::atomic<unsigned>> parent_;
+
+public:
+  explicit concurrent_disjoint_sets(unsigned n)
+    : parent_(n)
+  {
+    for (unsigned l = 0; l < n; ++l)
+      parent_[l].store(l, std::memory_order_relaxed);
+  }
+
+  unsigned
+  root(unsigned l)
+  {
+    while (true)
+    {
+      unsigned p = parent_[l].load();
+      if (p == l)
+        return l;
+      const unsigned gp = parent_[p].load();
+      if (gp != p)
+        parent_[l].compare_exchange_weak(p, gp);
+      l = gp;
+    }
+  }
+
+  void
+  merge_labels(unsigned a, unsigned b)
+  {
+    while (true)
+    {
+      a = root(a);
+      b = root(b);
+      if (a == b)
+        return;
+      if (a < b)
+        std::swap(a, b);
+      // Link the larger root a below b, unless another thread got there first.
+      unsigned expected = a;
+      if (parent_[a].compare_exchange_strong(expected, b))
+        return;
+    }
+  }
+};
+
+//: Call f(k) for each of the tiles, one tile per task of the vpl thread pool.
+template <class F>
+void
+for_each_tile(const std::vector<tile> & tiles, F f)
+{
+  vpl_parallel_for(0u, static_cast<unsigned>(tiles.size()), f, 1u);
+}
+
+//: Label pixels [0,t.ni)x[0,t.nj) of src into labels, with labels local to the tile.
+// Fills in the blob statistics and border labels of t.
+void
+label_tile(const vil_image_view<bool> & src,
+           vil_blob_connectivity conn,
+           vil_image_view<unsigned> & labels,
+           unsigned image_ni,
+           tile & t)
+{
+  const unsigned ni = t.ni, nj = t.nj;
+  const bool eight = (conn == vil_blob_8_conn);
+  assert(conn == vil_blob_4_conn || eight);
+
+  // First pass: provisional labels. Each set's root is its smallest label.
+  std::vector<unsigned> parent(1, 0u);
+  auto root = [&parent](unsigned l) {
+    while (parent[l] != l)
+      l = parent[l] = parent[parent[l]];
+    return l;
+  };
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      if (!src(i, j))
+      {
+        labels(i, j) = 0;
+        continue;
+      }
+      unsigned label = 0;
+      auto join = [&](unsigned n) {
+        if (!n)
+          return;
+        if (!label)
+        {
+          label = n;
+          return;
+        }
+        const unsigned a = root(label), b = root(n);
+        if (a < b)
+          parent[b] = a;
+        else if (b < a)
+          parent[a] = b;
+      };
+      if (i > 0)
+        join(labels(i - 1, j));
+      if (j > 0)
+      {
+        join(labels(i, j - 1));
+        if (eight && i > 0)
+          join(labels(i - 1, j - 1));
+        if (eight && i + 1 < ni)
+          join(labels(i + 1, j - 1));
+      }
+      if (!label)
+      {
+        label = static_cast<unsigned>(parent.size());
+        parent.push_back(label);
+      }
+      labels(i, j) = label;
+    }
+
+  // Number the sets compactly, in the raster order of their first pixel.
+  std::vector<unsigned> compact(parent.size(), 0u);
+  unsigned n_labels = 0;
+  for (unsigned l = 1; l < parent.size(); ++l)
+  {
+    const unsigned r = root(l);
+    compact[l] = (r == l) ? ++n_labels : compact[r];
+  }
+
+  // Second pass: final local labels and statistics.
+  t.blobs.assign(n_labels, blob_info());
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      unsigned & l = labels(i, j);
+      if (!l)
+        continue;
+      l = compact[l];
+      blob_info & b = t.blobs[l - 1];
+      const unsigned gi = t.i0 + i, gj = t.j0 + j;
+      if (b.area++ == 0)
+      {
+        b.i_min = b.i_max = gi;
+        b.j_min = b.j_max = gj;
+        b.first = vxl_uint_64(gj) * image_ni + gi;
+      }
+      else
+      {
+        b.i_min = std::min(b.i_min, gi);
+        b.i_max = std::max(b.i_max, gi);
+        b.j_max = gj;
+      }
+    }
+
+  t.top.resize(ni);
+  t.bottom.resize(ni);
+  t.left.resize(nj);
+  t.right.resize(nj);
+  for (unsigned i = 0; i < ni; ++i)
+  {
+    t.top[i] = labels(i, 0);
+    t.bottom[i] = labels(i, nj - 1);
+  }
+  for (unsigned j = 0; j < nj; ++j)
+  {
+    t.left[j] = labels(0, j);
+    t.right[j] = labels(ni - 1, j);
+  }
+}
+
+//: Join the blobs of tile k with those of the tiles above and to the left of it.
+void
+join_seams(const std::vector<tile> & tiles,
+           unsigned k,
+           unsigned n_tiles_i,
+           vil_blob_connectivity conn,
+           concurrent_disjoint_sets & sets)
+{
+  const tile & b = tiles[k];
+  const unsigned ti = k % n_tiles_i, tj = k / n_tiles_i;
+  const int d = (conn == vil_blob_8_conn) ? 1 : 0;
+  if (tj > 0)
+  {
+    const tile & a = tiles[k - n_tiles_i];
+    for (unsigned i = 0; i < b.ni; ++i)
+      if (b.top[i])
+        for (int di = -d; di <= d; ++di)
+        {
+          const unsigned ia = i + di;
+          if (ia < a.ni && a.bottom[ia]) // rely on wraparound for ia<0
+            sets.merge_labels(b.base + b.top[i], a.base + a.bottom[ia]);
+        }
+    if (d && ti > 0)
+    {
+      const tile & al = tiles[k - n_tiles_i - 1];
+      if (b.top[0] && al.bottom[al.ni - 1])
+        sets.merge_labels(b.base + b.top[0], al.base + al.bottom[al.ni - 1]);
+    }
+    if (d && ti + 1 < n_tiles_i)
+    {
+      const tile & ar = tiles[k - n_tiles_i + 1];
+      if (b.top[b.ni - 1] && ar.bottom[0])
+        sets.merge_labels(b.base + b.top[b.ni - 1], ar.base + ar.bottom[0]);
+    }
+  }
+  if (ti > 0)
+  {
+    const tile & l = tiles[k - 1];
+    for (unsigned j = 0; j < b.nj; ++j)
+      if (b.left[j])
+        for (int dj = -d; dj <= d; ++dj)
+        {
+          const unsigned jl = j + dj;
+          if (jl < l.nj && l.right[jl])
+            sets.merge_labels(b.base + b.left[j], l.base + l.right[jl]);
+        }
+  }
+}
+
+//: Join the tiles, and work out the final label of every global label.
+// On return final_label[tile.base + l] is the output label of local label l.
+void
+merge_tiles(std::vector<tile> & tiles,
+            unsigned n_tiles_i,
+            vil_blob_connectivity conn,
+            std::vector<unsigned> & final_label,
+            std::vector<vil_blob_stats> & stats)
+{
+  unsigned n = 0;
+  for (tile & t : tiles)
+  {
+    t.base = n;
+    n += static_cast<unsigned>(t.blobs.size());
+  }
+
+  concurrent_disjoint_sets sets(n + 1);
+  for_each_tile(tiles, [&](unsigned k) {
+    join_seams(tiles, k, n_tiles_i, conn, sets);
+  });
+
+  // Accumulate the statistics of each set in its root.
+  std::vector<blob_info> info(n + 1);
+  for (const tile & t : tiles)
+    std::copy(t.blobs.begin(), t.blobs.end(), info.begin() + t.base + 1);
+  std::vector<unsigned> roots;
+  final_label.assign(n + 1, 0u);
+  for (unsigned g = 1; g <= n; ++g)
+  {
+    const unsigned r = sets.root(g);
+    final_label[g] = r;
+    if (r == g)
+    {
+      roots.push_back(g);
+      continue;
+    }
+    blob_info & a = info[r];
+    const blob_info & b = info[g];
+    a.area += b.area;
+    a.i_min = std::min(a.i_min, b.i_min);
+    a.j_min = std::min(a.j_min, b.j_min);
+    a.i_max = std::max(a.i_max, b.i_max);
+    a.j_max = std::max(a.j_max, b.j_max);
+    a.first = std::min(a.first, b.first);
+  }
+
+  // Number the blobs in the raster order of their first pixels, as vil_blob_labels does.
+  std::sort(roots.begin(), roots.end(), [&info](unsigned a, unsigned b) { return info[a].first < info[b].first; });
+  std::vector<unsigned> number(n + 1, 0u);
+  stats.resize(roots.size());
+  for (unsigned k = 0; k < roots.size(); ++k)
+  {
+    const blob_info & b = info[roots[k]];
+    number[roots[k]] = k + 1;
+    stats[k].area = b.area;
+    stats[k].i_min = b.i_min;
+    stats[k].j_min = b.j_min;
+    stats[k].i_max = b.i_max;
+    stats[k].j_max = b.j_max;
+  }
+  for (unsigned g = 1; g <= n; ++g)
+    final_label[g] = number[final_label[g]];
+}
+
+//: Replace the local labels of tile t by the final labels.
+void
+relabel_tile(const tile & t, const std::vector<unsigned> & final_label, vil_image_view<unsigned> & labels)
+{
+  const unsigned * lut = &final_label[t.base];
+  for (unsigned j = 0; j < t.nj; ++j)
+    for (unsigned i = 0; i < t.ni; ++i)
+    {
+      unsigned & l = labels(i, j);
+      if (l)
+        l = lut[l];
+    }
+}
+
+//: Foreground mask of a block (non-zero pixels).
+template <class T>
+void
+block_mask(const vil_image_view<T> & block, unsigned ni, unsigned nj, vil_image_view<bool> & mask)
+{
+  mask.set_size(ni, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      mask(i, j) = block(i, j) != T(0);
+}
+} // namespace
+
+void
+vil_blob_labels_parallel(const vil_image_view<bool> & src_binary,
+                         vil_blob_connectivity conn,
+                         vil_image_view<unsigned> & dest_label,
+                         std::vector<vil_blob_stats> & stats,
+                         unsigned tile_size)
+{
+  const unsigned ni = src_binary.ni(), nj = src_binary.nj();
+  dest_label.set_size(ni, nj);
+  stats.clear();
+  if (ni == 0 || nj == 0)
+    return;
+  tile_size = std::max(tile_size, 1u);
+  const unsigned n_ti = (ni + tile_size - 1) / tile_size, n_tj = (nj + tile_size - 1) / tile_size;
+  std::vector<tile> tiles(n_ti * n_tj);
+  for (unsigned tj = 0; tj < n_tj; ++tj)
+    for (unsigned ti = 0; ti < n_ti; ++ti)
+    {
+      tile & t = tiles[tj * n_ti + ti];
+      t.i0 = ti * tile_size;
+      t.j0 = tj * tile_size;
+      t.ni = std::min(tile_size, ni - t.i0);
+      t.nj = std::min(tile_size, nj - t.j0);
+    }
+
+  for_each_tile(tiles, [&](unsigned k) {
+    tile & t = tiles[k];
+    vil_image_view<unsigned> labels = vil_crop(dest_label, t.i0, t.ni, t.j0, t.nj);
+    label_tile(vil_crop(src_binary, t.i0, t.ni, t.j0, t.nj), conn, labels, ni, t);
+  });
+
+  std::vector<unsigned> final_label;
+  merge_tiles(tiles, n_ti, conn, final_label, stats);
+
+  for_each_tile(tiles, [&](unsigned k) {
+    const tile & t = tiles[k];
+    vil_image_view<unsigned> labels = vil_crop(dest_label, t.i0, t.ni, t.j0, t.nj);
+    relabel_tile(t, final_label, labels);
+  });
+}
+
+void
+vil_blob_labels_parallel(const vil_image_view<bool> & src_binary,
+                         vil_blob_connectivity conn,
+                         vil_image_view<unsigned> & dest_label)
+{
+  std::vector<vil_blob_stats> stats;
+  vil_blob_labels_parallel(src_binary, conn, dest_label, stats);
+}
+
+bool
+vil_blob_labels_blocked(const vil_blocked_image_resource_sptr & src_binary,
+                        vil_blob_connectivity conn,
+                        const vil_blocked_image_resource_sptr & dest_label,
+                        std::vector<vil_blob_stats> & stats)
+{
+  stats.clear();
+  if (!src_binary || !dest_label)
+    return false;
+  const vil_pixel_format src_format = src_binary->pixel_format();
+  if (src_binary->nplanes() != 1 || (src_format != VIL_PIXEL_FORMAT_BOOL && src_format != VIL_PIXEL_FORMAT_BYTE))
+    return false;
+  if (dest_label->nplanes() != 1 || dest_label->pixel_format() != VIL_PIXEL_FORMAT_UINT_32 ||
+      dest_label->ni() != src_binary->ni() || dest_label->nj() != src_binary->nj() ||
+      dest_label->size_block_i() != src_binary->size_block_i() ||
+      dest_label->size_block_j() != src_binary->size_block_j())
+    return false;
+
+  const unsigned ni = src_binary->ni(), nj = src_binary->nj();
+  const unsigned sbi = src_binary->size_block_i(), sbj = src_binary->size_block_j();
+  const unsigned n_ti = src_binary->n_block_i(), n_tj = src_binary->n_block_j();
+  if (ni == 0 || nj == 0)
+    return true;
+  std::vector<tile> tiles(n_ti * n_tj);
+  for (unsigned tj = 0; tj < n_tj; ++tj)
+    for (unsigned ti = 0; ti < n_ti; ++ti)
+    {
+      tile & t = tiles[tj * n_ti + ti];
+      t.i0 = ti * sbi;
+      t.j0 = tj * sbj;
+      t.ni = std::min(sbi, ni - t.i0);
+      t.nj = std::min(sbj, nj - t.j0);
+    }
+
+  // Image resources are not thread safe, so serialise block input and output.
+  std::mutex io_mutex;
+  std::atomic<bool> ok(true);
+
+  for_each_tile(tiles, [&](unsigned k) {
+    tile & t = tiles[k];
+    const unsigned ti = k % n_ti, tj = k / n_ti;
+    vil_image_view_base_sptr block;
+    {
+      std::lock_guard<std::mutex> lock(io_mutex);
+      block = src_binary->get_block(ti, tj);
+    }
+    if (!block)
+    {
+      ok = false;
+      return;
+    }
+    vil_image_view<bool> mask;
+    if (src_format == VIL_PIXEL_FORMAT_BOOL)
+      block_mask(vil_image_view<bool>(*block), t.ni, t.nj, mask);
+    else
+      block_mask(vil_image_view<vxl_byte>(*block), t.ni, t.nj, mask);
+    vil_image_view<unsigned> labels(sbi, sbj);
+    labels.fill(0);
+    label_tile(mask, conn, labels, ni, t);
+    std::lock_guard<std::mutex> lock(io_mutex);
+    if (!dest_label->put_block(ti, tj, labels))
+      ok = false;
+  });
+  if (!ok)
+    return false;
+
+  std::vector<unsigned> final_label;
+  merge_tiles(tiles, n_ti, conn, final_label, stats);
+
+  for_each_tile(tiles, [&](unsigned k) {
+    const tile & t = tiles[k];
+    const unsigned ti = k % n_ti, tj = k / n_ti;
+    vil_image_view_base_sptr block;
+    {
+      std::lock_guard<std::mutex> lock(io_mutex);
+      block = dest_label->get_block(ti, tj);
+    }
+    if (!block)
+    {
+      ok = false;
+      return;
+    }
+    vil_image_view<unsigned> labels;
+    labels.deep_copy(vil_image_view<unsigned>(*block));
+    relabel_tile(t, final_label, labels);
+    std::lock_guard<std::mutex> lock(io_mutex);
+    if (!dest_label->put_block(ti, tj, labels))
+      ok = false;
+  });
+  if (!ok)
+    stats.clear();
+  return ok;
+}
@@ -0,0 +1,77 @@
+// This is core/vil/algo/vil_blob_parallel.h
+#ifndef vil_blob_parallel_h_
+#define vil_blob_parallel_h_
+//:
+// \file
+// \brief Block-parallel connected component labelling, with per-blob statistics.
+//
+// vil_blob_labels labels an image in one raster scan on one thread. For
+// very large masks the functions here instead cut the image into tiles
+// (or use the blocks of a vil_blocked_image_resource), and:
+// -# label every tile independently and concurrently on the vpl thread
+//    pool, collecting the area
+//    and bounding box of each tile-local blob as it goes;
+// -# join the tile-local blobs that touch across tile seams, using a
+//    lock-free union-find so that all seams are processed concurrently;
+// -# renumber the labels, again one tile per thread.
+//
+// The result is identical to vil_blob_labels: blobs are numbered 1,2,...
+// in the raster order of their first pixel.
+//
+// \code
+// vil_image_view<unsigned> labels;
+// std::vector<vil_blob_stats> stats;
+// vil_blob_labels_parallel(mask, vil_blob_8_conn, labels, stats);
+// std::cout << "blob 1 has " << stats[0].area << " pixels\n";
+// \endcode
+
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vil/vil_image_view.h>
+#include <vil/vil_blocked_image_resource_sptr.h>
+#include "vil_blob.h"
+
+//: Area and bounding box of a blob.
+struct vil_blob_stats
+{
+  //: Number of pixels in the blob.
+  std::size_t area{ 0 };
+  //: Inclusive bounding box of the blob.
+  unsigned i_min{ 0 }, j_min{ 0 }, i_max{ 0 }, j_max{ 0 };
+};
+
+//: Label the disjoint blobs of a binary image, processing tiles concurrently.
+// Produces the same labelling as vil_blob_labels. Blob n (n>=1) is
+// described by stats[n-1].
+// \param tile_size  side of the square tiles processed by each thread.
+void
+vil_blob_labels_parallel(const vil_image_view<bool> & src_binary,
+                         vil_blob_connectivity conn,
+                         vil_image_view<unsigned> & dest_label,
+                         std::vector<vil_blob_stats> & stats,
+                         unsigned tile_size = 512);
+
+//: Label the disjoint blobs of a binary image, processing tiles concurrently.
+void
+vil_blob_labels_parallel(const vil_image_view<bool> & src_binary,
+                         vil_blob_connectivity conn,
+                         vil_image_view<unsigned> & dest_label);
+
+//: Label the blobs of a blocked image, one block at a time.
+// Only the blocks being worked on, plus a border strip of each block, are
+// held in memory, so this works for images too large to load. src must be
+// a single plane image of bool or vxl_byte pixels (non-zero is foreground).
+// dest must be a single plane VIL_PIXEL_FORMAT_UINT_32 resource of the same
+// size and blocking. Blocks are read and written by one thread at a time,
+// and labelled concurrently.
+// \return false if the resources are unsuitable, or a block can not be read or written.
+bool
+vil_blob_labels_blocked(const vil_blocked_image_resource_sptr & src_binary,
+                        vil_blob_connectivity conn,
+                        const vil_blocked_image_resource_sptr & dest_label,
+                        std::vector<vil_blob_stats> & stats);
+
+#endif // vil_blob_parallel_h_
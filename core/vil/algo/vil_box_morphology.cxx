@@ -0,0 +1,155 @@
+// This is core/vil/algo/vil_box_morphology.cxx
+#include <vector>
+#include "vil_box_morphology.hxx"
+//:
+// \file
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+using vil_box_word = vxl_uint_64;
+
+//: Pack each row of src into words of 64 pixels; bits past the end of a row are set to fill.
+static void
+vil_box_pack(const vil_image_view<bool> & src, vil_image_view<vil_box_word> & packed, vil_box_word fill)
+{
+  const unsigned ni = src.ni(), nj = src.nj(), nw = (ni + 63) / 64;
+  packed.set_size(nw, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned w = 0; w < nw; ++w)
+    {
+      const unsigned i0 = 64 * w, i1 = std::min(ni, i0 + 64);
+      vil_box_word word = 0;
+      for (unsigned i = i0; i < i1; ++i)
+        if (src(i, j))
+          word |= vil_box_word(1) << (i - i0);
+      if (i1 - i0 < 64)
+        word |= fill & (~vil_box_word(0) << (i1 - i0));
+      packed(w, j) = word;
+    }
+}
+
+//: Word w of the row shifted left by s bits, i.e. with bit x taken from bit x+s.
+static inline vil_box_word
+vil_box_shifted(const vil_box_word * row, int nw, int w, int s, vil_box_word fill)
+{
+  // Floor division, so that r is in [0,64).
+  const int q = s >= 0 ? s / 64 : -((63 - s) / 64);
+  const int r = s - 64 * q;
+  const int w0 = w + q, w1 = w0 + 1;
+  const vil_box_word lo = (w0 >= 0 && w0 < nw) ? row[w0] : fill;
+  if (r == 0)
+    return lo;
+  const vil_box_word hi = (w1 >= 0 && w1 < nw) ? row[w1] : fill;
+  return (lo >> r) | (hi << (64 - r));
+}
+
+//: Bit x of acc becomes op of bits x, x+dir, ..., x+(len-1)*dir of row, with fill outside [0,ni).
+// Builds the window from shifted copies of runs of length 1,2,4,...
+// Looking only one way means that windows never start outside the row.
+template <class Op>
+static void
+vil_box_packed_run(const std::vector<vil_box_word> & row,
+                   unsigned ni,
+                   int len,
+                   int dir,
+                   vil_box_word fill,
+                   Op op,
+                   std::vector<vil_box_word> & acc,
+                   std::vector<vil_box_word> & run,
+                   std::vector<vil_box_word> & tmp)
+{
+  const int nw = row.size();
+  const unsigned n_tail = ni - 64 * (nw - 1); // bits used in the last word
+  const vil_box_word tail_mask = n_tail == 64 ? 0 : ~vil_box_word(0) << n_tail;
+  auto set_tail = [&](std::vector<vil_box_word> & v) { v[nw - 1] = (v[nw - 1] & ~tail_mask) | (fill & tail_mask); };
+
+  run = row; // run of length m
+  int a = 0; // acc holds runs of length a
+  for (int m = 1; m <= len; m *= 2)
+  {
+    if (len & m)
+    {
+      if (a == 0)
+        acc = run;
+      else
+      {
+        for (int w = 0; w < nw; ++w)
+          tmp[w] = op(acc[w], vil_box_shifted(run.data(), nw, w, a * dir, fill));
+        acc.swap(tmp);
+        set_tail(acc);
+      }
+      a += m;
+    }
+    if (2 * m <= len)
+    {
+      for (int w = 0; w < nw; ++w)
+        tmp[w] = op(run[w], vil_box_shifted(run.data(), nw, w, m * dir, fill));
+      run.swap(tmp);
+      set_tail(run);
+    }
+  }
+}
+
+template <class Op>
+static void
+vil_box_binary(const vil_image_view<bool> & src,
+               vil_image_view<bool> & dest,
+               int ilo,
+               int ihi,
+               int jlo,
+               int jhi,
+               vil_box_word fill,
+               Op op)
+{
+  assert(src.nplanes() == 1);
+  assert(ilo <= 0 && ihi >= 0 && jlo <= 0 && jhi >= 0);
+  const unsigned ni = src.ni(), nj = src.nj();
+  dest.set_size(ni, nj, 1);
+  if (ni == 0 || nj == 0)
+    return;
+
+  vil_image_view<vil_box_word> packed, result;
+  vil_box_pack(src, packed, fill);
+  const unsigned nw = packed.ni();
+  std::vector<vil_box_word> row(nw), left(nw), right(nw), run(nw), tmp(nw);
+  for (unsigned j = 0; j < nj; ++j)
+  {
+    for (unsigned w = 0; w < nw; ++w)
+      row[w] = packed(w, j);
+    // Bits [i+ilo,i] and [i,i+ihi].
+    vil_box_packed_run(row, ni, 1 - ilo, -1, fill, op, left, run, tmp);
+    vil_box_packed_run(row, ni, 1 + ihi, 1, fill, op, right, run, tmp);
+    for (unsigned w = 0; w < nw; ++w)
+      packed(w, j) = op(left[w], right[w]);
+  }
+  vil_box_morphology_j(packed, result, jlo, jhi, fill, op);
+
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      dest(i, j) = (result(i / 64, j) >> (i % 64)) & 1;
+}
+
+void
+vil_binary_dilate_box(const vil_image_view<bool> & src,
+                      vil_image_view<bool> & dest,
+                      int ilo,
+                      int ihi,
+                      int jlo,
+                      int jhi)
+{
+  vil_box_binary(src, dest, ilo, ihi, jlo, jhi, vil_box_word(0), [](vil_box_word a, vil_box_word b) { return a | b; });
+}
+
+void
+vil_binary_erode_box(const vil_image_view<bool> & src,
+                     vil_image_view<bool> & dest,
+                     int ilo,
+                     int ihi,
+                     int jlo,
+                     int jhi)
+{
+  vil_box_binary(
+    src, dest, ilo, ihi, jlo, jhi, ~vil_box_word(0), [](vil_box_word a, vil_box_word b) { return a & b; });
+}
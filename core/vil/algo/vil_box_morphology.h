@@ -0,0 +1,65 @@
+// This is core/vil/algo/vil_box_morphology.h
+#ifndef vil_box_morphology_h_
+#define vil_box_morphology_h_
+//:
+// \file
+// \brief Dilation and erosion by rectangles, in constant time per pixel
+//
+// A rectangular structuring element is the product of a line along i and
+// a line along j, so dilation (erosion) by it is a running maximum
+// (minimum) along the rows followed by one down the columns. Each running
+// extremum uses the van Herk / Gil-Werman method: the line is cut into
+// blocks as long as the window, and cumulative extrema are kept from the
+// start and from the end of each block, so every window is covered by one
+// value of each, and costs three comparisons whatever its length.
+//
+// The binary versions pack 64 pixels into each word. Along j whole words
+// are combined, and along i a window of length w is built from log2(w)
+// shifted copies of the row.
+//
+// The results are exactly those of vil_greyscale_dilate, vil_binary_erode,
+// etc. with the same (rectangular) element, which use these functions
+// automatically.
+
+#include <vil/vil_image_view.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Greyscale dilation by the rectangle [ilo,ihi]x[jlo,jhi], which must contain (0,0).
+// dest(i,j) is the maximum of src(i+a,j+b) over the pixels of the
+// rectangle inside the image. Each plane is processed independently.
+template <class T>
+void
+vil_greyscale_dilate_box(const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi);
+
+//: Greyscale erosion by the rectangle [ilo,ihi]x[jlo,jhi], which must contain (0,0).
+// dest(i,j) is the minimum of src(i+a,j+b) over the pixels of the
+// rectangle inside the image. Each plane is processed independently.
+template <class T>
+void
+vil_greyscale_erode_box(const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi);
+
+//: Binary dilation by the rectangle [ilo,ihi]x[jlo,jhi], which must contain (0,0).
+// Pixels outside the image are taken as false.
+void
+vil_binary_dilate_box(const vil_image_view<bool> & src,
+                      vil_image_view<bool> & dest,
+                      int ilo,
+                      int ihi,
+                      int jlo,
+                      int jhi);
+
+//: Binary erosion by the rectangle [ilo,ihi]x[jlo,jhi], which must contain (0,0).
+// Pixels outside the image are taken as true.
+void
+vil_binary_erode_box(const vil_image_view<bool> & src,
+                     vil_image_view<bool> & dest,
+                     int ilo,
+                     int ihi,
+                     int jlo,
+                     int jhi);
+
+#define VIL_BOX_MORPHOLOGY_INSTANTIATE(T) extern "please include vil/algo/vil_box_morphology.hxx first"
+
+#endif // vil_box_morphology_h_
@@ -0,0 +1,136 @@
+// This is core/vil/algo/vil_box_morphology.hxx
+#ifndef vil_box_morphology_hxx_
+#define vil_box_morphology_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "vil_box_morphology.h"
+#include <cassert>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: dest(i,j,p) = op of src(i+a,j,p) for ilo<=a<=ihi, with fill outside the image.
+// op must be associative, commutative and idempotent (max, min, |, &).
+template <class T, class Op>
+void
+vil_box_morphology_i(const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, T fill, Op op)
+{
+  const int ni = src.ni(), nj = src.nj(), np = src.nplanes();
+  dest.set_size(ni, nj, np);
+  const int w = ihi - ilo + 1;
+  // The padded row holds src(t+ilo) at position t, so window i is [i,i+w-1].
+  const int nb = ni + w - 1;
+  std::vector<T> padded(nb), h(nb);
+  const std::ptrdiff_t s_istep = src.istep(), d_istep = dest.istep();
+  for (int p = 0; p < np; ++p)
+    for (int j = 0; j < nj; ++j)
+    {
+      const T * s = &src(0, j, p);
+      for (int t = 0; t < nb; ++t)
+      {
+        const int i = t + ilo;
+        padded[t] = (i >= 0 && i < ni) ? s[i * s_istep] : fill;
+      }
+      // Cumulative values back to the start of each block of w.
+      h[nb - 1] = padded[nb - 1];
+      for (int t = nb - 2; t >= 0; --t)
+        h[t] = (t + 1) % w == 0 ? padded[t] : op(h[t + 1], padded[t]);
+      // Cumulative values on from the start of each block, combined with h.
+      T * d = &dest(0, j, p);
+      T g = padded[0];
+      for (int t = 0; t < nb; ++t)
+      {
+        g = t % w == 0 ? padded[t] : op(g, padded[t]);
+        if (t >= w - 1)
+          d[(t - w + 1) * d_istep] = op(h[t - w + 1], g);
+      }
+    }
+}
+
+//: dest(i,j,p) = op of src(i,j+b,p) for jlo<=b<=jhi, with fill outside the image.
+// Works on whole rows at a time, so memory is accessed in order.
+template <class T, class Op>
+void
+vil_box_morphology_j(const vil_image_view<T> & src, vil_image_view<T> & dest, int jlo, int jhi, T fill, Op op)
+{
+  const int ni = src.ni(), nj = src.nj(), np = src.nplanes();
+  dest.set_size(ni, nj, np);
+  const int w = jhi - jlo + 1;
+  const int nb = nj + w - 1;
+  std::vector<T> h(std::size_t(ni) * nb), g(ni), fill_row(ni, fill), row(ni);
+  // Padded row t is row t+jlo of src, or all fill.
+  auto padded = [&](int p, int t) -> const T * {
+    const int j = t + jlo;
+    if (j < 0 || j >= nj)
+      return fill_row.data();
+    if (src.istep() == 1)
+      return &src(0, j, p);
+    for (int i = 0; i < ni; ++i)
+      row[i] = src(i, j, p);
+    return row.data();
+  };
+  for (int p = 0; p < np; ++p)
+  {
+    for (int t = nb - 1; t >= 0; --t)
+    {
+      const T * r = padded(p, t);
+      T * ht = &h[std::size_t(t) * ni];
+      if (t == nb - 1 || (t + 1) % w == 0)
+        std::copy(r, r + ni, ht);
+      else
+        for (int i = 0; i < ni; ++i)
+          ht[i] = op(ht[i + ni], r[i]);
+    }
+    for (int t = 0; t < nb; ++t)
+    {
+      const T * r = padded(p, t);
+      if (t % w == 0)
+        std::copy(r, r + ni, g.begin());
+      else
+        for (int i = 0; i < ni; ++i)
+          g[i] = op(g[i], r[i]);
+      if (t >= w - 1)
+      {
+        const int j = t - w + 1;
+        const T * hj = &h[std::size_t(j) * ni];
+        for (int i = 0; i < ni; ++i)
+          dest(i, j, p) = op(hj[i], g[i]);
+      }
+    }
+  }
+}
+
+template <class T>
+void
+vil_greyscale_dilate_box(const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi)
+{
+  assert(ilo <= 0 && ihi >= 0 && jlo <= 0 && jhi >= 0);
+  auto op = [](T a, T b) { return a < b ? b : a; };
+  vil_image_view<T> tmp;
+  vil_box_morphology_i(src, tmp, ilo, ihi, std::numeric_limits<T>::lowest(), op);
+  vil_box_morphology_j(tmp, dest, jlo, jhi, std::numeric_limits<T>::lowest(), op);
+}
+
+template <class T>
+void
+vil_greyscale_erode_box(const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi)
+{
+  assert(ilo <= 0 && ihi >= 0 && jlo <= 0 && jhi >= 0);
+  auto op = [](T a, T b) { return b < a ? b : a; };
+  vil_image_view<T> tmp;
+  vil_box_morphology_i(src, tmp, ilo, ihi, std::numeric_limits<T>::max(), op);
+  vil_box_morphology_j(tmp, dest, jlo, jhi, std::numeric_limits<T>::max(), op);
+}
+
+#undef VIL_BOX_MORPHOLOGY_INSTANTIATE
+#define VIL_BOX_MORPHOLOGY_INSTANTIATE(T)                                                                             \
+  template void vil_greyscale_dilate_box(                                                                             \
+    const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi);                      \
+  template void vil_greyscale_erode_box(                                                                              \
+    const vil_image_view<T> & src, vil_image_view<T> & dest, int ilo, int ihi, int jlo, int jhi)
+
+#endif // vil_box_morphology_hxx_
@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cmath>
+#include <cassert>
+#include <cstddef>
 #include "vil_colour_space.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
@@ -246,15 +248,131 @@ vil_colour_space_YCbCr_601_to_RGB(const unsigned char YCbCr[3], unsigned char RG
 
 //----------------------------------------------------------------------
 
-#define inst(T)                                                                \
-  template void vil_colour_space_RGB_to_YIQ(T const[3], T[3]);                 \
-  template void vil_colour_space_YIQ_to_RGB(T const[3], T[3]);                 \
-  template void vil_colour_space_RGB_to_HSV(T, T, T, T *, T *, T *);           \
-  template void vil_colour_space_HSV_to_RGB(T, T, T, T *, T *, T *);           \
-  template void vil_colour_space_RGB_to_YUV(T const[3], T[3]);                 \
-  template void vil_colour_space_YUV_to_RGB(T const[3], T[3]);                 \
-  template void vil_colour_space_RGB_to_YPbPr_601(T const RGB[3], T YPbPr[3]); \
-  template void vil_colour_space_YPbPr_601_to_RGB(T const YPbPr[3], T RGB[3])
+//: Apply the per pixel transform f to every pixel of src, writing to dest.
+//  f is called through a lambda so that it is inlined into the row loops.
+template <class T, class F>
+static void
+vil_colour_space_apply(const vil_image_view<T> & src, vil_image_view<T> & dest, F f)
+{
+  assert(src.nplanes() == 3);
+  const unsigned ni = src.ni(), nj = src.nj();
+  dest.set_size(ni, nj, 3);
+  const std::ptrdiff_t s_is = src.istep(), s_js = src.jstep(), s_ps = src.planestep();
+  const std::ptrdiff_t d_is = dest.istep(), d_js = dest.jstep(), d_ps = dest.planestep();
+  const T * s_row = src.top_left_ptr();
+  T * d_row = dest.top_left_ptr();
+  for (unsigned j = 0; j < nj; ++j, s_row += s_js, d_row += d_js)
+  {
+    if (s_is == 1 && d_is == 1)
+    {
+      // Separate pointers to each plane, so the loop body is plain
+      // arithmetic on unit stride arrays.
+      const T * s0 = s_row;
+      const T * s1 = s_row + s_ps;
+      const T * s2 = s_row + 2 * s_ps;
+      T * d0 = d_row;
+      T * d1 = d_row + d_ps;
+      T * d2 = d_row + 2 * d_ps;
+      for (unsigned i = 0; i < ni; ++i)
+      {
+        const T in[3] = { s0[i], s1[i], s2[i] };
+        T out[3];
+        f(in, out);
+        d0[i] = out[0];
+        d1[i] = out[1];
+        d2[i] = out[2];
+      }
+    }
+    else
+    {
+      const T * s = s_row;
+      T * d = d_row;
+      for (unsigned i = 0; i < ni; ++i, s += s_is, d += d_is)
+      {
+        const T in[3] = { s[0], s[s_ps], s[2 * s_ps] };
+        T out[3];
+        f(in, out);
+        d[0] = out[0];
+        d[d_ps] = out[1];
+        d[2 * d_ps] = out[2];
+      }
+    }
+  }
+}
+
+template <class T>
+void
+vil_colour_space_RGB_to_YIQ(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_RGB_to_YIQ(in, out); });
+}
+
+template <class T>
+void
+vil_colour_space_YIQ_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_YIQ_to_RGB(in, out); });
+}
+
+template <class T>
+void
+vil_colour_space_RGB_to_YUV(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_RGB_to_YUV(in, out); });
+}
+
+template <class T>
+void
+vil_colour_space_YUV_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_YUV_to_RGB(in, out); });
+}
+
+template <class T>
+void
+vil_colour_space_RGB_to_YPbPr_601(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_RGB_to_YPbPr_601(in, out); });
+}
+
+template <class T>
+void
+vil_colour_space_YPbPr_601_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest)
+{
+  vil_colour_space_apply(src, dest, [](const T * in, T * out) { vil_colour_space_YPbPr_601_to_RGB(in, out); });
+}
+
+void
+vil_colour_space_RGB_to_YCbCr_601(const vil_image_view<unsigned char> & src, vil_image_view<unsigned char> & dest)
+{
+  vil_colour_space_apply(
+    src, dest, [](const unsigned char * in, unsigned char * out) { vil_colour_space_RGB_to_YCbCr_601(in, out); });
+}
+
+void
+vil_colour_space_YCbCr_601_to_RGB(const vil_image_view<unsigned char> & src, vil_image_view<unsigned char> & dest)
+{
+  vil_colour_space_apply(
+    src, dest, [](const unsigned char * in, unsigned char * out) { vil_colour_space_YCbCr_601_to_RGB(in, out); });
+}
+
+//----------------------------------------------------------------------
+
+#define inst(T)                                                                                    \
+  template void vil_colour_space_RGB_to_YIQ(T const[3], T[3]);                                     \
+  template void vil_colour_space_YIQ_to_RGB(T const[3], T[3]);                                     \
+  template void vil_colour_space_RGB_to_HSV(T, T, T, T *, T *, T *);                               \
+  template void vil_colour_space_HSV_to_RGB(T, T, T, T *, T *, T *);                               \
+  template void vil_colour_space_RGB_to_YUV(T const[3], T[3]);                                     \
+  template void vil_colour_space_YUV_to_RGB(T const[3], T[3]);                                     \
+  template void vil_colour_space_RGB_to_YPbPr_601(T const RGB[3], T YPbPr[3]);                     \
+  template void vil_colour_space_YPbPr_601_to_RGB(T const YPbPr[3], T RGB[3]);                     \
+  template void vil_colour_space_RGB_to_YIQ(const vil_image_view<T> &, vil_image_view<T> &);       \
+  template void vil_colour_space_YIQ_to_RGB(const vil_image_view<T> &, vil_image_view<T> &);       \
+  template void vil_colour_space_RGB_to_YUV(const vil_image_view<T> &, vil_image_view<T> &);       \
+  template void vil_colour_space_YUV_to_RGB(const vil_image_view<T> &, vil_image_view<T> &);       \
+  template void vil_colour_space_RGB_to_YPbPr_601(const vil_image_view<T> &, vil_image_view<T> &); \
+  template void vil_colour_space_YPbPr_601_to_RGB(const vil_image_view<T> &, vil_image_view<T> &)
 
 inst(double);
 inst(float);
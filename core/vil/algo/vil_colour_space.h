@@ -10,6 +10,8 @@
 //
 // \author fsm
 
+#include <vil/vil_image_view.h>
+
 //: Linear transformation from RGB to YIQ colour spaces
 template <class T>
 void
@@ -104,4 +106,46 @@ vil_colour_space_RGB_to_YCbCr_601(const unsigned char RGB[3], unsigned char YCbC
 void
 vil_colour_space_YCbCr_601_to_RGB(const unsigned char YCbCr[3], unsigned char RGB[3]);
 
+
+//: Apply vil_colour_space_RGB_to_YIQ to every pixel of a 3 plane image
+//  \p dest is resized as necessary, and may be \p src itself.  Rows whose
+//  planes are each contiguous are converted by a loop the compiler can
+//  vectorise; other layouts are converted a pixel at a time.
+template <class T>
+void
+vil_colour_space_RGB_to_YIQ(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_YIQ_to_RGB to every pixel of a 3 plane image
+template <class T>
+void
+vil_colour_space_YIQ_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_RGB_to_YUV to every pixel of a 3 plane image
+template <class T>
+void
+vil_colour_space_RGB_to_YUV(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_YUV_to_RGB to every pixel of a 3 plane image
+template <class T>
+void
+vil_colour_space_YUV_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_RGB_to_YPbPr_601 to every pixel of a 3 plane image
+template <class T>
+void
+vil_colour_space_RGB_to_YPbPr_601(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_YPbPr_601_to_RGB to every pixel of a 3 plane image
+template <class T>
+void
+vil_colour_space_YPbPr_601_to_RGB(const vil_image_view<T> & src, vil_image_view<T> & dest);
+
+//: Apply vil_colour_space_RGB_to_YCbCr_601 to every pixel of a 3 plane image
+void
+vil_colour_space_RGB_to_YCbCr_601(const vil_image_view<unsigned char> & src, vil_image_view<unsigned char> & dest);
+
+//: Apply vil_colour_space_YCbCr_601_to_RGB to every pixel of a 3 plane image
+void
+vil_colour_space_YCbCr_601_to_RGB(const vil_image_view<unsigned char> & src, vil_image_view<unsigned char> & dest);
+
 #endif // vil_colour_space_h_
@@ -0,0 +1,74 @@
+// This is core/vil/algo/vil_correlate_2d_fft.cxx
+#include <complex>
+#include "vil_correlate_2d_fft.h"
+//:
+// \file
+#include <cassert>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vil/algo/vil_fft.h>
+
+unsigned
+vil_fft_good_size(unsigned n)
+{
+  for (unsigned m = n < 1 ? 1 : n;; ++m)
+  {
+    unsigned r = m;
+    while (r % 2 == 0)
+      r /= 2;
+    while (r % 3 == 0)
+      r /= 3;
+    while (r % 5 == 0)
+      r /= 5;
+    if (r == 1)
+      return m;
+  }
+}
+
+void
+vil_correlate_2d_fft(const vil_image_view<double> & src,
+                     const vil_image_view<double> & kernel,
+                     vil_image_view<double> & dest)
+{
+  const unsigned np = src.nplanes();
+  assert(kernel.nplanes() == np);
+  assert(kernel.ni() <= src.ni() && kernel.nj() <= src.nj());
+  const unsigned ni = 1 + src.ni() - kernel.ni(), nj = 1 + src.nj() - kernel.nj();
+  dest.set_size(ni, nj, 1);
+
+  // Cyclic correlation over n0 x n1 matches the linear one at the valid
+  // positions, as long as the transforms cover the whole of src.
+  const unsigned n0 = vil_fft_good_size(src.ni()), n1 = vil_fft_good_size(src.nj());
+  using cplx = std::complex<double>;
+  vil_image_view<cplx> product(n0, n1), s(n0, n1), k(n0, n1);
+  product.fill(cplx(0.0));
+  for (unsigned p = 0; p < np; ++p)
+  {
+    s.fill(cplx(0.0));
+    k.fill(cplx(0.0));
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        s(i, j) = src(i, j, p);
+    for (unsigned j = 0; j < kernel.nj(); ++j)
+      for (unsigned i = 0; i < kernel.ni(); ++i)
+        k(i, j) = kernel(i, j, p);
+    vil_fft_2d_fwd(s);
+    vil_fft_2d_fwd(k);
+    // The transform of the correlation is S.conj(K).
+    for (unsigned j = 0; j < n1; ++j)
+    {
+      cplx * d = &product(0, j);
+      const cplx *sp = &s(0, j), *kp = &k(0, j);
+      for (unsigned i = 0; i < n0; ++i)
+        d[i] += sp[i] * std::conj(kp[i]);
+    }
+  }
+  vil_fft_2d_bwd(product);
+
+  // vil_fft_2d_fwd scales by 1/(n0*n1), so the product is scaled twice.
+  const double scale = double(n0) * n1;
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      dest(i, j) = scale * product(i, j).real();
+}
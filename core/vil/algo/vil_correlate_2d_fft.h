@@ -0,0 +1,34 @@
+// This is core/vil/algo/vil_correlate_2d_fft.h
+#ifndef vil_correlate_2d_fft_h_
+#define vil_correlate_2d_fft_h_
+//:
+// \file
+// \brief 2D correlation with a large kernel, using the FFT
+//
+// vil_correlate_2d takes time proportional to the kernel area at each
+// pixel. For large kernels it is quicker to multiply the transforms of
+// the image and of the kernel, which takes time proportional to
+// log(image area) at each pixel whatever the size of the kernel.
+
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vil/vil_image_view.h>
+
+//: Smallest n2 >= n with no prime factors other than 2, 3 and 5.
+//  These are the lengths vnl_fft_1d (and so vil_fft_2d_fwd) can handle.
+unsigned
+vil_fft_good_size(unsigned n);
+
+//: Correlation of src with kernel, summed over the planes.
+//  dest is resized to (1+src.ni()-kernel.ni())x(1+src.nj()-kernel.nj()),
+//  and on exit dest(x,y) = sum_ijp src(x+i,y+j,p)*kernel(i,j,p), as
+//  vil_correlate_2d gives for one plane. The sums are found by FFT, so are
+//  only accurate to around 1e-12 of the largest products.
+// \relatesalso vil_image_view
+void
+vil_correlate_2d_fft(const vil_image_view<double> & src,
+                     const vil_image_view<double> & kernel,
+                     vil_image_view<double> & dest);
+
+#endif // vil_correlate_2d_fft_h_
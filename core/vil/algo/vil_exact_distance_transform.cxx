@@ -0,0 +1,195 @@
+// This is core/vil/algo/vil_exact_distance_transform.cxx
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "vil_exact_distance_transform.h"
+//:
+// \file
+#include <cassert>
+#include <vpl/vpl_thread_pool.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+void
+vil_exact_distance_transform_1d(const vxl_uint_32 * f,
+                                std::ptrdiff_t f_step,
+                                unsigned n,
+                                vxl_uint_32 * d,
+                                std::ptrdiff_t d_step,
+                                vxl_uint_32 * arg,
+                                std::ptrdiff_t arg_step,
+                                vil_edt_workspace & ws)
+{
+  ws.site.resize(n);
+  ws.value.resize(n);
+  ws.start.resize(n);
+  unsigned * site = ws.site.data();
+  vxl_uint_32 * value = ws.value.data();
+  unsigned * start = ws.start.data();
+
+  // Build the lower envelope of the parabolas (x-u)^2+f(u), left to right.
+  int q = -1;
+  for (unsigned u = 0; u < n; ++u)
+  {
+    const vxl_uint_32 fu = f[u * f_step];
+    if (fu == vil_edt_infinity)
+      continue;
+    // Drop parabolas which are above the new one where they start.
+    while (q >= 0)
+    {
+      const vxl_int_64 x = start[q], a = x - site[q], b = x - vxl_int_64(u);
+      if (a * a + value[q] <= b * b + fu)
+        break;
+      --q;
+    }
+    if (q < 0)
+    {
+      q = 0;
+      site[0] = u;
+      value[0] = fu;
+      start[0] = 0;
+      continue;
+    }
+    // The new parabola is lowest after position sep.
+    const vxl_int_64 i = site[q];
+    const vxl_int_64 num = vxl_int_64(u) * u - i * i + vxl_int_64(fu) - vxl_int_64(value[q]);
+    const vxl_int_64 den = 2 * (vxl_int_64(u) - i);
+    const vxl_int_64 sep = num >= 0 ? num / den : -((den - 1 - num) / den);
+    if (sep + 1 < vxl_int_64(n))
+    {
+      ++q;
+      site[q] = u;
+      value[q] = fu;
+      start[q] = unsigned(sep + 1);
+    }
+  }
+
+  if (q < 0)
+  {
+    for (unsigned x = 0; x < n; ++x)
+    {
+      d[x * d_step] = vil_edt_infinity;
+      if (arg)
+        arg[x * arg_step] = vil_edt_infinity;
+    }
+    return;
+  }
+  for (int x = int(n) - 1; x >= 0; --x)
+  {
+    const vxl_int_64 a = x - vxl_int_64(site[q]);
+    const vxl_int_64 v = a * a + value[q];
+    assert(v < vxl_int_64(vil_edt_infinity));
+    d[x * d_step] = vxl_uint_32(v);
+    if (arg)
+      arg[x * arg_step] = site[q];
+    if (unsigned(x) == start[q])
+      --q;
+  }
+}
+
+//: Compute d2 and, if nearest is not null, the nearest feature.
+static void
+vil_exact_distance_transform_2d(const vil_image_view<bool> & mask,
+                                vil_image_view<vxl_uint_32> & d2,
+                                vil_image_view<vxl_uint_32> * nearest)
+{
+  assert(mask.nplanes() == 1);
+  const unsigned ni = mask.ni(), nj = mask.nj();
+  assert(ni <= 46340 && nj <= 46340);
+  d2.set_size(ni, nj, 1);
+  if (nearest)
+    nearest->set_size(ni, nj, 1);
+  if (ni == 0 || nj == 0)
+    return;
+
+  // Down the columns: distance to the nearest feature in the column, and
+  // its row, by a scan down and a scan up. Threads take bands of columns.
+  const unsigned band = 256;
+  const unsigned n_bands = (ni + band - 1) / band;
+  vpl_parallel_for(0u, n_bands, [&](unsigned b) {
+    const unsigned i0 = b * band, i1 = std::min(ni, i0 + band);
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = i0; i < i1; ++i)
+      {
+        if (mask(i, j))
+        {
+          d2(i, j) = 0;
+          if (nearest)
+            (*nearest)(i, j) = j;
+        }
+        else if (j > 0 && d2(i, j - 1) != vil_edt_infinity)
+        {
+          d2(i, j) = d2(i, j - 1) + 1;
+          if (nearest)
+            (*nearest)(i, j) = (*nearest)(i, j - 1);
+        }
+        else
+          d2(i, j) = vil_edt_infinity;
+      }
+    for (unsigned j = nj - 1; j-- > 0;)
+      for (unsigned i = i0; i < i1; ++i)
+        if (d2(i, j + 1) != vil_edt_infinity && d2(i, j + 1) + 1 < d2(i, j))
+        {
+          d2(i, j) = d2(i, j + 1) + 1;
+          if (nearest)
+            (*nearest)(i, j) = (*nearest)(i, j + 1);
+        }
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = i0; i < i1; ++i)
+        if (d2(i, j) != vil_edt_infinity)
+          d2(i, j) *= d2(i, j);
+  }, 1u);
+
+  // Along the rows: lower envelope of the column distances.
+  vpl_parallel_for_range(0u, nj, [&](unsigned j0, unsigned j1) {
+    vil_edt_workspace ws;
+    std::vector<vxl_uint_32> row, col;
+    if (nearest)
+    {
+      row.resize(ni);
+      col.resize(ni);
+    }
+    for (unsigned j = j0; j < j1; ++j)
+    {
+      if (!nearest)
+      {
+        vil_exact_distance_transform_1d(&d2(0, j), d2.istep(), ni, &d2(0, j), d2.istep(), nullptr, 0, ws);
+        continue;
+      }
+      for (unsigned i = 0; i < ni; ++i)
+        row[i] = (*nearest)(i, j);
+      vil_exact_distance_transform_1d(&d2(0, j), d2.istep(), ni, &d2(0, j), d2.istep(), col.data(), 1, ws);
+      for (unsigned i = 0; i < ni; ++i)
+        (*nearest)(i, j) = col[i] == vil_edt_infinity ? vil_edt_infinity : row[col[i]] * ni + col[i];
+    }
+  });
+}
+
+void
+vil_exact_distance_transform_r2(const vil_image_view<bool> & mask,
+                                vil_image_view<vxl_uint_32> & d2)
+{
+  vil_exact_distance_transform_2d(mask, d2, nullptr);
+}
+
+void
+vil_exact_distance_transform_r2(const vil_image_view<bool> & mask,
+                                vil_image_view<vxl_uint_32> & d2,
+                                vil_image_view<vxl_uint_32> & nearest)
+{
+  vil_exact_distance_transform_2d(mask, d2, &nearest);
+}
+
+void
+vil_exact_distance_transform(const vil_image_view<bool> & mask, vil_image_view<float> & distance)
+{
+  vil_image_view<vxl_uint_32> d2;
+  vil_exact_distance_transform_2d(mask, d2, nullptr);
+  const unsigned ni = d2.ni(), nj = d2.nj();
+  distance.set_size(ni, nj, 1);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      distance(i, j) =
+        d2(i, j) == vil_edt_infinity ? std::numeric_limits<float>::max() : float(std::sqrt(double(d2(i, j))));
+}
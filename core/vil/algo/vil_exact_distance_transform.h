@@ -0,0 +1,86 @@
+// This is core/vil/algo/vil_exact_distance_transform.h
+#ifndef vil_exact_distance_transform_h_
+#define vil_exact_distance_transform_h_
+//:
+// \file
+// \brief Exact Euclidean distance transform, in linear time
+//
+// vil_distance_transform propagates chamfer distances, which are only
+// approximately Euclidean. The functions here give the exact distance
+// from every pixel to the nearest true pixel of a mask, using the
+// separable method of Meijster et al. ("A general algorithm for computing
+// distance transforms in linear time", 2000), with the lower envelope of
+// parabolas of Felzenszwalb and Huttenlocher along the rows:
+// -# down each column, the distance to the nearest feature in that column
+//    (two scans of whole rows, with columns shared between threads);
+// -# along each row, the lower envelope of the parabolas (i-u)^2+g(u)^2
+//    given by the column distances g (rows shared between threads).
+// The threads are those of the vpl pool; see vpl_set_concurrency().
+//
+// Squared distances are integers, so they are returned exactly as
+// vxl_uint_32 values, which limits images to 46340 pixels on a side. The
+// nearest feature can also be found; it is given as its raster index
+// j*ni+i.
+
+#include <cstddef>
+#include <vector>
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vil/vil_image_view.h>
+
+//: Squared distance (and nearest feature index) where there is no feature.
+const vxl_uint_32 vil_edt_infinity = 0xffffffffu;
+
+//: Workspace for vil_exact_distance_transform_1d.
+struct vil_edt_workspace
+{
+  //: Positions of the parabolas in the lower envelope.
+  std::vector<unsigned> site;
+  //: Values of f at the sites.
+  std::vector<vxl_uint_32> value;
+  //: First position at which each parabola is lowest.
+  std::vector<unsigned> start;
+};
+
+//: One dimensional squared distance transform of a sampled function.
+//  d(x) = min_u (x-u)^2 + f(u) for 0<=x,u<n, where f(x) = f[x*f_step] and
+//  d(x) = d[x*d_step]. f values of vil_edt_infinity are ignored, and d is
+//  vil_edt_infinity everywhere if all of f is. If arg is not null,
+//  arg[x*arg_step] is set to the minimising u. d may be f.
+void
+vil_exact_distance_transform_1d(const vxl_uint_32 * f,
+                                std::ptrdiff_t f_step,
+                                unsigned n,
+                                vxl_uint_32 * d,
+                                std::ptrdiff_t d_step,
+                                vxl_uint_32 * arg,
+                                std::ptrdiff_t arg_step,
+                                vil_edt_workspace & ws);
+
+//: Squared Euclidean distance from each pixel to the nearest true pixel of mask.
+//  Pixels are vil_edt_infinity if mask has no true pixel.
+// \relatesalso vil_image_view
+void
+vil_exact_distance_transform_r2(const vil_image_view<bool> & mask,
+                                vil_image_view<vxl_uint_32> & d2);
+
+//: Squared distance from each pixel to the nearest true pixel of mask, and that pixel.
+//  nearest(i,j) is the raster index j*ni+i of the nearest true pixel of
+//  mask (or vil_edt_infinity, if there are none). Where several are
+//  equally near, the choice is arbitrary.
+// \relatesalso vil_image_view
+void
+vil_exact_distance_transform_r2(const vil_image_view<bool> & mask,
+                                vil_image_view<vxl_uint_32> & d2,
+                                vil_image_view<vxl_uint_32> & nearest);
+
+//: Euclidean distance from each pixel to the nearest true pixel of mask.
+//  Pixels are the largest float if mask has no true pixel.
+// \relatesalso vil_image_view
+void
+vil_exact_distance_transform(const vil_image_view<bool> & mask,
+                             vil_image_view<float> & distance);
+
+#endif // vil_exact_distance_transform_h_
@@ -7,6 +7,7 @@
 // \author Tim Cootes
 
 #include "vil_greyscale_dilate.h"
+#include "vil_box_morphology.hxx"
 #include <cassert>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
@@ -22,6 +23,12 @@ vil_greyscale_dilate(const vil_image_view<T> & src_image,
                      const vil_structuring_element & element)
 {
   assert(src_image.nplanes() == 1);
+  if (vil_structuring_element_is_box(element))
+  {
+    // Separable running maximum, constant time per pixel.
+    vil_greyscale_dilate_box(src_image, dest_image, element.min_i(), element.max_i(), element.min_j(), element.max_j());
+    return;
+  }
   unsigned ni = src_image.ni();
   unsigned nj = src_image.nj();
   dest_image.set_size(ni, nj, 1);
@@ -0,0 +1,173 @@
+// This is core/vil/algo/vil_integral_image.h
+#ifndef vil_integral_image_h_
+#define vil_integral_image_h_
+//:
+// \file
+// \brief Integral images of values and squared values, and box mean/variance filters
+//
+// vil_integral_image holds the sums of the values and of the squared
+// values of one plane of an image over every rectangle with corner (0,0),
+// so that the sum, mean or variance over any rectangle takes four look-ups
+// each. vil_math_integral_image gives the same sums for one image; this
+// class keeps the two together and chooses the accumulator: use a 64 bit
+// integer type for exact sums of integer images, or double.
+//
+// vil_box_mean_variance uses it to give the mean and variance under a
+// window at every position, in constant time per pixel.
+
+#include <cassert>
+#include <cstddef>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vil/vil_image_view.h>
+
+//: Integral images of the values and of the squared values of one image plane.
+//  sum_image()(i,j) is the sum of src(x,y) for x<i, y<j.
+template <class sumT>
+class vil_integral_image
+{
+public:
+  vil_integral_image() = default;
+
+  //: Compute the integral images of plane p of src.
+  template <class srcT>
+  explicit vil_integral_image(const vil_image_view<srcT> & src, unsigned p = 0)
+  {
+    set_image(src, p);
+  }
+
+  //: Compute the integral images of plane p of src.
+  template <class srcT>
+  void
+  set_image(const vil_image_view<srcT> & src, unsigned p = 0)
+  {
+    assert(p < src.nplanes() || src.size() == 0);
+    const unsigned ni = src.ni(), nj = src.nj();
+    sum_.set_size(ni + 1, nj + 1);
+    sum_sq_.set_size(ni + 1, nj + 1);
+    for (unsigned i = 0; i <= ni; ++i)
+      sum_(i, 0) = sum_sq_(i, 0) = 0;
+    for (unsigned j = 0; j < nj; ++j)
+    {
+      // Sums along the row so far, added to the row above.
+      const sumT * above = &sum_(0, j);
+      const sumT * above_sq = &sum_sq_(0, j);
+      sumT * row = &sum_(0, j + 1);
+      sumT * row_sq = &sum_sq_(0, j + 1);
+      row[0] = row_sq[0] = 0;
+      sumT s = 0, s_sq = 0;
+      for (unsigned i = 0; i < ni; ++i)
+      {
+        const sumT v = sumT(src(i, j, p));
+        s += v;
+        s_sq += v * v;
+        row[i + 1] = above[i + 1] + s;
+        row_sq[i + 1] = above_sq[i + 1] + s_sq;
+      }
+    }
+  }
+
+  //: Width of the source image.
+  unsigned
+  ni() const
+  {
+    return sum_.ni() == 0 ? 0 : sum_.ni() - 1;
+  }
+
+  //: Height of the source image.
+  unsigned
+  nj() const
+  {
+    return sum_.nj() == 0 ? 0 : sum_.nj() - 1;
+  }
+
+  //: Sum of src(x,y) over i0<=x<i1, j0<=y<j1.
+  sumT
+  sum(unsigned i0, unsigned j0, unsigned i1, unsigned j1) const
+  {
+    return sum_(i1, j1) - sum_(i0, j1) - sum_(i1, j0) + sum_(i0, j0);
+  }
+
+  //: Sum of src(x,y)^2 over i0<=x<i1, j0<=y<j1.
+  sumT
+  sum_sq(unsigned i0, unsigned j0, unsigned i1, unsigned j1) const
+  {
+    return sum_sq_(i1, j1) - sum_sq_(i0, j1) - sum_sq_(i1, j0) + sum_sq_(i0, j0);
+  }
+
+  //: The (ni+1)x(nj+1) integral image of the values.
+  const vil_image_view<sumT> &
+  sum_image() const
+  {
+    return sum_;
+  }
+
+  //: The (ni+1)x(nj+1) integral image of the squared values.
+  const vil_image_view<sumT> &
+  sum_sq_image() const
+  {
+    return sum_sq_;
+  }
+
+private:
+  vil_image_view<sumT> sum_;
+  vil_image_view<sumT> sum_sq_;
+};
+
+//: Mean and variance of the wi x wj window with corner (i,j), at every (i,j).
+//  mean and var are resized to (1+ni-wi)x(1+nj-wj), so the windows lie
+//  inside the image (as in vil_normalised_correlation_2d). The variance is
+//  that of the population, sum(x^2)/n - mean^2.
+// \relatesalso vil_integral_image
+template <class sumT, class destT>
+inline void
+vil_box_mean_variance(const vil_integral_image<sumT> & integral,
+                      unsigned wi,
+                      unsigned wj,
+                      vil_image_view<destT> & mean,
+                      vil_image_view<destT> & var)
+{
+  assert(wi > 0 && wj > 0 && wi <= integral.ni() && wj <= integral.nj());
+  const unsigned ni = 1 + integral.ni() - wi, nj = 1 + integral.nj() - wj;
+  mean.set_size(ni, nj, 1);
+  var.set_size(ni, nj, 1);
+  const double n = double(wi) * wj;
+  const vil_image_view<sumT> & s = integral.sum_image();
+  const vil_image_view<sumT> & s2 = integral.sum_sq_image();
+  const std::ptrdiff_t m_istep = mean.istep(), v_istep = var.istep();
+  for (unsigned j = 0; j < nj; ++j)
+  {
+    // Corners of the windows along row j; the integral images have istep 1.
+    const sumT *a = &s(0, j), *b = &s(wi, j), *c = &s(0, j + wj), *d = &s(wi, j + wj);
+    const sumT *a2 = &s2(0, j), *b2 = &s2(wi, j), *c2 = &s2(0, j + wj), *d2 = &s2(wi, j + wj);
+    destT * m = &mean(0, j);
+    destT * v = &var(0, j);
+    for (unsigned i = 0; i < ni; ++i, m += m_istep, v += v_istep)
+    {
+      const double mu = double(d[i] - b[i] - c[i] + a[i]) / n;
+      const double sq = double(d2[i] - b2[i] - c2[i] + a2[i]) / n;
+      *m = destT(mu);
+      *v = destT(sq > mu * mu ? sq - mu * mu : 0.0);
+    }
+  }
+}
+
+//: Mean and variance of src under the wi x wj window with corner (i,j), at every (i,j).
+//  Uses a vil_integral_image<sumT> of plane p of src; sumT should be
+//  vxl_int_64 or vxl_uint_64 for exact sums of integer data, or double.
+// \relatesalso vil_image_view
+template <class srcT, class sumT, class destT>
+inline void
+vil_box_mean_variance(const vil_image_view<srcT> & src,
+                      unsigned wi,
+                      unsigned wj,
+                      vil_image_view<destT> & mean,
+                      vil_image_view<destT> & var,
+                      sumT,
+                      unsigned p = 0)
+{
+  vil_box_mean_variance(vil_integral_image<sumT>(src, p), wi, wj, mean, var);
+}
+
+#endif // vil_integral_image_h_
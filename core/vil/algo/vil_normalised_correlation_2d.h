@@ -8,7 +8,10 @@
 
 #include <cmath>
 #include <cstddef>
+#include <vector>
 #include <vil/vil_image_view.h>
+#include <vil/algo/vil_correlate_2d_fft.h>
+#include <vil/algo/vil_integral_image.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -101,4 +104,105 @@ vil_normalised_correlation_2d(const vil_image_view<srcT> & src_im,
   }
 }
 
+//: Kernels with more elements than this are correlated using the FFT.
+const unsigned vil_normalised_correlation_fft_threshold = 100;
+
+//: Normalised cross-correlation of (pre-normalised) kernel with srcT, in time independent of the kernel size.
+// Gives the same result as vil_normalised_correlation_2d, calculated in
+// double precision, but finds the mean and variance under each position
+// of the kernel from a vil_integral_image of each plane, and, for kernels
+// with more than vil_normalised_correlation_fft_threshold elements, the
+// dot products by vil_correlate_2d_fft.  The variance is found as the
+// difference of two sums, so where it is no more than 1e-12 of the mean
+// square it is taken as lost in their rounding, and dest is 0 there;
+// vil_normalised_correlation_2d only gives 0 where the variance is 0.
+//
+// Assumes that the kernel has been normalised to have zero mean
+// and unit variance
+// \relatesalso vil_image_view
+template <class srcT, class destT, class kernelT>
+inline void
+vil_normalised_correlation_2d_fast(const vil_image_view<srcT> & src_im,
+                                   vil_image_view<destT> & dest_im,
+                                   const vil_image_view<kernelT> & kernel)
+{
+  const unsigned kni = kernel.ni(), knj = kernel.nj(), np = kernel.nplanes();
+  assert(1 + src_im.ni() >= kni && 1 + src_im.nj() >= knj);
+  assert(src_im.nplanes() == np);
+  const unsigned ni = 1 + src_im.ni() - kni, nj = 1 + src_im.nj() - knj;
+
+  // Sum of products under each position of the kernel.
+  vil_image_view<double> dot(ni, nj);
+  if (std::size_t(kni) * knj * np > vil_normalised_correlation_fft_threshold)
+  {
+    vil_image_view<double> src_d(src_im.ni(), src_im.nj(), np), kernel_d(kni, knj, np);
+    for (unsigned p = 0; p < np; ++p)
+    {
+      for (unsigned j = 0; j < src_im.nj(); ++j)
+        for (unsigned i = 0; i < src_im.ni(); ++i)
+          src_d(i, j, p) = double(src_im(i, j, p));
+      for (unsigned j = 0; j < knj; ++j)
+        for (unsigned i = 0; i < kni; ++i)
+          kernel_d(i, j, p) = double(kernel(i, j, p));
+    }
+    vil_correlate_2d_fft(src_d, kernel_d, dot);
+  }
+  else
+  {
+    dot.fill(0.0);
+    for (unsigned p = 0; p < np; ++p)
+      for (unsigned kj = 0; kj < knj; ++kj)
+        for (unsigned ki = 0; ki < kni; ++ki)
+        {
+          // Add the shifted image times one kernel element, a row at a time.
+          const double k = double(kernel(ki, kj, p));
+          const std::ptrdiff_t s_istep = src_im.istep();
+          for (unsigned j = 0; j < nj; ++j)
+          {
+            const srcT * s = &src_im(ki, j + kj, p);
+            double * d = &dot(0, j);
+            if (s_istep == 1) // contiguous rows, which the compiler can vectorise
+              for (unsigned i = 0; i < ni; ++i)
+                d[i] += k * double(s[i]);
+            else
+              for (unsigned i = 0; i < ni; ++i)
+                d[i] += k * double(s[i * s_istep]);
+          }
+        }
+  }
+
+  // Mean and variance under each position, over all the planes.
+  vil_image_view<double> sum(ni, nj), sum_sq(ni, nj);
+  sum.fill(0.0);
+  sum_sq.fill(0.0);
+  vil_integral_image<double> integral;
+  for (unsigned p = 0; p < np; ++p)
+  {
+    integral.set_image(src_im, p);
+    const vil_image_view<double> &s = integral.sum_image(), &s2 = integral.sum_sq_image();
+    for (unsigned j = 0; j < nj; ++j)
+    {
+      const double *a = &s(0, j), *b = &s(kni, j), *c = &s(0, j + knj), *d = &s(kni, j + knj);
+      const double *a2 = &s2(0, j), *b2 = &s2(kni, j), *c2 = &s2(0, j + knj), *d2 = &s2(kni, j + knj);
+      double *m = &sum(0, j), *m2 = &sum_sq(0, j);
+      for (unsigned i = 0; i < ni; ++i)
+      {
+        m[i] += d[i] - b[i] - c[i] + a[i];
+        m2[i] += d2[i] - b2[i] - c2[i] + a2[i];
+      }
+    }
+  }
+
+  dest_im.set_size(ni, nj, 1);
+  const double n = double(kni) * knj * np;
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+    {
+      // Variances lost in the rounding of the sums are taken as zero.
+      const double mean = sum(i, j) / n, mean_sq = sum_sq(i, j) / n;
+      const double var = mean_sq - mean * mean;
+      dest_im(i, j) = destT(var <= 1e-12 * mean_sq ? 0.0 : dot(i, j) / std::sqrt(var));
+    }
+}
+
 #endif // vil_normalised_correlation_2d_h_
@@ -0,0 +1,169 @@
+// This is core/vil/algo/vil_rank_filter.h
+#ifndef vil_rank_filter_h_
+#define vil_rank_filter_h_
+//:
+// \file
+// \brief Rank (e.g. median) filters over rectangles, using sliding histograms
+//
+// vil_median sorts the neighbourhood of every pixel, so its cost grows with
+// the area of the structuring element. For 8 and 16 bit unsigned images,
+// the functions here use the method of Perreault and Hebert ("Median
+// filtering in constant time", IEEE TIP 2007): every image column keeps a
+// histogram of the pixels in its part of the window, which is updated by
+// one pixel in and one out as the window moves down; the window histogram
+// is the sum of the column histograms under it, updated by one column in
+// and one out as it moves along the row. Histograms have two levels, on
+// the high and low halves of the pixel value. The window's fine (low half)
+// histograms are only brought up to date for the coarse bin that holds the
+// requested rank, so the cost per pixel is nearly independent of the
+// window size.
+//
+// Column histograms for 16-bit data are large, so the image is split into
+// vertical strips, each needing histograms only for its own columns; the
+// strips are processed concurrently on the vpl thread pool.
+//
+// Near the image border only the pixels inside the image are ranked, and
+// rank r picks sorted value number r*(n-1) of the n pixels, exactly as
+// vil_median and vil_sorted_value do.
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vil/vil_image_view.h>
+#include <vil/algo/vil_structuring_element.h>
+
+//: True for the pixel types handled by vil_rank_histogram (vxl_byte, vxl_uint_16).
+template <class T>
+struct vil_rank_histogram_supported : std::false_type
+{};
+template <>
+struct vil_rank_histogram_supported<vxl_byte> : std::true_type
+{};
+template <>
+struct vil_rank_histogram_supported<vxl_uint_16> : std::true_type
+{};
+
+//: Two level histograms of a row of columns, plus a sliding sum over a range of them.
+// Used to implement sliding window rank filters. Each column can hold at
+// most 65535 values.
+template <class T>
+class vil_rank_histogram
+{
+public:
+  explicit vil_rank_histogram(unsigned n_columns = 0) { set_size(n_columns); }
+
+  //: Set the number of columns, and empty all histograms.
+  void
+  set_size(unsigned n_columns);
+
+  //: Add value v to column c.
+  void
+  add(unsigned c, T v)
+  {
+    ++coarse_[c * n_bins + (v >> half_bits)];
+    ++fine_[(std::size_t(c) * n_bins + (v >> half_bits)) * n_bins + (v & (n_bins - 1))];
+  }
+
+  //: Remove value v from column c.
+  void
+  remove(unsigned c, T v)
+  {
+    --coarse_[c * n_bins + (v >> half_bits)];
+    --fine_[(std::size_t(c) * n_bins + (v >> half_bits)) * n_bins + (v & (n_bins - 1))];
+  }
+
+  //: Make the window cover columns [c0,c1].
+  void
+  set_window(int c0, int c1);
+
+  //: Move the window to columns [c0,c1]. Neither end may move left.
+  void
+  move_window(int c0, int c1);
+
+  //: The value of rank t (counting from 0) among all the values in the window.
+  T
+  rank(std::size_t t);
+
+private:
+  enum
+  {
+    half_bits = 4 * sizeof(T),
+    n_bins = 1 << half_bits
+  };
+
+  //: Bring the window's fine histogram for coarse bin c up to date.
+  void
+  update_fine(unsigned c);
+
+  //: Column histograms of the high halves of the values.
+  std::vector<vxl_uint_16> coarse_;
+  //: Column histograms of the low halves, for each coarse bin.
+  std::vector<vxl_uint_16> fine_;
+  //: Window histogram of the high halves.
+  std::vector<unsigned> window_coarse_;
+  //: Window fine histograms; bin c covers columns [fine_c0_[c],fine_c1_[c]].
+  std::vector<unsigned> window_fine_;
+  std::vector<int> fine_c0_, fine_c1_;
+  int c0_{ 0 }, c1_{ -1 };
+};
+
+//: Rank filter over a rectangle.
+// dest(i,j) is value number r*(n-1) of the sorted values of the n pixels
+// src(i+a,j+b) inside the image, for ilo<=a<=ihi and jlo<=b<=jhi.
+// The rectangle must contain (0,0). Each plane is filtered independently.
+// \param r in [0,1], 0.5 gives the median.
+template <class T>
+void
+vil_rank_filter_box(const vil_image_view<T> & src,
+                    vil_image_view<T> & dest,
+                    int ilo,
+                    int ihi,
+                    int jlo,
+                    int jhi,
+                    double r);
+
+//: Median over a (2ri+1)x(2rj+1) rectangle centred on each pixel.
+template <class T>
+inline void
+vil_median_box(const vil_image_view<T> & src,
+               vil_image_view<T> & dest,
+               unsigned ri,
+               unsigned rj)
+{
+  vil_rank_filter_box(src, dest, -int(ri), int(ri), -int(rj), int(rj), 0.5);
+}
+
+//: Apply vil_rank_filter_box if element is a box; otherwise return false.
+// Used by vil_median to switch to the sliding histogram method when it can.
+template <class T>
+inline bool
+vil_rank_filter_if_box(const vil_image_view<T> &,
+                       vil_image_view<T> &,
+                       const vil_structuring_element &,
+                       double,
+                       std::false_type)
+{
+  return false;
+}
+
+template <class T>
+inline bool
+vil_rank_filter_if_box(const vil_image_view<T> & src,
+                       vil_image_view<T> & dest,
+                       const vil_structuring_element & element,
+                       double r,
+                       std::true_type)
+{
+  if (!vil_structuring_element_is_box(element) || element.max_j() - element.min_j() >= 65535)
+    return false;
+  vil_rank_filter_box(src, dest, element.min_i(), element.max_i(), element.min_j(), element.max_j(), r);
+  return true;
+}
+
+#define VIL_RANK_FILTER_INSTANTIATE(T) extern "please include vil/algo/vil_rank_filter.hxx first"
+
+#endif // vil_rank_filter_h_
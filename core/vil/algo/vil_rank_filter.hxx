@@ -0,0 +1,216 @@
+// This is core/vil/algo/vil_rank_filter.hxx
+#ifndef vil_rank_filter_hxx_
+#define vil_rank_filter_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include "vil_rank_filter.h"
+#include <vpl/vpl_thread_pool.h>
+#include <cassert>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+template <class T>
+void
+vil_rank_histogram<T>::set_size(unsigned n_columns)
+{
+  coarse_.assign(std::size_t(n_columns) * n_bins, 0);
+  fine_.assign(std::size_t(n_columns) * n_bins * n_bins, 0);
+  window_coarse_.assign(n_bins, 0u);
+  window_fine_.assign(n_bins * n_bins, 0u);
+  fine_c0_.assign(n_bins, 0);
+  fine_c1_.assign(n_bins, -1);
+  c0_ = 0;
+  c1_ = -1;
+}
+
+template <class T>
+void
+vil_rank_histogram<T>::set_window(int c0, int c1)
+{
+  std::fill(window_coarse_.begin(), window_coarse_.end(), 0u);
+  for (int c = c0; c <= c1; ++c)
+  {
+    const vxl_uint_16 * h = &coarse_[std::size_t(c) * n_bins];
+    for (unsigned b = 0; b < n_bins; ++b)
+      window_coarse_[b] += h[b];
+  }
+  // Mark every fine histogram as out of date.
+  std::fill(fine_c0_.begin(), fine_c0_.end(), 0);
+  std::fill(fine_c1_.begin(), fine_c1_.end(), -1);
+  c0_ = c0;
+  c1_ = c1;
+}
+
+template <class T>
+void
+vil_rank_histogram<T>::move_window(int c0, int c1)
+{
+  assert(c0 >= c0_ && c1 >= c1_);
+  for (int c = c0_; c < c0 && c <= c1_; ++c)
+  {
+    const vxl_uint_16 * h = &coarse_[std::size_t(c) * n_bins];
+    for (unsigned b = 0; b < n_bins; ++b)
+      window_coarse_[b] -= h[b];
+  }
+  for (int c = std::max(c1_ + 1, c0); c <= c1; ++c)
+  {
+    const vxl_uint_16 * h = &coarse_[std::size_t(c) * n_bins];
+    for (unsigned b = 0; b < n_bins; ++b)
+      window_coarse_[b] += h[b];
+  }
+  c0_ = c0;
+  c1_ = c1;
+}
+
+template <class T>
+void
+vil_rank_histogram<T>::update_fine(unsigned cb)
+{
+  unsigned * w = &window_fine_[cb * n_bins];
+  const int f0 = fine_c0_[cb], f1 = fine_c1_[cb];
+  const std::size_t col_step = std::size_t(n_bins) * n_bins;
+  const vxl_uint_16 * col0 = &fine_[std::size_t(cb) * n_bins];
+  if (f1 < f0 || f1 < c0_ || (c0_ - f0) + (c1_ - f1) > c1_ - c0_ + 1)
+  {
+    // Cheaper to start again than to update.
+    std::fill(w, w + n_bins, 0u);
+    for (int c = c0_; c <= c1_; ++c)
+    {
+      const vxl_uint_16 * h = col0 + c * col_step;
+      for (unsigned b = 0; b < n_bins; ++b)
+        w[b] += h[b];
+    }
+  }
+  else
+  {
+    for (int c = f0; c < c0_; ++c)
+    {
+      const vxl_uint_16 * h = col0 + c * col_step;
+      for (unsigned b = 0; b < n_bins; ++b)
+        w[b] -= h[b];
+    }
+    for (int c = f1 + 1; c <= c1_; ++c)
+    {
+      const vxl_uint_16 * h = col0 + c * col_step;
+      for (unsigned b = 0; b < n_bins; ++b)
+        w[b] += h[b];
+    }
+  }
+  fine_c0_[cb] = c0_;
+  fine_c1_[cb] = c1_;
+}
+
+template <class T>
+T
+vil_rank_histogram<T>::rank(std::size_t t)
+{
+  std::size_t n = 0;
+  unsigned cb = 0;
+  while (n + window_coarse_[cb] <= t)
+    n += window_coarse_[cb++];
+  assert(cb < n_bins);
+  update_fine(cb);
+  const unsigned * w = &window_fine_[cb * n_bins];
+  unsigned fb = 0;
+  while (n + w[fb] <= t)
+    n += w[fb++];
+  return T((cb << half_bits) | fb);
+}
+
+//: Rank filter plane p of the columns [x0,x1) of src into dest.
+template <class T>
+void
+vil_rank_filter_box_strip(const vil_image_view<T> & src,
+                          vil_image_view<T> & dest,
+                          unsigned p,
+                          int x0,
+                          int x1,
+                          int ilo,
+                          int ihi,
+                          int jlo,
+                          int jhi,
+                          double r,
+                          vil_rank_histogram<T> & hist)
+{
+  const int ni = src.ni(), nj = src.nj();
+  // Columns needed for this strip.
+  const int c_first = std::max(0, x0 + ilo), c_last = std::min(ni - 1, x1 - 1 + ihi);
+  hist.set_size(c_last - c_first + 1);
+
+  int row0 = 0, row1 = -1; // rows currently held by the column histograms
+  for (int y = 0; y < nj; ++y)
+  {
+    const int r0 = std::max(0, y + jlo), r1 = std::min(nj - 1, y + jhi);
+    for (int row = row0; row < r0 && row <= row1; ++row)
+      for (int c = c_first; c <= c_last; ++c)
+        hist.remove(c - c_first, src(c, row, p));
+    for (int row = std::max(row1 + 1, r0); row <= r1; ++row)
+      for (int c = c_first; c <= c_last; ++c)
+        hist.add(c - c_first, src(c, row, p));
+    row0 = r0;
+    row1 = r1;
+    const std::size_t n_rows = r1 - r0 + 1;
+
+    for (int x = x0; x < x1; ++x)
+    {
+      const int k0 = std::max(0, x + ilo), k1 = std::min(ni - 1, x + ihi);
+      if (x == x0)
+        hist.set_window(k0 - c_first, k1 - c_first);
+      else
+        hist.move_window(k0 - c_first, k1 - c_first);
+      const std::size_t n = n_rows * (k1 - k0 + 1);
+      dest(x, y, p) = hist.rank(std::size_t(r * (n - 1)));
+    }
+  }
+}
+
+template <class T>
+void
+vil_rank_filter_box(const vil_image_view<T> & src,
+                    vil_image_view<T> & dest,
+                    int ilo,
+                    int ihi,
+                    int jlo,
+                    int jhi,
+                    double r)
+{
+  assert(ilo <= 0 && ihi >= 0 && jlo <= 0 && jhi >= 0);
+  assert(r >= 0.0 && r <= 1.0);
+  // Each column histogram bin must be able to count a whole column of the window.
+  assert(jhi - jlo < 65535);
+  const unsigned ni = src.ni(), nj = src.nj(), np = src.nplanes();
+  dest.set_size(ni, nj, np);
+  if (ni == 0 || nj == 0)
+    return;
+
+  // Strips are narrow for 16 bit data, whose column histograms are large.
+  const unsigned n_threads = vpl_concurrency();
+  const unsigned max_width = sizeof(T) == 1 ? 1024 : 128;
+  const unsigned width = std::max(1u, std::min(max_width, (ni + n_threads - 1) / n_threads));
+  const unsigned n_strips = (ni + width - 1) / width;
+  vpl_parallel_for_range(0u, n_strips * np, [&](unsigned first, unsigned last) {
+    vil_rank_histogram<T> hist;
+    for (unsigned k = first; k < last; ++k)
+    {
+      const unsigned p = k / n_strips, s = k % n_strips;
+      const int x0 = s * width, x1 = std::min(ni, (s + 1) * width);
+      vil_rank_filter_box_strip(src, dest, p, x0, x1, ilo, ihi, jlo, jhi, r, hist);
+    }
+  });
+}
+
+#undef VIL_RANK_FILTER_INSTANTIATE
+#define VIL_RANK_FILTER_INSTANTIATE(T)    \
+  template class vil_rank_histogram<T>;   \
+  template void vil_rank_filter_box(const vil_image_view<T> & src, \
+                                    vil_image_view<T> & dest,      \
+                                    int ilo,                       \
+                                    int ihi,                       \
+                                    int jlo,                       \
+                                    int jhi,                       \
+                                    double r)
+
+#endif // vil_rank_filter_hxx_
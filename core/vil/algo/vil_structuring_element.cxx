@@ -114,3 +114,27 @@ vil_compute_offsets(std::vector<std::ptrdiff_t> & offset,
   for (unsigned int k = 0; k < n; ++k)
     offset[k] = static_cast<std::ptrdiff_t>(element.p_i()[k] * istep + element.p_j()[k] * jstep);
 }
+
+//: True if element is a filled rectangle which contains (0,0).
+bool
+vil_structuring_element_is_box(const vil_structuring_element & element)
+{
+  const int ilo = element.min_i(), ihi = element.max_i();
+  const int jlo = element.min_j(), jhi = element.max_j();
+  if (ilo > 0 || ihi < 0 || jlo > 0 || jhi < 0)
+    return false;
+  const std::size_t ni = ihi - ilo + 1, nj = jhi - jlo + 1;
+  const std::size_t n = element.p_i().size();
+  if (n != ni * nj)
+    return false;
+  // n points in a box of n pixels fill it if none is repeated.
+  std::vector<bool> seen(n, false);
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    const std::size_t index = (element.p_j()[k] - jlo) * ni + (element.p_i()[k] - ilo);
+    if (seen[index])
+      return false;
+    seen[index] = true;
+  }
+  return true;
+}
@@ -105,4 +105,9 @@ vil_compute_offsets(std::vector<std::ptrdiff_t> & offset,
                     std::ptrdiff_t istep,
                     std::ptrdiff_t jstep);
 
+//: True if element is a filled rectangle which contains (0,0).
+// Such elements allow separable, constant time per pixel filters.
+bool
+vil_structuring_element_is_box(const vil_structuring_element & element);
+
 #endif // vil_structuring_element_h_
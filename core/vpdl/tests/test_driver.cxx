@@ -8,6 +8,7 @@ DECLARE(test_gaussian);
 DECLARE(test_update_gaussian);
 DECLARE(test_mixture);
 DECLARE(test_mixture_of);
+DECLARE(test_mixture_evaluator);
 DECLARE(test_update_mog);
 DECLARE(test_kernel_gaussian_sfbw);
 
@@ -21,6 +22,7 @@ register_tests()
   REGISTER(test_update_gaussian);
   REGISTER(test_mixture);
   REGISTER(test_mixture_of);
+  REGISTER(test_mixture_evaluator);
   REGISTER(test_update_mog);
   REGISTER(test_kernel_gaussian_sfbw);
 }
@@ -7,6 +7,7 @@
 #include "vpdl/vpdl_kernel_gaussian_sfbw.h"
 #include "vpdl/vpdl_mixture.h"
 #include "vpdl/vpdl_mixture_of.h"
+#include "vpdl/vpdl_mixture_evaluator.h"
 #include "vpdl/vpdl_multi_cmp_dist.h"
 
 #include <vpdl/vpdt/vpdt_access.h>
@@ -0,0 +1,127 @@
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vpdl/vpdl_mixture_evaluator.h"
+#include "vpdl/vpdl_mixture.h"
+#include "vpdl/vpdl_gaussian.h"
+#include "vpdl/vpdl_gaussian_sphere.h"
+#include "vpdl/vpdl_gaussian_indep.h"
+#include "vnl/vnl_random.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+
+//: Largest difference between the evaluator and log(mixture.prob_density()) over pts
+template <class T, unsigned int n>
+double
+max_error(const vpdl_mixture<T, n> & mixture,
+          const vpdl_mixture_evaluator<T, n> & evaluator,
+          const std::vector<typename vpdl_mixture<T, n>::vector> & pts)
+{
+  std::vector<T> batch;
+  evaluator.log_prob_density(pts, batch);
+  double err = 0.0;
+  for (unsigned int i = 0; i < pts.size(); ++i)
+  {
+    const double expected = std::log(double(mixture.prob_density(pts[i])));
+    err = std::max(err, std::abs(expected - batch[i]));
+    err = std::max(err, std::abs(double(evaluator.log_prob_density(pts[i])) - batch[i]));
+  }
+  return err;
+}
+
+
+template <class T>
+void
+test_mixture_evaluator_type(T epsilon, const std::string & type_name)
+{
+  vnl_random rnd(1234);
+  typedef vnl_vector_fixed<T, 3> vector3;
+  typedef vnl_matrix_fixed<T, 3, 3> matrix3;
+
+  const T covar_data[] = { T(2.0), T(0.3), T(-0.2), T(0.3), T(1.0), T(0.1), T(-0.2), T(0.1), T(0.5) };
+  const matrix3 covar(covar_data);
+
+  vpdl_mixture<T, 3> mixture;
+  mixture.insert(vpdl_gaussian<T, 3>(vector3(T(1), T(2), T(3)), covar), T(0.3));
+  mixture.insert(vpdl_gaussian_indep<T, 3>(vector3(T(-1), T(0), T(2)), vector3(T(0.5), T(1.5), T(2.0))), T(0.5));
+  mixture.insert(vpdl_gaussian_sphere<T, 3>(vector3(T(0), T(-2), T(1)), T(0.8)), T(0.4));
+  mixture.insert(vpdl_gaussian_sphere<T, 3>(vector3(T(5), T(5), T(5)), T(1.0)), T(0));
+
+  std::vector<vector3> pts;
+  for (unsigned int i = 0; i < 150; ++i)
+    pts.push_back(vector3(T(2 * rnd.normal64()), T(2 * rnd.normal64() + 1), T(2 * rnd.normal64() + 1)));
+
+  vpdl_mixture_evaluator<T, 3> evaluator(mixture);
+  TEST(("Zero weight components are dropped <" + type_name + ">").c_str(), evaluator.num_components(), 3u);
+  TEST_NEAR(("Fixed size mixture <" + type_name + ">").c_str(), max_error(mixture, evaluator, pts), 0.0, epsilon);
+
+  // Far from all components the density underflows, but its log does not
+  const vector3 far_pt(T(-30), T(40), T(-30));
+  const T far_log = evaluator.log_prob_density(far_pt);
+  double terms[3], max_term = -1e300;
+  for (unsigned int k = 0; k < 3; ++k)
+  {
+    terms[k] = std::log(double(mixture.weight(k)) / 1.2) + mixture.distribution(k).log_prob_density(far_pt);
+    max_term = std::max(max_term, terms[k]);
+  }
+  const double expected =
+    max_term + std::log(std::exp(terms[0] - max_term) + std::exp(terms[1] - max_term) + std::exp(terms[2] - max_term));
+  TEST(("Density underflows far away <" + type_name + ">").c_str(), mixture.prob_density(far_pt), T(0));
+  TEST_NEAR(("Log density far away <" + type_name + ">").c_str(), far_log, expected, std::abs(expected) * epsilon);
+
+  // Other distributions go through the virtual interface
+  vpdl_mixture<T, 3> nested;
+  nested.insert(mixture, T(1));
+  nested.insert(vpdl_gaussian<T, 3>(vector3(T(0), T(0), T(0)), covar), T(1));
+  vpdl_mixture_evaluator<T, 3> nested_evaluator(nested);
+  TEST_NEAR(("Mixture with a non-Gaussian component <" + type_name + ">").c_str(),
+            max_error(nested, nested_evaluator, pts),
+            0.0,
+            epsilon);
+
+  // Variable size
+  vpdl_mixture<T> var_mixture;
+  vnl_matrix<T> var_covar(covar.as_ref());
+  var_mixture.insert(vpdl_gaussian<T>(vnl_vector<T>(3, T(1)), var_covar), T(0.7));
+  var_mixture.insert(vpdl_gaussian_sphere<T>(vnl_vector<T>(3, T(-1)), T(2)), T(0.2));
+  std::vector<vnl_vector<T>> var_pts;
+  for (const auto & p : pts)
+    var_pts.push_back(p.as_vector());
+  vpdl_mixture_evaluator<T> var_evaluator(var_mixture);
+  TEST(("Variable size dimension <" + type_name + ">").c_str(), var_evaluator.dimension(), 3u);
+  TEST_NEAR(
+    ("Variable size mixture <" + type_name + ">").c_str(), max_error(var_mixture, var_evaluator, var_pts), 0.0, epsilon);
+
+  // Scalar
+  vpdl_mixture<T, 1> mixture1;
+  mixture1.insert(vpdl_gaussian<T, 1>(T(2), T(0.5)), T(1));
+  mixture1.insert(vpdl_gaussian_sphere<T, 1>(T(-1), T(3)), T(2));
+  std::vector<T> pts1;
+  for (unsigned int i = 0; i < 70; ++i)
+    pts1.push_back(T(3 * rnd.normal64()));
+  vpdl_mixture_evaluator<T, 1> evaluator1(mixture1);
+  TEST_NEAR(("Scalar mixture <" + type_name + ">").c_str(), max_error(mixture1, evaluator1, pts1), 0.0, epsilon);
+
+  // A recompiled evaluator follows the mixture
+  mixture1.set_weight(0, T(5));
+  evaluator1.compile(mixture1);
+  TEST_NEAR(("Recompiled <" + type_name + ">").c_str(), max_error(mixture1, evaluator1, pts1), 0.0, epsilon);
+
+  vpdl_mixture_evaluator<T, 1> empty;
+  TEST(("Empty evaluator <" + type_name + ">").c_str(), empty.log_prob_density(T(0)), -std::numeric_limits<T>::infinity());
+}
+
+
+static void
+test_mixture_evaluator()
+{
+  test_mixture_evaluator_type(1e-4f, "float");
+  test_mixture_evaluator_type(1e-10, "double");
+}
+
+TESTMAIN(test_mixture_evaluator);
@@ -0,0 +1,274 @@
+// This is core/vpdl/vpdl_mixture_evaluator.h
+#ifndef vpdl_mixture_evaluator_h_
+#define vpdl_mixture_evaluator_h_
+//:
+// \file
+// \brief Fast evaluation of the log density of a Gaussian mixture on many points
+//
+// vpdl_mixture evaluates each component through a virtual call, and each
+// Gaussian component solves with its covariance for every point.  A
+// vpdl_mixture_evaluator takes a snapshot of a mixture, storing the means,
+// the inverse Cholesky factors of the covariances and the log weights and
+// normalisers of all components in flat arrays.  It then evaluates points
+// in blocks, with loops over the points of a block which the compiler can
+// vectorise, and combines the components with a log-sum-exp, which stays
+// finite far from all components where the density itself underflows.
+//
+// Components which are not Gaussian (not derived from vpdl_gaussian_base)
+// are evaluated through log_prob_density() as usual.  The evaluator does
+// not see later changes to the mixture; call compile() again after an
+// update.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vpdl_mixture.h"
+#include "vpdl_gaussian_base.h"
+#include <vpdl/vpdt/vpdt_access.h>
+#include <cassert>
+
+//: Evaluates the log probability density of a snapshot of a vpdl_mixture
+template <class T, unsigned int n = 0>
+class vpdl_mixture_evaluator
+{
+public:
+  //: the data type used for vectors
+  typedef typename vpdt_field_default<T, n>::type vector;
+  //: the data type used for matrices
+  typedef typename vpdt_field_traits<vector>::matrix_type matrix;
+
+  //: Number of points evaluated together
+  static constexpr unsigned int block_size = 64;
+
+  //: Default Constructor
+  vpdl_mixture_evaluator() = default;
+
+  //: Construct from a mixture
+  explicit vpdl_mixture_evaluator(const vpdl_mixture<T, n> & mixture) { compile(mixture); }
+
+  //: Take a new snapshot of \a mixture
+  void
+  compile(const vpdl_mixture<T, n> & mixture)
+  {
+    dim_ = mixture.dimension();
+    gaussians_ = 0;
+    means_.clear();
+    inv_chol_.clear();
+    log_const_.clear();
+    others_.clear();
+    other_log_weights_.clear();
+
+    T sum_w = T(0);
+    for (unsigned int k = 0; k < mixture.num_components(); ++k)
+      sum_w += mixture.weight(k);
+    assert(sum_w > T(0));
+
+    const unsigned int d = dim_;
+    const double log_2pi = std::log(2.0 * 3.14159265358979323846);
+    vector mean;
+    matrix covar;
+    std::vector<double> L(d * d), W(d * d);
+    for (unsigned int k = 0; k < mixture.num_components(); ++k)
+    {
+      if (!(mixture.weight(k) > T(0)))
+        continue;
+      const double log_w = std::log(double(mixture.weight(k)) / double(sum_w));
+      const vpdl_distribution<T, n> & dist = mixture.distribution(k);
+      if (!dynamic_cast<const vpdl_gaussian_base<T, n> *>(&dist))
+      {
+        others_.emplace_back(dist.clone());
+        other_log_weights_.push_back(T(log_w));
+        continue;
+      }
+
+      dist.compute_mean(mean);
+      dist.compute_covar(covar);
+      // Cholesky factor covar = L L^t, then W = L^-1, so that the
+      // squared Mahalanobis distance of x is |W (x - mean)|^2.
+      double log_det = 0.0;
+      bool singular = false;
+      for (unsigned int j = 0; j < d; ++j)
+      {
+        double s = vpdt_index(covar, j, j);
+        for (unsigned int c = 0; c < j; ++c)
+          s -= L[j * d + c] * L[j * d + c];
+        if (!(s > 0.0))
+        {
+          singular = true;
+          break;
+        }
+        L[j * d + j] = std::sqrt(s);
+        log_det += 2.0 * std::log(L[j * d + j]);
+        for (unsigned int r = j + 1; r < d; ++r)
+        {
+          double t = vpdt_index(covar, r, j);
+          for (unsigned int c = 0; c < j; ++c)
+            t -= L[r * d + c] * L[j * d + c];
+          L[r * d + j] = t / L[j * d + j];
+        }
+      }
+      if (singular) // zero density everywhere, as far as a point is concerned
+        continue;
+      for (unsigned int c = 0; c < d; ++c)
+        for (unsigned int r = 0; r < d; ++r)
+        {
+          double t = r == c ? 1.0 : 0.0;
+          for (unsigned int m = c; m < r; ++m)
+            t -= L[r * d + m] * W[m * d + c];
+          W[r * d + c] = r < c ? 0.0 : t / L[r * d + r];
+        }
+
+      for (unsigned int c = 0; c < d; ++c)
+        means_.push_back(vpdt_index(mean, c));
+      for (unsigned int r = 0; r < d; ++r)
+        for (unsigned int c = 0; c <= r; ++c)
+          inv_chol_.push_back(T(W[r * d + c]));
+      log_const_.push_back(T(log_w - 0.5 * (d * log_2pi + log_det)));
+      ++gaussians_;
+    }
+  }
+
+  //: Return the dimension of the points
+  unsigned int
+  dimension() const
+  {
+    return dim_;
+  }
+
+  //: Number of components with non-zero weight
+  unsigned int
+  num_components() const
+  {
+    return gaussians_ + static_cast<unsigned int>(others_.size());
+  }
+
+  //: The log of vpdl_mixture::prob_density at \a pt
+  T
+  log_prob_density(const vector & pt) const
+  {
+    T result;
+    log_prob_density(&pt, 1, &result);
+    return result;
+  }
+
+  //: The probability density at \a pt, as vpdl_mixture::prob_density
+  T
+  prob_density(const vector & pt) const
+  {
+    return std::exp(log_prob_density(pt));
+  }
+
+  //: The log probability densities of \a num_pts points
+  void
+  log_prob_density(const vector * pts, unsigned int num_pts, T * log_dens) const
+  {
+    std::vector<T> x(dim_ * block_size), a(num_components() * block_size);
+    for (unsigned int b = 0; b < num_pts; b += block_size)
+    {
+      const unsigned int nb = std::min(block_size, num_pts - b);
+      for (unsigned int c = 0; c < dim_; ++c)
+        for (unsigned int i = 0; i < nb; ++i)
+          x[c * block_size + i] = vpdt_index(pts[b + i], c);
+      evaluate_block(x.data(), pts + b, nb, a.data(), log_dens + b);
+    }
+  }
+
+  //: The log probability densities of the points in \a pts
+  void
+  log_prob_density(const std::vector<vector> & pts, std::vector<T> & log_dens) const
+  {
+    log_dens.resize(pts.size());
+    if (!pts.empty())
+      log_prob_density(pts.data(), static_cast<unsigned int>(pts.size()), log_dens.data());
+  }
+
+private:
+  //: Evaluate \a nb points, with coordinate c of point i in x[c*block_size+i]
+  //  \a a is workspace for num_components()*block_size values.
+  void
+  evaluate_block(const T * x, const vector * pts, unsigned int nb, T * a, T * log_dens) const
+  {
+    const unsigned int d = dim_;
+    const unsigned int nk = num_components();
+    const T neg_inf = -std::numeric_limits<T>::infinity();
+    if (nk == 0)
+    {
+      std::fill(log_dens, log_dens + nb, neg_inf);
+      return;
+    }
+
+    // The log of each weighted component, then their log-sum-exp
+    T diff[block_size], mahal[block_size];
+    const T * W = inv_chol_.data();
+    for (unsigned int k = 0; k < gaussians_; ++k)
+    {
+      const T * mean = &means_[k * d];
+      std::fill(mahal, mahal + nb, T(0));
+      for (unsigned int r = 0; r < d; ++r)
+      {
+        // z_r = sum_{c<=r} W(r,c) (x_c - mean_c)
+        T * z = diff;
+        std::fill(z, z + nb, T(0));
+        for (unsigned int c = 0; c <= r; ++c, ++W)
+        {
+          const T w = *W, m = mean[c];
+          const T * xc = x + c * block_size;
+          for (unsigned int i = 0; i < nb; ++i)
+            z[i] += w * (xc[i] - m);
+        }
+        for (unsigned int i = 0; i < nb; ++i)
+          mahal[i] += z[i] * z[i];
+      }
+      T * ak = &a[k * block_size];
+      const T lc = log_const_[k];
+      for (unsigned int i = 0; i < nb; ++i)
+        ak[i] = lc - T(0.5) * mahal[i];
+    }
+    for (unsigned int k = gaussians_; k < nk; ++k)
+    {
+      T * ak = &a[k * block_size];
+      const vpdl_distribution<T, n> & dist = *others_[k - gaussians_];
+      const T lw = other_log_weights_[k - gaussians_];
+      for (unsigned int i = 0; i < nb; ++i)
+        ak[i] = lw + dist.log_prob_density(pts[i]);
+    }
+
+    T * mx = diff;
+    std::copy(a, a + nb, mx);
+    for (unsigned int k = 1; k < nk; ++k)
+      for (unsigned int i = 0; i < nb; ++i)
+        mx[i] = std::max(mx[i], a[k * block_size + i]);
+    T * sum = mahal;
+    std::fill(sum, sum + nb, T(0));
+    for (unsigned int k = 0; k < nk; ++k)
+      for (unsigned int i = 0; i < nb; ++i)
+        sum[i] += std::exp(a[k * block_size + i] - mx[i]);
+    for (unsigned int i = 0; i < nb; ++i)
+      log_dens[i] = mx[i] == neg_inf ? neg_inf : mx[i] + std::log(sum[i]);
+  }
+
+  // ============ Data =============
+
+  unsigned int dim_{ n };
+  //: Number of Gaussian components, which come first
+  unsigned int gaussians_{ 0 };
+  //: Mean of Gaussian k, coordinate c, at [k*dim+c]
+  std::vector<T> means_;
+  //: Lower triangles of the inverse Cholesky factors, row by row
+  std::vector<T> inv_chol_;
+  //: log(weight) - log(normaliser) of each Gaussian
+  std::vector<T> log_const_;
+  //: Components evaluated through the virtual interface
+  std::vector<std::shared_ptr<vpdl_distribution<T, n>>> others_;
+  std::vector<T> other_log_weights_;
+};
+
+template <class T, unsigned int n>
+constexpr unsigned int vpdl_mixture_evaluator<T, n>::block_size;
+
+#endif // vpdl_mixture_evaluator_h_
@@ -2,11 +2,13 @@
 #include "testlib/testlib_register.h"
 
 DECLARE(test_unistd);
+DECLARE(test_thread_pool);
 
 void
 register_tests()
 {
   REGISTER(test_unistd);
+  REGISTER(test_thread_pool);
 }
 
 DEFINE_MAIN;
@@ -2,6 +2,7 @@
 #include "vpl/vpl.h"
 #include "vpl/vpl_fdopen.h"
 #include "vpl/vpl_fileno.h"
+#include "vpl/vpl_thread_pool.h"
 
 #include "vxl_config.h"
 #if VXL_HAS_PTHREAD_H
@@ -0,0 +1,171 @@
+// This is core/vpl/tests/test_thread_pool.cxx
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "testlib/testlib_test.h"
+#include "vpl/vpl_thread_pool.h"
+
+static void
+test_pool()
+{
+  vpl_thread_pool pool(3);
+  TEST("Pool size", pool.size(), 3u);
+  std::vector<std::future<int>> results;
+  for (int k = 0; k < 100; ++k)
+    results.push_back(pool.submit([k]() { return k * k; }));
+  bool ok = true;
+  for (int k = 0; k < 100; ++k)
+    ok = ok && results[k].get() == k * k;
+  TEST("Futures hold the results", ok, true);
+
+  std::future<void> thrown = pool.submit([]() { throw std::runtime_error("task failed"); });
+  bool caught = false;
+  try
+  {
+    thrown.get();
+  }
+  catch (const std::runtime_error &)
+  {
+    caught = true;
+  }
+  TEST("Exceptions reach the future", caught, true);
+
+  vpl_thread_pool inline_pool(0);
+  const std::thread::id caller = std::this_thread::get_id();
+  TEST("A pool without workers runs tasks in the caller",
+       inline_pool.submit([caller]() { return std::this_thread::get_id() == caller; }).get(),
+       true);
+
+  std::atomic<int> count(0);
+  {
+    vpl_thread_pool short_lived(2);
+    for (int k = 0; k < 50; ++k)
+      short_lived.enqueue([&count]() { ++count; });
+  }
+  TEST("Queued tasks run before the pool is destroyed", count.load(), 50);
+}
+
+static void
+test_task_group()
+{
+  vpl_thread_pool pool(4);
+  std::atomic<int> sum(0);
+  vpl_task_group group(pool);
+  for (int k = 1; k <= 100; ++k)
+    group.run([&sum, k]() { sum += k; });
+  group.wait();
+  TEST("Task group waits for its tasks", sum.load(), 5050);
+
+  // Nested groups in tasks must not deadlock, even with one worker
+  vpl_thread_pool small(1);
+  std::atomic<int> leaves(0);
+  vpl_task_group outer(small);
+  for (int k = 0; k < 8; ++k)
+    outer.run([&small, &leaves]() {
+      vpl_task_group inner(small);
+      for (int m = 0; m < 8; ++m)
+        inner.run([&leaves]() { ++leaves; });
+      inner.wait();
+    });
+  outer.wait();
+  TEST("Nested task groups", leaves.load(), 64);
+
+  vpl_task_group failing(pool);
+  for (int k = 0; k < 10; ++k)
+    failing.run([k]() {
+      if (k == 5)
+        throw std::runtime_error("task failed");
+    });
+  bool caught = false;
+  try
+  {
+    failing.wait();
+  }
+  catch (const std::runtime_error &)
+  {
+    caught = true;
+  }
+  TEST("Task group rethrows", caught, true);
+}
+
+static void
+test_parallel_for()
+{
+  vpl_set_concurrency(4);
+  TEST("Concurrency set", vpl_concurrency(), 4u);
+  TEST("Global pool size", vpl_thread_pool::global().size(), 3u);
+
+  std::vector<int> v(10007, 0);
+  vpl_parallel_for(0, int(v.size()), [&v](int i) { v[i] += i; });
+  bool ok = true;
+  for (int i = 0; i < int(v.size()); ++i)
+    ok = ok && v[i] == i;
+  TEST("parallel_for visits each index once", ok, true);
+
+  std::atomic<long> total(0);
+  std::atomic<int> ranges(0);
+  vpl_parallel_for_range(
+    10L,
+    1010L,
+    [&](long b, long e) {
+      ++ranges;
+      long s = 0;
+      for (long i = b; i < e; ++i)
+        s += i;
+      total += s;
+    },
+    100L);
+  TEST("parallel_for_range", total.load() == 509500 && ranges.load() == 10, true);
+
+  std::vector<int> img(100 * 70, 0);
+  vpl_parallel_for_2d(
+    100,
+    70,
+    [&img](unsigned i0, unsigned i1, unsigned j0, unsigned j1) {
+      for (unsigned j = j0; j < j1; ++j)
+        for (unsigned i = i0; i < i1; ++i)
+          ++img[j * 100 + i];
+    },
+    16,
+    16);
+  TEST("parallel_for_2d covers each pixel once", std::accumulate(img.begin(), img.end(), 0) == 7000 &&
+                                                   *std::min_element(img.begin(), img.end()) == 1,
+       true);
+
+  // Nested loops
+  std::vector<int> m(64 * 64, 0);
+  vpl_parallel_for(0, 64, [&m](int j) { vpl_parallel_for(0, 64, [&m, j](int i) { m[j * 64 + i] = i + j; }); });
+  ok = true;
+  for (int j = 0; j < 64; ++j)
+    for (int i = 0; i < 64; ++i)
+      ok = ok && m[j * 64 + i] == i + j;
+  TEST("Nested parallel_for", ok, true);
+
+  vpl_set_concurrency(1);
+  std::vector<int> order;
+  vpl_parallel_for(0, 20, [&order](int i) { order.push_back(i); });
+  bool in_order = order.size() == 20;
+  for (int i = 0; in_order && i < 20; ++i)
+    in_order = order[i] == i;
+  TEST("Serial with a concurrency of 1", in_order, true);
+
+  vpl_set_concurrency(0);
+  TEST("Default concurrency", vpl_concurrency() >= 1, true);
+}
+
+static void
+test_thread_pool()
+{
+  test_pool();
+  test_task_group();
+  test_parallel_for();
+}
+
+TESTMAIN(test_thread_pool);
@@ -0,0 +1,78 @@
+//:
+// \file
+// \brief Tool to measure how vpl_parallel_for scales with the number of threads
+//   Times a memory bound loop (scaling a large array) and a compute bound
+//   one (a sum of square roots) for 1, 2, 4, ... threads, up to the
+//   hardware concurrency or the number given on the command line.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vpl/vpl_thread_pool.h"
+
+//: Milliseconds taken by f, the best of a few runs
+template <class F>
+static double
+time_ms(F f)
+{
+  double best = 1e30;
+  for (int k = 0; k < 5; ++k)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> t = std::chrono::steady_clock::now() - start;
+    best = std::min(best, t.count());
+  }
+  return best;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const unsigned hw = std::thread::hardware_concurrency();
+  const unsigned max_threads = argc > 1 ? unsigned(std::atoi(argv[1])) : (hw > 0 ? hw : 1);
+
+  std::vector<float> data(1 << 24, 1.0f);
+  const int n_compute = 1 << 22;
+  std::vector<double> partial(n_compute / 4096);
+
+  std::cout << std::setw(8) << "threads" << std::setw(16) << "scale (ms)" << std::setw(10) << "speedup"
+            << std::setw(16) << "sqrt sum (ms)" << std::setw(10) << "speedup" << '\n'
+            << std::fixed << std::setprecision(2);
+  double base_memory = 0, base_compute = 0;
+  for (unsigned n = 1; n <= max_threads; n = n < max_threads && 2 * n > max_threads ? max_threads : 2 * n)
+  {
+    vpl_set_concurrency(n);
+    const double memory = time_ms([&]() {
+      vpl_parallel_for_range(std::size_t(0), data.size(), [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i)
+          data[i] *= 1.0001f;
+      });
+    });
+    const double compute = time_ms([&]() {
+      vpl_parallel_for(0, int(partial.size()), [&](int c) {
+        double s = 0;
+        for (int i = c * 4096; i < (c + 1) * 4096; ++i)
+          s += std::sqrt(double(i));
+        partial[c] = s;
+      });
+    });
+    if (n == 1)
+    {
+      base_memory = memory;
+      base_compute = compute;
+    }
+    std::cout << std::setw(8) << n << std::setw(16) << memory << std::setw(10) << base_memory / memory
+              << std::setw(16) << compute << std::setw(10) << base_compute / compute << '\n';
+    if (n == max_threads)
+      break;
+  }
+  return 0;
+}
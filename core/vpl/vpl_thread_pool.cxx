@@ -0,0 +1,234 @@
+// This is core/vpl/vpl_thread_pool.cxx
+//:
+// \file
+
+#include <chrono>
+#include <cstdlib>
+#include "vpl_thread_pool.h"
+
+namespace
+{
+//: The pool and queue index of the current thread, if it is a worker
+thread_local const vpl_thread_pool * current_pool = nullptr;
+thread_local unsigned current_queue = 0;
+
+std::mutex global_mutex;
+unsigned global_concurrency = 0; // 0 until decided
+std::unique_ptr<vpl_thread_pool> global_pool;
+
+unsigned
+default_concurrency()
+{
+  if (const char * env = std::getenv("VXL_NUM_THREADS"))
+  {
+    const long n = std::strtol(env, nullptr, 10);
+    if (n > 0)
+      return static_cast<unsigned>(n);
+  }
+  const unsigned n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+} // namespace
+
+
+unsigned
+vpl_concurrency()
+{
+  std::lock_guard<std::mutex> lock(global_mutex);
+  if (global_concurrency == 0)
+    global_concurrency = default_concurrency();
+  return global_concurrency;
+}
+
+void
+vpl_set_concurrency(unsigned n)
+{
+  std::lock_guard<std::mutex> lock(global_mutex);
+  const unsigned new_concurrency = n > 0 ? n : default_concurrency();
+  if (global_pool && new_concurrency != global_concurrency)
+    global_pool.reset();
+  global_concurrency = new_concurrency;
+}
+
+vpl_thread_pool &
+vpl_thread_pool::global()
+{
+  std::lock_guard<std::mutex> lock(global_mutex);
+  if (global_concurrency == 0)
+    global_concurrency = default_concurrency();
+  if (!global_pool)
+    global_pool.reset(new vpl_thread_pool(global_concurrency - 1));
+  return *global_pool;
+}
+
+
+vpl_thread_pool::vpl_thread_pool(unsigned n_workers)
+  : pending_(0)
+  , stop_(false)
+{
+  for (unsigned i = 0; i <= n_workers; ++i)
+    queues_.emplace_back(new task_queue);
+  for (unsigned i = 0; i < n_workers; ++i)
+    workers_.emplace_back(&vpl_thread_pool::worker_loop, this, i);
+}
+
+vpl_thread_pool::~vpl_thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto & w : workers_)
+    w.join();
+}
+
+void
+vpl_thread_pool::enqueue(std::function<void()> task)
+{
+  if (workers_.empty())
+  {
+    task();
+    return;
+  }
+  task_queue & q = current_pool == this ? *queues_[current_queue] : *queues_.back();
+  {
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    ++pending_;
+  }
+  wake_.notify_one();
+}
+
+bool
+vpl_thread_pool::pop_task(std::function<void()> & task)
+{
+  if (pending_.load() == 0)
+    return false;
+  const unsigned n = static_cast<unsigned>(queues_.size());
+  const bool is_worker = current_pool == this;
+  // A worker takes the newest task from its own queue
+  if (is_worker)
+  {
+    task_queue & q = *queues_[current_queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty())
+    {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      --pending_;
+      return true;
+    }
+  }
+  // Otherwise the oldest from the shared queue, then from the other workers
+  const unsigned first = is_worker ? current_queue + 1 : 0;
+  for (unsigned k = 0; k < n; ++k)
+  {
+    const unsigned i = k == 0 ? n - 1 : (first + k - 1) % (n - 1);
+    if (is_worker && i == current_queue)
+      continue;
+    task_queue & q = *queues_[i];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty())
+    {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      --pending_;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+vpl_thread_pool::run_pending_task()
+{
+  std::function<void()> task;
+  if (!pop_task(task))
+    return false;
+  task();
+  return true;
+}
+
+void
+vpl_thread_pool::worker_loop(unsigned index)
+{
+  current_pool = this;
+  current_queue = index;
+  for (;;)
+  {
+    if (run_pending_task())
+      continue;
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this]() { return stop_ || pending_.load() > 0; });
+    if (stop_ && pending_.load() == 0)
+      return;
+  }
+}
+
+
+vpl_task_group::vpl_task_group(vpl_thread_pool & pool)
+  : pool_(pool)
+  , outstanding_(0)
+{}
+
+vpl_task_group::~vpl_task_group()
+{
+  try
+  {
+    wait();
+  }
+  catch (...)
+  {}
+}
+
+void
+vpl_task_group::run(std::function<void()> task)
+{
+  ++outstanding_;
+  pool_.enqueue([this, task]() {
+    std::exception_ptr error;
+    try
+    {
+      task();
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    finished(error);
+  });
+}
+
+void
+vpl_task_group::finished(std::exception_ptr error)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error && !error_)
+    error_ = error;
+  if (--outstanding_ == 0)
+    done_.notify_all();
+}
+
+void
+vpl_task_group::wait()
+{
+  while (outstanding_.load() > 0)
+  {
+    if (pool_.run_pending_task())
+      continue;
+    // Nothing to help with; wait a little for our tasks to finish
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait_for(lock, std::chrono::microseconds(200), [this]() { return outstanding_.load() == 0; });
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_)
+  {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,213 @@
+// This is core/vpl/vpl_thread_pool.h
+#ifndef vpl_thread_pool_h_
+#define vpl_thread_pool_h_
+//:
+// \file
+// \brief A work stealing thread pool, task groups and parallel loops
+//
+// Each worker thread of a vpl_thread_pool has its own queue of tasks.
+// Tasks submitted from a worker go to the end of its own queue and are
+// run newest first; idle workers take the oldest tasks from the other
+// queues.  Tasks submitted from other threads go to a shared queue.
+//
+// Waiting on a vpl_task_group (which includes waiting for a parallel
+// loop) runs pending tasks in the waiting thread, so tasks may
+// themselves run parallel loops without deadlock.  Waiting on a future
+// from submit() inside a task does not help in this way, and should be
+// avoided.
+//
+// The parallel loops use vpl_thread_pool::global(), whose size is set
+// by vpl_set_concurrency(), or else by the environment variable
+// VXL_NUM_THREADS, or else by the number of hardware threads.  With a
+// concurrency of 1 all work runs in the calling thread, in order.
+//
+// \code
+//   vpl_parallel_for(0, int(img.nj()), [&](int j) { process_row(img, j); });
+// \endcode
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "vpl/vpl_export.h"
+
+//: Number of threads (including the caller) the parallel loops may use
+VPL_EXPORT unsigned
+vpl_concurrency();
+
+//: Set the number of threads the parallel loops may use; 0 restores the default.
+//  Replaces the global pool, so must not be called while it is in use.
+VPL_EXPORT void
+vpl_set_concurrency(unsigned n);
+
+//: A pool of worker threads with work stealing
+class VPL_EXPORT vpl_thread_pool
+{
+public:
+  //: Start \p n_workers threads.  With none, submitted tasks run immediately in the caller.
+  explicit vpl_thread_pool(unsigned n_workers);
+
+  //: Run all tasks already submitted, then stop the workers
+  ~vpl_thread_pool();
+
+  vpl_thread_pool(const vpl_thread_pool &) = delete;
+  vpl_thread_pool &
+  operator=(const vpl_thread_pool &) = delete;
+
+  //: Number of worker threads
+  unsigned
+  size() const
+  {
+    return static_cast<unsigned>(workers_.size());
+  }
+
+  //: Queue a task
+  void
+  enqueue(std::function<void()> task);
+
+  //: Queue a task, returning a future for its result
+  template <class F>
+  std::future<typename std::result_of<F()>::type>
+  submit(F f)
+  {
+    using R = typename std::result_of<F()>::type;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::move(f));
+    std::future<R> result = task->get_future();
+    enqueue([task]() { (*task)(); });
+    return result;
+  }
+
+  //: Run one queued task in the calling thread.  Returns false if there were none.
+  bool
+  run_pending_task();
+
+  //: The pool used by the parallel loops, with vpl_concurrency()-1 workers
+  static vpl_thread_pool &
+  global();
+
+private:
+  struct task_queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool
+  pop_task(std::function<void()> & task);
+
+  void
+  worker_loop(unsigned index);
+
+  //: One queue per worker, then the shared queue
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<unsigned> pending_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stop_;
+};
+
+//: A set of tasks which can be waited for together
+//  The first exception thrown by a task is rethrown by wait().
+class VPL_EXPORT vpl_task_group
+{
+public:
+  explicit vpl_task_group(vpl_thread_pool & pool = vpl_thread_pool::global());
+
+  //: Waits for the tasks, but discards any exception
+  ~vpl_task_group();
+
+  vpl_task_group(const vpl_task_group &) = delete;
+  vpl_task_group &
+  operator=(const vpl_task_group &) = delete;
+
+  //: Queue a task
+  void
+  run(std::function<void()> task);
+
+  //: Wait until all tasks have finished, running queued tasks meanwhile
+  void
+  wait();
+
+private:
+  void
+  finished(std::exception_ptr error);
+
+  vpl_thread_pool & pool_;
+  std::atomic<unsigned> outstanding_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+  std::exception_ptr error_;
+};
+
+//: Call f(b, e) on consecutive sub-ranges [b, e) of [begin, end), in parallel
+//  Sub-ranges hold \p grain values, except perhaps the last; by default
+//  there are about four per thread.
+template <class Index, class F>
+void
+vpl_parallel_for_range(Index begin, Index end, F f, Index grain = 0)
+{
+  if (end <= begin)
+    return;
+  const Index n = end - begin;
+  const unsigned threads = vpl_concurrency();
+  if (!(grain > 0))
+    grain = std::max(Index(1), Index(n / Index(4 * threads)));
+  if (threads <= 1 || n <= grain)
+  {
+    f(begin, end);
+    return;
+  }
+  vpl_task_group group;
+  for (Index b = begin, e; b < end; b = e)
+  {
+    e = b + std::min(grain, Index(end - b));
+    group.run([&f, b, e]() { f(b, e); });
+  }
+  group.wait();
+}
+
+//: Call f(i) for each i in [begin, end), in parallel
+template <class Index, class F>
+void
+vpl_parallel_for(Index begin, Index end, F f, Index grain = 0)
+{
+  vpl_parallel_for_range(
+    begin,
+    end,
+    [&f](Index b, Index e) {
+      for (Index i = b; i < e; ++i)
+        f(i);
+    },
+    grain);
+}
+
+//: Call f(i0, i1, j0, j1) on blocks [i0, i1) x [j0, j1) tiling [0, ni) x [0, nj), in parallel
+template <class F>
+void
+vpl_parallel_for_2d(unsigned ni, unsigned nj, F f, unsigned block_ni = 64, unsigned block_nj = 64)
+{
+  if (ni == 0 || nj == 0)
+    return;
+  const unsigned bi = (ni + block_ni - 1) / block_ni;
+  const unsigned bj = (nj + block_nj - 1) / block_nj;
+  vpl_parallel_for(
+    0u,
+    bi * bj,
+    [&](unsigned b) {
+      const unsigned i0 = (b % bi) * block_ni;
+      const unsigned j0 = (b / bi) * block_nj;
+      f(i0, std::min(ni, i0 + block_ni), j0, std::min(nj, j0 + block_nj));
+    },
+    1u);
+}
+
+#endif // vpl_thread_pool_h_
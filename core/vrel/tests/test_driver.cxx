@@ -12,6 +12,7 @@ DECLARE(test_lms_lts);
 DECLARE(test_m_est_obj);
 DECLARE(test_orthogonal_regression);
 DECLARE(test_ran_sam_search);
+DECLARE(test_parallel_ran_sam_search);
 DECLARE(test_ransac_obj);
 DECLARE(test_robust_util);
 DECLARE(test_muse_table);
@@ -28,6 +29,7 @@ register_tests()
   REGISTER(test_m_est_obj);
   REGISTER(test_orthogonal_regression);
   REGISTER(test_ran_sam_search);
+  REGISTER(test_parallel_ran_sam_search);
   REGISTER(test_ransac_obj);
   REGISTER(test_robust_util);
   REGISTER(test_muse_table);
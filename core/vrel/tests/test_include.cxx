@@ -18,6 +18,7 @@
 #include <vrel/vrel_muset_obj.h>
 #include <vrel/vrel_objective.h>
 #include <vrel/vrel_orthogonal_regression.h>
+#include <vrel/vrel_parallel_ran_sam_search.h>
 #include <vrel/vrel_quad_est.h>
 #include <vrel/vrel_ran_sam_search.h>
 #include <vrel/vrel_ransac_obj.h>
@@ -0,0 +1,183 @@
+// This is core/vrel/tests/test_parallel_ran_sam_search.cxx
+#include <iostream>
+#include <cmath>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+#include "vnl/vnl_double_3.h"
+#include "vnl/vnl_random.h"
+
+#include <vrel/vrel_homography2d_est.h>
+#include <vrel/vrel_linear_regression.h>
+#include <vrel/vrel_lms_obj.h>
+#include <vrel/vrel_ransac_obj.h>
+#include <vrel/vrel_parallel_ran_sam_search.h>
+#include <vpl/vpl_thread_pool.h>
+
+#include "similarity_from_matches.h"
+
+#include "testlib/testlib_test.h"
+
+//: Points on the plane z = 10 + 0.02x - 0.1y, with outlier_frac of them moved well away.
+static std::vector<vnl_vector<double>>
+plane_points(unsigned int num_pts, double outlier_frac, vnl_random & rand)
+{
+  std::vector<vnl_vector<double>> pts(num_pts);
+  for (unsigned int i = 0; i < num_pts; ++i)
+  {
+    const double x = rand.drand64(-10, 10), y = rand.drand64(-10, 10);
+    double z = 10.0 + 0.02 * x - 0.1 * y + rand.normal() * 0.01;
+    if (i < outlier_frac * num_pts)
+      z += rand.drand64(1, 5) * (rand.drand64() < 0.5 ? -1 : 1);
+    pts[i] = vnl_double_3(x, y, z).as_vector();
+  }
+  return pts;
+}
+
+static bool
+plane_ok(const vnl_vector<double> & p)
+{
+  return std::fabs(p[0] - 10.0) < 0.05 && std::fabs(p[1] - 0.02) < 0.005 && std::fabs(p[2] + 0.1) < 0.005;
+}
+
+static void
+test_linear_regression()
+{
+  vnl_random rand(1234);
+  const std::vector<vnl_vector<double>> pts = plane_points(500, 0.4, rand);
+  vrel_linear_regression problem(pts, /*use_intercept=*/true);
+  problem.set_prior_scale(0.01);
+  vrel_ransac_obj obj(3.0);
+
+  vrel_ran_sam_search serial(7);
+  serial.set_sampling_params(0.7);
+  TEST("Serial search succeeds", serial.estimate(&problem, &obj), true);
+
+  std::cout << "Full scoring\n";
+  vpl_set_concurrency(4);
+  vrel_parallel_ran_sam_search full(7);
+  full.set_sampling_params(0.7);
+  TEST("Search succeeds", full.estimate(&problem, &obj), true);
+  TEST("Accurate estimate", plane_ok(full.params()), true);
+  TEST("Takes all samples", full.samples_tested(), serial.samples_tested());
+  TEST("Rejects none", full.samples_rejected(), 0u);
+  TEST_NEAR("Objective no worse than 5% above serial search", full.cost(), serial.cost(), 0.05 * problem.num_samples());
+
+  std::cout << "Preemptive test\n";
+  vpl_set_concurrency(1);
+  vrel_parallel_ran_sam_search preempt(7);
+  preempt.set_sampling_params(0.7);
+  preempt.set_preemptive_test(3.0);
+  TEST("Search succeeds", preempt.estimate(&problem, &obj), true);
+  TEST("Accurate estimate", plane_ok(preempt.params()), true);
+  std::cout << "Samples: " << preempt.samples_tested() << " of " << serial.samples_tested() << ", "
+            << preempt.samples_rejected() << " rejected early\n";
+  TEST("Rejects poor fits early", preempt.samples_rejected() > 0, true);
+  TEST("Takes fewer samples", preempt.samples_tested() < serial.samples_tested(), true);
+  const double outliers = preempt.cost();
+  TEST("About 40% outliers", outliers >= 195 && outliers <= 215, true);
+
+  std::cout << "Deterministic for a given seed\n";
+  bool same = true;
+  for (unsigned int n_threads = 2; n_threads <= 8; n_threads *= 2)
+  {
+    vrel_parallel_ran_sam_search other(7);
+    other.set_sampling_params(0.7);
+    other.set_preemptive_test(3.0);
+    vpl_set_concurrency(n_threads);
+    other.estimate(&problem, &obj);
+    same = same && other.params() == preempt.params() && other.index() == preempt.index() &&
+           other.samples_tested() == preempt.samples_tested() &&
+           other.samples_rejected() == preempt.samples_rejected();
+  }
+  vpl_set_concurrency(0);
+  TEST("Same result with 2, 4 and 8 threads", same, true);
+}
+
+static void
+test_homography()
+{
+  // A projective map, and matches with 30% outliers.
+  vnl_random rand(99);
+  vnl_matrix<double> H(3, 3);
+  H(0, 0) = 1.1;
+  H(0, 1) = 0.05;
+  H(0, 2) = 12;
+  H(1, 0) = -0.03;
+  H(1, 1) = 0.95;
+  H(1, 2) = -7;
+  H(2, 0) = 1e-4;
+  H(2, 1) = -2e-4;
+  H(2, 2) = 1;
+  std::vector<vnl_vector<double>> from_pts, to_pts;
+  for (unsigned int i = 0; i < 300; ++i)
+  {
+    vnl_vector<double> p(3, 1.0);
+    p[0] = rand.drand64(0, 500);
+    p[1] = rand.drand64(0, 500);
+    vnl_vector<double> q = H * p;
+    q /= q[2];
+    q[0] += rand.normal() * 0.2;
+    q[1] += rand.normal() * 0.2;
+    if (i % 10 < 3)
+    {
+      q[0] = rand.drand64(0, 500);
+      q[1] = rand.drand64(0, 500);
+    }
+    from_pts.push_back(p);
+    to_pts.push_back(q);
+  }
+  vrel_homography2d_est problem(from_pts, to_pts);
+  problem.set_prior_scale(0.3);
+  vrel_ransac_obj obj(3.0);
+
+  vrel_parallel_ran_sam_search search(3);
+  search.set_sampling_params(0.5);
+  search.set_preemptive_test(3.0);
+  TEST("Homography search succeeds", search.estimate(&problem, &obj), true);
+  vnl_vector<double> h = search.params() / search.params()[8];
+  double err = 0;
+  for (unsigned int i = 0; i < 9; ++i)
+    err = std::max(err, std::fabs(h[i] - H(i / 3, i % 3)) / std::max(1e-3, std::fabs(H(i / 3, i % 3))));
+  std::cout << "Homography " << h << ", " << search.samples_tested() << " samples, " << search.samples_rejected()
+            << " rejected early\n";
+  TEST("Outliers found", search.cost() >= 85 && search.cost() <= 95, true);
+  TEST_NEAR("Accurate affine part", std::fabs(h[0] - 1.1) + std::fabs(h[4] - 0.95), 0.0, 0.05);
+}
+
+static void
+test_default_residuals()
+{
+  // similarity_from_matches can only compute all of its residuals at once.
+  std::vector<image_point_match> matches;
+  vnl_vector<double> sim_params(4);
+  sim_params[0] = 1.4;
+  sim_params[1] = -0.2;
+  sim_params[2] = 20.0;
+  sim_params[3] = -18.0;
+  generate_similarity_matches(sim_params, 0.1, matches);
+  similarity_from_matches problem(matches);
+  vrel_lms_obj obj(problem.num_samples_to_instantiate());
+
+  vrel_parallel_ran_sam_search search(5);
+  search.set_preemptive_test(3.0);
+  problem.set_prior_scale(0.1);
+  TEST("Non-unique estimate succeeds", search.estimate(&problem, &obj), true);
+  const vnl_vector<double> & p = search.params();
+  TEST("Non-unique estimate accurate",
+       std::fabs(p[0] - 1.4) < 0.025 && std::fabs(p[1] + 0.2) < 0.025 && std::fabs(p[2] - 20.0) < 1.0 &&
+         std::fabs(p[3] + 18.0) < 1.0,
+       true);
+}
+
+static void
+test_parallel_ran_sam_search()
+{
+  test_linear_regression();
+  test_homography();
+  test_default_residuals();
+}
+
+TESTMAIN(test_parallel_ran_sam_search);
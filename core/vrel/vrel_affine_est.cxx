@@ -169,6 +169,28 @@ vrel_affine_est::compute_residuals(const vnl_vector<double> & params, std::vecto
 }
 
 
+bool
+vrel_affine_est::compute_residuals_at(const vnl_vector<double> & params,
+                                      const std::vector<int> & indices,
+                                      std::vector<double> & residuals) const
+{
+  residuals.resize(indices.size());
+  const vnl_matrix<double> A = this->A(params);
+  const vnl_vector<double> t = trans(params);
+
+  vnl_vector<double> diff;
+  for (unsigned int k = 0; k < indices.size(); ++k)
+  {
+    const int i = indices[k];
+    diff = A * from_pts_[i];
+    diff += t;
+    diff -= to_pts_[i];
+    residuals[k] = diff.two_norm();
+  }
+  return true;
+}
+
+
 bool
 vrel_affine_est::weighted_least_squares_fit(vnl_vector<double> & params,
                                             vnl_matrix<double> & norm_covar,
@@ -22,6 +22,15 @@ vrel_estimation_problem::vrel_estimation_problem()
 vrel_estimation_problem::~vrel_estimation_problem() { delete multiple_scales_; }
 
 
+bool
+vrel_estimation_problem::compute_residuals_at(const vnl_vector<double> & /*params*/,
+                                              const std::vector<int> & /*indices*/,
+                                              std::vector<double> & /*residuals*/) const
+{
+  return false;
+}
+
+
 void
 vrel_estimation_problem::compute_weights(const std::vector<double> & residuals,
                                          const vrel_wls_obj * obj,
@@ -126,6 +126,19 @@ public:
   virtual void
   compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const = 0;
 
+  //: Compute the residuals of the data points with the given indices only.
+  // residuals is resized to indices.size(), and residuals[k] is the
+  // residual of point indices[k], as compute_residuals() would give it.
+  // This lets a search reject a poor parameter vector after looking at
+  // a few points.
+  //
+  // Returns false, computing nothing, if the problem can only compute
+  // all its residuals at once. This is the default.
+  virtual bool
+  compute_residuals_at(const vnl_vector<double> & params,
+                       const std::vector<int> & indices,
+                       std::vector<double> & residuals) const;
+
   //: Compute the weights for the given residuals.
   // The residuals are essentially those returned by
   // compute_residuals(). The default behaviour is to apply obj->wgt()
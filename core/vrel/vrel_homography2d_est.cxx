@@ -104,45 +104,67 @@ vrel_homography2d_est ::fit_from_minimal_set(const std::vector<int> & point_indi
   }
 }
 
-void
-vrel_homography2d_est ::compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const
+//: Symmetric transfer error of one match under H, whose inverse is H_inv.
+static double
+vrel_homography2d_residual(const vnl_matrix<double> & H,
+                           const vnl_matrix<double> & H_inv,
+                           const vnl_vector<double> & from_pt,
+                           const vnl_vector<double> & to_pt)
+{
+  const vnl_vector<double> trans_pt = H * from_pt;
+  const vnl_vector<double> inv_trans_pt = H_inv * to_pt;
+
+  if (from_pt[2] == 0 || to_pt[2] == 0 || trans_pt[2] == 0 || inv_trans_pt[2] == 0)
+    return 1e10;
+
+  const double del_x = trans_pt[0] / trans_pt[2] - to_pt[0] / to_pt[2];
+  const double del_y = trans_pt[1] / trans_pt[2] - to_pt[1] / to_pt[2];
+  const double inv_del_x = inv_trans_pt[0] / inv_trans_pt[2] - from_pt[0] / from_pt[2];
+  const double inv_del_y = inv_trans_pt[1] / inv_trans_pt[2] - from_pt[1] / from_pt[2];
+  return std::sqrt(vnl_math::sqr(del_x) + vnl_math::sqr(del_y) + vnl_math::sqr(inv_del_x) + vnl_math::sqr(inv_del_y));
+}
+
+//: The homography held in params, and its inverse.
+static void
+vrel_homography2d_matrices(const vnl_vector<double> & params, vnl_matrix<double> & H, vnl_matrix<double> & H_inv)
 {
-  vnl_matrix<double> H(3, 3);
-  int r = 0, c = 0;
-  for (r = 0; r < 3; ++r)
-    for (c = 0; c < 3; ++c)
+  H.set_size(3, 3);
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
       H(r, c) = params[3 * r + c];
 
   const vnl_svd<double> svd_H(H);
   if (svd_H.rank() < 3)
     std::cerr << "vrel_homography2d_est :: compute_residuals  rank(H) < 3!!";
-  const vnl_matrix<double> H_inv(svd_H.inverse());
+  H_inv = svd_H.inverse();
+}
+
+void
+vrel_homography2d_est ::compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const
+{
+  vnl_matrix<double> H, H_inv;
+  vrel_homography2d_matrices(params, H, H_inv);
 
   if (residuals.size() != from_pts_.size())
     residuals.resize(from_pts_.size());
 
-  vnl_vector<double> trans_pt(3), inv_trans_pt(3);
-  double del_x = NAN, del_y = NAN, inv_del_x = NAN, inv_del_y = NAN;
-
   for (unsigned int i = 0; i < from_pts_.size(); ++i)
-  {
-    trans_pt = H * from_pts_[i];
-    inv_trans_pt = H_inv * to_pts_[i];
+    residuals[i] = vrel_homography2d_residual(H, H_inv, from_pts_[i], to_pts_[i]);
+}
 
-    if (from_pts_[i][2] == 0 || to_pts_[i][2] == 0 || trans_pt[2] == 0 || inv_trans_pt[2] == 0)
-    {
-      residuals[i] = 1e10;
-    }
-    else
-    {
-      del_x = trans_pt[0] / trans_pt[2] - to_pts_[i][0] / to_pts_[i][2];
-      del_y = trans_pt[1] / trans_pt[2] - to_pts_[i][1] / to_pts_[i][2];
-      inv_del_x = inv_trans_pt[0] / inv_trans_pt[2] - from_pts_[i][0] / from_pts_[i][2];
-      inv_del_y = inv_trans_pt[1] / inv_trans_pt[2] - from_pts_[i][1] / from_pts_[i][2];
-      residuals[i] =
-        std::sqrt(vnl_math::sqr(del_x) + vnl_math::sqr(del_y) + vnl_math::sqr(inv_del_x) + vnl_math::sqr(inv_del_y));
-    }
-  }
+
+bool
+vrel_homography2d_est ::compute_residuals_at(const vnl_vector<double> & params,
+                                             const std::vector<int> & indices,
+                                             std::vector<double> & residuals) const
+{
+  vnl_matrix<double> H, H_inv;
+  vrel_homography2d_matrices(params, H, H_inv);
+
+  residuals.resize(indices.size());
+  for (unsigned int k = 0; k < indices.size(); ++k)
+    residuals[k] = vrel_homography2d_residual(H, H_inv, from_pts_[indices[k]], to_pts_[indices[k]]);
+  return true;
 }
 
 
@@ -139,6 +139,21 @@ vrel_linear_regression::compute_residuals(const vnl_vector<double> & params, std
 }
 
 
+bool
+vrel_linear_regression::compute_residuals_at(const vnl_vector<double> & params,
+                                             const std::vector<int> & indices,
+                                             std::vector<double> & residuals) const
+{
+  residuals.resize(indices.size());
+  for (unsigned int k = 0; k < indices.size(); ++k)
+  {
+    const int i = indices[k];
+    residuals[k] = rand_vars_[i] - dot_product(params, ind_vars_[i]);
+  }
+  return true;
+}
+
+
 bool
 vrel_linear_regression::weighted_least_squares_fit(vnl_vector<double> & params,
                                                    vnl_matrix<double> & norm_covar,
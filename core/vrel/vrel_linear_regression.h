@@ -73,6 +73,12 @@ public:
   void
   compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const override;
 
+  //: Compute the residuals of the points with the given indices only.
+  bool
+  compute_residuals_at(const vnl_vector<double> & params,
+                       const std::vector<int> & indices,
+                       std::vector<double> & residuals) const override;
+
   //: \brief Weighted least squares parameter estimate.
   bool
   weighted_least_squares_fit(vnl_vector<double> & params,
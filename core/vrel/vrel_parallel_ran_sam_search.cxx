@@ -0,0 +1,317 @@
+// This is core/vrel/vrel_parallel_ran_sam_search.cxx
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "vrel_parallel_ran_sam_search.h"
+#include <vrel/vrel_objective.h>
+#include <vrel/vrel_estimation_problem.h>
+
+#include "vnl/vnl_vector.h"
+#include "vnl/vnl_random.h"
+#include <vpl/vpl_thread_pool.h>
+
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+namespace
+{
+//: A sample and what became of it.
+struct vrel_hypothesis
+{
+  std::vector<int> sample;
+  vnl_vector<double> params;
+  std::vector<double> residuals;
+  bool fitted{ false };
+  bool rejected{ false };
+  double obj{ 0.0 };
+  //: Points visited by the preemptive test, and how many agreed with the fit.
+  unsigned int tested{ 0 };
+  unsigned int agreed{ 0 };
+};
+} // namespace
+
+
+// ------------------------------------------------------------
+void
+vrel_parallel_ran_sam_search::set_preemptive_test(double inlier_threshold, double fit_cost, double delta, bool adaptive)
+{
+  inlier_threshold_ = inlier_threshold;
+  fit_cost_ = fit_cost;
+  delta_ = delta;
+  adaptive_ = adaptive;
+}
+
+
+// ------------------------------------------------------------
+double
+vrel_parallel_ran_sam_search::sprt_threshold(double epsilon, double delta) const
+{
+  if (epsilon <= delta)
+    return HUGE_VAL; // the test cannot tell good fits from bad ones
+  // Chum and Matas, eq. (2) and (6), with one fit per sample.
+  const double c = (1 - delta) * std::log((1 - delta) / (1 - epsilon)) + delta * std::log(delta / epsilon);
+  const double a0 = fit_cost_ * c + 1;
+  double a = a0;
+  for (int i = 0; i < 100; ++i)
+  {
+    const double next = a0 + std::log(a);
+    if (std::fabs(next - a) < 1e-6 * a)
+      return next;
+    a = next;
+  }
+  return a;
+}
+
+
+// ------------------------------------------------------------
+bool
+vrel_parallel_ran_sam_search::estimate(const vrel_estimation_problem * problem, const vrel_objective * obj_fcn)
+{
+  //
+  //  Initialize the random sampling.
+  //
+  this->calc_num_samples(problem);
+  const unsigned int max_samples = samples_to_take_;
+  if (trace_level_ >= 1)
+    std::cout << "\nSamples = " << samples_to_take_ << std::endl;
+
+  if (obj_fcn->requires_prior_scale() && problem->scale_type() == vrel_estimation_problem::NONE)
+  {
+    std::cerr << "parallel_ran_sam::estimate: Objective function requires a prior scale,"
+              << " and the problem does not provide one.\n"
+              << "                            Aborting estimation.\n";
+    return false;
+  }
+
+  const unsigned int points_per = problem->num_samples_to_instantiate();
+  const unsigned int num_points = problem->num_samples();
+  min_obj_ = 0.0;
+  bool obj_set = false;
+  scale_ = -1;
+  samples_rejected_ = 0;
+
+  //
+  //  Preemptive test.  The points are visited in the same random order
+  //  for every fit.  epsilon is the fraction of points agreeing with a
+  //  good fit, delta with a bad one.
+  //
+  const bool preempt = inlier_threshold_ > 0 && num_points > 0;
+  std::vector<int> order;
+  std::vector<double> thresholds(num_points, inlier_threshold_);
+  double epsilon = std::max(1e-6, std::min(1.0 - 1e-6, 1.0 - max_outlier_frac_));
+  double delta = std::max(1e-6, std::min(1.0 - 1e-6, delta_));
+  double max_agreed = 0.0;
+  if (preempt)
+  {
+    order.resize(num_points);
+    for (unsigned int i = 0; i < num_points; ++i)
+      order[i] = i;
+    for (unsigned int i = num_points - 1; i > 0; --i)
+      std::swap(order[i], order[generator_->lrand32(0, i)]);
+    for (unsigned int i = 0; i < num_points; ++i)
+    {
+      if (problem->scale_type() == vrel_estimation_problem::SINGLE)
+        thresholds[i] *= problem->prior_scale();
+      else if (problem->scale_type() == vrel_estimation_problem::MULTIPLE)
+        thresholds[i] *= problem->prior_multiple_scales()[i];
+    }
+  }
+  double threshold_a = sprt_threshold(epsilon, delta);
+  double rejected_tested = 0, rejected_agreed = 0;
+
+  //: Fit and score one hypothesis.  Runs on any thread.
+  auto evaluate = [&](vrel_hypothesis & h, std::vector<int> & block, std::vector<double> & block_res) {
+    h.fitted = problem->fit_from_minimal_set(h.sample, h.params);
+    h.rejected = false;
+    h.tested = h.agreed = 0;
+    if (!h.fitted)
+      return;
+    h.residuals.resize(num_points);
+
+    if (preempt)
+    {
+      // Visit the points in blocks of doubling size, computing only their
+      // residuals if the problem can.  Otherwise compute them all first.
+      bool all_computed = false;
+      double lambda = 1.0;
+      const double agree_factor = delta / epsilon, disagree_factor = (1 - delta) / (1 - epsilon);
+      for (unsigned int first = 0, size = 32; first < num_points && !h.rejected; first += size, size *= 2)
+      {
+        const unsigned int last = std::min(num_points, first + size);
+        if (!all_computed)
+        {
+          block.assign(order.begin() + first, order.begin() + last);
+          if (problem->compute_residuals_at(h.params, block, block_res))
+          {
+            for (unsigned int k = first; k < last; ++k)
+              h.residuals[order[k]] = block_res[k - first];
+          }
+          else
+          {
+            problem->compute_residuals(h.params, h.residuals);
+            all_computed = true;
+          }
+        }
+        for (unsigned int k = first; k < last; ++k)
+        {
+          const int i = order[k];
+          const bool agrees = std::fabs(h.residuals[i]) <= thresholds[i];
+          ++h.tested;
+          if (agrees)
+            ++h.agreed;
+          lambda *= agrees ? agree_factor : disagree_factor;
+          if (lambda > threshold_a)
+          {
+            h.rejected = true;
+            break;
+          }
+        }
+      }
+      if (h.rejected)
+        return;
+    }
+    else
+      problem->compute_residuals(h.params, h.residuals);
+
+    switch (problem->scale_type())
+    {
+      case vrel_estimation_problem::NONE:
+        h.obj = obj_fcn->fcn(h.residuals.begin(), h.residuals.end(), scale_, &h.params);
+        break;
+      case vrel_estimation_problem::SINGLE:
+        h.obj = obj_fcn->fcn(h.residuals.begin(), h.residuals.end(), problem->prior_scale(), &h.params);
+        break;
+      case vrel_estimation_problem::MULTIPLE:
+        h.obj =
+          obj_fcn->fcn(h.residuals.begin(), h.residuals.end(), problem->prior_multiple_scales().begin(), &h.params);
+        break;
+      default:
+        std::cerr << __FILE__ << ": unknown scale type\n";
+        std::abort();
+    }
+  };
+
+  //
+  //  The main loop draws a batch of samples, fits and scores them in
+  //  parallel, and then looks at the results in sample order.  As in
+  //  vrel_ran_sam_search, samples which don't yield a parameter vector
+  //  still count toward the total.
+  //
+  std::vector<vrel_hypothesis> batch(batch_size_);
+  std::vector<int> point_indices(points_per);
+  unsigned int taken = 0;
+  while (taken < samples_to_take_)
+  {
+    const unsigned int nb = std::min(batch_size_, samples_to_take_ - taken);
+    for (unsigned int b = 0; b < nb; ++b)
+    {
+      this->next_sample(taken + b, num_points, point_indices, points_per);
+      batch[b].sample = point_indices;
+    }
+
+    vpl_parallel_for_range(0u, nb, [&](unsigned int b0, unsigned int b1) {
+      std::vector<int> block;
+      std::vector<double> block_res;
+      for (unsigned int b = b0; b < b1; ++b)
+        evaluate(batch[b], block, block_res);
+    });
+
+    bool new_support = false;
+    for (unsigned int b = 0; b < nb; ++b)
+    {
+      vrel_hypothesis & h = batch[b];
+      if (trace_level_ >= 2)
+        std::cout << "\nSample " << taken + b << ':';
+      if (!h.fitted)
+      {
+        if (trace_level_ >= 1)
+          std::cout << "No fit to sample.\n";
+        continue;
+      }
+      if (h.rejected)
+      {
+        ++samples_rejected_;
+        rejected_tested += h.tested;
+        rejected_agreed += h.agreed;
+        if (trace_level_ >= 2)
+          std::cout << "Rejected after " << h.tested << " points\n";
+        continue;
+      }
+      if (trace_level_ >= 1)
+        std::cout << "Fit = " << h.params << "\nObjective = " << h.obj << std::endl;
+      if (!obj_set || h.obj < min_obj_)
+      {
+        if (trace_level_ >= 2)
+          std::cout << "New best\n";
+        obj_set = true;
+        min_obj_ = h.obj;
+        params_ = h.params;
+        indices_ = h.sample;
+        residuals_ = h.residuals;
+      }
+      if (preempt && h.agreed > max_agreed * num_points)
+      {
+        max_agreed = double(h.agreed) / num_points;
+        new_support = true;
+      }
+    }
+    taken += nb;
+
+    //
+    //  Update the test, and the number of samples still needed, from the
+    //  largest support found and the fits that were rejected.
+    //
+    if (!preempt)
+      continue;
+    bool new_test = false;
+    if (new_support)
+    {
+      epsilon = std::min(1.0 - 1e-6, max_agreed);
+      new_test = true;
+    }
+    if (rejected_tested > 0)
+    {
+      const double delta_hat = std::max(1e-6, rejected_agreed / rejected_tested);
+      if (std::fabs(delta_hat - delta) > 0.05 * delta)
+      {
+        delta = delta_hat;
+        new_test = true;
+      }
+    }
+    if (new_test)
+      threshold_a = sprt_threshold(epsilon, delta);
+    if (adaptive_ && !generate_all_ && max_agreed > 0)
+    {
+      // As in calc_num_samples, allowing for good samples that the test rejects.
+      const unsigned int m = max_populations_expected_;
+      const double prob_good =
+        m * std::pow(max_agreed / m, int(points_per)) * (1 - 1 / std::max(1.0, threshold_a));
+      if (prob_good >= 1)
+        samples_to_take_ = std::max(taken, min_samples_);
+      else if (prob_good > 0)
+      {
+        const double needed = std::ceil(std::log(1.0 - desired_prob_good_) / std::log(1.0 - prob_good));
+        if (needed < samples_to_take_)
+          samples_to_take_ = std::max(unsigned(needed), min_samples_);
+      }
+      samples_to_take_ = std::min(samples_to_take_, max_samples);
+    }
+    if (trace_level_ >= 1)
+      std::cout << "epsilon = " << epsilon << ", delta = " << delta << ", A = " << threshold_a
+                << ", samples = " << samples_to_take_ << std::endl;
+  }
+  samples_to_take_ = taken;
+
+  if (!obj_set)
+  {
+    return false;
+  }
+
+  //
+  // Estimation succeeded.  Now, estimate scale and then return.
+  //
+  return this->estimate_scale(problem, obj_fcn);
+}
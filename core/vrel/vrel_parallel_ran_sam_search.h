@@ -0,0 +1,101 @@
+#ifndef vrel_parallel_ran_sam_search_h_
+#define vrel_parallel_ran_sam_search_h_
+//:
+// \file
+// \brief Random sampling search which scores hypotheses in parallel, with a preemptive test
+//
+// vrel_ran_sam_search fits and scores its samples one after another, and
+// computes every residual of every fit. This search draws the samples in
+// the same way, but fits and scores a batch of them at a time on the vpl
+// thread pool (see vpl_set_concurrency()).
+//
+// Optionally, each fit first goes through the sequential probability
+// ratio test (SPRT) of Chum and Matas ("Optimal randomized RANSAC", PAMI
+// 2008): the points are visited in a random order, and the fit is dropped
+// as soon as the points which disagree with it make it unlikely to be
+// good. Only fits which pass are scored with the objective function. The
+// fraction of points which agree with the best fit so far then gives a
+// smaller number of samples to take than the worst case
+// max_outlier_frac of set_sampling_params.
+//
+// The samples are drawn from the generator on the calling thread, and the
+// test parameters and the number of samples are only updated between
+// batches, with the batch results taken in sample order. So for a given
+// seed and batch size the result does not depend on the number of
+// threads, or on how they are scheduled.
+
+#include <vector>
+#include <vrel/vrel_ran_sam_search.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+class vrel_parallel_ran_sam_search : public vrel_ran_sam_search
+{
+public:
+  //: Constructor using a non-deterministic random-sampling seed.
+  vrel_parallel_ran_sam_search() = default;
+
+  //: Constructor using a given random-sampling seed.
+  vrel_parallel_ran_sam_search(int seed)
+    : vrel_ran_sam_search(seed)
+  {}
+
+  ~vrel_parallel_ran_sam_search() override = default;
+
+  //: Number of samples fitted and scored together (default 64).
+  //  The result for a given seed depends on this, but not on the number of threads.
+  void
+  set_batch_size(unsigned int n)
+  {
+    batch_size_ = n > 0 ? n : 1;
+  }
+
+  //: Reject poor fits with the sequential probability ratio test before scoring them.
+  //  A point agrees with a fit if the magnitude of its residual is at most
+  //  inlier_threshold times its prior scale (or inlier_threshold, if the
+  //  problem has no prior scale).
+  // \param fit_cost  time to fit a sample, in units of the time to compute one residual.
+  // \param delta  initial estimate of the fraction of points that agree with a bad fit;
+  //               it is re-estimated from the fits that are rejected.
+  // \param adaptive  also reduce the number of samples taken, from the
+  //                  fraction of points agreeing with the best fit.
+  void
+  set_preemptive_test(double inlier_threshold, double fit_cost = 200.0, double delta = 0.05, bool adaptive = true);
+
+  //: Score every fit in full (the default).
+  void
+  set_no_preemptive_test()
+  {
+    inlier_threshold_ = 0.0;
+  }
+
+  // ----------------------------------------
+  //  Main estimation functions
+  // ----------------------------------------
+
+  //: \brief Estimation for an "ordinary" estimation problem.
+  bool
+  estimate(const vrel_estimation_problem * problem, const vrel_objective * obj_fcn) override;
+
+  //:  Get the number of fits rejected by the preemptive test in the last estimate().
+  unsigned int
+  samples_rejected() const
+  {
+    return samples_rejected_;
+  }
+
+protected:
+  //: SPRT decision threshold for the given fractions of points agreeing with good and bad fits.
+  double
+  sprt_threshold(double epsilon, double delta) const;
+
+  unsigned int batch_size_{ 64 };
+  double inlier_threshold_{ 0.0 };
+  double fit_cost_{ 200.0 };
+  double delta_{ 0.05 };
+  bool adaptive_{ true };
+  unsigned int samples_rejected_{ 0 };
+};
+
+#endif
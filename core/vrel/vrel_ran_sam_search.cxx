@@ -162,6 +162,15 @@ vrel_ran_sam_search::estimate(const vrel_estimation_problem * problem, const vre
   //
   // Estimation succeeded.  Now, estimate scale and then return.
   //
+  return this->estimate_scale(problem, obj_fcn);
+}
+
+
+// ------------------------------------------------------------
+bool
+vrel_ran_sam_search::estimate_scale(const vrel_estimation_problem * problem, const vrel_objective * obj_fcn)
+{
+  std::vector<double> residuals(problem->num_samples());
   problem->compute_residuals(params_, residuals);
   if (trace_level_ >= 1)
     std::cout << "\nOptimum fit = " << params_ << std::endl;
@@ -145,6 +145,10 @@ protected:
   virtual void
   next_sample(unsigned int taken, unsigned int num_points, std::vector<int> & sample, unsigned int points_per_sample);
 
+  //: Estimate scale from the residuals of params_, once the best sample is found.
+  bool
+  estimate_scale(const vrel_estimation_problem * problem, const vrel_objective * obj_fcn);
+
 private:
   void
   trace_sample(const std::vector<int> & point_indices) const;
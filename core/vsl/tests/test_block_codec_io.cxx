@@ -0,0 +1,199 @@
+// This is core/vsl/tests/test_block_codec_io.cxx
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vsl/vsl_binary_io.h"
+#include "vsl/vsl_block_binary.h"
+#include "vsl/vsl_block_binary_codec.h"
+#include "testlib/testlib_test.h"
+
+template <class T>
+static void
+test_round_trip(const char * name, const std::vector<T> & v_out, const vsl_block_codec_params & params,
+                unsigned n_read_threads)
+{
+  std::ostringstream oss;
+  vsl_b_ostream bos(&oss);
+  vsl_block_binary_codec_write(bos, v_out.data(), v_out.size(), params);
+  vsl_b_write(bos, 12345); // Check that the stream is correctly positioned afterwards.
+  TEST("Stream OK after write", !bos, false);
+
+  std::istringstream iss(oss.str());
+  vsl_b_istream bis(&iss);
+  std::vector<T> v_in(v_out.size());
+  vsl_block_binary_codec_read(bis, v_in.data(), v_in.size(), n_read_threads);
+  int check = 0;
+  vsl_b_read(bis, check);
+  TEST("Stream OK after read", !bis, false);
+  TEST("Stream correctly positioned after block", check, 12345);
+  std::cout << name << ": " << v_out.size() * sizeof(T) << " bytes stored in " << oss.str().size() << '\n';
+  TEST(name, v_in == v_out, true);
+}
+
+static std::size_t
+stored_size(const std::vector<float> & v, const vsl_block_codec_params & params)
+{
+  std::ostringstream oss;
+  vsl_b_ostream bos(&oss);
+  vsl_block_binary_codec_write(bos, v.data(), v.size(), params);
+  return oss.str().size();
+}
+
+void
+test_block_codec_io()
+{
+  std::cout << "***********************************\n"
+            << " Testing vsl_block_binary_codec io\n"
+            << "***********************************\n";
+
+  constexpr unsigned n = 100000;
+  std::vector<float> v_float(n);
+  std::vector<double> v_double(n);
+  std::vector<int> v_int(n);
+  std::vector<unsigned short> v_ushort(n);
+  std::vector<unsigned char> v_uchar(n);
+  std::vector<vxl_int_64> v_int64(n);
+  for (unsigned i = 0; i < n; ++i)
+  {
+    v_float[i] = 100.0f + std::sin(0.001f * i);
+    v_double[i] = -0.5 * i;
+    v_int[i] = 3 * int(i) - 7000;
+    v_ushort[i] = (unsigned short)(i * 7);
+    v_uchar[i] = (unsigned char)(i / 300);
+    v_int64[i] = vxl_int_64(i) * 1000000;
+  }
+
+  vsl_block_codec_params params;
+  for (int c = VSL_BLOCK_CODEC_NONE; c <= VSL_BLOCK_CODEC_BZIP2; ++c)
+  {
+    params.codec = vsl_block_codec_type(c);
+    std::cout << "\nCodec " << c << " available: " << vsl_block_codec_available(params.codec) << '\n';
+    for (int f = VSL_BLOCK_FILTER_NONE; f <= VSL_BLOCK_FILTER_DELTA_SHUFFLE; ++f)
+    {
+      params.filter = vsl_block_codec_filter(f);
+      params.chunk_bytes = 1 << 20;
+      params.n_threads = 1;
+      test_round_trip("float round trip", v_float, params, 1);
+      test_round_trip("double round trip", v_double, params, 1);
+      test_round_trip("int round trip", v_int, params, 1);
+      test_round_trip("ushort round trip", v_ushort, params, 1);
+      test_round_trip("uchar round trip", v_uchar, params, 1);
+      test_round_trip("int64 round trip", v_int64, params, 1);
+
+      // Many small chunks, (de)compressed on several threads.
+      params.chunk_bytes = 10000;
+      params.n_threads = 4;
+      test_round_trip("float multi-threaded round trip", v_float, params, 3);
+      test_round_trip("int multi-threaded round trip", v_int, params, 0);
+    }
+  }
+
+  // An odd sized final chunk, and an empty block.
+  params = vsl_block_codec_params();
+  params.chunk_bytes = 999;
+  test_round_trip("Partial last chunk round trip", std::vector<double>(1001, 2.5), params, 2);
+  test_round_trip("Empty block round trip", std::vector<float>(), params, 1);
+
+  if (vsl_block_codec_available(VSL_BLOCK_CODEC_ZLIB))
+  {
+    vsl_block_codec_params plain;
+    plain.codec = VSL_BLOCK_CODEC_NONE;
+    vsl_block_codec_params zlib;
+    vsl_block_codec_params zlib_shuffle;
+    zlib_shuffle.filter = VSL_BLOCK_FILTER_SHUFFLE;
+    const std::size_t plain_size = stored_size(v_float, plain);
+    const std::size_t zlib_size = stored_size(v_float, zlib);
+    const std::size_t shuffle_size = stored_size(v_float, zlib_shuffle);
+    std::cout << "Smooth float data: plain " << plain_size << " zlib " << zlib_size << " zlib+shuffle " << shuffle_size
+              << '\n';
+    TEST("zlib compresses smooth data", zlib_size < plain_size, true);
+    TEST("Byte-shuffle improves compression of smooth float data", shuffle_size < zlib_size, true);
+
+    vsl_block_codec_params zlib_delta;
+    zlib_delta.filter = VSL_BLOCK_FILTER_DELTA;
+    std::ostringstream a, b;
+    vsl_b_ostream ba(&a), bb(&b);
+    vsl_block_binary_codec_write(ba, v_int.data(), n, zlib);
+    vsl_block_binary_codec_write(bb, v_int.data(), n, zlib_delta);
+    TEST("Delta filter improves compression of a ramp", b.str().size() < a.str().size() / 10, true);
+  }
+
+  {
+    std::cout << "\nTesting vsl_block_binary_write/read on a compressing stream\n";
+    vsl_block_codec_params zlib_shuffle;
+    zlib_shuffle.filter = VSL_BLOCK_FILTER_SHUFFLE;
+    zlib_shuffle.chunk_bytes = 50000;
+    std::ostringstream oss;
+    vsl_b_ostream bos(&oss, zlib_shuffle);
+    TEST("Stream keeps its codec", bos.block_codec() && bos.block_codec()->filter == VSL_BLOCK_FILTER_SHUFFLE, true);
+    vsl_block_binary_write(bos, v_float.data(), n);
+    vsl_block_binary_write(bos, v_int.data(), n);
+    vsl_block_binary_write(bos, v_uchar.data(), n);
+    vsl_b_write(bos, 12345);
+
+    std::ostringstream plain_oss;
+    vsl_b_ostream plain_bos(&plain_oss);
+    TEST("Plain stream has no codec", plain_bos.block_codec() == nullptr, true);
+    vsl_block_binary_write(plain_bos, v_float.data(), n);
+    TEST("Compressing stream is smaller", oss.str().size() < plain_oss.str().size(), vsl_block_codec_available(VSL_BLOCK_CODEC_ZLIB));
+
+    std::istringstream iss(oss.str());
+    vsl_b_istream bis(&iss);
+    TEST("Compressing stream has version 2", bis.version_no(), 2);
+    std::vector<float> f_in(n);
+    std::vector<int> i_in(n);
+    std::vector<unsigned char> c_in(n);
+    vsl_block_binary_read(bis, f_in.data(), n);
+    vsl_block_binary_read(bis, i_in.data(), n);
+    vsl_block_binary_read(bis, c_in.data(), n);
+    int check = 0;
+    vsl_b_read(bis, check);
+    TEST("Stream OK after block reads", !bis, false);
+    TEST("Stream correctly positioned after blocks", check, 12345);
+    TEST("float block round trip", f_in == v_float, true);
+    TEST("int block round trip", i_in == v_int, true);
+    TEST("uchar block round trip", c_in == v_uchar, true);
+
+    std::istringstream plain_iss(plain_oss.str());
+    vsl_b_istream plain_bis(&plain_iss);
+    TEST("Plain stream has version 1", plain_bis.version_no(), 1);
+    std::vector<float> p_in(n);
+    vsl_block_binary_read(plain_bis, p_in.data(), n);
+    TEST("Plain stream still readable", !plain_bis == false && p_in == v_float, true);
+  }
+
+  {
+    std::cout << "\nTesting error detection\n";
+    std::ostringstream oss;
+    vsl_b_ostream bos(&oss);
+    vsl_block_binary_codec_write(bos, v_float.data(), n);
+
+    std::istringstream iss(oss.str());
+    vsl_b_istream bis(&iss);
+    std::vector<float> v_in(n + 1);
+    vsl_block_binary_codec_read(bis, v_in.data(), n + 1);
+    TEST("Wrong element count detected", !bis, true);
+
+    std::string corrupt = oss.str();
+    corrupt[corrupt.size() / 2] ^= 0x55;
+    corrupt[corrupt.size() / 2 + 1] ^= 0x55;
+    std::istringstream iss2(corrupt);
+    vsl_b_istream bis2(&iss2);
+    vsl_block_binary_codec_read(bis2, v_in.data(), n);
+    TEST("Corrupted data detected", !bis2 || std::vector<float>(v_in.begin(), v_in.end() - 1) == v_float, true);
+
+    std::ostringstream oss3;
+    vsl_b_ostream bos3(&oss3);
+    vsl_b_write(bos3, short(99));
+    std::istringstream iss3(oss3.str());
+    vsl_b_istream bis3(&iss3);
+    vsl_block_binary_codec_read(bis3, v_in.data(), n);
+    TEST("Unknown version detected", !bis3, true);
+  }
+}
+
+TESTMAIN(test_block_codec_io);
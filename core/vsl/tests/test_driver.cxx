@@ -17,6 +17,7 @@ DECLARE(test_tuple_io);
 DECLARE(test_vector_io);
 DECLARE(test_vlarge_block_io);
 DECLARE(test_block_rle_io);
+DECLARE(test_block_codec_io);
 
 void
 register_tests()
@@ -38,6 +39,7 @@ register_tests()
   REGISTER(test_vector_io);
   REGISTER(test_vlarge_block_io);
   REGISTER(test_block_rle_io);
+  REGISTER(test_block_codec_io);
 }
 
 DEFINE_MAIN;
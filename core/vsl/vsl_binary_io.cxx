@@ -3,6 +3,7 @@
 #include <map>
 #include <cstdlib>
 #include "vsl_binary_io.h"
+#include "vsl_block_binary_codec.h"
 //:
 // \file
 // \brief Functions to perform consistent binary IO within vsl
@@ -227,6 +228,17 @@ vsl_b_ostream::vsl_b_ostream(std::ostream * o_s)
   vsl_b_write_uint_16(*this, vsl_magic_number_part_2);
 }
 
+//: Create this adaptor using an existing stream, compressing blocks with block_codec.
+vsl_b_ostream::vsl_b_ostream(std::ostream * o_s, const vsl_block_codec_params & block_codec)
+  : os_(o_s)
+  , block_codec_(std::make_shared<vsl_block_codec_params>(block_codec))
+{
+  assert(os_ != nullptr);
+  vsl_b_write_uint_16(*this, codec_version_no_);
+  vsl_b_write_uint_16(*this, vsl_magic_number_part_1);
+  vsl_b_write_uint_16(*this, vsl_magic_number_part_2);
+}
+
 //: A reference to the adaptor's stream
 std::ostream &
 vsl_b_ostream::os() const
@@ -364,10 +376,10 @@ vsl_b_istream::vsl_b_istream(std::istream * i_s)
     is_->clear(std::ios::badbit); // Set an unrecoverable IO error on stream
   }
 
-  if (v != 1)
+  if (v != 1 && v != 2)
   {
     std::cerr << "\nI/O ERROR: vsl_b_istream::vsl_b_istream(std::istream *is)\n"
-              << "             The stream's leading version number is " << v << ". Expected value 1.\n";
+              << "             The stream's leading version number is " << v << ". Expected value 1 or 2.\n";
     is_->clear(std::ios::badbit); // Set an unrecoverable IO error on stream
   }
   version_no_ = (unsigned short)v;
@@ -511,7 +523,7 @@ vsl_b_istream_test(std::istream & is)
 
   is.seekg(0);
 
-  if (!is || m2 != vsl_magic_number_part_2 || m1 != vsl_magic_number_part_1 || v > 1)
+  if (!is || m2 != vsl_magic_number_part_2 || m1 != vsl_magic_number_part_1 || v > 2)
     return false;
 
 
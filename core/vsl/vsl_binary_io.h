@@ -17,12 +17,16 @@
 #include <string>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <utility>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
 #include <vxl_config.h>
 #include <vsl/vsl_export.h>
+
+struct vsl_block_codec_params;
+
 //: A binary output adaptor for any std::ostream
 // Currently the main use of this is to encourage streams to be opened
 // in binary mode (ie. without CR/LF conversion)
@@ -44,10 +48,23 @@ public:
   // User is responsible for deleting os after deleting the adaptor
   vsl_b_ostream(std::ostream * os);
 
+  //: Create this adaptor using an existing stream, compressing blocks with \p block_codec
+  // Blocks of fundamental values written by vsl_block_binary_write() are
+  // stored by vsl_block_binary_codec_write().  The stream is marked with IO
+  // version number 2, so readers that predate the compressed blocks refuse it.
+  vsl_b_ostream(std::ostream * os, const vsl_block_codec_params & block_codec);
+
   //: A reference to the adaptor's stream
   std::ostream &
   os() const;
 
+  //: The compression of blocks of fundamental values, or null if they are stored as they are
+  const vsl_block_codec_params *
+  block_codec() const
+  {
+    return block_codec_.get();
+  }
+
   //: Virtual destructor.
   virtual ~vsl_b_ostream() = default;
 
@@ -122,8 +139,14 @@ protected:
   // (user_defined data.)
   serialisation_records_type serialisation_records_;
 
+  //: The compression of blocks of fundamental values, if any.
+  std::shared_ptr<const vsl_block_codec_params> block_codec_;
+
   //: The version number of the IO scheme.
   static constexpr unsigned short version_no_ = 1;
+
+  //: The version number of the IO scheme with compressed blocks.
+  static constexpr unsigned short codec_version_no_ = 2;
 };
 
 
@@ -143,6 +166,14 @@ public:
     : vsl_b_ostream(new std::ofstream(filename, mode | std::ios::binary))
   {}
 
+  //: Create this adaptor from a file, compressing blocks with \p block_codec.
+  // The adapter will delete the internal stream automatically on destruction.
+  vsl_b_ofstream(const std::string & filename,
+                 const vsl_block_codec_params & block_codec,
+                 std::ios::openmode mode = std::ios::out | std::ios::trunc)
+    : vsl_b_ostream(new std::ofstream(filename, mode | std::ios::binary), block_codec)
+  {}
+
   //: Virtual destructor.
   ~vsl_b_ofstream() override;
 
@@ -224,6 +255,7 @@ public:
 
 
   //: Return the version number of the IO format of the file being read.
+  // Version 2 streams hold blocks of fundamental values compressed by vsl_block_binary_codec_write().
   unsigned short
   version_no() const;
 
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include "vsl_block_binary.h"
+#include "vsl_block_binary_codec.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -70,6 +71,11 @@ void
 vsl_block_binary_write_float_impl(vsl_b_ostream & os, const T * begin, std::size_t nelems)
 {
   vsl_b_write(os, true); // Error check that this is a specialised version
+  if (os.block_codec())
+  {
+    vsl_block_binary_codec_write(os, begin, nelems, *os.block_codec());
+    return;
+  }
 
   const std::size_t wanted = sizeof(T) * nelems;
   const vsl_block_t block = allocate_up_to(wanted);
@@ -100,6 +106,11 @@ vsl_block_binary_read_float_impl(vsl_b_istream & is, T * begin, std::size_t nele
   vsl_block_binary_read_confirm_specialisation(is, true);
   if (!is)
     return;
+  if (is.version_no() >= 2)
+  {
+    vsl_block_binary_codec_read(is, begin, nelems);
+    return;
+  }
   is.is().read((char *)begin, nelems * sizeof(T));
   vsl_swap_bytes((char *)begin, sizeof(T), nelems);
 }
@@ -112,6 +123,11 @@ vsl_block_binary_write_int_impl(vsl_b_ostream & os, const T * begin, std::size_t
 {
 
   vsl_b_write(os, true); // Error check that this is a specialised version
+  if (os.block_codec())
+  {
+    vsl_block_binary_codec_write(os, begin, nelems, *os.block_codec());
+    return;
+  }
 
   const std::size_t wanted = VSL_MAX_ARBITRARY_INT_BUFFER_LENGTH(sizeof(T)) * nelems;
   const vsl_block_t block = allocate_up_to(wanted);
@@ -167,6 +183,11 @@ vsl_block_binary_read_int_impl(vsl_b_istream & is, T * begin, std::size_t nelems
   vsl_block_binary_read_confirm_specialisation(is, true);
   if (!is)
     return;
+  if (is.version_no() >= 2)
+  {
+    vsl_block_binary_codec_read(is, begin, nelems);
+    return;
+  }
   std::size_t nbytes = 0;
   vsl_b_read(is, nbytes);
   if (nbytes == 0)
@@ -248,6 +269,11 @@ void
 vsl_block_binary_write_byte_impl(vsl_b_ostream & os, const T * begin, std::size_t nelems)
 {
   vsl_b_write(os, true); // Error check that this is a specialised version
+  if (os.block_codec())
+  {
+    vsl_block_binary_codec_write(os, begin, nelems, *os.block_codec());
+    return;
+  }
   os.os().write((char *)begin, nelems);
 }
 
@@ -261,6 +287,11 @@ vsl_block_binary_read_byte_impl(vsl_b_istream & is, T * begin, std::size_t nelem
   vsl_block_binary_read_confirm_specialisation(is, true);
   if (!is)
     return;
+  if (is.version_no() >= 2)
+  {
+    vsl_block_binary_codec_read(is, begin, nelems);
+    return;
+  }
   is.is().read((char *)begin, nelems);
 }
 
@@ -0,0 +1,417 @@
+// This is core/vsl/vsl_block_binary_codec.cxx
+//:
+// \file
+// \brief Store/Load a block of values through a filter and a general purpose compressor.
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "vsl_block_binary_codec.h"
+#include "vsl_binary_explicit_io.h"
+#include <vpl/vpl_thread_pool.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vxl_config.h>
+#ifndef VSL_HAS_ZLIB
+#  define VSL_HAS_ZLIB 0
+#endif
+#ifndef VSL_HAS_BZLIB2
+#  define VSL_HAS_BZLIB2 0
+#endif
+#if VSL_HAS_ZLIB
+#  include <zlib.h>
+#endif
+#if VSL_HAS_BZLIB2
+#  include <bzlib.h>
+#endif
+
+namespace
+{
+// Largest chunk accepted by the underlying libraries' 32 bit length arguments.
+constexpr std::size_t max_chunk_bytes = std::size_t(1) << 30;
+
+//: Number of chunks (de)compressed at once; 0 means vpl_concurrency().
+std::size_t
+batch_size(unsigned n_threads)
+{
+  return n_threads == 0 ? vpl_concurrency() : n_threads;
+}
+
+//: Load a little-endian unsigned integer.
+template <class U>
+inline U
+load_le(const unsigned char * p)
+{
+  U v;
+  std::memcpy(&v, p, sizeof(U));
+  vsl_swap_bytes(reinterpret_cast<char *>(&v), sizeof(U));
+  return v;
+}
+
+//: Store a little-endian unsigned integer.
+template <class U>
+inline void
+store_le(unsigned char * p, U v)
+{
+  vsl_swap_bytes(reinterpret_cast<char *>(&v), sizeof(U));
+  std::memcpy(p, &v, sizeof(U));
+}
+
+template <class U>
+void
+delta_encode(unsigned char * data, std::size_t n)
+{
+  // Go backwards so that each previous value is still unmodified.
+  for (std::size_t i = n; i-- > 1;)
+  {
+    unsigned char * p = data + i * sizeof(U);
+    store_le<U>(p, U(load_le<U>(p) - load_le<U>(p - sizeof(U))));
+  }
+}
+
+template <class U>
+void
+delta_decode(unsigned char * data, std::size_t n)
+{
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    unsigned char * p = data + i * sizeof(U);
+    store_le<U>(p, U(load_le<U>(p) + load_le<U>(p - sizeof(U))));
+  }
+}
+
+//: Returns false if elem_size is not supported by the delta filter.
+bool
+delta_filter(unsigned char * data, unsigned elem_size, std::size_t n, bool encode)
+{
+  switch (elem_size)
+  {
+    case 1:
+      encode ? delta_encode<vxl_uint_8>(data, n) : delta_decode<vxl_uint_8>(data, n);
+      return true;
+    case 2:
+      encode ? delta_encode<vxl_uint_16>(data, n) : delta_decode<vxl_uint_16>(data, n);
+      return true;
+    case 4:
+      encode ? delta_encode<vxl_uint_32>(data, n) : delta_decode<vxl_uint_32>(data, n);
+      return true;
+#if VXL_HAS_INT_64
+    case 8:
+      encode ? delta_encode<vxl_uint_64>(data, n) : delta_decode<vxl_uint_64>(data, n);
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+void
+shuffle(const unsigned char * src, unsigned char * dest, unsigned elem_size, std::size_t n)
+{
+  for (unsigned b = 0; b < elem_size; ++b)
+  {
+    unsigned char * d = dest + b * n;
+    const unsigned char * s = src + b;
+    for (std::size_t i = 0; i < n; ++i, s += elem_size)
+      d[i] = *s;
+  }
+}
+
+void
+unshuffle(const unsigned char * src, unsigned char * dest, unsigned elem_size, std::size_t n)
+{
+  for (unsigned b = 0; b < elem_size; ++b)
+  {
+    const unsigned char * s = src + b * n;
+    unsigned char * d = dest + b;
+    for (std::size_t i = 0; i < n; ++i, d += elem_size)
+      *d = s[i];
+  }
+}
+
+//: Compress src into dest. Returns false on failure.
+bool
+compress_chunk(vsl_block_codec_type codec, int level, const std::vector<unsigned char> & src,
+               std::vector<unsigned char> & dest)
+{
+  switch (codec)
+  {
+    case VSL_BLOCK_CODEC_NONE:
+      dest = src;
+      return true;
+#if VSL_HAS_ZLIB
+    case VSL_BLOCK_CODEC_ZLIB:
+    {
+      // Worst case expansion from the zlib documentation, with some slack.
+      uLongf n = static_cast<uLongf>(src.size() + src.size() / 100 + 64);
+      dest.resize(n);
+      if (compress2(dest.data(), &n, src.data(), static_cast<uLong>(src.size()), level) != Z_OK)
+        return false;
+      dest.resize(n);
+      return true;
+    }
+#endif
+#if VSL_HAS_BZLIB2
+    case VSL_BLOCK_CODEC_BZIP2:
+    {
+      // Worst case expansion from the bzip2 documentation, with some slack.
+      unsigned int n = static_cast<unsigned int>(src.size() + src.size() / 100 + 640);
+      dest.resize(n);
+      if (BZ2_bzBuffToBuffCompress(reinterpret_cast<char *>(dest.data()), &n,
+                                   const_cast<char *>(reinterpret_cast<const char *>(src.data())),
+                                   static_cast<unsigned int>(src.size()), level, 0, 0) != BZ_OK)
+        return false;
+      dest.resize(n);
+      return true;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+//: Decompress src into exactly dest_size bytes at dest. Returns false on failure.
+bool
+decompress_chunk(vsl_block_codec_type codec, const std::vector<unsigned char> & src, unsigned char * dest,
+                 std::size_t dest_size)
+{
+  switch (codec)
+  {
+    case VSL_BLOCK_CODEC_NONE:
+      if (src.size() != dest_size)
+        return false;
+      std::memcpy(dest, src.data(), dest_size);
+      return true;
+#if VSL_HAS_ZLIB
+    case VSL_BLOCK_CODEC_ZLIB:
+    {
+      uLongf n = static_cast<uLongf>(dest_size);
+      return uncompress(dest, &n, src.data(), static_cast<uLong>(src.size())) == Z_OK && n == dest_size;
+    }
+#endif
+#if VSL_HAS_BZLIB2
+    case VSL_BLOCK_CODEC_BZIP2:
+    {
+      unsigned int n = static_cast<unsigned int>(dest_size);
+      return BZ2_bzBuffToBuffDecompress(reinterpret_cast<char *>(dest), &n,
+                                        const_cast<char *>(reinterpret_cast<const char *>(src.data())),
+                                        static_cast<unsigned int>(src.size()), 0, 0) == BZ_OK &&
+             n == dest_size;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+void
+set_read_error(vsl_b_istream & is, const char * msg)
+{
+  std::cerr << "I/O ERROR: vsl_block_binary_codec_read()\n"
+            << "           " << msg << '\n';
+  is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+}
+} // namespace
+
+
+bool
+vsl_block_codec_available(vsl_block_codec_type codec)
+{
+  switch (codec)
+  {
+    case VSL_BLOCK_CODEC_NONE:
+      return true;
+    case VSL_BLOCK_CODEC_ZLIB:
+      return VSL_HAS_ZLIB != 0;
+    case VSL_BLOCK_CODEC_BZIP2:
+      return VSL_HAS_BZLIB2 != 0;
+    default:
+      return false;
+  }
+}
+
+
+void
+vsl_block_binary_codec_write_bytes(vsl_b_ostream & os,
+                                   const void * begin,
+                                   unsigned elem_size,
+                                   std::size_t nelems,
+                                   const vsl_block_codec_params & params)
+{
+  vsl_block_codec_type codec = params.codec;
+  if (!vsl_block_codec_available(codec))
+    codec = VSL_BLOCK_CODEC_NONE;
+  vsl_block_codec_filter filter = params.filter;
+  if ((filter & VSL_BLOCK_FILTER_DELTA) && (elem_size > 8 || (elem_size & (elem_size - 1)) != 0))
+    filter = vsl_block_codec_filter(filter & ~VSL_BLOCK_FILTER_DELTA);
+
+  const std::size_t chunk_bytes = std::min(std::max<std::size_t>(params.chunk_bytes, elem_size), max_chunk_bytes);
+  const std::size_t chunk_elems = chunk_bytes / elem_size;
+  const std::size_t n_chunks = nelems == 0 ? 0 : (nelems + chunk_elems - 1) / chunk_elems;
+  int level = std::min(9, std::max(1, params.level));
+
+  constexpr short version = 1;
+  vsl_b_write(os, version);
+  vsl_b_write(os, static_cast<unsigned char>(codec));
+  vsl_b_write(os, static_cast<unsigned char>(filter));
+  vsl_b_write(os, elem_size);
+  vsl_b_write(os, nelems);
+  vsl_b_write(os, chunk_elems);
+
+  const unsigned char * data = static_cast<const unsigned char *>(begin);
+
+  // Compress a batch of chunks in parallel, then write them in order, so
+  // that only a few chunks need to be held in memory at once.
+  std::vector<std::vector<unsigned char>> packed(std::min(n_chunks, batch_size(params.n_threads)));
+  std::vector<char> ok(packed.size());
+  for (std::size_t first = 0; first < n_chunks; first += packed.size())
+  {
+    const std::size_t batch = std::min(packed.size(), n_chunks - first);
+    vpl_parallel_for(std::size_t(0), batch, [&](std::size_t k) {
+      const std::size_t c = first + k;
+      const std::size_t n = std::min(chunk_elems, nelems - c * chunk_elems);
+      std::vector<unsigned char> raw(n * elem_size);
+      vsl_swap_bytes_to_buffer(reinterpret_cast<const char *>(data + c * chunk_elems * elem_size),
+                               reinterpret_cast<char *>(raw.data()), elem_size, n);
+      if (filter & VSL_BLOCK_FILTER_DELTA)
+        delta_filter(raw.data(), elem_size, n, true);
+      if ((filter & VSL_BLOCK_FILTER_SHUFFLE) && elem_size > 1)
+      {
+        std::vector<unsigned char> tmp(raw.size());
+        shuffle(raw.data(), tmp.data(), elem_size, n);
+        raw.swap(tmp);
+      }
+      ok[k] = compress_chunk(codec, level, raw, packed[k]);
+    }, std::size_t(1));
+
+    for (std::size_t k = 0; k < batch; ++k)
+    {
+      if (!ok[k])
+      {
+        std::cerr << "I/O ERROR: vsl_block_binary_codec_write()\n"
+                  << "           Failed to compress chunk " << first + k << '\n';
+        os.os().setstate(std::ios::badbit);
+        return;
+      }
+      vsl_b_write(os, packed[k].size());
+      os.os().write(reinterpret_cast<const char *>(packed[k].data()), packed[k].size());
+    }
+  }
+}
+
+
+void
+vsl_block_binary_codec_read_bytes(vsl_b_istream & is,
+                                  void * begin,
+                                  unsigned elem_size,
+                                  std::size_t nelems,
+                                  unsigned n_threads)
+{
+  if (!is)
+    return;
+
+  short ver;
+  vsl_b_read(is, ver);
+  switch (ver)
+  {
+    case 1:
+    {
+      unsigned char codec_byte = 0, filter_byte = 0;
+      unsigned stored_elem_size = 0;
+      std::size_t stored_nelems = 0, chunk_elems = 0;
+      vsl_b_read(is, codec_byte);
+      vsl_b_read(is, filter_byte);
+      vsl_b_read(is, stored_elem_size);
+      vsl_b_read(is, stored_nelems);
+      vsl_b_read(is, chunk_elems);
+      if (!is)
+        return;
+
+      const vsl_block_codec_type codec = vsl_block_codec_type(codec_byte);
+      const vsl_block_codec_filter filter = vsl_block_codec_filter(filter_byte);
+      if (!vsl_block_codec_available(codec))
+      {
+        set_read_error(is, "Compression codec is unknown or was not compiled into this build.");
+        return;
+      }
+      if (filter > VSL_BLOCK_FILTER_DELTA_SHUFFLE)
+      {
+        set_read_error(is, "Unknown filter.");
+        return;
+      }
+      if (stored_elem_size != elem_size || stored_nelems != nelems)
+      {
+        set_read_error(is, "Element size or count in stream does not match the requested block.");
+        return;
+      }
+      if (nelems == 0)
+        return;
+      if (chunk_elems == 0 || chunk_elems > max_chunk_bytes / elem_size)
+      {
+        set_read_error(is, "Corrupted data stream.");
+        return;
+      }
+
+      const std::size_t n_chunks = (nelems + chunk_elems - 1) / chunk_elems;
+      unsigned char * data = static_cast<unsigned char *>(begin);
+
+      // Read a batch of compressed chunks, then decompress them in parallel
+      // straight into the destination.
+      std::vector<std::vector<unsigned char>> packed(std::min(n_chunks, batch_size(n_threads)));
+      std::vector<char> ok(packed.size());
+      for (std::size_t first = 0; first < n_chunks; first += packed.size())
+      {
+        const std::size_t batch = std::min(packed.size(), n_chunks - first);
+        for (std::size_t k = 0; k < batch; ++k)
+        {
+          std::size_t nbytes = 0;
+          vsl_b_read(is, nbytes);
+          // A chunk can never legitimately be much bigger than its uncompressed size.
+          if (!is || nbytes > 2 * chunk_elems * elem_size + 1024)
+          {
+            set_read_error(is, "Corrupted data stream.");
+            return;
+          }
+          packed[k].resize(nbytes);
+          is.is().read(reinterpret_cast<char *>(packed[k].data()), nbytes);
+        }
+        if (!is)
+          return;
+
+        vpl_parallel_for(std::size_t(0), batch, [&](std::size_t k) {
+          const std::size_t c = first + k;
+          const std::size_t n = std::min(chunk_elems, nelems - c * chunk_elems);
+          unsigned char * dest = data + c * chunk_elems * elem_size;
+          if ((filter & VSL_BLOCK_FILTER_SHUFFLE) && elem_size > 1)
+          {
+            std::vector<unsigned char> tmp(n * elem_size);
+            ok[k] = decompress_chunk(codec, packed[k], tmp.data(), tmp.size());
+            if (ok[k])
+              unshuffle(tmp.data(), dest, elem_size, n);
+          }
+          else
+            ok[k] = decompress_chunk(codec, packed[k], dest, n * elem_size);
+          if (ok[k] && (filter & VSL_BLOCK_FILTER_DELTA))
+            ok[k] = delta_filter(dest, elem_size, n, false);
+          if (ok[k])
+            vsl_swap_bytes(reinterpret_cast<char *>(dest), elem_size, n);
+        }, std::size_t(1));
+
+        for (std::size_t k = 0; k < batch; ++k)
+          if (!ok[k])
+          {
+            set_read_error(is, "Failed to decompress chunk; corrupted data stream.");
+            return;
+          }
+      }
+      break;
+    }
+    default:
+      std::cerr << "I/O ERROR: vsl_block_binary_codec_read()\n"
+                << "           Unknown version number " << ver << '\n';
+      is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+      return;
+  }
+}
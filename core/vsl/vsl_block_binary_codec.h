@@ -0,0 +1,108 @@
+// This is core/vsl/vsl_block_binary_codec.h
+#ifndef vsl_block_binary_codec_h_
+#define vsl_block_binary_codec_h_
+//:
+// \file
+// \brief Store/Load a block of values through a filter and a general purpose compressor.
+//
+// This is the compressed counterpart of vsl_block_binary_write/read and
+// vsl_block_binary_rle_write/read. The block is converted to little-endian,
+// split into chunks, each chunk is optionally run through a reversible
+// filter (delta or byte-shuffle) and then compressed with zlib or bzip2.
+// Chunks are independent, so they are compressed and decompressed
+// on the vpl thread pool.
+//
+// The stream format is versioned, and the codec, filter and chunk size
+// are saved in the stream, so a reader does not need to know the
+// parameters that were used to write the data.
+
+#include <cstddef>
+#include <type_traits>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vsl_binary_io.h"
+
+//: The general purpose compressor applied to each chunk.
+enum vsl_block_codec_type
+{
+  VSL_BLOCK_CODEC_NONE = 0,
+  VSL_BLOCK_CODEC_ZLIB = 1,
+  VSL_BLOCK_CODEC_BZIP2 = 2
+};
+
+//: A reversible transformation applied to each chunk before compression.
+// DELTA replaces each element by its difference from the previous one
+// (as an unsigned integer of the same size, so it is exact for floats too).
+// SHUFFLE stores byte 0 of every element, then byte 1 of every element, etc.
+// which groups the slowly varying exponent bytes of floating point data.
+enum vsl_block_codec_filter
+{
+  VSL_BLOCK_FILTER_NONE = 0,
+  VSL_BLOCK_FILTER_DELTA = 1,
+  VSL_BLOCK_FILTER_SHUFFLE = 2,
+  VSL_BLOCK_FILTER_DELTA_SHUFFLE = 3
+};
+
+//: Parameters controlling vsl_block_binary_codec_write().
+// A vsl_b_ostream constructed with these parameters writes every block of
+// fundamental values through the codec (see vsl_block_binary_write()).
+struct vsl_block_codec_params
+{
+  vsl_block_codec_type codec = VSL_BLOCK_CODEC_ZLIB;
+  vsl_block_codec_filter filter = VSL_BLOCK_FILTER_NONE;
+  //: Compression level, 1 (fast) to 9 (small).
+  int level = 6;
+  //: Uncompressed size of each independently compressed chunk.
+  std::size_t chunk_bytes = 1 << 20;
+  //: Number of chunks compressed at once on the vpl pool. 0 means vpl_concurrency().
+  unsigned n_threads = 0;
+};
+
+//: True if support for \p codec was compiled into vsl.
+bool
+vsl_block_codec_available(vsl_block_codec_type codec);
+
+//: Write a block of raw elements, each \p elem_size bytes long.
+// Prefer the typed vsl_block_binary_codec_write().
+void
+vsl_block_binary_codec_write_bytes(vsl_b_ostream & os,
+                                   const void * begin,
+                                   unsigned elem_size,
+                                   std::size_t nelems,
+                                   const vsl_block_codec_params & params);
+
+//: Read a block of raw elements, each \p elem_size bytes long.
+// The decompressed data is converted back to the native byte order.
+// \param n_threads number of chunks decompressed at once on the vpl pool (0 means vpl_concurrency()).
+void
+vsl_block_binary_codec_read_bytes(vsl_b_istream & is,
+                                  void * begin,
+                                  unsigned elem_size,
+                                  std::size_t nelems,
+                                  unsigned n_threads = 0);
+
+//: Write a block of fundamental values to a vsl_b_ostream, compressed.
+// If the requested codec is not available in this build, the data
+// is stored uncompressed, and can still be read by vsl_block_binary_codec_read().
+template <class T>
+inline void
+vsl_block_binary_codec_write(vsl_b_ostream & os,
+                             const T * begin,
+                             std::size_t nelems,
+                             const vsl_block_codec_params & params = vsl_block_codec_params())
+{
+  static_assert(std::is_arithmetic<T>::value, "vsl_block_binary_codec_write only supports fundamental types");
+  vsl_block_binary_codec_write_bytes(os, begin, sizeof(T), nelems, params);
+}
+
+//: Read a block of fundamental values written by vsl_block_binary_codec_write().
+template <class T>
+inline void
+vsl_block_binary_codec_read(vsl_b_istream & is, T * begin, std::size_t nelems, unsigned n_threads = 0)
+{
+  static_assert(std::is_arithmetic<T>::value, "vsl_block_binary_codec_read only supports fundamental types");
+  vsl_block_binary_codec_read_bytes(is, begin, sizeof(T), nelems, n_threads);
+}
+
+#endif // vsl_block_binary_codec_h_
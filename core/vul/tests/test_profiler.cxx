@@ -0,0 +1,162 @@
+// This is core/vul/tests/test_profiler.cxx
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vul/vul_profiler.h"
+#include "testlib/testlib_test.h"
+
+static void
+busy(int n)
+{
+  VUL_PROFILE_ZONE("inner");
+  volatile double x = 0;
+  for (int i = 0; i < n; ++i)
+    x = x + 1.0 / (i + 1);
+}
+
+static void
+outer()
+{
+  VUL_PROFILE_ZONE("outer");
+  busy(1000);
+  busy(1000);
+}
+
+static const vul_profiler_stats *
+find_stats(const std::vector<vul_profiler_stats> & stats, const std::string & name)
+{
+  for (const auto & s : stats)
+    if (s.name == name)
+      return &s;
+  return nullptr;
+}
+
+void
+test_profiler()
+{
+  vul_profiler::reset();
+  outer();
+  TEST("Nothing recorded while disabled", vul_profiler::statistics().empty(), true);
+
+  vul_profiler::set_enabled(true);
+  for (int k = 0; k < 10; ++k)
+    outer();
+  vul_profiler::set_enabled(false);
+  outer();
+
+  std::vector<vul_profiler_stats> stats = vul_profiler::statistics();
+  const vul_profiler_stats * so = find_stats(stats, "outer");
+  const vul_profiler_stats * si = find_stats(stats, "inner");
+  TEST("Zone counts", so && si && so->count == 10 && si->count == 20, true);
+  TEST("Outer zone is listed first", stats.size() == 2 && stats[0].name == "outer", true);
+  TEST("Outer zone encloses inner zones", so && si && so->total >= si->total, true);
+  TEST("Percentiles are ordered",
+       si && si->p50 <= si->p90 && si->p90 <= si->p99 && si->p99 <= si->max && si->mean <= si->max,
+       true);
+
+  std::vector<std::vector<vul_profiler_event>> events = vul_profiler::events();
+  bool nesting_ok = events.size() == 1 && events[0].size() == 30;
+  if (nesting_ok)
+    for (unsigned k = 0; k < 30; k += 3)
+    {
+      const vul_profiler_event & a = events[0][k];
+      const vul_profiler_event & b = events[0][k + 1];
+      const vul_profiler_event & c = events[0][k + 2];
+      nesting_ok = nesting_ok && std::string(c.name) == "outer" && c.depth == 0 && a.depth == 1 && b.depth == 1 &&
+                   c.start <= a.start && a.end <= b.start && b.end <= c.end;
+    }
+  TEST("Events are nested", nesting_ok, true);
+
+  std::ostringstream folded;
+  vul_profiler::write_folded_stacks(folded);
+  TEST("Folded stacks",
+       folded.str().find("outer ") != std::string::npos && folded.str().find("outer;inner ") != std::string::npos,
+       true);
+
+  std::ostringstream trace;
+  vul_profiler::write_chrome_trace(trace);
+  TEST("Chrome trace",
+       trace.str().find("{\"traceEvents\":[") == 0 &&
+         trace.str().find("{\"name\":\"inner\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":") != std::string::npos,
+       true);
+
+  std::ostringstream summary;
+  vul_profiler::print_summary(summary);
+  std::istringstream summary_lines(summary.str());
+  std::string header, first_zone, second_zone;
+  std::getline(summary_lines, header);
+  summary_lines >> first_zone;
+  summary_lines.ignore(1000, '\n');
+  summary_lines >> second_zone;
+  unsigned long count = 0;
+  summary_lines >> count;
+  TEST("Summary table", header.find("zone") == 0 && first_zone == "outer" && second_zone == "inner" && count == 20, true);
+
+  // Each thread keeps its own events
+  vul_profiler::reset();
+  vul_profiler::set_enabled(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([]() {
+      for (int k = 0; k < 5; ++k)
+        outer();
+    });
+  for (auto & t : threads)
+    t.join();
+  events = vul_profiler::events();
+  unsigned n_threads = 0;
+  for (const auto & e : events)
+    if (e.size() == 15)
+      ++n_threads;
+  TEST("Events recorded per thread", n_threads, 4u);
+  stats = vul_profiler::statistics();
+  so = find_stats(stats, "outer");
+  TEST("Statistics over all threads", so && so->count == 20, true);
+
+  // Events can be read while other threads record them
+  vul_profiler::set_buffer_capacity(64);
+  vul_profiler::reset();
+  std::atomic<bool> recording{ true };
+  threads.clear();
+  for (int t = 0; t < 2; ++t)
+    threads.emplace_back([&recording]() {
+      while (recording)
+        outer();
+    });
+  bool well_formed = true;
+  for (int k = 0; k < 200; ++k)
+    for (const auto & thread_events : vul_profiler::events())
+    {
+      well_formed = well_formed && thread_events.size() <= 64;
+      for (const auto & e : thread_events)
+        well_formed = well_formed && e.start <= e.end &&
+                      ((std::string(e.name) == "outer" && e.depth == 0) ||
+                       (std::string(e.name) == "inner" && e.depth == 1));
+    }
+  recording = false;
+  for (auto & t : threads)
+    t.join();
+  TEST("Events read while recording are whole", well_formed, true);
+
+  // The oldest events are overwritten
+  vul_profiler::set_buffer_capacity(4);
+  vul_profiler::reset();
+  TEST("Finished threads are forgotten", vul_profiler::events().size(), 1u);
+  for (int k = 0; k < 3; ++k)
+    outer();
+  vul_profiler::set_enabled(false);
+  events = vul_profiler::events();
+  TEST("Ring buffer keeps the latest events",
+       events.size() == 1 && events[0].size() == 4 && std::string(events[0][3].name) == "outer" &&
+         std::string(events[0][2].name) == "inner" && std::string(events[0][0].name) == "outer",
+       true);
+  vul_profiler::set_buffer_capacity(1u << 16);
+  vul_profiler::reset();
+}
+
+TEST_MAIN(test_profiler)
@@ -0,0 +1,361 @@
+// This is core/vul/vul_profiler.cxx
+//:
+// \file
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include "vul_profiler.h"
+
+namespace
+{
+using vul_profiler_clock = std::chrono::steady_clock;
+
+std::atomic<bool> profiler_on{ false };
+std::atomic<unsigned> buffer_capacity{ 1u << 16 };
+
+//: Bumped by reset(), so that each thread renews its ring before its next event
+std::atomic<unsigned> reset_generation{ 0 };
+
+//: One event of a ring.
+//  The fields are atomic so that a reader may race with the owning thread
+//  overwriting them; copy_events() then discards the torn copy.
+struct event_slot
+{
+  std::atomic<const char *> name;
+  std::atomic<long long> start;
+  std::atomic<long long> end;
+  std::atomic<unsigned> depth;
+};
+
+//: The events of one thread.
+//  The ring has a single writer, its thread, which takes no lock to record
+//  an event.  The sequence count is odd while an event is being written, so
+//  readers can tell which of the events they copied may have been overwritten.
+//  The mutex is only taken by readers, by reset(), and by the owning thread
+//  when it renews the ring after a reset().
+struct thread_buffer
+{
+  std::mutex mutex;
+  std::unique_ptr<event_slot[]> ring;
+  std::size_t capacity{ 0 };
+  //: Twice the number of events begun; odd while one is being written
+  std::atomic<std::size_t> sequence{ 0 };
+  //: Events before this one were discarded by reset()
+  std::atomic<std::size_t> discarded{ 0 };
+  //: Value of reset_generation when the ring was allocated; only used by the owning thread
+  unsigned generation{ 0 };
+  //: Number of open zones; only used by the owning thread
+  unsigned depth{ 0 };
+
+  //: Allocate an empty ring.  Called by the owning thread.
+  void
+  renew()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation = reset_generation.load();
+    capacity = std::max(1u, buffer_capacity.load());
+    ring.reset(new event_slot[capacity]);
+    sequence.store(0, std::memory_order_relaxed);
+    discarded.store(0, std::memory_order_relaxed);
+  }
+};
+
+struct buffer_registry
+{
+  std::mutex mutex;
+  std::vector<std::shared_ptr<thread_buffer>> buffers;
+};
+
+buffer_registry &
+registry()
+{
+  static buffer_registry r;
+  return r;
+}
+
+const vul_profiler_clock::time_point &
+epoch()
+{
+  static const vul_profiler_clock::time_point t = vul_profiler_clock::now();
+  return t;
+}
+
+thread_buffer &
+local_buffer()
+{
+  thread_local std::shared_ptr<thread_buffer> buffer;
+  if (!buffer)
+  {
+    buffer = std::make_shared<thread_buffer>();
+    buffer->renew();
+    buffer_registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+//: Copy the events held in b, oldest first
+std::vector<vul_profiler_event>
+copy_events(thread_buffer & b)
+{
+  std::lock_guard<std::mutex> lock(b.mutex);
+  const std::size_t n = b.capacity;
+  const std::size_t written = b.sequence.load(std::memory_order_acquire) / 2;
+  const std::size_t discarded = b.discarded.load(std::memory_order_relaxed);
+  const std::size_t first = std::max(discarded, written > n ? written - n : 0);
+  std::vector<vul_profiler_event> out;
+  out.reserve(written > first ? written - first : 0);
+  for (std::size_t i = first; i < written; ++i)
+  {
+    const event_slot & s = b.ring[i % n];
+    vul_profiler_event e;
+    e.name = s.name.load(std::memory_order_relaxed);
+    e.start = s.start.load(std::memory_order_relaxed);
+    e.end = s.end.load(std::memory_order_relaxed);
+    e.depth = s.depth.load(std::memory_order_relaxed);
+    out.push_back(e);
+  }
+  // Drop the copies of any slots the owning thread began to overwrite meanwhile
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const std::size_t begun = (b.sequence.load(std::memory_order_relaxed) + 1) / 2;
+  if (begun > n && begun - n > first)
+    out.erase(out.begin(), out.begin() + std::min(out.size(), begun - n - first));
+  return out;
+}
+
+//: Value at fraction p of the sorted values v (nearest rank)
+double
+percentile(const std::vector<double> & v, double p)
+{
+  const auto rank = static_cast<std::size_t>(std::ceil(p * v.size()));
+  return v[rank > 0 ? rank - 1 : 0];
+}
+
+void
+write_json_string(std::ostream & os, const char * s)
+{
+  os << '"';
+  for (; *s; ++s)
+  {
+    const auto c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\')
+      os << '\\' << *s;
+    else if (c < 0x20)
+      os << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+    else
+      os << *s;
+  }
+  os << '"';
+}
+} // namespace
+
+
+void
+vul_profiler::set_enabled(bool on)
+{
+  epoch();
+  profiler_on = on;
+}
+
+bool
+vul_profiler::enabled()
+{
+  return profiler_on.load(std::memory_order_relaxed);
+}
+
+void
+vul_profiler::set_buffer_capacity(unsigned n)
+{
+  buffer_capacity = n;
+}
+
+void
+vul_profiler::reset()
+{
+  buffer_registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  // Forget the buffers of threads which have finished
+  r.buffers.erase(std::remove_if(r.buffers.begin(),
+                                 r.buffers.end(),
+                                 [](const std::shared_ptr<thread_buffer> & b) { return b.use_count() == 1; }),
+                  r.buffers.end());
+  // Other threads' rings cannot be replaced under them: hide their events
+  // now, and let each thread renew its ring before its next event.
+  ++reset_generation;
+  for (const auto & b : r.buffers)
+  {
+    std::lock_guard<std::mutex> buffer_lock(b->mutex);
+    b->discarded.store((b->sequence.load() + 1) / 2, std::memory_order_relaxed);
+  }
+}
+
+long long
+vul_profiler::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(vul_profiler_clock::now() - epoch()).count();
+}
+
+std::vector<std::vector<vul_profiler_event>>
+vul_profiler::events()
+{
+  std::vector<std::shared_ptr<thread_buffer>> buffers;
+  {
+    buffer_registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    buffers = r.buffers;
+  }
+  std::vector<std::vector<vul_profiler_event>> out;
+  out.reserve(buffers.size());
+  for (const auto & b : buffers)
+    out.push_back(copy_events(*b));
+  return out;
+}
+
+std::vector<vul_profiler_stats>
+vul_profiler::statistics()
+{
+  std::map<std::string, std::vector<double>> durations;
+  for (const auto & thread_events : events())
+    for (const auto & e : thread_events)
+      durations[e.name].push_back((e.end - e.start) * 1e-3);
+
+  std::vector<vul_profiler_stats> stats;
+  for (auto & d : durations)
+  {
+    std::vector<double> & v = d.second;
+    std::sort(v.begin(), v.end());
+    vul_profiler_stats s;
+    s.name = d.first;
+    s.count = static_cast<unsigned long>(v.size());
+    s.total = 0.0;
+    for (double t : v)
+      s.total += t;
+    s.mean = s.total / v.size();
+    s.p50 = percentile(v, 0.50);
+    s.p90 = percentile(v, 0.90);
+    s.p99 = percentile(v, 0.99);
+    s.max = v.back();
+    stats.push_back(s);
+  }
+  std::stable_sort(stats.begin(), stats.end(), [](const vul_profiler_stats & a, const vul_profiler_stats & b) {
+    return a.total > b.total;
+  });
+  return stats;
+}
+
+void
+vul_profiler::print_summary(std::ostream & os)
+{
+  const std::vector<vul_profiler_stats> stats = statistics();
+  std::size_t width = 4;
+  for (const auto & s : stats)
+    width = std::max(width, s.name.size());
+
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  os << std::left << std::setw(int(width)) << "zone" << std::right << std::setw(10) << "count" << std::setw(12)
+     << "total ms" << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(12) << "p90 us"
+     << std::setw(12) << "p99 us" << std::setw(12) << "max us" << '\n'
+     << std::fixed;
+  for (const auto & s : stats)
+    os << std::left << std::setw(int(width)) << s.name << std::right << std::setw(10) << s.count << std::setprecision(3)
+       << std::setw(12) << s.total * 1e-3 << std::setprecision(1) << std::setw(12) << s.mean << std::setw(12) << s.p50
+       << std::setw(12) << s.p90 << std::setw(12) << s.p99 << std::setw(12) << s.max << '\n';
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void
+vul_profiler::write_chrome_trace(std::ostream & os)
+{
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  os << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+  bool first = true;
+  unsigned tid = 0;
+  for (const auto & thread_events : events())
+  {
+    for (const auto & e : thread_events)
+    {
+      os << (first ? "\n" : ",\n") << "{\"name\":";
+      write_json_string(os, e.name);
+      os << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << e.start * 1e-3
+         << ",\"dur\":" << (e.end - e.start) * 1e-3 << '}';
+      first = false;
+    }
+    ++tid;
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void
+vul_profiler::write_folded_stacks(std::ostream & os)
+{
+  // Total time of each stack, and of the zones directly inside it
+  std::map<std::string, long long> total, children;
+  for (auto & thread_events : events())
+  {
+    // Enclosing zones start no later, and are less deeply nested.
+    std::sort(thread_events.begin(), thread_events.end(), [](const vul_profiler_event & a, const vul_profiler_event & b) {
+      return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+    });
+    std::vector<std::string> stack;
+    for (const auto & e : thread_events)
+    {
+      if (stack.size() > e.depth)
+        stack.resize(e.depth);
+      const long long duration = e.end - e.start;
+      if (!stack.empty())
+        children[stack.back()] += duration;
+      stack.push_back(stack.empty() ? std::string(e.name) : stack.back() + ';' + e.name);
+      total[stack.back()] += duration;
+    }
+  }
+  for (const auto & t : total)
+  {
+    const long long self = t.second - children[t.first];
+    os << t.first << ' ' << std::max(0LL, (self + 500) / 1000) << '\n';
+  }
+}
+
+
+vul_profiler_zone::vul_profiler_zone(const char * name)
+  : name_(nullptr)
+  , start_(0)
+{
+  if (!profiler_on.load(std::memory_order_relaxed))
+    return;
+  name_ = name;
+  ++local_buffer().depth;
+  start_ = vul_profiler::now();
+}
+
+vul_profiler_zone::~vul_profiler_zone()
+{
+  if (!name_)
+    return;
+  const long long end = vul_profiler::now();
+  thread_buffer & b = local_buffer();
+  --b.depth;
+  if (b.generation != reset_generation.load(std::memory_order_relaxed))
+    b.renew();
+  const std::size_t seq = b.sequence.load(std::memory_order_relaxed);
+  b.sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event_slot & e = b.ring[(seq / 2) % b.capacity];
+  e.name.store(name_, std::memory_order_relaxed);
+  e.start.store(start_, std::memory_order_relaxed);
+  e.end.store(end, std::memory_order_relaxed);
+  e.depth.store(b.depth, std::memory_order_relaxed);
+  b.sequence.store(seq + 2, std::memory_order_release);
+}
@@ -0,0 +1,144 @@
+// This is core/vul/vul_profiler.h
+#ifndef vul_profiler_h_
+#define vul_profiler_h_
+//:
+// \file
+// \brief Low overhead profiling of nested, named zones of code
+//
+// A zone is a scope marked with VUL_PROFILE_ZONE("name").  While the
+// profiler is enabled, each zone records its start and end time, from a
+// monotonic high resolution clock, into a ring buffer private to the
+// calling thread.  Zones may nest, and the nesting is recorded.
+// Afterwards the events can be summarised per zone name (count, total,
+// mean, percentiles), or written out as a Chrome trace (load it at
+// chrome://tracing or ui.perfetto.dev) or as folded stacks for
+// flamegraph.pl.
+//
+// \code
+//   vul_profiler::set_enabled(true);
+//   {
+//     VUL_PROFILE_ZONE("census");
+//     ...
+//   }
+//   vul_profiler::print_summary(std::cout);
+// \endcode
+//
+// The profiler starts disabled, when a zone costs a single flag test.
+// Compile with -DVUL_PROFILER_DISABLE to remove the zones altogether.
+//
+// Zone names are kept by pointer, so they must outlive the profiler;
+// string literals are the intended use.  Each thread keeps only its most
+// recent events; see set_buffer_capacity().  Recording takes no lock.
+// The reporting functions may be called while other threads are
+// recording, but the results only include zones which have ended.
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Summary statistics of the events recorded for one zone name.
+//  Times are in microseconds.
+struct vul_profiler_stats
+{
+  std::string name;
+  unsigned long count;
+  double total;
+  double mean;
+  double p50;
+  double p90;
+  double p99;
+  double max;
+};
+
+//: Record of one completed zone
+struct vul_profiler_event
+{
+  const char * name;
+  //: Start and end, in nanoseconds since the profiler was first used
+  long long start;
+  long long end;
+  //: Number of zones enclosing this one in the same thread
+  unsigned depth;
+};
+
+//: Collects the zones recorded by all threads.
+//  All members are static.
+class vul_profiler
+{
+public:
+  //: Start or stop recording
+  static void
+  set_enabled(bool on);
+
+  //: True if zones are being recorded
+  static bool
+  enabled();
+
+  //: Number of events each thread keeps before overwriting the oldest.
+  //  Applies to buffers created after the call, and to all buffers after reset().
+  static void
+  set_buffer_capacity(unsigned n);
+
+  //: Discard all recorded events
+  static void
+  reset();
+
+  //: Statistics per zone name, in order of decreasing total time
+  static std::vector<vul_profiler_stats>
+  statistics();
+
+  //: Print statistics() as a table
+  static void
+  print_summary(std::ostream & os);
+
+  //: Write all events as Chrome trace event format JSON
+  static void
+  write_chrome_trace(std::ostream & os);
+
+  //: Write the self time (in microseconds) of each stack of zones, in the folded format read by flamegraph.pl
+  static void
+  write_folded_stacks(std::ostream & os);
+
+  //: The events still held for each thread, in order of completion
+  static std::vector<std::vector<vul_profiler_event>>
+  events();
+
+  //: Nanoseconds since the profiler was first used
+  static long long
+  now();
+};
+
+//: Records a zone from construction to destruction.
+//  Normally used through VUL_PROFILE_ZONE.
+class vul_profiler_zone
+{
+public:
+  explicit vul_profiler_zone(const char * name);
+  ~vul_profiler_zone();
+
+  vul_profiler_zone(const vul_profiler_zone &) = delete;
+  vul_profiler_zone &
+  operator=(const vul_profiler_zone &) = delete;
+
+private:
+  const char * name_;
+  long long start_;
+};
+
+#define vul_profiler_cat2(a, b) a##b
+#define vul_profiler_cat(a, b) vul_profiler_cat2(a, b)
+
+#if defined(VUL_PROFILER_DISABLE)
+#  define VUL_PROFILE_ZONE(name) /* */
+#  define VUL_PROFILE_FUNCTION() /* */
+#else
+//: Profile the rest of the enclosing scope as zone \p name
+#  define VUL_PROFILE_ZONE(name) vul_profiler_zone vul_profiler_cat(vul_profiler_zone_, __LINE__)(name)
+//: Profile the rest of the enclosing function, named after it
+#  define VUL_PROFILE_FUNCTION() VUL_PROFILE_ZONE(__func__)
+#endif
+
+#endif // vul_profiler_h_